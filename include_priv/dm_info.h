@@ -64,6 +64,7 @@
 #define __dm_info_h__
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <amxc/amxc_string.h>
@@ -85,10 +86,24 @@ typedef enum _xpon_object_id {
     obj_id_unknown = obj_id_nbr
 } object_id_t;
 
+/**
+ * How a parameter changes.
+ *
+ * - stable: the ONU HAL agent sends dm:object-changed when it changes, e.g.,
+ *     a software image version or the status of an interface
+ * - volatile: it changes without notification, e.g., a measurement such as
+ *     the optical rx power, or a time since the last change
+ */
+typedef enum _param_volatility {
+    param_volatility_stable = 0,
+    param_volatility_volatile
+} param_volatility_t;
+
 typedef struct _param_info {
     const char* bbf_name;
     const char* prpl_name;
     uint32_t type; /* One of the AMXC_VAR_ID values */
+    param_volatility_t volatility;
 } param_info_t;
 
 /**
@@ -125,6 +140,8 @@ object_id_t dm_get_object_id(const char* const path);
 const object_info_t* dm_get_object_info(object_id_t id);
 
 bool dm_get_object_param_info(object_id_t id, const param_info_t** param_info, uint32_t* size);
+const param_info_t* dm_get_param_info_by_prpl_name(object_id_t id, const char* const name,
+                                                   size_t len);
 
 bool dm_convert_bbf_path_to_prpl_path(const char* const bbf_path, amxc_string_t* const prpl_path);
 bool dm_convert_prpl_path_to_bbf_path(const char* const prpl_path, amxc_string_t* const bbf_path);
@@ -0,0 +1,132 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __flight_recorder_h__
+#define __flight_recorder_h__
+
+/**
+ * @file flight_recorder.h
+ *
+ * In-memory ring with a compact binary record per southbound call and per
+ * notification processed.
+ *
+ * The ring has a fixed size and is statically allocated: adding a record
+ * does not allocate memory and does not format any string. Each record is
+ * tagged with the current trace ID (see trace_id.h): the records with the
+ * same trace ID are the spans of one pon_ctrl request or notification. When
+ * the ring is full, a new record overwrites the oldest one. The records can
+ * be dumped on demand via pon_ctrl.dump_flight_recorder(), e.g., for a
+ * postmortem analysis without having to enable verbose traces.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <amxc/amxc_variant.h>
+
+/** Nr of records in the ring */
+#define FLIGHT_RECORDER_SIZE 1024
+
+/** Operations the flight recorder keeps track of */
+typedef enum _fr_op {
+    fr_op_sbi_enable = 0,
+    fr_op_sbi_disable,
+    fr_op_sbi_get,
+    fr_op_sbi_get_params,
+    fr_op_notif_instance_added,
+    fr_op_notif_instance_removed,
+    fr_op_notif_object_changed,
+    fr_op_notif_reset_mib,
+    fr_op_notif_resync,
+    fr_op_pon_ctrl_request,
+    fr_op_span_path_translation,
+    fr_op_span_conversion,
+    fr_op_nr
+} fr_op_t;
+
+/**
+ * Record in the ring.
+ *
+ * - ts_us: time the operation ended. See latency_now_us().
+ * - trace_id: trace ID of the request or notification, or 0
+ * - duration_us: how long the operation took, saturated at UINT32_MAX
+ * - rc: 0 on success, else a negative error code of the operation
+ * - onu_index: xpon_onu instance index, or 0 if unknown
+ * - op: one of fr_op_t
+ * - obj_id: one of object_id_t
+ */
+typedef struct _fr_record {
+    uint64_t ts_us;
+    uint32_t trace_id;
+    uint32_t duration_us;
+    int32_t rc;
+    uint16_t onu_index;
+    uint8_t op;
+    uint8_t obj_id;
+} fr_record_t;
+
+void flight_recorder_add(fr_op_t op, uint32_t obj_id, uint32_t onu_index,
+                         uint64_t duration_us, int32_t rc);
+void flight_recorder_dump(amxc_var_t* const records);
+void flight_recorder_clear(void);
+
+#endif
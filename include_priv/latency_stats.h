@@ -0,0 +1,102 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __latency_stats_h__
+#define __latency_stats_h__
+
+/**
+ * @file latency_stats.h
+ *
+ * Counters to keep track of how long something takes, e.g., how long a
+ * notification waits in a queue before it is processed.
+ *
+ * Besides count, total and max, the statistics have a histogram with
+ * log2-sized buckets: bucket 0 counts the samples of 0 us, and bucket i > 0
+ * counts the samples in [2^(i-1), 2^i) us. The last bucket also counts all
+ * longer samples.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <amxc/amxc_variant.h>
+
+/** Nr of histogram buckets. The last one starts at 2^23 us (about 8 s). */
+#define LATENCY_STATS_N_BUCKETS 25
+
+typedef struct _latency_stats {
+    uint64_t count;
+    uint64_t errors;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint32_t buckets[LATENCY_STATS_N_BUCKETS];
+} latency_stats_t;
+
+uint64_t latency_now_us(void);
+
+void latency_stats_add(latency_stats_t* const stats, uint64_t duration_us);
+void latency_stats_add_result(latency_stats_t* const stats, uint64_t duration_us,
+                              bool success);
+void latency_stats_reset(latency_stats_t* const stats);
+void latency_stats_to_var(const latency_stats_t* const stats, amxc_var_t* const var);
+
+#endif
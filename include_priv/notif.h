@@ -86,19 +86,34 @@
 #include <amxb/amxb_types.h>
 
 /**
- * Maximum number of ONUs on a board.
+ * Default maximum number of ONUs on a board.
  *
  * We expect a board to have maximum 2 ONUs, e.g. one for G-PON and one for
  * XGS-PON. Take the number a bit higher to provide some margin. The tr181-xpon
  * plugin sets the actual (max) number of ONUs with set_max_nr_of_onus() at
  * startup.
  */
-#define MAX_NR_OF_ONUS 4
+#define NOTIF_DEFAULT_MAX_NR_OF_ONUS 4
 
-void notif_init(void);
+/**
+ * Upper limit for the max number of ONUs.
+ *
+ * Lab setups and the ONU HAL mock can have more ONUs than a real board. The
+ * limit keeps "xpon_onu.<index>." within the buffers used to build it.
+ */
+#define NOTIF_MAX_NR_OF_ONUS_LIMIT 4096
+
+bool notif_init(void);
 void notif_cleanup(void);
 
+bool notif_set_max_nr_of_onus(uint32_t max_nr_of_onus);
+uint32_t notif_get_max_nr_of_onus(void);
+
 bool notif_is_subscribed(uint32_t index);
+uint32_t notif_get_nr_of_subscribed_onus(void);
 void notif_subscribe(amxb_bus_ctx_t* const ctx, uint32_t index);
 
+void notif_get_stats(amxc_var_t* const stats);
+void notif_reset_stats(void);
+
 #endif
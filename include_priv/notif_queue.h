@@ -0,0 +1,218 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __notif_queue_h__
+#define __notif_queue_h__
+
+/**
+ * @file notif_queue.h
+ *
+ * Per-ONU queues for notifications coming from the ONU HAL agents, and a
+ * scheduler draining them.
+ *
+ * The notification handler only puts a copy of each notification in the queue
+ * of the ONU it belongs to. A scheduler, running from a timer in the event
+ * loop of the tr181-xpon plugin, drains the queues round-robin: it processes
+ * one notification of an ONU and then moves on to the next ONU with pending
+ * notifications. It processes a limited number of notifications per pass, and
+ * then gives control back to the event loop. Hence a burst of notifications
+ * from one ONU does not starve the other ONU(s), nor the 'pon_ctrl' calls from
+ * the tr181-xpon plugin.
+ *
+ * Each queue has two lanes: a high-priority lane and a normal lane. The
+ * caller decides to which lane a notification goes. The scheduler always
+ * serves the high-priority lanes of all ONUs before it serves any normal lane.
+ * Hence an alarm does not wait behind a burst of notifications about GEM ports
+ * being provisioned.
+ *
+ * Each lane is bounded, by default to NOTIF_QUEUE_DEFAULT_DEPTH. Depth
+ * NOTIF_QUEUE_UNBOUNDED is an explicit opt-out. If a notification arrives
+ * while the lane is full, the queue applies the configured overflow policy:
+ * - notif_queue_drop_oldest: drop the oldest notification in the lane.
+ * - notif_queue_resync: replace the notifications of the ONU by a single
+ *   resync request, which re-reads the ONU. The resync is served as part of
+ *   the normal lane, in steps: each step is one unit of work of a drain pass,
+ *   so a resync does not block the event loop. If the normal lane overflows,
+ *   the queue drops the normal lane, and the normal notifications arriving
+ *   until the resync starts. Normal notifications arriving while it runs are
+ *   queued and processed after it. If the high-priority lane overflows, the
+ *   queue only drops its oldest notification. It never drops a high-priority
+ *   notification because a resync is pending.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <amxc/amxc_llist.h>
+#include <amxc/amxc_variant.h>
+
+#include "latency_stats.h"
+
+/** Depth of a lane without limit. Only used if configured explicitly. */
+#define NOTIF_QUEUE_UNBOUNDED 0
+
+/**
+ * Default max number of notifications in one lane of the queue of one ONU.
+ *
+ * A MIB upload can result in a dm:instance-added notification for each
+ * object of the ONU, e.g., for each GEM port: up to a few thousand for a
+ * large ONU. The default depth absorbs that without a resync.
+ */
+#define NOTIF_QUEUE_DEFAULT_DEPTH 4096
+
+/** Max value accepted for the depth of a queue. */
+#define NOTIF_QUEUE_MAX_DEPTH 65536
+
+/** Default max number of notifications the scheduler processes per pass. */
+#define NOTIF_QUEUE_DEFAULT_EVENTS_PER_PASS 8
+
+typedef enum _notif_lane {
+    notif_lane_high = 0,
+    notif_lane_normal,
+    notif_lane_nr
+} notif_lane_t;
+
+typedef enum _notif_queue_overflow_policy {
+    notif_queue_drop_oldest = 0,
+    notif_queue_resync,
+    notif_queue_overflow_policy_nr
+} notif_queue_overflow_policy_t;
+
+/**
+ * Process a notification taken from a queue.
+ *
+ * @param[in] onu_index  xpon_onu instance index of the queue
+ * @param[in] type       type passed to notif_queue_push()
+ * @param[in] data       notification data passed to notif_queue_push()
+ * @param[in] enqueued_us  time the notification was added to the queue. See
+ *                       latency_now_us().
+ */
+typedef void (* notif_queue_process_fn_t) (uint32_t onu_index, uint32_t type,
+                                           const amxc_var_t* const data,
+                                           uint64_t enqueued_us);
+
+/**
+ * Do one step of the resync of an ONU after the queue of that ONU overflowed.
+ *
+ * @param[in] onu_index  xpon_onu instance index of the queue
+ * @param[in] start      true for the first step of a resync. The function
+ *                       must then drop the steps left of an earlier resync.
+ *
+ * @return true if steps remain, false if the resync is done
+ */
+typedef bool (* notif_queue_resync_fn_t) (uint32_t onu_index, bool start);
+
+struct _notif_queue;
+
+/**
+ * One lane of the queue of an ONU.
+ */
+typedef struct _notif_lane_queue {
+    struct _notif_queue* owner;
+    amxc_llist_t events;      /* notif_event_t entries, oldest first */
+    uint32_t size;            /* nr of entries in 'events' */
+    uint32_t max_size;
+    amxc_llist_it_t ready_it; /* in list of scheduler while lane has work */
+} notif_lane_queue_t;
+
+/**
+ * Queue with the pending notifications of one ONU.
+ *
+ * The fields are private to notif_queue.c. Other parts should only use the
+ * notif_queue_xxx() functions.
+ */
+typedef struct _notif_queue {
+    uint32_t onu_index;
+    notif_lane_queue_t lanes[notif_lane_nr];
+    bool resync_pending;      /* a resync is requested or running */
+    bool resync_running;      /* the first step of the resync was done */
+    uint32_t resync_trace_id; /* trace ID of all steps of the resync */
+    /* statistics */
+    uint64_t n_enqueued;
+    uint64_t n_processed;
+    uint64_t n_dropped;
+    uint64_t n_overflows;
+    uint64_t n_resyncs;
+} notif_queue_t;
+
+bool notif_queue_init(notif_queue_t* const queue, uint32_t onu_index);
+void notif_queue_clean(notif_queue_t* const queue);
+bool notif_queue_push(notif_queue_t* const queue, notif_lane_t lane,
+                      uint32_t type, const amxc_var_t* const data);
+void notif_queue_get_stats(const notif_queue_t* const queue, amxc_var_t* const stats);
+void notif_queue_reset_stats(notif_queue_t* const queue);
+
+bool notif_queue_init_scheduler(notif_queue_process_fn_t process_fn,
+                                notif_queue_resync_fn_t resync_fn);
+void notif_queue_cleanup_scheduler(void);
+
+bool notif_queue_set_config(uint32_t depth,
+                            notif_queue_overflow_policy_t policy,
+                            uint32_t events_per_pass);
+void notif_queue_get_config(amxc_var_t* const config);
+void notif_queue_get_lane_stats(amxc_var_t* const stats);
+void notif_queue_reset_lane_stats(void);
+
+notif_queue_overflow_policy_t notif_queue_policy_from_string(const char* const policy);
+const char* notif_queue_policy_to_string(notif_queue_overflow_policy_t policy);
+
+#endif
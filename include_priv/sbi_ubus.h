@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __sbi_ubus_h__
+#define __sbi_ubus_h__
+
+/**
+ * @file sbi_ubus.h
+ *
+ * Reading the prpl xpon_onu DM with libubus directly.
+ *
+ * Via amxb, a reply of an ONU HAL agent travels as blobmsg, amxb-ubus
+ * converts it to a list with an htable, and obj_process_object_params()
+ * converts that to the htable with BBF names tr181-xpon expects. The "ubus"
+ * backend calls get() and get_params() with libubus instead, and decodes the
+ * blobmsg reply straight into that last htable. The param tables in
+ * dm_info.c serve as blobmsg policy.
+ *
+ * All other operations of the "ubus" backend, e.g. enable() and the
+ * subscriptions on notifications, still go via amxb: they need the event
+ * loop of the tr181-xpon plugin, while the reads here are synchronous.
+ *
+ * The backend invokes by ubus object ID. It resolves the path of an object
+ * to its ID once, and caches it. See id_cache_t in sbi_ubus.c.
+ *
+ * The backend is only built if CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND is set.
+ * Even then, the module only uses it if the tr181-xpon plugin selects it with
+ * pon_ctrl.set_southbound_backend().
+ */
+
+#include <stdbool.h>
+
+#include <amxc/amxc_variant.h>
+
+#include "southbound_if.h" /* sbi_backend_t */
+
+bool sbi_ubus_configure(const amxc_var_t* const config);
+int sbi_ubus_query(amxb_bus_ctx_t* const ctx, object_id_t id, const char* const object,
+                   const char* const method, amxc_var_t* const args, bool extract_key,
+                   amxc_var_t* const ret, int timeout_s);
+void sbi_ubus_forget_object(const char* const prpl_path);
+void sbi_ubus_get_stats(amxc_var_t* const section);
+void sbi_ubus_reset_stats(void);
+void sbi_ubus_cleanup(void);
+
+#endif
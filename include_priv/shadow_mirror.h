@@ -0,0 +1,131 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __shadow_mirror_h__
+#define __shadow_mirror_h__
+
+/**
+ * @file shadow_mirror.h
+ *
+ * Optional in-memory mirror of the prpl xpon_onu objects.
+ *
+ * If enabled, the mirror keeps the param values of each object in a typed
+ * record laid out after the param table of the object in dm_info.c, with
+ * interned strings. The records of one object type are stored back to back
+ * in one array, and are looked up by their instance indexes. It only converts a record to a variant in the BBF XPON
+ * DM format to serve a read. It fills a record at the first read of the
+ * object, i.e., when the tr181-xpon plugin discovers the object, and keeps it
+ * current with the objects the module queries for dm:instance-added and
+ * dm:object-changed notifications. It drops records for dm:instance-removed,
+ * for a MIB reset or resync of the ONU, and after enable() or disable() on
+ * the object.
+ *
+ * The mirror serves a parameter based on its volatility (see dm_info.h):
+ * - stable: from memory
+ * - volatile: from memory if the value is younger than
+ *   'volatile_max_age_ms', else from the ONU HAL agent via get_params().
+ *   With the default age 0, volatile values always come from the agent.
+ *
+ * The mirror is disabled by default. Then the functions below pass each read
+ * as is to the southbound interface.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <amxc/amxc_string.h>
+#include <amxc/amxc_variant.h>
+
+#include "dm_info.h"       /* object_id_t */
+#include "southbound_if.h" /* amxb_bus_ctx_t */
+
+/** Default max age of a volatile value served from the mirror */
+#define SHADOW_MIRROR_DEFAULT_VOLATILE_MAX_AGE_MS 0
+
+bool shadow_mirror_set_config(bool enable, uint32_t volatile_max_age_ms);
+void shadow_mirror_get_config(amxc_var_t* const config);
+
+bool shadow_mirror_get_object_content(amxb_bus_ctx_t* ctx,
+                                      object_id_t id,
+                                      const amxc_string_t* const prpl_path,
+                                      bool extract_key,
+                                      amxc_var_t* const ret);
+
+bool shadow_mirror_get_param_values(amxb_bus_ctx_t* ctx,
+                                    object_id_t id,
+                                    const amxc_string_t* const prpl_path,
+                                    const char* const names,
+                                    amxc_var_t* const ret);
+
+void shadow_mirror_update(object_id_t id,
+                          const char* const prpl_path,
+                          const amxc_var_t* const content,
+                          bool has_keys);
+void shadow_mirror_forget(const char* const prpl_path);
+void shadow_mirror_forget_onu(uint32_t onu_index);
+
+void shadow_mirror_get_stats(amxc_var_t* const stats);
+void shadow_mirror_reset_stats(void);
+
+void shadow_mirror_cleanup(void);
+
+#endif
@@ -67,6 +67,13 @@
  * @file southbound_if.h
  *
  * Operations on the southbound interface towards the prpl PON HAL agents.
+ *
+ * The module does not call Ambiorix directly for those operations. It goes
+ * via a backend, see sbi_backend_t. The default backend "amxb" uses the bus,
+ * or "ubus" if the module is built with it.
+ * The backend "loopback" serves a synthetic xpon_onu DM from memory, see
+ * sbi_loopback.h. The optional backend "ubus" reads via libubus directly,
+ * see sbi_ubus.h.
  */
 
 #include <stdbool.h>
@@ -80,18 +87,97 @@
 #include <amxd/amxd_types.h>   /* required by amxb.h */
 #include <amxb/amxb.h>         /* amxb_bus_ctx_t */
 
+#include "dm_info.h"           /* object_id_t */
+
+#define SBI_BACKEND_AMXB "amxb"
+#define SBI_BACKEND_LOOPBACK "loopback"
+#define SBI_BACKEND_UBUS "ubus"
+
+/**
+ * Backend of the southbound interface.
+ *
+ * - name: name to select the backend with sbi_set_backend()
+ * - configure: optional. Apply the backend specific settings in @a config,
+ *     an htable. sbi_set_backend() calls it before it switches.
+ * - who_has: return the bus context serving @a object, e.g., "xpon_onu.1",
+ *     or NULL if the object does not exist. The module only compares the bus
+ *     context and passes it back to the backend.
+ * - call: call @a method on @a object. Same contract as amxb_call().
+ * - subscribe: subscribe @a fn on the notifications of @a object. Same
+ *     contract as amxb_subscribe() without expression.
+ * - unsubscribe: undo subscribe. Same contract as amxb_unsubscribe().
+ * - get_indexes: same contract as ubus_prpl_get_indexes().
+ * - query: optional. Call get() or get_params() on @a object like call, but
+ *     return the reply in the format of obj_process_object_params(): an
+ *     htable with the key 'parameters' (BBF names) and, if @a extract_key is
+ *     true, the key 'keys'. A backend which decodes the reply of the ONU HAL
+ *     agent itself offers it to skip the conversion to the prpl variant.
+ * - forget: optional. Drop the state the backend keeps for @a prpl_path and
+ *     its descendants, e.g., a cached object ID. The module calls it when the
+ *     object was removed. @a prpl_path has no trailing dot.
+ *
+ * The paths passed to call, query, subscribe and unsubscribe end with a dot.
+ */
+typedef struct _sbi_backend {
+    const char* name;
+    bool (* configure)(const amxc_var_t* const config);
+    amxb_bus_ctx_t* (* who_has)(const char* const object);
+    int (* call)(amxb_bus_ctx_t* const ctx, const char* const object,
+                 const char* const method, amxc_var_t* const args,
+                 amxc_var_t* const ret, int timeout_s);
+    int (* subscribe)(amxb_bus_ctx_t* const ctx, const char* const object,
+                      amxp_slot_fn_t fn, void* const priv);
+    int (* unsubscribe)(amxb_bus_ctx_t* const ctx, const char* const object,
+                        amxp_slot_fn_t fn, void* const priv);
+    bool (* get_indexes)(const char* const prpl_path, amxc_string_t* const indexes);
+    int (* query)(amxb_bus_ctx_t* const ctx, object_id_t id, const char* const object,
+                  const char* const method, amxc_var_t* const args, bool extract_key,
+                  amxc_var_t* const ret, int timeout_s);
+    void (* forget)(const char* const prpl_path);
+} sbi_backend_t;
+
+bool sbi_set_backend(const char* const name, const amxc_var_t* const config);
+const char* sbi_get_backend_name(void);
+
+amxb_bus_ctx_t* sbi_who_has(const char* const object);
+bool sbi_subscribe(amxb_bus_ctx_t* const ctx, const char* const object,
+                   amxp_slot_fn_t fn, void* const priv);
+bool sbi_unsubscribe(amxb_bus_ctx_t* const ctx, const char* const object,
+                     amxp_slot_fn_t fn, void* const priv);
+bool sbi_get_indexes(const char* const prpl_path, amxc_string_t* const indexes);
+void sbi_forget_object(const char* const prpl_path);
 
 bool sbi_enable(amxb_bus_ctx_t* ctx,
+                object_id_t id,
                 const amxc_string_t* const path,
                 bool enable);
 
 bool sbi_query_object(amxb_bus_ctx_t* ctx,
+                      object_id_t id,
                       const amxc_string_t* const path,
                       amxc_var_t* const param_values);
 
 bool sbi_query_params(amxb_bus_ctx_t* ctx,
+                      object_id_t id,
                       const amxc_string_t* const path,
                       const char* const names,
                       amxc_var_t* const param_values);
 
+bool sbi_get_object_content(amxb_bus_ctx_t* ctx,
+                            object_id_t id,
+                            const amxc_string_t* const path,
+                            bool extract_key,
+                            amxc_var_t* const ret);
+
+bool sbi_get_param_values(amxb_bus_ctx_t* ctx,
+                          object_id_t id,
+                          const amxc_string_t* const path,
+                          const char* const names,
+                          amxc_var_t* const ret);
+
+void sbi_get_stats(amxc_var_t* const stats);
+void sbi_reset_stats(void);
+
+void sbi_cleanup(void);
+
 #endif
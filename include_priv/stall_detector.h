@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __stall_detector_h__
+#define __stall_detector_h__
+
+/**
+ * @file stall_detector.h
+ *
+ * Detect when this module blocks the event loop of the tr181-xpon plugin.
+ *
+ * The module runs in the event loop of the plugin, and calls amxb_call() and
+ * system() synchronously. Each entry point (the pon_ctrl functions, the
+ * notification handler, the timers and the constructor) measures how long it
+ * runs. An invocation taking longer than a threshold counts as a stall. The
+ * module keeps the worst stalls, together with the path and the method of the
+ * entry point, and the slowest blocking call made during the stall.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <amxc/amxc_variant.h>
+
+/** Default threshold for a stall */
+#define STALL_DEFAULT_WARN_MS 10
+
+/** Default threshold for a severe stall */
+#define STALL_DEFAULT_SEVERE_MS 100
+
+/** Nr of worst stalls the module keeps */
+#define STALL_N_WORST 8
+
+typedef enum _stall_entry {
+    stall_entry_pon_ctrl = 0,
+    stall_entry_notif_handler,
+    stall_entry_notif_drain,
+    stall_entry_pon_stat_flush,
+    stall_entry_constructor,
+    stall_entry_nr
+} stall_entry_t;
+
+uint64_t stall_detector_begin(void);
+void stall_detector_end(stall_entry_t entry, uint64_t start_us,
+                        const char* const method, const amxc_var_t* const args);
+void stall_detector_note_call(const char* const path, const char* const method,
+                              uint64_t duration_us);
+
+bool stall_detector_set_thresholds(uint32_t warn_ms, uint32_t severe_ms);
+void stall_detector_get_thresholds(amxc_var_t* const thresholds);
+
+void stall_detector_get_stats(amxc_var_t* const stats);
+void stall_detector_reset_stats(void);
+
+#endif
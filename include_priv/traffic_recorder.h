@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#ifndef __traffic_recorder_h__
+#define __traffic_recorder_h__
+
+/**
+ * @file traffic_recorder.h
+ *
+ * Recording of the traffic on the southbound interface to a trace file.
+ *
+ * When recording, the module writes one line per southbound call and per
+ * notification it receives, with their timing, to a trace file. onu_hal_mock
+ * can replay the file: it serves the recorded replies and re-emits the
+ * notifications with the original timing or a scaled version of it. So a
+ * problem seen on a real ONU can be reproduced without PON hardware.
+ *
+ * Format of the trace file: text, one record per line, fields separated by a
+ * tab:
+ *
+ *     C <t_us> <duration_us> <rc> <path> <method> <args> <reply>
+ *     N <t_us> <onu_index> <notification> <data>
+ *
+ * - t_us: time since the start of the recording. For a call, the time the
+ *   call started.
+ * - args, reply, data: comma-separated list of 'key:type:value' with type 's'
+ *   (string), 'i' (signed integer), 'u' (unsigned integer) or 'b' (boolean),
+ *   or '-' if empty. Keys and string values are percent-encoded. Composite
+ *   values are recorded as their string conversion.
+ *
+ * The 'trace_id' argument of a call (see trace_id.h) is not recorded.
+ * Recording is off by default.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <amxc/amxc_variant.h>
+
+bool traffic_recorder_start(const char* const file);
+void traffic_recorder_stop(void);
+bool traffic_recorder_is_active(void);
+
+void traffic_recorder_add_call(const char* const path, const char* const method,
+                               const amxc_var_t* const args, int rc,
+                               const amxc_var_t* const reply,
+                               uint64_t start_us, uint64_t duration_us);
+void traffic_recorder_add_notif(uint32_t onu_index, const char* const notification,
+                                const amxc_var_t* const data);
+
+#endif
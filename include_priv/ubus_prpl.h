@@ -81,11 +81,15 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>  /* FILE */
 
 #include <amxc/amxc_string.h>
 
 bool ubus_prpl_init(void);
 bool ubus_prpl_get_indexes(const char* const prpl_path,
                            amxc_string_t* const indexes);
+bool ubus_prpl_parse_indexes(FILE* const file,
+                             const char* const prpl_path,
+                             amxc_string_t* const indexes);
 
 #endif
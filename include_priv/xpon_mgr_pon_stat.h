@@ -70,8 +70,30 @@
  * tr181-xpon plugin (aka the XPON manager).
  */
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include <amxc/amxc_variant.h>
 
-void xpon_mngr_call_pon_stat_function(const char* const func_name, amxc_var_t* args);
+/** Default max nr of calls the module delivers in one batch */
+#define PON_STAT_BATCH_DEFAULT_MAX_SIZE 64
+
+/** Upper limit for the max nr of calls in one batch */
+#define PON_STAT_BATCH_MAX_SIZE 4096
+
+/** Default batch window: deliver at the next iteration of the event loop */
+#define PON_STAT_BATCH_DEFAULT_WINDOW_MS 0
+
+void xpon_mgr_pon_stat_init(void);
+void xpon_mgr_pon_stat_cleanup(void);
+
+bool xpon_mngr_call_pon_stat_function(const char* const func_name, amxc_var_t* args);
+
+bool xpon_mgr_pon_stat_set_batch_config(bool enable, uint32_t max_batch_size,
+                                        uint32_t window_ms);
+void xpon_mgr_pon_stat_get_batch_config(amxc_var_t* const config);
+
+void xpon_mgr_pon_stat_get_stats(amxc_var_t* const stats);
+void xpon_mgr_pon_stat_reset_stats(void);
 
 #endif
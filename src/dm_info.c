@@ -62,92 +62,93 @@
 
 #include "dm_info.h"
 
-#include <string.h> /* strncmp() */
+#include <string.h> /* strncmp(), strlen() */
 
 #include <amxc/amxc.h>
 #include <amxc/amxc_macros.h>
 
 #include "mod_xpon_macros.h" /* ARRAY_SIZE() */
 #include "mod_xpon_trace.h"
+#include "string_pool.h"     /* string_pool_add_static() */
 
 static const param_info_t ONU_PARAMS[] = {
-    { .bbf_name = "Enable", .prpl_name = "enable", .type = AMXC_VAR_ID_BOOL    },
-    { .bbf_name = "Version", .prpl_name = "version", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "EquipmentID", .prpl_name = "equipment_id", .type = AMXC_VAR_ID_CSTRING }
+    { .bbf_name = "Enable", .prpl_name = "enable", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "Version", .prpl_name = "version", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "EquipmentID", .prpl_name = "equipment_id", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable }
 };
 
 static const param_info_t SOFTWARE_IMAGE_PARAMS[] = {
-    { .bbf_name = "Version", .prpl_name = "version", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "IsCommitted", .prpl_name = "is_committed", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "IsActive", .prpl_name = "is_active", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "IsValid", .prpl_name = "is_valid", .type = AMXC_VAR_ID_BOOL }
+    { .bbf_name = "Version", .prpl_name = "version", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "IsCommitted", .prpl_name = "is_committed", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "IsActive", .prpl_name = "is_active", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "IsValid", .prpl_name = "is_valid", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable }
 };
 
 static const param_info_t ETHERNET_UNI_PARAMS[] = {
-    { .bbf_name = "Enable", .prpl_name = "enable", .type = AMXC_VAR_ID_BOOL       },
-    { .bbf_name = "Status", .prpl_name = "status", .type = AMXC_VAR_ID_CSTRING    },
-    { .bbf_name = "LastChange", .prpl_name = "last_change", .type = AMXC_VAR_ID_UINT32     },
-    { .bbf_name = "ANIs", .prpl_name = "ani_list", .type = AMXC_VAR_ID_CSV_STRING },
-    { .bbf_name = "InterdomainID", .prpl_name = "interdomain_id", .type = AMXC_VAR_ID_CSTRING    },
-    { .bbf_name = "InterdomainName", .prpl_name = "interdomain_name", .type = AMXC_VAR_ID_CSTRING    },
+    { .bbf_name = "Enable", .prpl_name = "enable", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "Status", .prpl_name = "status", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "LastChange", .prpl_name = "last_change", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_volatile },
+    { .bbf_name = "ANIs", .prpl_name = "ani_list", .type = AMXC_VAR_ID_CSV_STRING, .volatility = param_volatility_stable },
+    { .bbf_name = "InterdomainID", .prpl_name = "interdomain_id", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "InterdomainName", .prpl_name = "interdomain_name", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
 };
 
 static const param_info_t ANI_PARAMS[] = {
-    { .bbf_name = "Enable", .prpl_name = "enable", .type = AMXC_VAR_ID_BOOL    },
-    { .bbf_name = "Status", .prpl_name = "status", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "LastChange", .prpl_name = "last_change", .type = AMXC_VAR_ID_UINT32  },
-    { .bbf_name = "PONMode", .prpl_name = "pon_mode", .type = AMXC_VAR_ID_CSTRING }
+    { .bbf_name = "Enable", .prpl_name = "enable", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "Status", .prpl_name = "status", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "LastChange", .prpl_name = "last_change", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_volatile },
+    { .bbf_name = "PONMode", .prpl_name = "pon_mode", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable }
 };
 
 static const param_info_t GEM_PORT_PARAMS[] = {
-    { .bbf_name = "Direction", .prpl_name = "direction", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "PortType", .prpl_name = "port_type", .type = AMXC_VAR_ID_CSTRING }
+    { .bbf_name = "Direction", .prpl_name = "direction", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "PortType", .prpl_name = "port_type", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable }
 };
 
 static const param_info_t TRANSCEIVER_PARAMS[] = {
-    { .bbf_name = "Identifier", .prpl_name = "identifier", .type = AMXC_VAR_ID_UINT32  },
-    { .bbf_name = "VendorName", .prpl_name = "vendor_name", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "VendorPartNumber", .prpl_name = "vendor_part_number", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "VendorRevision", .prpl_name = "vendor_revision", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "PONMode", .prpl_name = "pon_mode", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "Connector", .prpl_name = "connector", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "NominalBitRateDownstream", .prpl_name = "nominal_bit_rate_downstream", .type = AMXC_VAR_ID_UINT32  },
-    { .bbf_name = "NominalBitRateUpstream", .prpl_name = "nominal_bit_rate_upstream", .type = AMXC_VAR_ID_UINT32  },
-    { .bbf_name = "RxPower", .prpl_name = "rx_power", .type = AMXC_VAR_ID_INT32   },
-    { .bbf_name = "TxPower", .prpl_name = "tx_power", .type = AMXC_VAR_ID_INT32   },
-    { .bbf_name = "Voltage", .prpl_name = "voltage", .type = AMXC_VAR_ID_UINT32  },
-    { .bbf_name = "Bias", .prpl_name = "bias", .type = AMXC_VAR_ID_UINT32  },
-    { .bbf_name = "Temperature", .prpl_name = "temperature", .type = AMXC_VAR_ID_INT32   }
+    { .bbf_name = "Identifier", .prpl_name = "identifier", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_stable },
+    { .bbf_name = "VendorName", .prpl_name = "vendor_name", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "VendorPartNumber", .prpl_name = "vendor_part_number", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "VendorRevision", .prpl_name = "vendor_revision", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "PONMode", .prpl_name = "pon_mode", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "Connector", .prpl_name = "connector", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "NominalBitRateDownstream", .prpl_name = "nominal_bit_rate_downstream", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_stable },
+    { .bbf_name = "NominalBitRateUpstream", .prpl_name = "nominal_bit_rate_upstream", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_stable },
+    { .bbf_name = "RxPower", .prpl_name = "rx_power", .type = AMXC_VAR_ID_INT32, .volatility = param_volatility_volatile },
+    { .bbf_name = "TxPower", .prpl_name = "tx_power", .type = AMXC_VAR_ID_INT32, .volatility = param_volatility_volatile },
+    { .bbf_name = "Voltage", .prpl_name = "voltage", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_volatile },
+    { .bbf_name = "Bias", .prpl_name = "bias", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_volatile },
+    { .bbf_name = "Temperature", .prpl_name = "temperature", .type = AMXC_VAR_ID_INT32, .volatility = param_volatility_volatile }
 };
 
 static const param_info_t ONU_ACTIVATION_PARAMS[] = {
-    { .bbf_name = "ONUState", .prpl_name = "onu_state", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "VendorID", .prpl_name = "vendor_id", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "SerialNumber", .prpl_name = "serial_number", .type = AMXC_VAR_ID_CSTRING },
-    { .bbf_name = "ONUID", .prpl_name = "onu_id", .type = AMXC_VAR_ID_UINT32  }
+    { .bbf_name = "ONUState", .prpl_name = "onu_state", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "VendorID", .prpl_name = "vendor_id", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "SerialNumber", .prpl_name = "serial_number", .type = AMXC_VAR_ID_CSTRING, .volatility = param_volatility_stable },
+    { .bbf_name = "ONUID", .prpl_name = "onu_id", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_stable }
 };
 
 static const param_info_t PERFORMANCE_THRESHOLDS_PARAMS[] = {
-    { .bbf_name = "SignalFail", .prpl_name = "signal_fail", .type = AMXC_VAR_ID_UINT32 },
-    { .bbf_name = "SignalDegrade", .prpl_name = "signal_degrade", .type = AMXC_VAR_ID_UINT32 }
+    { .bbf_name = "SignalFail", .prpl_name = "signal_fail", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_stable },
+    { .bbf_name = "SignalDegrade", .prpl_name = "signal_degrade", .type = AMXC_VAR_ID_UINT32, .volatility = param_volatility_stable }
 };
 
 static const param_info_t TC_ALARMS_PARAMS[] = {
-    { .bbf_name = "LOS", .prpl_name = "los", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "LOF", .prpl_name = "lof", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "SF", .prpl_name = "sf", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "SD", .prpl_name = "sd", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "LCDG", .prpl_name = "lcdg", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "TF", .prpl_name = "tf", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "SUF", .prpl_name = "suf", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "MEM", .prpl_name = "mem", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "DACT", .prpl_name = "dact", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "DIS", .prpl_name = "dis", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "MIS", .prpl_name = "mis", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "PEE", .prpl_name = "pee", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "RDI", .prpl_name = "rdi", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "LODS", .prpl_name = "lods", .type = AMXC_VAR_ID_BOOL },
-    { .bbf_name = "ROGUE", .prpl_name = "rogue", .type = AMXC_VAR_ID_BOOL }
+    { .bbf_name = "LOS", .prpl_name = "los", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "LOF", .prpl_name = "lof", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "SF", .prpl_name = "sf", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "SD", .prpl_name = "sd", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "LCDG", .prpl_name = "lcdg", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "TF", .prpl_name = "tf", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "SUF", .prpl_name = "suf", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "MEM", .prpl_name = "mem", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "DACT", .prpl_name = "dact", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "DIS", .prpl_name = "dis", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "MIS", .prpl_name = "mis", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "PEE", .prpl_name = "pee", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "RDI", .prpl_name = "rdi", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "LODS", .prpl_name = "lods", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable },
+    { .bbf_name = "ROGUE", .prpl_name = "rogue", .type = AMXC_VAR_ID_BOOL, .volatility = param_volatility_stable }
 };
 
 /**
@@ -260,10 +261,69 @@ static const struct bbf_vs_prpl_entry BBF_vs_PRPL_ENTRIES[] = {
     { .bbf_name = "Alarms", .prpl_name = "alarms" }
 };
 
+/* Nr of params in all tables */
+#define N_PARAMS_TOTAL (ARRAY_SIZE(ONU_PARAMS) + ARRAY_SIZE(SOFTWARE_IMAGE_PARAMS) + \
+                        ARRAY_SIZE(ETHERNET_UNI_PARAMS) + ARRAY_SIZE(ANI_PARAMS) + \
+                        ARRAY_SIZE(GEM_PORT_PARAMS) + ARRAY_SIZE(TRANSCEIVER_PARAMS) + \
+                        ARRAY_SIZE(ONU_ACTIVATION_PARAMS) + \
+                        ARRAY_SIZE(PERFORMANCE_THRESHOLDS_PARAMS) + \
+                        ARRAY_SIZE(TC_ALARMS_PARAMS))
+
+/* Pooled names of a param: the pointers the string pool has for its names */
+typedef struct _pooled_names {
+    const char* bbf_name;
+    const char* prpl_name;
+} pooled_names_t;
+
+/**
+ * Pooled names of the params of all objects. The ones of the params of
+ * OBJECT_INFO[id] start at index s_pooled_offset[id], in the same order as
+ * OBJECT_INFO[id].params. dm_info_init() fills them in.
+ */
+static pooled_names_t s_pooled_names[N_PARAMS_TOTAL];
+static uint32_t s_pooled_offset[obj_id_nbr];
+
+/* True if dm_info_init() filled in s_pooled_names */
+static bool s_names_pooled = false;
+
+/**
+ * Add the key and param names of all objects to the string pool, and fill in
+ * s_pooled_names.
+ */
+static bool add_names_to_string_pool(void) {
+
+    bool rv = true;
+    unsigned int i;
+    uint32_t j;
+    uint32_t offset = 0;
+
+    for(i = 0; i < obj_id_nbr; ++i) {
+        const object_info_t* const info = &OBJECT_INFO[i];
+        if(info->bbf_key_name) {
+            rv = (string_pool_add_static(info->bbf_key_name) != NULL) && rv;
+            rv = (string_pool_add_static(info->prpl_key_name) != NULL) && rv;
+        }
+        if(offset + info->n_params > N_PARAMS_TOTAL) {
+            SAH_TRACEZ_ERROR(ME, "OBJECT_INFO[%u]: too many params", i);
+            return false;
+        }
+        s_pooled_offset[i] = offset;
+        for(j = 0; j < info->n_params; ++j) {
+            pooled_names_t* const names = &s_pooled_names[offset + j];
+            names->bbf_name = string_pool_add_static(info->params[j].bbf_name);
+            names->prpl_name = string_pool_add_static(info->params[j].prpl_name);
+            rv = (names->bbf_name != NULL) && (names->prpl_name != NULL) && rv;
+        }
+        offset += info->n_params;
+    }
+    return rv;
+}
+
 /**
  * Initialize the dm_info part.
  *
- * The function only runs a sanity check on the OBJECT_INFO array.
+ * The function runs a sanity check on the OBJECT_INFO array, and adds the
+ * key and param names to the string pool.
  *
  * The module must call this function once at startup.
  *
@@ -278,6 +338,11 @@ bool dm_info_init(void) {
             return false;
         }
     }
+    if(!add_names_to_string_pool()) {
+        SAH_TRACEZ_ERROR(ME, "Failed to add names to string pool");
+        return false;
+    }
+    s_names_pooled = true;
     return true;
 }
 
@@ -432,6 +497,55 @@ bool dm_get_object_param_info(object_id_t id, const param_info_t** param_info,
     return false;
 }
 
+/**
+ * Return the info about the param of object @a id whose prpl name (or BBF
+ * name if @a prpl is false) equals the first @a len chars of @a name, or NULL
+ * if the object has no such param.
+ *
+ * The function looks up @a name in the string pool once, and then only
+ * compares pointers with the pooled names of the params. The caller must
+ * have called dm_info_init().
+ */
+static const param_info_t* find_param_info(object_id_t id, const char* const name, size_t len,
+                                           bool prpl) {
+
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t i;
+
+    when_null(name, exit);
+    when_false_trace(s_names_pooled, exit, ERROR, "dm_info_init() was not called");
+    when_false(dm_get_object_param_info(id, &params, &n_params), exit);
+
+    const char* const pooled = string_pool_lookup(name, len);
+    when_null(pooled, exit); /* no table has this name */
+
+    const pooled_names_t* const names = &s_pooled_names[s_pooled_offset[id]];
+    for(i = 0; i < n_params; ++i) {
+        if((prpl ? names[i].prpl_name : names[i].bbf_name) == pooled) {
+            return &params[i];
+        }
+    }
+
+exit:
+    return NULL;
+}
+
+/**
+ * Return the info about the param of object @a id with prpl name @a name.
+ *
+ * @param[in] id    object ID
+ * @param[in] name  prpl param name. It does not need to be null-terminated:
+ *                  the function only looks at its first @a len chars.
+ * @param[in] len   length of the name
+ *
+ * @return the param info, or NULL if the object has no such param
+ */
+const param_info_t* dm_get_param_info_by_prpl_name(object_id_t id, const char* const name,
+                                                   size_t len) {
+    return find_param_info(id, name, len, /*prpl=*/ true);
+}
+
 static bool convert_path_between_bbf_and_prpl(const char* const input,
                                               amxc_string_t* const output,
                                               bool bbf_to_prpl) {
@@ -612,21 +726,11 @@ bool dm_convert_param_names(object_id_t id,
         return false;
     }
 
-    const param_info_t* param_info;
-    uint32_t n_params;
-
-    if(!dm_get_object_param_info(id, &param_info, &n_params)) {
-        SAH_TRACEZ_ERROR(ME, "Failed to get info about params of object with ID=%d", id);
-        return false;
-    }
-    uint32_t i;
-    for(i = 0; i < n_params; ++i) {
-        if(strncmp(bbf_param_names, param_info[i].bbf_name,
-                   strlen(param_info[i].bbf_name)) == 0) {
-            amxc_string_set(prpl_param_names, param_info[i].prpl_name);
-            rv = true;
-            break;
-        }
+    const param_info_t* const param_info =
+        find_param_info(id, bbf_param_names, strlen(bbf_param_names), /*prpl=*/ false);
+    if(param_info != NULL) {
+        amxc_string_set(prpl_param_names, param_info->prpl_name);
+        rv = true;
     }
     if(!rv) {
         SAH_TRACEZ_ERROR(ME, "Failed to convert '%s'", bbf_param_names);
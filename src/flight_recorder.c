@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "flight_recorder.h"
+
+#include <string.h> /* memset() */
+
+#include <amxc/amxc_macros.h> /* when_null() */
+
+#include "dm_info.h"       /* dm_get_object_info() */
+#include "latency_stats.h" /* latency_now_us() */
+#include "mod_xpon_trace.h"
+#include "trace_id.h"      /* trace_id_current() */
+
+static const char* const FR_OP_NAMES[fr_op_nr] = {
+    "sbi_enable",
+    "sbi_disable",
+    "sbi_get",
+    "sbi_get_params",
+    "notif_instance_added",
+    "notif_instance_removed",
+    "notif_object_changed",
+    "notif_reset_mib",
+    "notif_resync",
+    "pon_ctrl_request",
+    "span_path_translation",
+    "span_conversion"
+};
+
+static fr_record_t s_ring[FLIGHT_RECORDER_SIZE];
+static uint64_t s_n_records = 0; /* nr of records ever added */
+
+/**
+ * Add a record to the ring.
+ *
+ * @param[in] op           operation
+ * @param[in] obj_id       object_id_t of the object the operation was about
+ * @param[in] onu_index    xpon_onu instance index, or 0 if unknown
+ * @param[in] duration_us  how long the operation took
+ * @param[in] rc           0 on success, else a negative error code
+ */
+void flight_recorder_add(fr_op_t op, uint32_t obj_id, uint32_t onu_index,
+                         uint64_t duration_us, int32_t rc) {
+
+    fr_record_t* const record = &s_ring[s_n_records % FLIGHT_RECORDER_SIZE];
+
+    record->ts_us = latency_now_us();
+    record->trace_id = trace_id_current();
+    record->duration_us = (duration_us > UINT32_MAX) ? UINT32_MAX : (uint32_t) duration_us;
+    record->rc = rc;
+    record->onu_index = (onu_index > UINT16_MAX) ? UINT16_MAX : (uint16_t) onu_index;
+    record->op = (uint8_t) op;
+    record->obj_id = (obj_id > UINT8_MAX) ? UINT8_MAX : (uint8_t) obj_id;
+    ++s_n_records;
+}
+
+/**
+ * Add the records in the ring to a list variant, the oldest one first.
+ *
+ * @param[in,out] records  list. The function adds an htable per record with
+ *                         the keys 'ts_us', 'trace_id', 'op', 'object',
+ *                         'onu_index', 'duration_us' and 'rc'. 'object' is the generic
+ *                         BBF path of the object, or "unknown".
+ */
+void flight_recorder_dump(amxc_var_t* const records) {
+
+    uint64_t i;
+
+    when_null(records, exit);
+
+    const uint64_t first = (s_n_records > FLIGHT_RECORDER_SIZE) ?
+        (s_n_records - FLIGHT_RECORDER_SIZE) : 0;
+
+    for(i = first; i < s_n_records; ++i) {
+        const fr_record_t* const record = &s_ring[i % FLIGHT_RECORDER_SIZE];
+        /* dm_get_object_info() logs an error for obj_id_unknown */
+        const object_info_t* const info = (record->obj_id < obj_id_nbr) ?
+            dm_get_object_info((object_id_t) record->obj_id) : NULL;
+
+        amxc_var_t* const var = amxc_var_add(amxc_htable_t, records, NULL);
+        when_null(var, exit);
+        amxc_var_add_key(uint64_t, var, "ts_us", record->ts_us);
+        amxc_var_add_key(uint32_t, var, "trace_id", record->trace_id);
+        amxc_var_add_key(cstring_t, var, "op",
+                         (record->op < fr_op_nr) ? FR_OP_NAMES[record->op] : "unknown");
+        amxc_var_add_key(cstring_t, var, "object", info ? info->bbf_path : "unknown");
+        amxc_var_add_key(uint32_t, var, "onu_index", record->onu_index);
+        amxc_var_add_key(uint32_t, var, "duration_us", record->duration_us);
+        amxc_var_add_key(int32_t, var, "rc", record->rc);
+    }
+
+exit:
+    return;
+}
+
+void flight_recorder_clear(void) {
+    memset(s_ring, 0, sizeof(s_ring));
+    s_n_records = 0;
+}
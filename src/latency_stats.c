@@ -0,0 +1,194 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+/**
+ * Define _POSIX_C_SOURCE to avoid following error:
+ * implicit declaration of function ‘clock_gettime’
+ */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "latency_stats.h"
+
+#include <string.h> /* memset() */
+#include <time.h>   /* clock_gettime() */
+
+#include <amxc/amxc_macros.h> /* when_null() */
+
+#include "mod_xpon_trace.h"
+
+/**
+ * Return the time of the monotonic clock in microseconds.
+ *
+ * Only use the return value to calculate durations.
+ */
+uint64_t latency_now_us(void) {
+
+    struct timespec ts;
+    if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return ((uint64_t) ts.tv_sec * 1000000) + ((uint64_t) ts.tv_nsec / 1000);
+}
+
+static inline uint32_t bucket_index(uint64_t duration_us) {
+
+    if(0 == duration_us) {
+        return 0;
+    }
+    /* nr of significant bits: 1 for 1 us, 2 for [2, 4) us, ... */
+    const uint32_t index = 64 - (uint32_t) __builtin_clzll(duration_us);
+    return (index < LATENCY_STATS_N_BUCKETS) ? index : (LATENCY_STATS_N_BUCKETS - 1);
+}
+
+/**
+ * Add a sample to the statistics.
+ *
+ * @param[in,out] stats    statistics to update
+ * @param[in] duration_us  how long something took in microseconds
+ */
+void latency_stats_add(latency_stats_t* const stats, uint64_t duration_us) {
+
+    when_null(stats, exit);
+
+    ++stats->count;
+    stats->total_us += duration_us;
+    if(duration_us > stats->max_us) {
+        stats->max_us = duration_us;
+    }
+    ++stats->buckets[bucket_index(duration_us)];
+
+exit:
+    return;
+}
+
+/**
+ * Add a sample of an operation which can fail to the statistics.
+ *
+ * @param[in,out] stats    statistics to update
+ * @param[in] duration_us  how long the operation took in microseconds
+ * @param[in] success      false if the operation failed
+ */
+void latency_stats_add_result(latency_stats_t* const stats, uint64_t duration_us,
+                              bool success) {
+
+    when_null(stats, exit);
+
+    latency_stats_add(stats, duration_us);
+    if(!success) {
+        ++stats->errors;
+    }
+
+exit:
+    return;
+}
+
+void latency_stats_reset(latency_stats_t* const stats) {
+
+    when_null(stats, exit);
+    memset(stats, 0, sizeof(latency_stats_t));
+
+exit:
+    return;
+}
+
+/**
+ * Add the statistics to an htable variant.
+ *
+ * @param[in] stats    statistics
+ * @param[in,out] var  htable. The function adds the keys 'count', 'errors',
+ *                     'avg_us', 'max_us', 'total_us' and 'histogram' to it.
+ *
+ * 'histogram' is a list with an htable per non-empty bucket. Each htable has
+ * the keys 'ge_us' (lower bound of the bucket) and 'count'.
+ */
+void latency_stats_to_var(const latency_stats_t* const stats, amxc_var_t* const var) {
+
+    when_null(stats, exit);
+    when_null(var, exit);
+
+    const uint64_t avg_us = stats->count ? (stats->total_us / stats->count) : 0;
+
+    amxc_var_add_key(uint64_t, var, "count", stats->count);
+    amxc_var_add_key(uint64_t, var, "avg_us", avg_us);
+    amxc_var_add_key(uint64_t, var, "max_us", stats->max_us);
+    amxc_var_add_key(uint64_t, var, "total_us", stats->total_us);
+    amxc_var_add_key(uint64_t, var, "errors", stats->errors);
+
+    amxc_var_t* const histogram = amxc_var_add_key(amxc_llist_t, var, "histogram", NULL);
+    when_null(histogram, exit);
+
+    uint32_t i;
+    for(i = 0; i < LATENCY_STATS_N_BUCKETS; ++i) {
+        if(0 == stats->buckets[i]) {
+            continue;
+        }
+        amxc_var_t* const bucket = amxc_var_add(amxc_htable_t, histogram, NULL);
+        const uint64_t ge_us = (0 == i) ? 0 : (1ULL << (i - 1));
+        amxc_var_add_key(uint64_t, bucket, "ge_us", ge_us);
+        amxc_var_add_key(uint32_t, bucket, "count", stats->buckets[i]);
+    }
+
+exit:
+    return;
+}
@@ -63,10 +63,16 @@
 #include <amxc/amxc.h> /* to satisfy include of amxm/amxm.h */
 #include <amxm/amxm.h> /* AMXM_CONSTRUCTOR */
 
-#include "dm_info.h"   /* dm_info_init() */
-#include "notif.h"     /* notif_init() */
-#include "pon_ctrl.h"  /* pon_ctrl_init() */
-#include "ubus_prpl.h" /* ubus_prpl_init() */
+#include "dm_info.h"           /* dm_info_init() */
+#include "notif.h"             /* notif_init() */
+#include "pon_ctrl.h"          /* pon_ctrl_init() */
+#include "shadow_mirror.h"     /* shadow_mirror_cleanup() */
+#include "southbound_if.h"     /* sbi_cleanup() */
+#include "stall_detector.h"    /* stall_detector_begin() */
+#include "string_pool.h"       /* string_pool_cleanup() */
+#include "traffic_recorder.h"  /* traffic_recorder_stop() */
+#include "ubus_prpl.h"         /* ubus_prpl_init() */
+#include "xpon_mgr_pon_stat.h" /* xpon_mgr_pon_stat_init() */
 
 #include "mod_xpon_trace.h"
 
@@ -79,13 +85,18 @@
 static AMXM_CONSTRUCTOR mod_xpon_prpl_start(void) {
 
     int rc = -1;
+    const uint64_t start_us = stall_detector_begin();
 
     SAH_TRACEZ_INFO(ME, "start");
 
     if(!dm_info_init()) {
         goto exit;
     }
-    notif_init();
+    xpon_mgr_pon_stat_init();
+
+    if(!notif_init()) {
+        goto exit;
+    }
 
     if(!pon_ctrl_init()) {
         goto exit;
@@ -98,6 +109,7 @@ static AMXM_CONSTRUCTOR mod_xpon_prpl_start(void) {
     rc = 0; /* success */
 
 exit:
+    stall_detector_end(stall_entry_constructor, start_us, "start", NULL);
     return rc;
 }
 
@@ -112,6 +124,11 @@ static AMXM_DESTRUCTOR mod_xpon_prpl_stop(void) {
     SAH_TRACEZ_INFO(ME, "stop");
     pon_ctrl_cleanup();
     notif_cleanup();
+    sbi_cleanup();
+    shadow_mirror_cleanup();
+    string_pool_cleanup();
+    xpon_mgr_pon_stat_cleanup();
+    traffic_recorder_stop();
     return 0;
 }
 
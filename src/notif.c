@@ -63,22 +63,95 @@
 #include "notif.h"
 
 #include <stdio.h>
+#include <stdlib.h>           /* calloc(), free() */
 #include <string.h>
 #include <unistd.h>           /* STDOUT_FILENO */
 
 #include <amxc/amxc_macros.h> /* UNUSED */
-#include <amxb/amxb_subscribe.h>
 
 #include "dm_info.h"           /* dm_convert_prpl_path_to_bbf_path() */
+#include "flight_recorder.h"   /* flight_recorder_add() */
+#include "latency_stats.h"     /* latency_now_us() */
 #include "mod_xpon_macros.h"   /* ARRAY_SIZE() */
 #include "mod_xpon_trace.h"
-#include "object_utils.h"      /* obj_process_object_params() */
-#include "southbound_if.h"     /* sbi_query_object() */
+#include "notif_queue.h"       /* notif_queue_push() */
+#include "shadow_mirror.h"     /* shadow_mirror_update() */
+#include "southbound_if.h"     /* sbi_get_object_content(), sbi_forget_object() */
+#include "stall_detector.h"    /* stall_detector_begin() */
+#include "trace_id.h"          /* trace_id_new() */
+#include "traffic_recorder.h"  /* traffic_recorder_add_notif() */
 #include "xpon_mgr_pon_stat.h" /* xpon_mngr_call_pon_stat_function() */
 
 static amxb_bus_ctx_t* s_bus_ctx = NULL;
 
-typedef void (* handle_notification_fn_t) (uint32_t onu_index, const amxc_var_t* const data);
+/**
+ * Stages of the notification pipeline.
+ *
+ * - receive: notif_handler() checking a notification and adding it to a queue
+ * - requery: calling get() on the ONU HAL agent to get the info missing in
+ *   the notification, and converting the params to the BBF XPON DM
+ * - convert: converting the path to the BBF XPON DM, and building the
+ *   arguments for pon_stat
+ * - forward: calling the function in the 'pon_stat' namespace
+ * - end_to_end: from adding the notification to a queue until forward is done
+ */
+typedef enum _notif_stage {
+    notif_stage_receive = 0,
+    notif_stage_requery,
+    notif_stage_convert,
+    notif_stage_forward,
+    notif_stage_end_to_end,
+    notif_stage_nr
+} notif_stage_t;
+
+static const char* const NOTIF_STAGE_NAMES[notif_stage_nr] = {
+    "receive",
+    "requery",
+    "convert",
+    "forward",
+    "end_to_end"
+};
+
+/* Outcome of handling a notification taken from a queue */
+typedef enum _notif_outcome {
+    notif_outcome_forwarded = 0,
+    notif_outcome_invalid,
+    notif_outcome_requery_failed,
+    notif_outcome_conversion_failed,
+    notif_outcome_forward_failed,
+    notif_outcome_nr
+} notif_outcome_t;
+
+static const char* const NOTIF_OUTCOME_NAMES[notif_outcome_nr] = {
+    "forwarded",
+    "invalid",
+    "requery_failed",
+    "conversion_failed",
+    "forward_failed"
+};
+
+/**
+ * Result of handling a notification, filled in by the handler.
+ *
+ * A handler only sets the bit of a stage in 'stages' if it went through that
+ * stage. It only sets 'id' if it had to find out the object ID anyway.
+ */
+typedef struct _notif_sample {
+    notif_outcome_t outcome;
+    object_id_t id;  /* object the notification is about, if known */
+    uint32_t stages; /* bit mask: 1 << notif_stage_t */
+    uint64_t duration_us[notif_stage_nr];
+} notif_sample_t;
+
+static inline void sample_set_stage(notif_sample_t* const sample, notif_stage_t stage,
+                                    uint64_t duration_us) {
+    sample->stages |= (1U << stage);
+    sample->duration_us[stage] = duration_us;
+}
+
+typedef void (* handle_notification_fn_t) (uint32_t onu_index,
+                                           const amxc_var_t* const data,
+                                           notif_sample_t* const sample);
 
 typedef enum _dm_notification {
     notif_dm_instance_added = 0,
@@ -88,11 +161,27 @@ typedef enum _dm_notification {
 } dm_notification_t;
 
 typedef struct _subscription_info {
+    amxc_llist_it_t it;  /* in s_active_onus */
     uint32_t onu_index;
     bool subscribed;
+    notif_queue_t queue;        /* notifications waiting to be processed */
+    amxc_llist_t resync_steps;  /* resync_step_t entries, see resync_onu() */
 } subscription_info_t;
 
-static subscription_info_t s_subscription_info[MAX_NR_OF_ONUS];
+/**
+ * Table with an entry per xpon_onu instance index.
+ *
+ * The element at position 'i' points to the subscription info of the ONU with
+ * index 'i + 1', or is NULL if the module did not subscribe on that ONU. The
+ * module allocates the subscription info of an ONU when subscribing on it.
+ * The size of the table is the max nr of ONUs, which the tr181-xpon plugin
+ * sets with set_max_nr_of_onus().
+ */
+static subscription_info_t** s_onu_table = NULL;
+static uint32_t s_max_nr_of_onus = 0;
+
+/* subscription_info_t entries of the ONUs the module subscribed on */
+static amxc_llist_t s_active_onus;
 
 static const char* dm_notification_to_xpon_mgr_func_name(dm_notification_t notif) {
 
@@ -131,9 +220,17 @@ static const char* dm_notification_to_xpon_mgr_func_name(dm_notification_t notif
  * Then it calls the function in the 'pon_stat' namespace of the tr181-xpon
  * plugin corresponding to the notification type, passing the variant as
  * argument.
+ *
+ * The function reports the outcome and the duration of each stage via
+ * @a sample.
  */
 static void handle_dm_notification(dm_notification_t notif,
-                                   const amxc_var_t* const data) {
+                                   const amxc_var_t* const data,
+                                   notif_sample_t* const sample) {
+
+    const uint64_t start_us = latency_now_us();
+    uint64_t requery_us = 0;
+    sample->outcome = notif_outcome_invalid;
 
     when_null_trace(data, exit, ERROR, "data is NULL");
     when_null_trace(s_bus_ctx, exit, ERROR, "No bus context");
@@ -156,15 +253,14 @@ static void handle_dm_notification(dm_notification_t notif,
 
     amxc_string_t bbf_path;
     amxc_string_t prpl_path;
-    amxc_var_t params; /* params of the prpl object */
     /* args for dm_instance_added(), dm_instance_removed() or dm_object_changed() call */
     amxc_var_t args;
 
     amxc_string_init(&bbf_path, 0);
     amxc_string_init(&prpl_path, 0);
-    amxc_var_init(&params);
     amxc_var_init(&args);
 
+    sample->outcome = notif_outcome_conversion_failed;
     if(!dm_convert_prpl_path_to_bbf_path(path, &bbf_path)) {
         SAH_TRACEZ_ERROR(ME, "Failed to convert '%s' to bbf path", path);
         goto exit_clean;
@@ -178,23 +274,24 @@ static void handle_dm_notification(dm_notification_t notif,
             SAH_TRACEZ_ERROR(ME, "Failed to get ID for path '%s'", path);
             goto exit_clean;
         }
+        sample->id = id;
 
         amxc_string_set(&prpl_path, path);
         if(notif_dm_instance_added == notif) {
             amxc_string_appendf(&prpl_path, ".%d", index);
         }
 
-        if(!sbi_query_object(s_bus_ctx, &prpl_path, &params)) {
-            SAH_TRACEZ_ERROR(ME, "Failed to query %s", amxc_string_get(&prpl_path, 0));
-            goto exit_clean;
-        }
-
         const bool extract_key = (notif_dm_instance_added == notif);
-
-        if(!obj_process_object_params(id, &params, extract_key, &args,
-                                      amxc_string_get(&prpl_path, 0))) {
+        const uint64_t requery_start_us = latency_now_us();
+        const bool queried = sbi_get_object_content(s_bus_ctx, id, &prpl_path, extract_key, &args);
+        requery_us = latency_now_us() - requery_start_us;
+        sample_set_stage(sample, notif_stage_requery, requery_us);
+        if(!queried) {
+            SAH_TRACEZ_ERROR(ME, "Failed to query %s", amxc_string_get(&prpl_path, 0));
+            sample->outcome = notif_outcome_requery_failed;
             goto exit_clean;
         }
+        shadow_mirror_update(id, amxc_string_get(&prpl_path, 0), &args, extract_key);
     } else {
         amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
     }
@@ -211,14 +308,20 @@ static void handle_dm_notification(dm_notification_t notif,
         }
     }
 
+    const uint64_t forward_start_us = latency_now_us();
+    const uint64_t convert_us = forward_start_us - start_us - requery_us;
+    sample_set_stage(sample, notif_stage_convert, convert_us);
+    flight_recorder_add(fr_op_span_conversion, sample->id, 0, convert_us, 0);
+
     /* Function name to call towards XPON manager */
     const char* const func_name = dm_notification_to_xpon_mgr_func_name(notif);
-    xpon_mngr_call_pon_stat_function(func_name, &args);
+    sample->outcome = xpon_mngr_call_pon_stat_function(func_name, &args) ?
+        notif_outcome_forwarded : notif_outcome_forward_failed;
+    sample_set_stage(sample, notif_stage_forward, latency_now_us() - forward_start_us);
 
 exit_clean:
     amxc_string_clean(&bbf_path);
     amxc_string_clean(&prpl_path);
-    amxc_var_clean(&params);
     amxc_var_clean(&args);
 
 exit:
@@ -231,9 +334,37 @@ exit:
  *
  * @param[in] data   should contain the 'path' and the 'index' of the instance added
  */
-static void handle_dm_instance_added(UNUSED uint32_t onu_index, const amxc_var_t* const data) {
+static void handle_dm_instance_added(UNUSED uint32_t onu_index, const amxc_var_t* const data,
+                                     notif_sample_t* const sample) {
 
-    handle_dm_notification(notif_dm_instance_added, data);
+    handle_dm_notification(notif_dm_instance_added, data, sample);
+}
+
+/**
+ * Let the southbound backend and the mirror drop what they keep for a
+ * removed instance.
+ *
+ * @param[in] data   should contain the 'path' and the 'index' of the instance removed
+ */
+static void forget_removed_instance(const amxc_var_t* const data) {
+
+    const char* const path = GETP_CHAR(data, "path");
+    const uint32_t index = GETP_UINT32(data, "index");
+    amxc_string_t instance;
+
+    when_null(path, exit);
+    when_true(0 == index, exit);
+
+    amxc_string_init(&instance, 0);
+    /* 'path' may end with a dot: the backend wants a path without one */
+    amxc_string_setf(&instance, "%s%s%u", path,
+                     (path[0] != '\0') && (path[strlen(path) - 1] == '.') ? "" : ".", index);
+    sbi_forget_object(amxc_string_get(&instance, 0));
+    shadow_mirror_forget(amxc_string_get(&instance, 0));
+    amxc_string_clean(&instance);
+
+exit:
+    return;
 }
 
 /**
@@ -241,9 +372,11 @@ static void handle_dm_instance_added(UNUSED uint32_t onu_index, const amxc_var_t
  *
  * @param[in] data   should contain the 'path' and the 'index' of the instance removed
  */
-static void handle_dm_instance_removed(UNUSED uint32_t onu_index, const amxc_var_t* const data) {
+static void handle_dm_instance_removed(UNUSED uint32_t onu_index, const amxc_var_t* const data,
+                                       notif_sample_t* const sample) {
 
-    handle_dm_notification(notif_dm_instance_removed, data);
+    forget_removed_instance(data);
+    handle_dm_notification(notif_dm_instance_removed, data, sample);
 }
 
 /**
@@ -251,9 +384,10 @@ static void handle_dm_instance_removed(UNUSED uint32_t onu_index, const amxc_var
  *
  * @param[in] data   should contain the 'path' of the object changed
  */
-static void handle_dm_object_changed(UNUSED uint32_t onu_index, const amxc_var_t* const data) {
+static void handle_dm_object_changed(UNUSED uint32_t onu_index, const amxc_var_t* const data,
+                                     notif_sample_t* const sample) {
 
-    handle_dm_notification(notif_dm_object_changed, data);
+    handle_dm_notification(notif_dm_object_changed, data, sample);
 }
 
 /**
@@ -261,20 +395,28 @@ static void handle_dm_object_changed(UNUSED uint32_t onu_index, const amxc_var_t
  *
  * @param[in] onu_index   xpon_onu instance index
  *
+ * Drop the ONU from the mirror: the plugin rebuilds its view on the ONU.
  * Create a htable with 1 element with key="index" and @a onu_index as value.
  * Pass the htable as argument of omci_reset_mib().
  */
-static void handle_omci_reset_mib(uint32_t onu_index, UNUSED const amxc_var_t* const data) {
+static void handle_omci_reset_mib(uint32_t onu_index, UNUSED const amxc_var_t* const data,
+                                  notif_sample_t* const sample) {
 
     amxc_var_t args;
     amxc_var_init(&args);
     amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
 
+    shadow_mirror_forget_onu(onu_index);
+
+    sample->outcome = notif_outcome_conversion_failed;
     if(!amxc_var_add_key(uint32_t, &args, "index", onu_index)) {
         SAH_TRACEZ_ERROR(ME, "Failed to add index to args");
         goto exit;
     }
-    xpon_mngr_call_pon_stat_function("omci_reset_mib", &args);
+    const uint64_t forward_start_us = latency_now_us();
+    sample->outcome = xpon_mngr_call_pon_stat_function("omci_reset_mib", &args) ?
+        notif_outcome_forwarded : notif_outcome_forward_failed;
+    sample_set_stage(sample, notif_stage_forward, latency_now_us() - forward_start_us);
 
 exit:
     amxc_var_clean(&args);
@@ -284,15 +426,382 @@ exit:
 typedef struct _notification_handler {
     const char* name; /* notification name, e.g., "dm:instance-added" */
     handle_notification_fn_t handler;
+    fr_op_t fr_op;    /* operation in the flight recorder */
 } notification_handler_t;
 
 static const notification_handler_t NOTIFICATION_HANDLERS[] = {
-    { .name = "dm:instance-added", .handler = handle_dm_instance_added   },
-    { .name = "dm:instance-removed", .handler = handle_dm_instance_removed },
-    { .name = "dm:object-changed", .handler = handle_dm_object_changed   },
-    { .name = "omci:reset_mib", .handler = handle_omci_reset_mib      }
+    { .name = "dm:instance-added", .handler = handle_dm_instance_added,
+      .fr_op = fr_op_notif_instance_added },
+    { .name = "dm:instance-removed", .handler = handle_dm_instance_removed,
+      .fr_op = fr_op_notif_instance_removed },
+    { .name = "dm:object-changed", .handler = handle_dm_object_changed,
+      .fr_op = fr_op_notif_object_changed },
+    { .name = "omci:reset_mib", .handler = handle_omci_reset_mib,
+      .fr_op = fr_op_notif_reset_mib }
+};
+
+#define N_NOTIFICATION_TYPES ARRAY_SIZE(NOTIFICATION_HANDLERS)
+
+/* Statistics of the notification pipeline per notification type */
+typedef struct _notif_type_stats {
+    uint64_t received; /* added to a queue */
+    uint64_t outcomes[notif_outcome_nr];
+    latency_stats_t stages[notif_stage_nr];
+} notif_type_stats_t;
+
+/**
+ * Statistics of the notification pipeline.
+ *
+ * The 'ignored_*' counters count the notifications notif_handler() ignores
+ * because they have no name, because the module is not subscribed on the
+ * ONU, or because the module does not know the notification. The
+ * notifications dropped because a queue overflowed are counted per ONU in
+ * the notif_queue statistics.
+ */
+typedef struct _notif_pipeline_stats {
+    uint64_t ignored_no_name;
+    uint64_t ignored_not_subscribed;
+    uint64_t ignored_unknown;
+    notif_type_stats_t per_type[N_NOTIFICATION_TYPES];
+} notif_pipeline_stats_t;
+
+static notif_pipeline_stats_t s_pipeline_stats;
+
+/**
+ * Find the entry in NOTIFICATION_HANDLERS for a notification.
+ *
+ * @param[in] notification  notification name, e.g., "dm:instance-added"
+ *
+ * @return index of the entry in NOTIFICATION_HANDLERS upon success, else the
+ *         size of NOTIFICATION_HANDLERS
+ */
+static uint32_t find_notification_handler(const char* const notification) {
+
+    const uint32_t n_notifs = ARRAY_SIZE(NOTIFICATION_HANDLERS);
+    uint32_t i;
+
+    for(i = 0; i < n_notifs; ++i) {
+        if(strncmp(notification, NOTIFICATION_HANDLERS[i].name,
+                   strlen(NOTIFICATION_HANDLERS[i].name)) == 0) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * Objects whose changes go to the high-priority lane of the notification
+ * queues.
+ *
+ * Alarms and ONU activation state changes must reach the tr181-xpon plugin
+ * quickly, also when they happen during provisioning, which can result in
+ * hundreds of notifications about GEM ports.
+ */
+static const object_id_t HIGH_PRIORITY_OBJECTS[] = {
+    obj_id_ani_tc_alarms,
+    obj_id_ani_tc_onu_activation
 };
 
+/**
+ * Return the lane of the notification queue a notification must go to.
+ *
+ * @param[in] type  index of the entry in NOTIFICATION_HANDLERS
+ * @param[in] data  notification data
+ *
+ * Only dm:object-changed notifications can go to the high-priority lane: the
+ * objects in HIGH_PRIORITY_OBJECTS are singletons, and the ONU HAL agent only
+ * sends dm:object-changed notifications for singletons.
+ *
+ * @return notif_lane_high if the notification is about an object in
+ *         HIGH_PRIORITY_OBJECTS, else notif_lane_normal
+ */
+static notif_lane_t classify_notification(uint32_t type, const amxc_var_t* const data) {
+
+    notif_lane_t lane = notif_lane_normal;
+    size_t i;
+
+    if(NOTIFICATION_HANDLERS[type].handler != handle_dm_object_changed) {
+        goto exit;
+    }
+
+    const object_id_t id = dm_get_object_id(GETP_CHAR(data, "path"));
+    for(i = 0; i < ARRAY_SIZE(HIGH_PRIORITY_OBJECTS); ++i) {
+        if(HIGH_PRIORITY_OBJECTS[i] == id) {
+            lane = notif_lane_high;
+            break;
+        }
+    }
+
+exit:
+    return lane;
+}
+
+/**
+ * Process a notification taken from the queue of an ONU.
+ *
+ * @param[in] onu_index  xpon_onu instance index which sent the notification
+ * @param[in] type       index of the entry in NOTIFICATION_HANDLERS
+ * @param[in] data       notification data
+ * @param[in] enqueued_us  time the notification was added to the queue
+ */
+static void process_notification(uint32_t onu_index, uint32_t type,
+                                 const amxc_var_t* const data,
+                                 uint64_t enqueued_us) {
+
+    notif_sample_t sample;
+    uint32_t stage;
+
+    when_false_trace(type < N_NOTIFICATION_TYPES, exit, ERROR,
+                     "Invalid notification type [%u]", type);
+
+    memset(&sample, 0, sizeof(sample));
+    sample.id = obj_id_unknown;
+    NOTIFICATION_HANDLERS[type].handler(onu_index, data, &sample);
+    sample_set_stage(&sample, notif_stage_end_to_end, latency_now_us() - enqueued_us);
+
+    flight_recorder_add(NOTIFICATION_HANDLERS[type].fr_op, sample.id, onu_index,
+                        sample.duration_us[notif_stage_end_to_end], -(int32_t) sample.outcome);
+
+    notif_type_stats_t* const stats = &s_pipeline_stats.per_type[type];
+    ++stats->outcomes[sample.outcome];
+    for(stage = notif_stage_requery; stage < notif_stage_nr; ++stage) {
+        if(sample.stages & (1U << stage)) {
+            latency_stats_add_result(&stats->stages[stage], sample.duration_us[stage],
+                                     (notif_outcome_forwarded == sample.outcome));
+        }
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Re-announce an object of an ONU to the tr181-xpon plugin.
+ *
+ * @param[in] notif  notif_dm_instance_added or notif_dm_object_changed
+ * @param[in] path   prpl path. For notif_dm_instance_added, the path of the
+ *                   template object.
+ * @param[in] index  instance index for notif_dm_instance_added, else 0
+ */
+static void resync_emit(dm_notification_t notif, const char* const path,
+                        uint32_t index) {
+
+    amxc_var_t data;
+    notif_sample_t sample;
+
+    amxc_var_init(&data);
+    amxc_var_set_type(&data, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &data, "path", path);
+    if(index != 0) {
+        amxc_var_add_key(uint32_t, &data, "index", index);
+    }
+    memset(&sample, 0, sizeof(sample));
+    handle_dm_notification(notif, &data, &sample);
+    amxc_var_clean(&data);
+}
+
+static inline bool is_valid_index(uint32_t index) {
+
+    return ((index == 0) || (index > s_max_nr_of_onus)) ? false : true;
+}
+
+/**
+ * Step of the resync of an ONU.
+ *
+ * - resync_step_expand: list the instances of the objects of one type below
+ *     'path'. 'rest' is the remainder of the generic prpl path of the type
+ *     after 'path', e.g., ".ani.x.tc.gem.port".
+ * - resync_step_announce: announce the object 'path' with 'notif': for
+ *     notif_dm_instance_added, 'path' is the template object and 'index' the
+ *     instance.
+ */
+typedef enum _resync_step_type {
+    resync_step_expand = 0,
+    resync_step_announce
+} resync_step_type_t;
+
+typedef struct _resync_step {
+    amxc_llist_it_t it;
+    resync_step_type_t type;
+    dm_notification_t notif;
+    const char* rest;   /* points into OBJECT_INFO */
+    uint32_t index;
+    char path[128];
+} resync_step_t;
+
+static void free_resync_step(amxc_llist_it_t* it) {
+    free(amxc_container_of(it, resync_step_t, it));
+}
+
+static resync_step_t* new_resync_step(amxc_llist_t* const steps, resync_step_type_t type,
+                                      const char* const path) {
+
+    resync_step_t* const step = (resync_step_t*) calloc(1, sizeof(resync_step_t));
+    when_null_trace(step, exit, ERROR, "Failed to allocate mem");
+    step->type = type;
+    snprintf(step->path, sizeof(step->path), "%s", path);
+    amxc_llist_append(steps, &step->it);
+
+exit:
+    return step;
+}
+
+/**
+ * Do a resync_step_expand step: add the steps for the instances it finds to
+ * @a steps.
+ *
+ * If 'rest' ends in the template object itself, the new steps announce the
+ * instances. Else they expand the remainder below each instance.
+ */
+static void resync_expand(const resync_step_t* const step, amxc_llist_t* const steps) {
+
+    amxc_string_t path;
+    amxc_string_t indexes;
+    const char* const rest = step->rest;
+    const char* const x = strstr(rest, ".x.");
+    const char* idx;
+    char* end = NULL;
+    resync_step_t* new_step = NULL;
+
+    amxc_string_init(&path, 0);
+    amxc_string_init(&indexes, 0);
+
+    amxc_string_set(&path, step->path);
+    amxc_string_appendf(&path, "%.*s", (int) (x ? (size_t) (x - rest) : strlen(rest)), rest);
+    const char* const path_cstr = amxc_string_get(&path, 0);
+
+    if(x == NULL) {
+        const object_info_t* const info = dm_get_object_info(dm_get_object_id(path_cstr));
+        if((info != NULL) && (info->prpl_key_name == NULL)) {
+            new_step = new_resync_step(steps, resync_step_announce, path_cstr);
+            if(new_step) {
+                new_step->notif = notif_dm_object_changed;
+            }
+            goto exit;
+        }
+    }
+
+    when_false_trace(sbi_get_indexes(path_cstr, &indexes), exit, ERROR,
+                     "%s: failed to get instances", path_cstr);
+
+    idx = amxc_string_get(&indexes, 0);
+    while((idx != NULL) && (*idx != '\0')) {
+        const uint32_t index = (uint32_t) strtoul(idx, &end, 10);
+        if(end == idx) {
+            break;
+        }
+        if(x == NULL) {
+            new_step = new_resync_step(steps, resync_step_announce, path_cstr);
+            if(new_step) {
+                new_step->notif = notif_dm_instance_added;
+                new_step->index = index;
+            }
+        } else {
+            char instance[128];
+            snprintf(instance, sizeof(instance), "%s.%u", path_cstr, index);
+            new_step = new_resync_step(steps, resync_step_expand, instance);
+            if(new_step) {
+                new_step->rest = x + 2;
+            }
+        }
+        idx = (*end == ',') ? end + 1 : end;
+    }
+
+exit:
+    amxc_string_clean(&indexes);
+    amxc_string_clean(&path);
+}
+
+/**
+ * Start the resync of an ONU: call 'omci_reset_mib()' in the tr181-xpon
+ * plugin, and plan the steps which re-read the ONU.
+ */
+static void resync_start(subscription_info_t* const info) {
+
+    notif_sample_t sample;
+    char onu_path[16];
+    const size_t onu_generic_len = strlen("xpon_onu.x");
+    resync_step_t* step = NULL;
+    uint32_t id;
+
+    amxc_llist_clean(&info->resync_steps, free_resync_step);
+
+    SAH_TRACEZ_WARNING(ME, "onu_index=%d: resync", info->onu_index);
+    memset(&sample, 0, sizeof(sample));
+    handle_omci_reset_mib(info->onu_index, NULL, &sample);
+    flight_recorder_add(fr_op_notif_resync, obj_id_onu, info->onu_index,
+                        sample.duration_us[notif_stage_forward], -(int32_t) sample.outcome);
+
+    snprintf(onu_path, sizeof(onu_path), "xpon_onu.%u", info->onu_index);
+    step = new_resync_step(&info->resync_steps, resync_step_announce, onu_path);
+    if(step) {
+        step->notif = notif_dm_object_changed;
+    }
+    for(id = obj_id_onu + 1; id < obj_id_nbr; ++id) {
+        const object_info_t* const info_obj = dm_get_object_info((object_id_t) id);
+        if((info_obj == NULL) || (strlen(info_obj->prpl_path) <= onu_generic_len)) {
+            continue;
+        }
+        step = new_resync_step(&info->resync_steps, resync_step_expand, onu_path);
+        if(step) {
+            step->rest = info_obj->prpl_path + onu_generic_len;
+        }
+    }
+}
+
+/**
+ * Do one step of the resync of an ONU after its notification queue
+ * overflowed.
+ *
+ * @param[in] onu_index  xpon_onu instance index
+ * @param[in] start      true for the first step
+ *
+ * The module dropped notifications of the ONU. The first step calls
+ * 'omci_reset_mib()' in the tr181-xpon plugin: the plugin then drops its view
+ * on the ONU. The next steps re-read the ONU from the ONU HAL agent, as
+ * during discovery, and announce all its objects again: the plugin rebuilds
+ * its view from those notifications. Each step lists the instances of one
+ * template object, or announces one object. The queue runs one step per unit
+ * of work of a drain pass, so a resync does not block the event loop.
+ *
+ * The steps run depth first: the instances a step finds are announced
+ * before the steps planned earlier run. Hence a parent object is announced
+ * before its children, e.g., an ANI before its GEM ports.
+ *
+ * @return true if steps remain, false if the resync is done
+ */
+static bool resync_onu(uint32_t onu_index, bool start) {
+
+    subscription_info_t* const info = is_valid_index(onu_index) ? s_onu_table[onu_index - 1] : NULL;
+    when_null_trace(info, exit, ERROR, "onu_index=%d: not subscribed", onu_index);
+
+    if(start) {
+        resync_start(info);
+        goto exit;
+    }
+
+    amxc_llist_it_t* const it = amxc_llist_take_first(&info->resync_steps);
+    when_null(it, exit);
+    resync_step_t* const step = amxc_container_of(it, resync_step_t, it);
+
+    if(resync_step_expand == step->type) {
+        amxc_llist_t found;
+        amxc_llist_init(&found);
+        resync_expand(step, &found);
+        /* Depth first: run the new steps before the ones planned earlier */
+        amxc_llist_it_t* last = NULL;
+        while((last = amxc_llist_take_last(&found)) != NULL) {
+            amxc_llist_prepend(&info->resync_steps, last);
+        }
+    } else {
+        resync_emit(step->notif, step->path, step->index);
+    }
+    free_resync_step(it);
+
+exit:
+    return (info != NULL) && !amxc_llist_is_empty(&info->resync_steps);
+}
+
 /**
  * Notification handler.
  *
@@ -303,11 +812,18 @@ static const notification_handler_t NOTIFICATION_HANDLERS[] = {
  * @param[in] priv  pointer to subscription_info_t instance. Its field
  *                  'onu_index' shows which xpon_onu instance sent the
  *                  notification.
+ *
+ * The function does not process the notification itself. It adds it to the
+ * queue of the ONU which sent it. See notif_queue.h.
  */
 static void notif_handler(const char* const sig_name,
                           const amxc_var_t* const data,
                           void* const priv) {
 
+    const uint64_t start_us = stall_detector_begin();
+    /* Give the notification a new trace ID. notif_queue_push() stores it. */
+    const uint32_t previous_trace_id = trace_id_swap(trace_id_new());
+
     SAH_TRACEZ_DEBUG(ME, "sig_name='%s'", sig_name);
 
     when_null_trace(data, exit, ERROR, "data is NULL");
@@ -319,60 +835,126 @@ static void notif_handler(const char* const sig_name,
 #endif
 
     const char* const notification = GETP_CHAR(data, "notification");
-    when_null_trace(notification, exit, ERROR, "Notification does not include name");
+    if(NULL == notification) {
+        SAH_TRACEZ_ERROR(ME, "Notification does not include name");
+        ++s_pipeline_stats.ignored_no_name;
+        goto exit;
+    }
 
-    const subscription_info_t* info = (const subscription_info_t*) priv;
+    subscription_info_t* info = (subscription_info_t*) priv;
     SAH_TRACEZ_DEBUG(ME, "onu_index=%d: notification='%s'", info->onu_index, notification);
+    traffic_recorder_add_notif(info->onu_index, notification, data);
     if(!info->subscribed) {
         SAH_TRACEZ_WARNING(ME, "onu_index=%d: ignore '%s': not subscribed",
                            info->onu_index, notification);
+        ++s_pipeline_stats.ignored_not_subscribed;
         goto exit;
     }
 
-    const size_t n_notifs = ARRAY_SIZE(NOTIFICATION_HANDLERS);
-    size_t i;
+    const uint32_t type = find_notification_handler(notification);
+    if(type >= N_NOTIFICATION_TYPES) {
+        SAH_TRACEZ_WARNING(ME, "Unknown notification: %s", notification);
+        ++s_pipeline_stats.ignored_unknown;
+        goto exit;
+    }
 
-    bool found = false;
-    for(i = 0; i < n_notifs; ++i) {
-        if(strncmp(notification, NOTIFICATION_HANDLERS[i].name,
-                   strlen(NOTIFICATION_HANDLERS[i].name)) == 0) {
-            NOTIFICATION_HANDLERS[i].handler(info->onu_index, data);
-            found = true;
-            break;
+    notif_queue_push(&info->queue, classify_notification(type, data), type, data);
+
+    notif_type_stats_t* const stats = &s_pipeline_stats.per_type[type];
+    ++stats->received;
+    latency_stats_add(&stats->stages[notif_stage_receive], latency_now_us() - start_us);
+
+exit:
+    trace_id_swap(previous_trace_id);
+    stall_detector_end(stall_entry_notif_handler, start_us, NULL, data);
+    return;
+}
+
+static void free_subscription_info(amxc_llist_it_t* it) {
+    subscription_info_t* info = amxc_container_of(it, subscription_info_t, it);
+    notif_queue_clean(&info->queue);
+    amxc_llist_clean(&info->resync_steps, free_resync_step);
+    free(info);
+}
+
+/**
+ * Set the size of the ONU table.
+ *
+ * @param[in] max_nr_of_onus  new size. Must be in [1, NOTIF_MAX_NR_OF_ONUS_LIMIT].
+ *
+ * The function refuses to make the table smaller than the highest index of
+ * the ONUs the module subscribed on.
+ *
+ * @return true on success, else false
+ */
+bool notif_set_max_nr_of_onus(uint32_t max_nr_of_onus) {
+
+    bool rv = false;
+    uint32_t i;
+
+    if((0 == max_nr_of_onus) || (max_nr_of_onus > NOTIF_MAX_NR_OF_ONUS_LIMIT)) {
+        SAH_TRACEZ_ERROR(ME, "max_nr_of_onus=%u is not in [1, %d]",
+                         max_nr_of_onus, NOTIF_MAX_NR_OF_ONUS_LIMIT);
+        goto exit;
+    }
+    if(max_nr_of_onus == s_max_nr_of_onus) {
+        rv = true;
+        goto exit;
+    }
+
+    for(i = max_nr_of_onus; i < s_max_nr_of_onus; ++i) {
+        if(s_onu_table[i] != NULL) {
+            SAH_TRACEZ_ERROR(ME, "max_nr_of_onus=%u: already subscribed on xpon_onu.%u",
+                             max_nr_of_onus, i + 1);
+            goto exit;
         }
     }
 
-    if(!found) {
-        SAH_TRACEZ_WARNING(ME, "Unknown notification: %s", notification);
+    subscription_info_t** table =
+        (subscription_info_t**) realloc(s_onu_table, max_nr_of_onus * sizeof(subscription_info_t*));
+    when_null_trace(table, exit, ERROR, "Failed to allocate mem");
+    for(i = s_max_nr_of_onus; i < max_nr_of_onus; ++i) {
+        table[i] = NULL;
     }
 
+    SAH_TRACEZ_INFO(ME, "max_nr_of_onus: %u -> %u", s_max_nr_of_onus, max_nr_of_onus);
+    s_onu_table = table;
+    s_max_nr_of_onus = max_nr_of_onus;
+    rv = true;
+
 exit:
-    return;
+    return rv;
+}
+
+/**
+ * Return the max nr of ONUs, i.e., the size of the ONU table.
+ */
+uint32_t notif_get_max_nr_of_onus(void) {
+    return s_max_nr_of_onus;
 }
 
 /**
  * Initialize the 'notif' part.
  *
  * The module must call this function once at startup.
+ *
+ * @return true on success, else false
  */
-void notif_init(void) {
+bool notif_init(void) {
 
-    int i;
-    for(i = 0; i < MAX_NR_OF_ONUS; ++i) {
-        s_subscription_info[i].onu_index = (i + 1);
-        s_subscription_info[i].subscribed = false;
-    }
-}
+    amxc_llist_init(&s_active_onus);
 
-static inline bool is_valid_index(uint32_t index) {
+    if(!notif_set_max_nr_of_onus(NOTIF_DEFAULT_MAX_NR_OF_ONUS)) {
+        return false;
+    }
 
-    return ((index == 0) || (index > MAX_NR_OF_ONUS)) ? false : true;
+    return notif_queue_init_scheduler(process_notification, resync_onu);
 }
 
 /**
  * Return true if plugin is subscribed on notifications from xpon_onu.<index>
  *
- * @param[in] index   xpon_onu instance index. Must be in interval [1, MAX_NR_OF_ONUS].
+ * @param[in] index   xpon_onu instance index. Must be in interval [1, max nr of ONUs].
  *
  * @return true if plugin is subscribed on notifications from xpon_onu instance, else false
  */
@@ -380,32 +962,50 @@ bool notif_is_subscribed(uint32_t index) {
 
     when_false_trace(is_valid_index(index), exit_error, ERROR, "Invalid index [%d]", index);
 
-    return s_subscription_info[index - 1].subscribed;
+    return (s_onu_table[index - 1] != NULL) && s_onu_table[index - 1]->subscribed;
 
 exit_error:
     return false;
 }
 
+/**
+ * Return the nr of xpon_onu instances the plugin is subscribed on.
+ */
+uint32_t notif_get_nr_of_subscribed_onus(void) {
+
+    uint32_t n = 0;
+
+    amxc_llist_iterate(it, &s_active_onus) {
+        const subscription_info_t* const info = amxc_container_of(it, subscription_info_t, it);
+        if(info->subscribed) {
+            ++n;
+        }
+    }
+    return n;
+}
+
 /**
  * Subscribe on notifications from xpon_onu.<index>
  *
  * @param[in] ctx    bus context
- * @param[in] index  xpon_onu instance index. Must be in interval [1, MAX_NR_OF_ONUS].
+ * @param[in] index  xpon_onu instance index. Must be in interval [1, max nr of ONUs].
  *
- * When subscribing, pass pointer to entry in s_subscription_info array
- * corresponding to @a index. If the plugin calls the callback function upon
- * receiving a notification, the plugin can find out to which xpon_onu instance
- * the notification belongs.
+ * When subscribing, pass pointer to the subscription info of the ONU with
+ * index @a index. If the plugin calls the callback function upon receiving a
+ * notification, the plugin can find out to which xpon_onu instance the
+ * notification belongs.
  */
 void notif_subscribe(amxb_bus_ctx_t* const ctx, uint32_t index) {
 
+    subscription_info_t* info = NULL;
+
     when_null_trace(ctx, exit, ERROR, "bus context is NULL");
     when_false_trace(is_valid_index(index), exit, ERROR, "Invalid index [%d]", index);
 
     SAH_TRACEZ_DEBUG(ME, "index='%d'", index);
     const uint32_t idx = index - 1;
 
-    if(s_subscription_info[idx].subscribed) {
+    if(s_onu_table[idx] && s_onu_table[idx]->subscribed) {
         SAH_TRACEZ_DEBUG(ME, "Already subscribed on xpon_onu.%d", index);
         goto exit;
     }
@@ -420,15 +1020,24 @@ void notif_subscribe(amxb_bus_ctx_t* const ctx, uint32_t index) {
         s_bus_ctx = ctx;
     }
 
+    info = (subscription_info_t*) calloc(1, sizeof(subscription_info_t));
+    when_null_trace(info, exit, ERROR, "Failed to allocate mem");
+    info->onu_index = index;
+    notif_queue_init(&info->queue, index);
+    amxc_llist_init(&info->resync_steps);
+
     char object[16];
 
-    /* amxb_subscribe() expects the parameter 'object' end with a "." */
+    /* sbi_subscribe() expects the parameter 'object' end with a "." */
     snprintf(object, 16, "xpon_onu.%d.", index);
 
-    if(amxb_subscribe(ctx, object, NULL, notif_handler, &s_subscription_info[idx])) {
+    if(!sbi_subscribe(ctx, object, notif_handler, info)) {
         SAH_TRACEZ_ERROR(ME, "Failed to subscribe on %s", object);
+        free_subscription_info(&info->it);
     } else {
-        s_subscription_info[idx].subscribed = true;
+        info->subscribed = true;
+        amxc_llist_append(&s_active_onus, &info->it);
+        s_onu_table[idx] = info;
     }
 
 exit:
@@ -438,27 +1047,131 @@ exit:
 /**
  * Clean up the notif part.
  *
- * Unsubscribe from all xpon_oni.{i} instances.
+ * Unsubscribe from all xpon_oni.{i} instances, and drop the notifications
+ * which are still waiting to be processed.
  *
  * The module must call this function once when stopping.
  */
 void notif_cleanup(void) {
-    uint32_t i;
-    if(s_bus_ctx) {
-        char object[16];
-        for(i = 0; i < MAX_NR_OF_ONUS; ++i) {
-            if(s_subscription_info[i].subscribed) {
-                /* amxb_unsubscribe() expects the parameter 'object' end with a "." */
-                snprintf(object, 16, "xpon_onu.%d.", i + 1);
-                SAH_TRACEZ_DEBUG(ME, "%s: unsubscribe", object);
-                if(amxb_unsubscribe(s_bus_ctx, object, notif_handler,
-                                    &s_subscription_info[i])) {
-                    SAH_TRACEZ_ERROR(ME, "Failed to unsubscribe from %s", object);
-                } else {
-                    s_subscription_info[i].subscribed = false;
-                }
+    subscription_info_t* info = NULL;
+    char object[16];
+
+    amxc_llist_for_each(it, &s_active_onus) {
+        info = amxc_container_of(it, subscription_info_t, it);
+        if(s_bus_ctx && info->subscribed) {
+            /* sbi_unsubscribe() expects the parameter 'object' end with a "." */
+            snprintf(object, 16, "xpon_onu.%d.", info->onu_index);
+            SAH_TRACEZ_DEBUG(ME, "%s: unsubscribe", object);
+            if(!sbi_unsubscribe(s_bus_ctx, object, notif_handler, info)) {
+                /* The bus still passes 'info' to notif_handler(): leak it
+                 * on purpose rather than leaving the slot with freed mem.
+                 * notif_handler() ignores the events for it from now on. */
+                SAH_TRACEZ_ERROR(ME, "Failed to unsubscribe from %s", object);
+                amxc_llist_it_take(it);
+                info->subscribed = false;
+                notif_queue_clean(&info->queue);
+                amxc_llist_clean(&info->resync_steps, free_resync_step);
             }
         }
     }
+    amxc_llist_clean(&s_active_onus, free_subscription_info);
+    s_bus_ctx = NULL;
+
+    free(s_onu_table);
+    s_onu_table = NULL;
+    s_max_nr_of_onus = 0;
+
+    notif_queue_cleanup_scheduler();
+}
+
+/**
+ * Add a 'notif_pipeline' section with the pipeline statistics to @a stats.
+ *
+ * The section has the key 'ignored' with the counters of the notifications
+ * ignored by notif_handler(), and a key per notification type, e.g.,
+ * "dm:object-changed", with:
+ * - 'received': nr of notifications added to a queue
+ * - 'outcomes': nr of notifications per outcome, e.g. 'requery_failed'
+ * - 'stages': latency statistics per stage. The stats of all stages but
+ *   'receive' count a notification as error if its outcome is not
+ *   'forwarded'.
+ */
+static void add_pipeline_stats(amxc_var_t* const stats) {
+
+    uint32_t type;
+    uint32_t i;
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "notif_pipeline", NULL);
+    when_null_trace(section, exit, ERROR, "Failed to add 'notif_pipeline' to stats");
+
+    amxc_var_t* const ignored = amxc_var_add_key(amxc_htable_t, section, "ignored", NULL);
+    amxc_var_add_key(uint64_t, ignored, "no_name", s_pipeline_stats.ignored_no_name);
+    amxc_var_add_key(uint64_t, ignored, "not_subscribed", s_pipeline_stats.ignored_not_subscribed);
+    amxc_var_add_key(uint64_t, ignored, "unknown", s_pipeline_stats.ignored_unknown);
+
+    for(type = 0; type < N_NOTIFICATION_TYPES; ++type) {
+        const notif_type_stats_t* const type_stats = &s_pipeline_stats.per_type[type];
+        amxc_var_t* const var =
+            amxc_var_add_key(amxc_htable_t, section, NOTIFICATION_HANDLERS[type].name, NULL);
+        amxc_var_add_key(uint64_t, var, "received", type_stats->received);
+
+        amxc_var_t* const outcomes = amxc_var_add_key(amxc_htable_t, var, "outcomes", NULL);
+        for(i = 0; i < notif_outcome_nr; ++i) {
+            amxc_var_add_key(uint64_t, outcomes, NOTIF_OUTCOME_NAMES[i], type_stats->outcomes[i]);
+        }
+
+        amxc_var_t* const stages = amxc_var_add_key(amxc_htable_t, var, "stages", NULL);
+        for(i = 0; i < notif_stage_nr; ++i) {
+            amxc_var_t* const stage = amxc_var_add_key(amxc_htable_t, stages, NOTIF_STAGE_NAMES[i], NULL);
+            latency_stats_to_var(&type_stats->stages[i], stage);
+        }
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Add the statistics of the notification queues to an htable variant.
+ *
+ * @param[in,out] stats  the function adds the key 'notif_queue' to this
+ *                       htable. Its value is an htable with the configuration
+ *                       of the queues, with the key 'lanes': the latency
+ *                       statistics per lane, and with the key 'onus': a list
+ *                       with the statistics of the queue of each subscribed
+ *                       ONU. The function also adds the key 'notif_pipeline'.
+ *                       See add_pipeline_stats().
+ */
+void notif_get_stats(amxc_var_t* const stats) {
+
+    subscription_info_t* info = NULL;
+
+    amxc_var_t* section = amxc_var_add_key(amxc_htable_t, stats, "notif_queue", NULL);
+    when_null_trace(section, exit, ERROR, "Failed to add 'notif_queue' to stats");
+
+    notif_queue_get_config(section);
+    notif_queue_get_lane_stats(section);
+    amxc_var_t* onus = amxc_var_add_key(amxc_llist_t, section, "onus", NULL);
+    when_null_trace(onus, exit, ERROR, "Failed to add 'onus' to stats");
+
+    amxc_llist_iterate(it, &s_active_onus) {
+        info = amxc_container_of(it, subscription_info_t, it);
+        notif_queue_get_stats(&info->queue, onus);
+    }
+
+    add_pipeline_stats(stats);
+
+exit:
+    return;
+}
+
+void notif_reset_stats(void) {
+    subscription_info_t* info = NULL;
+    memset(&s_pipeline_stats, 0, sizeof(s_pipeline_stats));
+    notif_queue_reset_lane_stats();
+    amxc_llist_iterate(it, &s_active_onus) {
+        info = amxc_container_of(it, subscription_info_t, it);
+        notif_queue_reset_stats(&info->queue);
+    }
 }
 
@@ -0,0 +1,700 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "notif_queue.h"
+
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strcmp() */
+
+#include <amxc/amxc_macros.h> /* when_null() */
+#include <amxp/amxp_timer.h>
+
+#include "mod_xpon_trace.h"
+#include "shadow_mirror.h"  /* shadow_mirror_forget_onu() */
+#include "stall_detector.h"
+#include "trace_id.h"
+
+/**
+ * Notification in the queue of an ONU.
+ *
+ * The queue owns a copy of the notification data: the variant passed to the
+ * notification handler is only valid during the callback.
+ */
+typedef struct _notif_event {
+    amxc_llist_it_t it;
+    uint32_t type;
+    uint64_t enqueued_us; /* when the notification was added to the queue */
+    uint32_t trace_id;    /* trace ID current when it was added to the queue */
+    amxc_var_t data;
+} notif_event_t;
+
+typedef struct _notif_queue_config {
+    uint32_t depth;
+    notif_queue_overflow_policy_t policy;
+    uint32_t events_per_pass;
+} notif_queue_config_t;
+
+/**
+ * Latency statistics of a lane, over all ONUs.
+ *
+ * - wait: time between adding a notification to the queue and starting to
+ *   process it
+ * - total: time between adding a notification to the queue and the end of
+ *   processing it
+ */
+typedef struct _lane_stats {
+    latency_stats_t wait;
+    latency_stats_t total;
+} lane_stats_t;
+
+static notif_queue_config_t s_config = {
+    .depth = NOTIF_QUEUE_DEFAULT_DEPTH,
+    .policy = notif_queue_resync,
+    .events_per_pass = NOTIF_QUEUE_DEFAULT_EVENTS_PER_PASS
+};
+
+/* Per lane: lanes with pending work, in the order the scheduler serves them */
+static amxc_llist_t s_ready_lanes[notif_lane_nr];
+static lane_stats_t s_lane_stats[notif_lane_nr];
+static amxp_timer_t* s_drain_timer = NULL;
+static bool s_drain_scheduled = false;
+
+static notif_queue_process_fn_t s_process_fn = NULL;
+static notif_queue_resync_fn_t s_resync_fn = NULL;
+
+static const char* const POLICY_NAMES[notif_queue_overflow_policy_nr] = {
+    "drop_oldest",
+    "resync"
+};
+
+static const char* const LANE_NAMES[notif_lane_nr] = {
+    "high",
+    "normal"
+};
+
+static void free_event(amxc_llist_it_t* it) {
+    notif_event_t* event = amxc_container_of(it, notif_event_t, it);
+    amxc_var_clean(&event->data);
+    free(event);
+}
+
+static inline bool lane_has_work(const notif_lane_queue_t* const lane_queue,
+                                 notif_lane_t lane) {
+    if(lane_queue->size != 0) {
+        return true;
+    }
+    return (notif_lane_normal == lane) && lane_queue->owner->resync_pending;
+}
+
+static void schedule_drain(void) {
+    if(s_drain_scheduled) {
+        return;
+    }
+    when_null_trace(s_drain_timer, exit, ERROR, "No drain timer");
+    if(amxp_timer_start(s_drain_timer, 0) != 0) {
+        SAH_TRACEZ_ERROR(ME, "Failed to start drain timer");
+        goto exit;
+    }
+    s_drain_scheduled = true;
+
+exit:
+    return;
+}
+
+static void mark_ready(notif_queue_t* const queue, notif_lane_t lane) {
+    notif_lane_queue_t* const lane_queue = &queue->lanes[lane];
+    if(!amxc_llist_it_is_in_list(&lane_queue->ready_it)) {
+        amxc_llist_append(&s_ready_lanes[lane], &lane_queue->ready_it);
+    }
+    schedule_drain();
+}
+
+/**
+ * Drop all notifications in one lane of a queue.
+ *
+ * @return the nr of notifications dropped
+ */
+static uint32_t drop_lane(notif_queue_t* const queue, notif_lane_t lane) {
+    const uint32_t n_dropped = queue->lanes[lane].size;
+    amxc_llist_clean(&queue->lanes[lane].events, free_event);
+    queue->lanes[lane].size = 0;
+    amxc_llist_it_take(&queue->lanes[lane].ready_it);
+    queue->n_dropped += n_dropped;
+    return n_dropped;
+}
+
+static bool lane_is_full(const notif_lane_queue_t* const lane_queue) {
+    return (s_config.depth != NOTIF_QUEUE_UNBOUNDED) && (lane_queue->size >= s_config.depth);
+}
+
+static void drop_oldest(notif_queue_t* const queue, notif_lane_t lane) {
+    notif_lane_queue_t* const lane_queue = &queue->lanes[lane];
+    amxc_llist_it_t* it = amxc_llist_take_first(&lane_queue->events);
+    if(it) {
+        free_event(it);
+        --lane_queue->size;
+        ++queue->n_dropped;
+    }
+}
+
+/**
+ * Make room in a full lane according to the overflow policy.
+ *
+ * The function always drops at least one notification. A dropped
+ * dm:object-changed would leave the shadow mirror stale, so the function
+ * drops the objects of the ONU from the mirror as well.
+ *
+ * @return true if the caller can add the new notification to the lane,
+ *         false if the new notification must be dropped
+ */
+static bool handle_overflow(notif_queue_t* const queue, notif_lane_t lane) {
+    bool rv = true;
+
+    ++queue->n_overflows;
+    shadow_mirror_forget_onu(queue->onu_index);
+
+    switch(s_config.policy) {
+    case notif_queue_resync:
+        if(notif_lane_normal == lane) {
+            /* Not in the trace call: sahtrace only evaluates its args if the
+             * trace level is enabled. */
+            const uint32_t n_dropped = drop_lane(queue, lane);
+            SAH_TRACEZ_WARNING(ME, "onu_index=%d: %s lane full: dropped %u notification(s), resync",
+                               queue->onu_index, LANE_NAMES[lane], n_dropped);
+            ++queue->n_dropped; /* the new notification */
+            rv = false;
+        } else {
+            /* Keep the high-priority notifications flowing: the resync
+             * re-reads what the dropped ones were about. */
+            SAH_TRACEZ_WARNING(ME, "onu_index=%d: %s lane full: dropped oldest notification, resync",
+                               queue->onu_index, LANE_NAMES[lane]);
+            while(lane_is_full(&queue->lanes[lane])) {
+                drop_oldest(queue, lane);
+            }
+        }
+        /* A running resync may already have read what was dropped: restart */
+        queue->resync_pending = true;
+        queue->resync_running = false;
+        mark_ready(queue, notif_lane_normal);
+        break;
+    case notif_queue_drop_oldest: /* no break */
+    default:
+        while(lane_is_full(&queue->lanes[lane])) {
+            drop_oldest(queue, lane);
+        }
+        break;
+    }
+
+    return rv;
+}
+
+/**
+ * Initialize the queue of an ONU.
+ *
+ * @param[in,out] queue   queue to initialize
+ * @param[in] onu_index   xpon_onu instance index the queue belongs to
+ *
+ * @return true on success, else false
+ */
+bool notif_queue_init(notif_queue_t* const queue, uint32_t onu_index) {
+
+    bool rv = false;
+    uint32_t lane;
+    when_null(queue, exit);
+
+    memset(queue, 0, sizeof(notif_queue_t));
+    queue->onu_index = onu_index;
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        queue->lanes[lane].owner = queue;
+        amxc_llist_init(&queue->lanes[lane].events);
+        amxc_llist_it_init(&queue->lanes[lane].ready_it);
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Drop all notifications in a queue and remove it from the scheduler.
+ *
+ * @param[in,out] queue   queue to clean up
+ */
+void notif_queue_clean(notif_queue_t* const queue) {
+
+    uint32_t lane;
+    when_null(queue, exit);
+
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        amxc_llist_it_take(&queue->lanes[lane].ready_it);
+        amxc_llist_clean(&queue->lanes[lane].events, free_event);
+        queue->lanes[lane].size = 0;
+    }
+    queue->resync_pending = false;
+    queue->resync_running = false;
+
+exit:
+    return;
+}
+
+/**
+ * Add a notification to the queue of an ONU.
+ *
+ * @param[in,out] queue  queue of the ONU which sent the notification
+ * @param[in] lane       lane to add the notification to
+ * @param[in] type       type of the notification. The queue does not interpret
+ *                       it: it passes it to the process function.
+ * @param[in] data       notification data. The function adds a copy of it to
+ *                       the queue.
+ *
+ * If the lane is full, the function applies the overflow policy. If a resync
+ * is pending for the ONU but did not start yet, the function drops a
+ * notification for the normal lane: the resync covers it.
+ *
+ * @return true if the notification was added to the queue, else false
+ */
+bool notif_queue_push(notif_queue_t* const queue, notif_lane_t lane,
+                      uint32_t type, const amxc_var_t* const data) {
+
+    bool rv = false;
+    notif_event_t* event = NULL;
+    notif_lane_queue_t* lane_queue = NULL;
+
+    when_null(queue, exit);
+    when_null(data, exit);
+    when_false_trace(lane < notif_lane_nr, exit, ERROR, "Invalid lane [%d]", lane);
+
+    if(queue->resync_pending && !queue->resync_running && (notif_lane_normal == lane)) {
+        ++queue->n_dropped;
+        goto exit;
+    }
+
+    lane_queue = &queue->lanes[lane];
+    if(lane_is_full(lane_queue)) {
+        if(!handle_overflow(queue, lane)) {
+            goto exit;
+        }
+    }
+
+    event = (notif_event_t*) calloc(1, sizeof(notif_event_t));
+    when_null_trace(event, exit, ERROR, "Failed to allocate mem");
+    event->type = type;
+    event->enqueued_us = latency_now_us();
+    event->trace_id = trace_id_current();
+    amxc_var_init(&event->data);
+    if(amxc_var_copy(&event->data, data) != 0) {
+        SAH_TRACEZ_ERROR(ME, "onu_index=%d: failed to copy notification data",
+                         queue->onu_index);
+        free_event(&event->it);
+        goto exit;
+    }
+
+    amxc_llist_append(&lane_queue->events, &event->it);
+    ++lane_queue->size;
+    ++queue->n_enqueued;
+    if(lane_queue->size > lane_queue->max_size) {
+        lane_queue->max_size = lane_queue->size;
+    }
+    mark_ready(queue, lane);
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Process one unit of work of a lane: a step of a pending resync (normal lane
+ * only) or the oldest notification in the lane.
+ */
+static void process_one(notif_lane_queue_t* const lane_queue, notif_lane_t lane) {
+
+    notif_queue_t* const queue = lane_queue->owner;
+
+    if((notif_lane_normal == lane) && queue->resync_pending) {
+        const bool start = !queue->resync_running;
+        bool more = false;
+        if(start) {
+            ++queue->n_resyncs;
+            queue->resync_trace_id = trace_id_new();
+        }
+        if(s_resync_fn) {
+            const uint32_t previous_trace_id = trace_id_swap(queue->resync_trace_id);
+            more = s_resync_fn(queue->onu_index, start);
+            trace_id_swap(previous_trace_id);
+        }
+        queue->resync_running = more;
+        queue->resync_pending = more;
+        return;
+    }
+
+    amxc_llist_it_t* it = amxc_llist_take_first(&lane_queue->events);
+    when_null(it, exit);
+    --lane_queue->size;
+
+    notif_event_t* event = amxc_container_of(it, notif_event_t, it);
+    ++queue->n_processed;
+
+    latency_stats_add(&s_lane_stats[lane].wait, latency_now_us() - event->enqueued_us);
+    if(s_process_fn) {
+        /* Process the notification under the trace ID it got when it arrived */
+        const uint32_t previous_trace_id = trace_id_swap(event->trace_id);
+        s_process_fn(queue->onu_index, event->type, &event->data, event->enqueued_us);
+        trace_id_swap(previous_trace_id);
+    }
+    latency_stats_add(&s_lane_stats[lane].total, latency_now_us() - event->enqueued_us);
+    free_event(it);
+
+exit:
+    return;
+}
+
+/**
+ * Take the next lane to serve from the lists of ready lanes.
+ *
+ * @param[in,out] lane  the function returns the lane type via this parameter
+ *
+ * @return lane to serve, or NULL if no lane has work
+ */
+static notif_lane_queue_t* take_next_ready_lane(notif_lane_t* const lane) {
+
+    uint32_t i;
+    amxc_llist_it_t* it = NULL;
+
+    for(i = 0; i < notif_lane_nr; ++i) {
+        it = amxc_llist_take_first(&s_ready_lanes[i]);
+        if(it) {
+            *lane = (notif_lane_t) i;
+            return amxc_container_of(it, notif_lane_queue_t, ready_it);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Drain the queues.
+ *
+ * Serve the lanes with pending work round-robin, one notification at a time,
+ * for at most 'events_per_pass' notifications. Always serve the high-priority
+ * lanes first: the function only serves a normal lane if no high-priority lane
+ * has work. If work remains afterwards, schedule a new pass: this gives the
+ * event loop the opportunity to handle other events first.
+ *
+ * A notification being processed can result in a new notification being
+ * queued (nested event handling while waiting for the reply of an ONU HAL
+ * agent). The function takes the lane out of the list of ready lanes while
+ * processing, and only puts it back at the end if it is not in the list yet.
+ */
+static void drain_cb(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+
+    uint32_t n_processed = 0;
+    notif_lane_queue_t* lane_queue = NULL;
+    notif_lane_t lane = notif_lane_normal;
+    const uint64_t start_us = stall_detector_begin();
+
+    s_drain_scheduled = false;
+
+    while(n_processed < s_config.events_per_pass) {
+        lane_queue = take_next_ready_lane(&lane);
+        if(NULL == lane_queue) {
+            break;
+        }
+        process_one(lane_queue, lane);
+        ++n_processed;
+
+        if(lane_has_work(lane_queue, lane) &&
+           !amxc_llist_it_is_in_list(&lane_queue->ready_it)) {
+            amxc_llist_append(&s_ready_lanes[lane], &lane_queue->ready_it);
+        }
+    }
+
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        if(!amxc_llist_is_empty(&s_ready_lanes[lane])) {
+            schedule_drain();
+            break;
+        }
+    }
+
+    stall_detector_end(stall_entry_notif_drain, start_us, "drain", NULL);
+}
+
+/**
+ * Add the statistics of a queue to a variant.
+ *
+ * @param[in] queue      queue
+ * @param[in,out] stats  the function adds an htable with the statistics of
+ *                       @a queue to this variant, which must be a list.
+ */
+void notif_queue_get_stats(const notif_queue_t* const queue, amxc_var_t* const stats) {
+
+    uint32_t lane;
+
+    when_null(queue, exit);
+    when_null(stats, exit);
+
+    amxc_var_t* entry = amxc_var_add(amxc_htable_t, stats, NULL);
+    when_null_trace(entry, exit, ERROR, "Failed to add entry to stats");
+
+    amxc_var_add_key(uint32_t, entry, "onu_index", queue->onu_index);
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        amxc_var_t* lane_var = amxc_var_add_key(amxc_htable_t, entry, LANE_NAMES[lane], NULL);
+        amxc_var_add_key(uint32_t, lane_var, "size", queue->lanes[lane].size);
+        amxc_var_add_key(uint32_t, lane_var, "max_size", queue->lanes[lane].max_size);
+    }
+    amxc_var_add_key(bool, entry, "resync_pending", queue->resync_pending);
+    amxc_var_add_key(uint64_t, entry, "enqueued", queue->n_enqueued);
+    amxc_var_add_key(uint64_t, entry, "processed", queue->n_processed);
+    amxc_var_add_key(uint64_t, entry, "dropped", queue->n_dropped);
+    amxc_var_add_key(uint64_t, entry, "overflows", queue->n_overflows);
+    amxc_var_add_key(uint64_t, entry, "resyncs", queue->n_resyncs);
+
+exit:
+    return;
+}
+
+void notif_queue_reset_stats(notif_queue_t* const queue) {
+
+    uint32_t lane;
+
+    when_null(queue, exit);
+
+    queue->n_enqueued = 0;
+    queue->n_processed = 0;
+    queue->n_dropped = 0;
+    queue->n_overflows = 0;
+    queue->n_resyncs = 0;
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        queue->lanes[lane].max_size = queue->lanes[lane].size;
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Add the latency statistics of the lanes to an htable variant.
+ *
+ * @param[in,out] stats  the function adds the key 'lanes' to this htable. Its
+ *                       value is an htable with per lane the latency
+ *                       statistics 'wait' and 'total'.
+ */
+void notif_queue_get_lane_stats(amxc_var_t* const stats) {
+
+    uint32_t lane;
+
+    when_null(stats, exit);
+
+    amxc_var_t* lanes = amxc_var_add_key(amxc_htable_t, stats, "lanes", NULL);
+    when_null_trace(lanes, exit, ERROR, "Failed to add 'lanes' to stats");
+
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        amxc_var_t* lane_var = amxc_var_add_key(amxc_htable_t, lanes, LANE_NAMES[lane], NULL);
+        amxc_var_t* wait = amxc_var_add_key(amxc_htable_t, lane_var, "wait", NULL);
+        amxc_var_t* total = amxc_var_add_key(amxc_htable_t, lane_var, "total", NULL);
+        latency_stats_to_var(&s_lane_stats[lane].wait, wait);
+        latency_stats_to_var(&s_lane_stats[lane].total, total);
+    }
+
+exit:
+    return;
+}
+
+void notif_queue_reset_lane_stats(void) {
+    uint32_t lane;
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        latency_stats_reset(&s_lane_stats[lane].wait);
+        latency_stats_reset(&s_lane_stats[lane].total);
+    }
+}
+
+/**
+ * Initialize the scheduler draining the queues.
+ *
+ * @param[in] process_fn  function to call for each notification taken from a
+ *                        queue
+ * @param[in] resync_fn   function to call if a resync is needed for an ONU
+ *                        because its queue overflowed
+ *
+ * The module must call this function once at startup.
+ *
+ * @return true on success, else false
+ */
+bool notif_queue_init_scheduler(notif_queue_process_fn_t process_fn,
+                                notif_queue_resync_fn_t resync_fn) {
+
+    bool rv = false;
+    uint32_t lane;
+
+    s_process_fn = process_fn;
+    s_resync_fn = resync_fn;
+    s_drain_scheduled = false;
+    for(lane = 0; lane < notif_lane_nr; ++lane) {
+        amxc_llist_init(&s_ready_lanes[lane]);
+    }
+    notif_queue_reset_lane_stats();
+
+    if(amxp_timer_new(&s_drain_timer, drain_cb, NULL) != 0) {
+        SAH_TRACEZ_ERROR(ME, "Failed to create drain timer");
+        goto exit;
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Clean up the scheduler.
+ *
+ * The caller must clean up all queues with notif_queue_clean() before calling
+ * this function.
+ */
+void notif_queue_cleanup_scheduler(void) {
+
+    amxp_timer_delete(&s_drain_timer);
+    s_drain_scheduled = false;
+    s_process_fn = NULL;
+    s_resync_fn = NULL;
+}
+
+/**
+ * Configure the queues and the scheduler.
+ *
+ * @param[in] depth            max nr of notifications in one lane of the queue
+ *                             of one ONU. Must be at most NOTIF_QUEUE_MAX_DEPTH.
+ *                             NOTIF_QUEUE_UNBOUNDED (0) means no limit.
+ * @param[in] policy           what to do if a notification arrives while the
+ *                             lane is full
+ * @param[in] events_per_pass  max nr of notifications the scheduler processes
+ *                             before giving control back to the event loop.
+ *                             Must be at least 1.
+ *
+ * A new depth smaller than the current size of a lane only takes effect when
+ * the next notification arrives for that lane.
+ *
+ * @return true on success, else false
+ */
+bool notif_queue_set_config(uint32_t depth,
+                            notif_queue_overflow_policy_t policy,
+                            uint32_t events_per_pass) {
+    bool rv = false;
+
+    if(depth > NOTIF_QUEUE_MAX_DEPTH) {
+        SAH_TRACEZ_ERROR(ME, "depth=%u is not in [0, %d]", depth, NOTIF_QUEUE_MAX_DEPTH);
+        goto exit;
+    }
+    when_false_trace(policy < notif_queue_overflow_policy_nr, exit, ERROR,
+                     "Invalid overflow policy [%d]", policy);
+    when_false_trace(events_per_pass != 0, exit, ERROR, "events_per_pass is 0");
+
+    SAH_TRACEZ_INFO(ME, "depth=%u policy=%s events_per_pass=%u", depth,
+                    POLICY_NAMES[policy], events_per_pass);
+    s_config.depth = depth;
+    s_config.policy = policy;
+    s_config.events_per_pass = events_per_pass;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Add the configuration of the queues to an htable variant.
+ */
+void notif_queue_get_config(amxc_var_t* const config) {
+
+    when_null(config, exit);
+
+    amxc_var_add_key(uint32_t, config, "depth", s_config.depth);
+    amxc_var_add_key(cstring_t, config, "overflow_policy", POLICY_NAMES[s_config.policy]);
+    amxc_var_add_key(uint32_t, config, "events_per_pass", s_config.events_per_pass);
+
+exit:
+    return;
+}
+
+/**
+ * Convert a string to an overflow policy.
+ *
+ * @param[in] policy  "drop_oldest" or "resync"
+ *
+ * @return the overflow policy upon success, notif_queue_overflow_policy_nr if
+ *         @a policy is unknown
+ */
+notif_queue_overflow_policy_t notif_queue_policy_from_string(const char* const policy) {
+
+    uint32_t i;
+
+    when_null(policy, exit);
+
+    for(i = 0; i < notif_queue_overflow_policy_nr; ++i) {
+        if(strcmp(policy, POLICY_NAMES[i]) == 0) {
+            return (notif_queue_overflow_policy_t) i;
+        }
+    }
+
+exit:
+    return notif_queue_overflow_policy_nr;
+}
+
+const char* notif_queue_policy_to_string(notif_queue_overflow_policy_t policy) {
+    return (policy < notif_queue_overflow_policy_nr) ? POLICY_NAMES[policy] : NULL;
+}
@@ -63,7 +63,8 @@
 #include "pon_ctrl.h"
 
 #include <stdio.h>  /* snprintf() */
-#include <string.h> /* strncmp() */
+#include <stdlib.h> /* strtoul() */
+#include <string.h> /* strcmp(), memset() */
 
 #include <amxc/amxc_macros.h>
 #include <amxc/amxc.h>
@@ -75,29 +76,82 @@
 #include <amxb/amxb.h>        /* amxb_bus_ctx_t */
 
 #include "dm_info.h"
-#include "mod_xpon_macros.h" /* ARRAY_SIZE() */
+#include "flight_recorder.h"   /* flight_recorder_dump() */
+#include "latency_stats.h"
+#include "mod_xpon_macros.h"   /* ARRAY_SIZE() */
 #include "mod_xpon_trace.h"
-#include "notif.h"           /* notif_subscribe() */
-#include "object_utils.h"    /* obj_process_object_params() */
-#include "southbound_if.h"   /* sbi_enable() */
-#include "ubus_prpl.h"       /* ubus_prpl_get_indexes() */
+#include "notif.h"             /* notif_subscribe() */
+#include "notif_queue.h"       /* notif_queue_set_config() */
+#include "sbi_loopback.h"      /* sbi_loopback_inject() */
+#include "shadow_mirror.h"     /* shadow_mirror_get_object_content() */
+#include "southbound_if.h"     /* sbi_enable() */
+#include "stall_detector.h"    /* stall_detector_begin() */
+#include "string_pool.h"       /* string_pool_get_stats() */
+#include "trace_id.h"          /* trace_id_new() */
+#include "traffic_recorder.h"  /* traffic_recorder_start() */
+#include "xpon_mgr_pon_stat.h" /* xpon_mgr_pon_stat_set_batch_config() */
 
 #define MOD_PON_CTRL "pon_ctrl"
 
 static amxm_module_t* s_pon_ctrl_module = NULL;
 static amxb_bus_ctx_t* s_bus_ctx = NULL;
 
-#ifndef MAX_NR_OF_ONUS
-#error MAX_NR_OF_ONUS is not defined
-#endif
+/**
+ * Functions in the 'pon_ctrl' namespace.
+ *
+ * The list expands to the index of each function, to a wrapper per function
+ * which passes that index to dispatch(), and to MOD_PON_CTRL_FUNCS.
+ */
+#define PON_CTRL_FUNCS(FUNC) \
+    FUNC(set_max_nr_of_onus) \
+    FUNC(set_enable) \
+    FUNC(get_list_of_instances) \
+    FUNC(get_object_content) \
+    FUNC(get_param_values) \
+    FUNC(set_notif_queue_config) \
+    FUNC(set_pon_stat_batch_config) \
+    FUNC(set_shadow_mirror_config) \
+    FUNC(dump_flight_recorder) \
+    FUNC(set_stall_thresholds) \
+    FUNC(set_trace_id_propagation) \
+    FUNC(set_traffic_recording) \
+    FUNC(set_southbound_backend) \
+    FUNC(inject_notification) \
+    FUNC(get_stats) \
+    FUNC(reset_stats)
+
+#define FUNC_INDEX(name) func_index_ ## name,
+typedef enum _func_index {
+    PON_CTRL_FUNCS(FUNC_INDEX)
+    func_index_nr
+} func_index_t;
+
+/* Statistics per function, in the same order as MOD_PON_CTRL_FUNCS */
+static latency_stats_t s_func_stats[func_index_nr];
+
+static void add_function_stats(amxc_var_t* const stats);
+static void update_loopback_functions(void);
 
-static uint32_t s_max_nr_of_onus = MAX_NR_OF_ONUS;
+/**
+ * Add a span of the current request to the flight recorder.
+ *
+ * @param[in] op        fr_op_span_path_translation or fr_op_span_conversion
+ * @param[in] id        object ID
+ * @param[in] start_us  time the span started
+ * @param[in] success   false if the operation in the span failed
+ */
+static void add_span(fr_op_t op, object_id_t id, uint64_t start_us, bool success) {
+    flight_recorder_add(op, id, 0, latency_now_us() - start_us, success ? 0 : -1);
+}
 
 /**
  * Set the max nr of ONUs on this board.
  *
  * @param[in] args  the variant must be an uint32_t with the max nr of ONUs
  *
+ * The module sizes its ONU table according to this number. See
+ * notif_set_max_nr_of_onus().
+ *
  * @return 0 on success
  * @return -1 on error
  */
@@ -109,18 +163,10 @@ static int set_max_nr_of_onus(UNUSED const char* function_name,
     when_null(args, exit);
 
     const uint32_t max_nr_of_onus = amxc_var_constcast(uint32_t, args);
-    if((0 == max_nr_of_onus) || (max_nr_of_onus > MAX_NR_OF_ONUS)) {
-        SAH_TRACEZ_ERROR(ME, "max_nr_of_onus=%d is not in [1, %d]",
-                         max_nr_of_onus, MAX_NR_OF_ONUS);
+    if(!notif_set_max_nr_of_onus(max_nr_of_onus)) {
         goto exit;
     }
 
-    if(s_max_nr_of_onus != max_nr_of_onus) {
-        SAH_TRACEZ_INFO(ME, "max_nr_of_onus: %d -> %d", s_max_nr_of_onus,
-                        max_nr_of_onus);
-        s_max_nr_of_onus = max_nr_of_onus;
-    }
-
     rc = 0;
 
 exit:
@@ -161,15 +207,22 @@ static int set_enable(UNUSED const char* function_name,
     const bool enable = GET_BOOL(args, "enable");
     SAH_TRACEZ_INFO(ME, "path='%s' enable=%d", path, enable);
 
-    if(!dm_convert_bbf_path_to_prpl_path(path, &prpl_path)) {
+    /* Only used for the statistics: no need to fail on an unknown ID */
+    const object_id_t id = dm_get_object_id(path);
+
+    const uint64_t start_us = latency_now_us();
+    const bool converted = dm_convert_bbf_path_to_prpl_path(path, &prpl_path);
+    add_span(fr_op_span_path_translation, id, start_us, converted);
+    if(!converted) {
         SAH_TRACEZ_ERROR(ME, "path='%s': failed to convert to prpl path", path);
         goto exit;
     }
 
-    if(!sbi_enable(s_bus_ctx, &prpl_path, enable)) {
+    if(!sbi_enable(s_bus_ctx, id, &prpl_path, enable)) {
         SAH_TRACEZ_ERROR(ME, "path='%s' enable=%d failed", path, enable);
         goto exit;
     }
+    shadow_mirror_forget(amxc_string_get(&prpl_path, 0));
 
     rc = 0;
 
@@ -192,7 +245,7 @@ static bool get_indexes(const char* const bbf_path,
     }
     const char* const prpl_path_cstr = amxc_string_get(&prpl_path, 0);
 
-    if(!ubus_prpl_get_indexes(prpl_path_cstr, indexes)) {
+    if(!sbi_get_indexes(prpl_path_cstr, indexes)) {
         SAH_TRACEZ_ERROR(ME, "path='%s': failed to get instances", bbf_path);
         goto exit;
     }
@@ -208,6 +261,34 @@ exit:
     return rv;
 }
 
+/**
+ * Subscribe on the notifications from xpon_onu.<index> if it exists.
+ *
+ * @return true if xpon_onu.<index> exists, else false
+ */
+static bool subscribe_onu(uint32_t index) {
+
+    char onu_path[16];
+
+    snprintf(onu_path, 16, "xpon_onu.%u", index);
+    amxb_bus_ctx_t* const bus_ctx = sbi_who_has(onu_path);
+    if(NULL == bus_ctx) {
+        SAH_TRACEZ_DEBUG(ME, "%s does not exist", onu_path);
+        return false;
+    }
+
+    if(NULL == s_bus_ctx) {
+        SAH_TRACEZ_DEBUG(ME, "Set bus context");
+        s_bus_ctx = bus_ctx;
+    } else if(bus_ctx != s_bus_ctx) {
+        SAH_TRACEZ_ERROR(ME, "bus ctx [%p] != s_bus_ctx [%p]",
+                         bus_ctx, s_bus_ctx);
+    }
+
+    notif_subscribe(bus_ctx, index);
+    return true;
+}
+
 /**
  * Check xpon_onu instances.
  *
@@ -221,7 +302,12 @@ exit:
  *
  * Note: this module assumes that an ONU HAL agent keeps running until reboot.
  * Hence it assumes an xpon_onu instance does not disappear. And hence it does
- * not unsubscribe from any xpon_onu instances.
+ * not unsubscribe from any xpon_onu instances. The function takes the
+ * instances the module subscribed on from the ONU table, and only asks the
+ * bus about the other indexes. Only at a cold start, i.e., as long as the
+ * module did not subscribe on any xpon_onu instance, it lists the existing
+ * instances via sbi_get_indexes(). Depending on the backend, that runs
+ * 'ubus list'.
  *
  * Example:
  * if the function finds out that xpon_onu.1 and xpon_onu.2 exist, it assigns
@@ -230,39 +316,50 @@ exit:
 static void get_onu_indexes(amxc_string_t* const indexes) {
 
     bool first = true;
-    uint32_t i;
-    char onu_path[16];
-    amxb_bus_ctx_t* bus_ctx;
     uint32_t index;
+    const char* idx;
+    char* end = NULL;
+
+    const uint32_t max_nr_of_onus = notif_get_max_nr_of_onus();
 
-    for(i = 0; i < s_max_nr_of_onus; ++i) {
-        index = (i + 1);
-        snprintf(onu_path, 16, "xpon_onu.%d", index);
-        bus_ctx = amxb_be_who_has(onu_path);
+    amxc_string_t found;
+    amxc_string_init(&found, 0);
 
-        if(bus_ctx) {
-            if(first) {
-                amxc_string_appendf(indexes, "%d", index);
+    if(notif_get_nr_of_subscribed_onus() != 0) {
+        for(index = 1; index <= max_nr_of_onus; ++index) {
+            if(notif_is_subscribed(index) || subscribe_onu(index)) {
+                amxc_string_appendf(indexes, first ? "%d" : ",%d", index);
                 first = false;
-            } else {
-                amxc_string_appendf(indexes, ",%d", index);
             }
+        }
+        goto exit;
+    }
 
-            if(NULL == s_bus_ctx) {
-                SAH_TRACEZ_DEBUG(ME, "Set bus context");
-                s_bus_ctx = bus_ctx;
-            } else if(bus_ctx != s_bus_ctx) {
-                SAH_TRACEZ_ERROR(ME, "bus ctx [%p] != s_bus_ctx [%p]",
-                                 bus_ctx, s_bus_ctx);
-            }
+    if(!sbi_get_indexes("xpon_onu", &found)) {
+        SAH_TRACEZ_DEBUG(ME, "xpon_onu does not exist");
+        goto exit;
+    }
 
-            if(!notif_is_subscribed(index)) {
-                notif_subscribe(bus_ctx, index);
-            }
-        } else {
-            SAH_TRACEZ_DEBUG(ME, "%s does not exist", onu_path);
+    idx = amxc_string_get(&found, 0);
+    while((idx != NULL) && (*idx != '\0')) {
+        index = (uint32_t) strtoul(idx, &end, 10);
+        if(end == idx) {
+            break;
+        }
+        idx = (*end == ',') ? end + 1 : end;
+
+        if((0 == index) || (index > max_nr_of_onus)) {
+            SAH_TRACEZ_WARNING(ME, "xpon_onu.%u: index is not in [1, %u]", index, max_nr_of_onus);
+            continue;
+        }
+        if(notif_is_subscribed(index) || subscribe_onu(index)) {
+            amxc_string_appendf(indexes, first ? "%d" : ",%d", index);
+            first = false;
         }
     }
+
+exit:
+    amxc_string_clean(&found);
 }
 
 /**
@@ -329,7 +426,10 @@ exit:
     return rc;
 }
 
-static bool query_object(const amxc_string_t* const bbf_path, amxc_var_t* params) {
+static bool query_object(object_id_t id,
+                         const amxc_string_t* const bbf_path,
+                         bool extract_key,
+                         amxc_var_t* ret) {
 
     bool rv = false;
     const char* const bbf_path_cstr = amxc_string_get(bbf_path, 0);
@@ -338,12 +438,15 @@ static bool query_object(const amxc_string_t* const bbf_path, amxc_var_t* params
     amxc_string_t prpl_path;
     amxc_string_init(&prpl_path, 0);
 
-    if(!dm_convert_bbf_path_to_prpl_path(bbf_path_cstr, &prpl_path)) {
+    const uint64_t start_us = latency_now_us();
+    const bool converted = dm_convert_bbf_path_to_prpl_path(bbf_path_cstr, &prpl_path);
+    add_span(fr_op_span_path_translation, id, start_us, converted);
+    if(!converted) {
         SAH_TRACEZ_ERROR(ME, "path='%s': failed to convert to prpl path", bbf_path_cstr);
         goto exit;
     }
 
-    if(!sbi_query_object(s_bus_ctx, &prpl_path, params)) {
+    if(!shadow_mirror_get_object_content(s_bus_ctx, id, &prpl_path, extract_key, ret)) {
         goto exit;
     }
 
@@ -374,10 +477,8 @@ static int get_object_content(UNUSED const char* function_name,
                               amxc_var_t* args,
                               amxc_var_t* ret) {
     int rc = -1;
-    amxc_var_t params;
     amxc_string_t bbf_path;
 
-    amxc_var_init(&params); /* will contain the param value(s) */
     amxc_string_init(&bbf_path, 0);
 
     when_null(args, exit);
@@ -403,13 +504,7 @@ static int get_object_content(UNUSED const char* function_name,
         amxc_string_appendf(&bbf_path, ".%d", index);
     }
 
-    if(!query_object(&bbf_path, &params)) {
-        goto exit;
-    }
-
-    const bool extract_key = (index != 0);
-    if(!obj_process_object_params(id, &params, extract_key, ret,
-                                  amxc_string_get(&bbf_path, 0))) {
+    if(!query_object(id, &bbf_path, /*extract_key=*/ (index != 0), ret)) {
         goto exit;
     }
 
@@ -417,14 +512,13 @@ static int get_object_content(UNUSED const char* function_name,
 
 exit:
     amxc_string_clean(&bbf_path);
-    amxc_var_clean(&params);
     return rc;
 }
 
 static bool query_params(object_id_t id,
                          const amxc_string_t* const bbf_path,
                          const char* const bbf_param_names,
-                         amxc_var_t* params) {
+                         amxc_var_t* ret) {
 
     bool rv = false;
     const char* const bbf_path_cstr = amxc_string_get(bbf_path, 0);
@@ -436,17 +530,21 @@ static bool query_params(object_id_t id,
     amxc_string_init(&prpl_path, 0);
     amxc_string_init(&prpl_param_names, 0);
 
+    const uint64_t start_us = latency_now_us();
     if(!dm_convert_bbf_path_to_prpl_path(bbf_path_cstr, &prpl_path)) {
         SAH_TRACEZ_ERROR(ME, "path='%s': failed to convert to prpl path", bbf_path_cstr);
+        add_span(fr_op_span_path_translation, id, start_us, false);
         goto exit;
     }
 
-    if(!dm_convert_param_names(id, bbf_param_names, &prpl_param_names)) {
+    const bool converted = dm_convert_param_names(id, bbf_param_names, &prpl_param_names);
+    add_span(fr_op_span_path_translation, id, start_us, converted);
+    if(!converted) {
         goto exit;
     }
 
     const char* const prpl_param_names_ctr = amxc_string_get(&prpl_param_names, 0);
-    if(!sbi_query_params(s_bus_ctx, &prpl_path, prpl_param_names_ctr, params)) {
+    if(!shadow_mirror_get_param_values(s_bus_ctx, id, &prpl_path, prpl_param_names_ctr, ret)) {
         goto exit;
     }
 
@@ -478,10 +576,8 @@ static int get_param_values(UNUSED const char* function_name,
                             amxc_var_t* args,
                             amxc_var_t* ret) {
     int rc = -1;
-    amxc_var_t params;
     amxc_string_t bbf_path;
 
-    amxc_var_init(&params); /* will contain the param value(s) */
     amxc_string_init(&bbf_path, 0);
 
     when_null(args, exit);
@@ -506,37 +602,539 @@ static int get_param_values(UNUSED const char* function_name,
 
     amxc_string_set(&bbf_path, path);
 
-    if(!query_params(id, &bbf_path, names, &params)) {
+    if(!query_params(id, &bbf_path, names, ret)) {
+        goto exit;
+    }
+
+    rc = 0;
+
+exit:
+    amxc_string_clean(&bbf_path);
+    return rc;
+}
+
+
+/**
+ * Configure the queues with the notifications of the ONU HAL agents.
+ *
+ * @param[in] args  htable with one or more of following keys:
+ *                  - 'depth': max nr of notifications in the queue of one ONU,
+ *                    0 for no limit
+ *                  - 'overflow_policy': "drop_oldest" or "resync"
+ *                  - 'events_per_pass': max nr of notifications processed
+ *                    before giving control back to the event loop
+ *                  The function keeps the current value for a missing key.
+ *
+ * See notif_queue.h for more info.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_notif_queue_config(UNUSED const char* function_name,
+                                  amxc_var_t* args,
+                                  UNUSED amxc_var_t* ret) {
+    int rc = -1;
+    amxc_var_t current;
+    amxc_var_init(&current);
+    amxc_var_set_type(&current, AMXC_VAR_ID_HTABLE);
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+
+    notif_queue_get_config(&current);
+
+    const amxc_var_t* const depth_var = GET_ARG(args, "depth");
+    const amxc_var_t* const policy_var = GET_ARG(args, "overflow_policy");
+    const amxc_var_t* const per_pass_var = GET_ARG(args, "events_per_pass");
+
+    const uint32_t depth = depth_var ? amxc_var_dyncast(uint32_t, depth_var) :
+        GET_UINT32(&current, "depth");
+    const char* const policy_str = policy_var ? amxc_var_constcast(cstring_t, policy_var) :
+        GET_CHAR(&current, "overflow_policy");
+    const uint32_t events_per_pass = per_pass_var ? amxc_var_dyncast(uint32_t, per_pass_var) :
+        GET_UINT32(&current, "events_per_pass");
+
+    const notif_queue_overflow_policy_t policy = notif_queue_policy_from_string(policy_str);
+    if(notif_queue_overflow_policy_nr == policy) {
+        SAH_TRACEZ_ERROR(ME, "Unknown overflow policy '%s'", policy_str ? policy_str : "");
         goto exit;
     }
 
-    if(!obj_process_object_params(id, &params, /*extract_key=*/ false, ret,
-                                  amxc_string_get(&bbf_path, 0))) {
+    if(!notif_queue_set_config(depth, policy, events_per_pass)) {
         goto exit;
     }
 
     rc = 0;
 
 exit:
-    amxc_string_clean(&bbf_path);
-    amxc_var_clean(&params);
+    amxc_var_clean(&current);
+    return rc;
+}
+
+/**
+ * Configure batched delivery of the calls to the 'pon_stat' namespace.
+ *
+ * @param[in] args  htable with following optional keys:
+ *                  - 'enable': bool. If true, the module collects the calls
+ *                    to the 'pon_stat' namespace in batches and delivers them
+ *                    via 'dm_batch' (or one by one if the tr181-xpon plugin
+ *                    does not support 'dm_batch').
+ *                  - 'max_batch_size': max nr of calls in one batch
+ *                  - 'window_ms': max time a call waits in a batch. 0 means
+ *                    until the next iteration of the event loop.
+ *                  The module keeps the current value for a missing key.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_pon_stat_batch_config(UNUSED const char* function_name,
+                                     amxc_var_t* args,
+                                     UNUSED amxc_var_t* ret) {
+    int rc = -1;
+    amxc_var_t current;
+    amxc_var_init(&current);
+    amxc_var_set_type(&current, AMXC_VAR_ID_HTABLE);
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+
+    xpon_mgr_pon_stat_get_batch_config(&current);
+
+    const amxc_var_t* const enable_var = GET_ARG(args, "enable");
+    const amxc_var_t* const size_var = GET_ARG(args, "max_batch_size");
+    const amxc_var_t* const window_var = GET_ARG(args, "window_ms");
+
+    const bool enable = enable_var ? amxc_var_dyncast(bool, enable_var) :
+        GET_BOOL(&current, "enable");
+    const uint32_t max_batch_size = size_var ? amxc_var_dyncast(uint32_t, size_var) :
+        GET_UINT32(&current, "max_batch_size");
+    const uint32_t window_ms = window_var ? amxc_var_dyncast(uint32_t, window_var) :
+        GET_UINT32(&current, "window_ms");
+
+    if(!xpon_mgr_pon_stat_set_batch_config(enable, max_batch_size, window_ms)) {
+        goto exit;
+    }
+
+    rc = 0;
+
+exit:
+    amxc_var_clean(&current);
+    return rc;
+}
+
+/**
+ * Configure the in-memory mirror of the prpl xpon_onu objects.
+ *
+ * @param[in] args  htable with following optional keys:
+ *                  - 'enable': bool. If true, the module serves reads from
+ *                    the mirror where it can. If false, it drops the mirror.
+ *                  - 'volatile_max_age_ms': max age of a volatile value
+ *                    served from the mirror, e.g., the rx power. 0 means the
+ *                    module always reads it from the ONU HAL agent.
+ *                  The module keeps the current value for a missing key.
+ *
+ * See shadow_mirror.h for more info.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_shadow_mirror_config(UNUSED const char* function_name,
+                                    amxc_var_t* args,
+                                    UNUSED amxc_var_t* ret) {
+    int rc = -1;
+    amxc_var_t current;
+    amxc_var_init(&current);
+    amxc_var_set_type(&current, AMXC_VAR_ID_HTABLE);
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+
+    shadow_mirror_get_config(&current);
+
+    const amxc_var_t* const enable_var = GET_ARG(args, "enable");
+    const amxc_var_t* const max_age_var = GET_ARG(args, "volatile_max_age_ms");
+
+    const bool enable = enable_var ? amxc_var_dyncast(bool, enable_var) :
+        GET_BOOL(&current, "enable");
+    const uint32_t max_age_ms = max_age_var ? amxc_var_dyncast(uint32_t, max_age_var) :
+        GET_UINT32(&current, "volatile_max_age_ms");
+
+    if(!shadow_mirror_set_config(enable, max_age_ms)) {
+        goto exit;
+    }
+
+    rc = 0;
+
+exit:
+    amxc_var_clean(&current);
+    return rc;
+}
+
+/**
+ * Dump the records of the flight recorder.
+ *
+ * @param[in] args     optional htable with the key 'clear'. If it's true, the
+ *                     function clears the flight recorder after the dump.
+ * @param[in,out] ret  the function returns the records via this parameter.
+ *                     It's a list, the oldest record first. See
+ *                     flight_recorder_dump().
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int dump_flight_recorder(UNUSED const char* function_name,
+                                amxc_var_t* args,
+                                amxc_var_t* ret) {
+    int rc = -1;
+
+    when_null(ret, exit);
+
+    amxc_var_set_type(ret, AMXC_VAR_ID_LIST);
+    flight_recorder_dump(ret);
+
+    if(args && (amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE) && GET_BOOL(args, "clear")) {
+        flight_recorder_clear();
+    }
+
+    rc = 0;
+
+exit:
     return rc;
 }
 
+/**
+ * Set the thresholds of the stall detector.
+ *
+ * @param[in] args  htable with following optional keys:
+ *                  - 'warn_ms': an invocation of an entry point of this module
+ *                    taking longer is a stall
+ *                  - 'severe_ms': an invocation taking longer is a severe stall
+ *                  The module keeps the current value for a missing key.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_stall_thresholds(UNUSED const char* function_name,
+                                amxc_var_t* args,
+                                UNUSED amxc_var_t* ret) {
+    int rc = -1;
+    amxc_var_t current;
+    amxc_var_init(&current);
+    amxc_var_set_type(&current, AMXC_VAR_ID_HTABLE);
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+
+    stall_detector_get_thresholds(&current);
+
+    const amxc_var_t* const warn_var = GET_ARG(args, "warn_ms");
+    const amxc_var_t* const severe_var = GET_ARG(args, "severe_ms");
+
+    const uint32_t warn_ms = warn_var ? amxc_var_dyncast(uint32_t, warn_var) :
+        GET_UINT32(&current, "warn_ms");
+    const uint32_t severe_ms = severe_var ? amxc_var_dyncast(uint32_t, severe_var) :
+        GET_UINT32(&current, "severe_ms");
+
+    if(!stall_detector_set_thresholds(warn_ms, severe_ms)) {
+        goto exit;
+    }
+
+    rc = 0;
+
+exit:
+    amxc_var_clean(&current);
+    return rc;
+}
+
+/**
+ * Enable or disable passing trace IDs to the ONU HAL agents.
+ *
+ * @param[in] args  htable with the key 'enable'. If true, the module adds the
+ *                  argument 'trace_id' to each call towards an ONU HAL agent.
+ *                  See trace_id.h.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_trace_id_propagation(UNUSED const char* function_name,
+                                    amxc_var_t* args,
+                                    UNUSED amxc_var_t* ret) {
+    int rc = -1;
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+    when_null_trace(GET_ARG(args, "enable"), exit, ERROR, "Failed to extract 'enable'");
+
+    trace_id_set_propagation(GET_BOOL(args, "enable"));
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Start or stop recording the traffic on the southbound interface.
+ *
+ * @param[in] args  htable with the key 'enable', and the key 'file' if
+ *                  'enable' is true: path of the trace file. See
+ *                  traffic_recorder.h for its format.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_traffic_recording(UNUSED const char* function_name,
+                                 amxc_var_t* args,
+                                 UNUSED amxc_var_t* ret) {
+    int rc = -1;
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+    when_null_trace(GET_ARG(args, "enable"), exit, ERROR, "Failed to extract 'enable'");
+
+    if(GET_BOOL(args, "enable")) {
+        const char* const file = GET_CHAR(args, "file");
+        when_null_trace(file, exit, ERROR, "Failed to extract 'file'");
+        when_false(traffic_recorder_start(file), exit);
+    } else {
+        traffic_recorder_stop();
+    }
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Select the backend of the southbound interface.
+ *
+ * @param[in] args  htable with the key 'name': "amxb", "loopback" or, if
+ *                  the module is built with it, "ubus". The other keys are
+ *                  passed to the backend as settings. See
+ *                  sbi_loopback_configure() and sbi_ubus_configure().
+ *
+ * The caller must select the backend before the first call of
+ * get_list_of_instances() for XPON.ONU. Afterwards the function refuses.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int set_southbound_backend(UNUSED const char* function_name,
+                                  amxc_var_t* args,
+                                  UNUSED amxc_var_t* ret) {
+    int rc = -1;
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+    const char* const name = GET_CHAR(args, "name");
+    when_null_trace(name, exit, ERROR, "Failed to extract 'name'");
+    when_false_trace(NULL == s_bus_ctx, exit, ERROR,
+                     "Backend '%s' already serves xpon_onu instances", sbi_get_backend_name());
+
+    when_false(sbi_set_backend(name, args), exit);
+    update_loopback_functions();
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Let the loopback backend send a notification.
+ *
+ * @param[in] args  htable with the keys 'onu_index' and 'notification', and
+ *                  the keys the notification has, e.g., 'path' and 'index'.
+ *                  The function passes @a args as is to the module as if an
+ *                  ONU HAL agent sent it.
+ *
+ * Only the loopback backend supports this. The module only registers the
+ * function while the loopback backend is selected: it is a test hook.
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int inject_notification(UNUSED const char* function_name,
+                               amxc_var_t* args,
+                               UNUSED amxc_var_t* ret) {
+    int rc = -1;
+
+    when_null(args, exit);
+    when_false_trace(amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                     "args is not an htable");
+    const uint32_t onu_index = GET_UINT32(args, "onu_index");
+    when_null_trace(GET_CHAR(args, "notification"), exit, ERROR,
+                    "Failed to extract 'notification'");
+
+    when_false(sbi_loopback_inject(onu_index, args), exit);
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Get the statistics of this module.
+ *
+ * @param[in,out] ret  the function returns the statistics via this parameter.
+ *                     It's an htable with a key per part of the module:
+ *                     - 'functions': calls, errors and latency histogram per
+ *                       function in this namespace
+ *                     - 'southbound': the same per method and per object for
+ *                       the calls towards the ONU HAL agents
+ *                     - 'stalls': see stall_detector_get_stats()
+ *                     - 'notif_queue', 'pon_stat': see notif_get_stats() and
+ *                       xpon_mgr_pon_stat_get_stats()
+ *                     - 'shadow_mirror', 'string_pool': see
+ *                       shadow_mirror_get_stats() and string_pool_get_stats()
+ *
+ * @return 0 on success
+ * @return -1 on error
+ */
+static int get_stats(UNUSED const char* function_name,
+                     UNUSED amxc_var_t* args,
+                     amxc_var_t* ret) {
+    int rc = -1;
+
+    when_null(ret, exit);
+
+    amxc_var_set_type(ret, AMXC_VAR_ID_HTABLE);
+    add_function_stats(ret);
+    sbi_get_stats(ret);
+    stall_detector_get_stats(ret);
+    notif_get_stats(ret);
+    xpon_mgr_pon_stat_get_stats(ret);
+    shadow_mirror_get_stats(ret);
+    string_pool_get_stats(ret);
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Reset the statistics of this module.
+ *
+ * @return 0
+ */
+static int reset_stats(UNUSED const char* function_name,
+                       UNUSED amxc_var_t* args,
+                       UNUSED amxc_var_t* ret) {
+    memset(s_func_stats, 0, sizeof(s_func_stats));
+    sbi_reset_stats();
+    stall_detector_reset_stats();
+    notif_reset_stats();
+    xpon_mgr_pon_stat_reset_stats();
+    shadow_mirror_reset_stats();
+    string_pool_reset_stats();
+    return 0;
+}
+
 
 typedef struct _func_info {
     const char* const name;
     amxm_callback_t cb;
+    amxm_callback_t wrapper; /* registered in the namespace: calls dispatch() */
 } func_info_t;
 
-static const func_info_t MOD_PON_CTRL_FUNCS[] = {
-    { .name = "set_max_nr_of_onus", .cb = set_max_nr_of_onus },
-    { .name = "set_enable", .cb = set_enable },
-    { .name = "get_list_of_instances", .cb = get_list_of_instances },
-    { .name = "get_object_content", .cb = get_object_content },
-    { .name = "get_param_values", .cb = get_param_values }
+static int dispatch(func_index_t index, const char* function_name,
+                    amxc_var_t* args, amxc_var_t* ret);
+
+#define FUNC_WRAPPER(name) \
+    static int dispatch_ ## name(const char* function_name, amxc_var_t* args, amxc_var_t* ret) { \
+        return dispatch(func_index_ ## name, function_name, args, ret); \
+    }
+PON_CTRL_FUNCS(FUNC_WRAPPER)
+
+#define FUNC_INFO(fname) { .name = #fname, .cb = fname, .wrapper = dispatch_ ## fname },
+static const func_info_t MOD_PON_CTRL_FUNCS[func_index_nr] = {
+    PON_CTRL_FUNCS(FUNC_INFO)
 };
 
+static const int N_PON_CTRL_FUNCS = ARRAY_SIZE(MOD_PON_CTRL_FUNCS);
+
+/**
+ * Register the functions which only make sense with the loopback backend
+ * while that backend is selected, and remove them otherwise.
+ *
+ * They are test hooks: they must not be reachable in production, where the
+ * module talks to the ONU HAL agents.
+ */
+static void update_loopback_functions(void) {
+
+    const func_info_t* const info = &MOD_PON_CTRL_FUNCS[func_index_inject_notification];
+    const bool loopback = (strcmp(sbi_get_backend_name(), SBI_BACKEND_LOOPBACK) == 0);
+    const bool registered = amxm_module_has_function(s_pon_ctrl_module, info->name);
+
+    if(loopback && !registered) {
+        amxm_module_add_function(s_pon_ctrl_module, info->name, info->wrapper);
+    } else if(!loopback && registered) {
+        amxm_module_remove_function(s_pon_ctrl_module, info->name);
+    }
+}
+
+/**
+ * Add a 'functions' section with the statistics per function to @a stats.
+ *
+ * @param[in,out] stats  htable
+ */
+static void add_function_stats(amxc_var_t* const stats) {
+
+    int i;
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "functions", NULL);
+    when_null(section, exit);
+
+    for(i = 0; i < N_PON_CTRL_FUNCS; ++i) {
+        amxc_var_t* const var =
+            amxc_var_add_key(amxc_htable_t, section, MOD_PON_CTRL_FUNCS[i].name, NULL);
+        latency_stats_to_var(&s_func_stats[i], var);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Entry point of all functions in the 'pon_ctrl' namespace.
+ *
+ * Call the function with index @a index in MOD_PON_CTRL_FUNCS, and update
+ * its call count, error count and latency histogram. Also report the
+ * invocation to the stall detector. The function gives each invocation a new
+ * trace ID.
+ *
+ * The wrapper registered for each function passes its index: the function
+ * does not need to look up @a function_name.
+ */
+static int dispatch(func_index_t index, const char* function_name,
+                    amxc_var_t* args, amxc_var_t* ret) {
+    int rc = -1;
+
+    when_false_trace(index < func_index_nr, exit, ERROR, "Invalid function index %d", index);
+
+    const uint32_t previous_trace_id = trace_id_swap(trace_id_new());
+    const uint64_t start_us = stall_detector_begin();
+    rc = MOD_PON_CTRL_FUNCS[index].cb(function_name, args, ret);
+    const uint64_t duration_us = latency_now_us() - start_us;
+    latency_stats_add_result(&s_func_stats[index], duration_us, (rc == 0));
+    flight_recorder_add(fr_op_pon_ctrl_request, obj_id_unknown, 0, duration_us, rc);
+    stall_detector_end(stall_entry_pon_ctrl, start_us, function_name, args);
+    trace_id_swap(previous_trace_id);
+
+exit:
+    return rc;
+}
+
 
 /**
  * Register the 'pon_ctrl' namespace.
@@ -557,10 +1155,14 @@ bool pon_ctrl_init(void) {
     when_failed_trace(rc, exit, ERROR, "Failed to register %s namespace (rc=%d)", MOD_PON_CTRL, rc);
     when_null_trace(s_pon_ctrl_module, exit, ERROR, "Failed to register %s namespace", MOD_PON_CTRL);
 
-    const int n_functions = ARRAY_SIZE(MOD_PON_CTRL_FUNCS);
-    for(i = 0; i < n_functions; ++i) {
-        amxm_module_add_function(s_pon_ctrl_module, MOD_PON_CTRL_FUNCS[i].name, MOD_PON_CTRL_FUNCS[i].cb);
+    for(i = 0; i < N_PON_CTRL_FUNCS; ++i) {
+        if(i == func_index_inject_notification) {
+            continue; /* See update_loopback_functions() */
+        }
+        amxm_module_add_function(s_pon_ctrl_module, MOD_PON_CTRL_FUNCS[i].name,
+                                 MOD_PON_CTRL_FUNCS[i].wrapper);
     }
+    update_loopback_functions();
 
     rv = true;
 
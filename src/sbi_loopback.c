@@ -0,0 +1,732 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "sbi_loopback.h"
+
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h> /* calloc(), free(), strtoul() */
+#include <string.h> /* strlen(), strchr(), strrchr(), strncmp(), strcmp(), memcpy() */
+
+#include <amxc/amxc_macros.h> /* when_null(), UNUSED */
+#include <amxc/amxc.h>
+
+#include "dm_info.h"         /* dm_get_object_id() */
+#include "mod_xpon_macros.h" /* ARRAY_SIZE() */
+#include "mod_xpon_trace.h"
+#include "notif.h"           /* NOTIF_MAX_NR_OF_ONUS_LIMIT */
+
+#define LOOPBACK_DEFAULT_NR_OF_ONUS 1
+#define LOOPBACK_DEFAULT_NR_OF_ETHERNET_UNIS 4
+#define LOOPBACK_DEFAULT_NR_OF_GEM_PORTS 8
+#define LOOPBACK_NR_OF_SOFTWARE_IMAGES 2
+
+/* Upper limit for the nr of Ethernet UNIs and GEM ports per ONU */
+#define LOOPBACK_MAX_NR_OF_INSTANCES 4096
+
+#define LOOPBACK_FIRST_GEM_PORT_ID 1024
+#define LOOPBACK_MAX_PATH_LEN 128
+#define LOOPBACK_MAX_VALUE_LEN 64
+
+/**
+ * State of an xpon_onu instance.
+ *
+ * - fn, priv: the subscriber on the notifications of the instance. 'fn' is
+ *   NULL if there is none.
+ * - enabled, ani_enabled: set by enable() and disable() on the xpon_onu
+ *   instance and on its ANI
+ */
+typedef struct _loopback_onu {
+    amxp_slot_fn_t fn;
+    void* priv;
+    bool enabled;
+    bool ani_enabled;
+} loopback_onu_t;
+
+/**
+ * State of the loopback backend.
+ *
+ * The backend allocates 'onus' when it needs it. 'revision' is incremented
+ * per injected notification. The generated param values depend on it, so a
+ * get() after a dm:object-changed returns other values than before.
+ */
+typedef struct _loopback {
+    loopback_onu_t* onus;
+    uint32_t n_onus;
+    uint32_t n_ethernet_unis;
+    uint32_t n_gem_ports;
+    uint32_t revision;
+} loopback_t;
+
+static loopback_t s_loopback = {
+    .onus = NULL,
+    .n_onus = LOOPBACK_DEFAULT_NR_OF_ONUS,
+    .n_ethernet_unis = LOOPBACK_DEFAULT_NR_OF_ETHERNET_UNIS,
+    .n_gem_ports = LOOPBACK_DEFAULT_NR_OF_GEM_PORTS,
+    .revision = 0
+};
+
+/**
+ * There is no bus. The backend hands out the address of its state as bus
+ * context: the module only compares it and passes it back.
+ */
+#define LOOPBACK_BUS_CTX ((amxb_bus_ctx_t*) &s_loopback)
+
+/**
+ * Object path resolved against the synthetic DM.
+ *
+ * - path: the path without trailing dot
+ * - id: ID of the object
+ * - onu_index: index of the xpon_onu instance, 0 for "xpon_onu" itself
+ * - index: the last instance index if the path ends with one, else 0
+ * - n_instances: nr of instances if the path refers to a template object
+ */
+typedef struct _loopback_path {
+    char path[LOOPBACK_MAX_PATH_LEN];
+    object_id_t id;
+    uint32_t onu_index;
+    uint32_t index;
+    uint32_t n_instances;
+} loopback_path_t;
+
+/* Value of a string parameter which is an enumeration in the prpl DM */
+typedef struct _loopback_enum_value {
+    const char* prpl_name;
+    const char* value;
+} loopback_enum_value_t;
+
+static const loopback_enum_value_t ENUM_VALUES[] = {
+    { .prpl_name = "status", .value = "Up" },
+    { .prpl_name = "pon_mode", .value = "XGS-PON" },
+    { .prpl_name = "direction", .value = "Bidirectional" },
+    { .prpl_name = "port_type", .value = "Unicast" },
+    { .prpl_name = "connector", .value = "SC" },
+    { .prpl_name = "onu_state", .value = "O5" }
+};
+
+static bool segment_equals(const char* const segment, size_t len,
+                           const char* const name) {
+    return (strlen(name) == len) && (strncmp(segment, name, len) == 0);
+}
+
+static bool segment_is_numeric(const char* const segment, size_t len) {
+
+    size_t i;
+
+    if(0 == len) {
+        return false;
+    }
+    for(i = 0; i < len; ++i) {
+        if((segment[i] < '0') || (segment[i] > '9')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Return the nr of instances of the template object with name @a segment,
+ * e.g. "ethernet_uni", or 0 if it's not a template object.
+ *
+ * @param[in] segment  name, not 0-terminated
+ * @param[in] len      length of the name
+ */
+static uint32_t get_nr_of_instances(const char* const segment, size_t len) {
+
+    if(segment_equals(segment, len, "xpon_onu")) {
+        return s_loopback.n_onus;
+    }
+    if(segment_equals(segment, len, "software_image")) {
+        return LOOPBACK_NR_OF_SOFTWARE_IMAGES;
+    }
+    if(segment_equals(segment, len, "ethernet_uni")) {
+        return s_loopback.n_ethernet_unis;
+    }
+    if(segment_equals(segment, len, "port")) {
+        return s_loopback.n_gem_ports;
+    }
+    if(segment_equals(segment, len, "ani") || segment_equals(segment, len, "transceiver")) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Resolve a prpl path against the synthetic DM.
+ *
+ * @param[in] object     prpl path, with or without trailing dot
+ * @param[in] instance   if true, @a object must refer to an instance or to a
+ *                       singleton object, e.g., "xpon_onu.1.ani.1" or
+ *                       "xpon_onu.1.ani.1.tc.alarms". Else it must refer to a
+ *                       template object, e.g., "xpon_onu.1.ani".
+ * @param[in,out] lp     the function returns the result via this parameter
+ *
+ * @return true if @a object exists in the synthetic DM, else false
+ */
+static bool resolve_path(const char* const object, bool instance,
+                         loopback_path_t* const lp) {
+
+    bool rv = false;
+    bool ends_with_index = false;
+    const char* name = NULL; /* last segment which is not an index */
+    size_t name_len = 0;
+    uint32_t index = 0;
+
+    memset(lp, 0, sizeof(*lp));
+    lp->id = obj_id_unknown;
+    when_null(object, exit);
+
+    size_t len = strlen(object);
+    if((len > 0) && (object[len - 1] == '.')) {
+        --len;
+    }
+    when_false_trace(len < sizeof(lp->path), exit, ERROR, "Path too long: '%s'", object);
+    memcpy(lp->path, object, len);
+    lp->path[len] = '\0';
+
+    const char* segment = lp->path;
+    while(*segment != '\0') {
+        const char* const dot = strchr(segment, '.');
+        const size_t segment_len = dot ? (size_t) (dot - segment) : strlen(segment);
+
+        ends_with_index = segment_is_numeric(segment, segment_len);
+        if(ends_with_index) {
+            index = (uint32_t) strtoul(segment, NULL, 10);
+            if((0 == index) || (NULL == name) ||
+               (index > get_nr_of_instances(name, name_len))) {
+                goto exit;
+            }
+            if(0 == lp->onu_index) {
+                lp->onu_index = index;
+            }
+        } else {
+            name = segment;
+            name_len = segment_len;
+        }
+        segment = dot ? (dot + 1) : (segment + segment_len);
+    }
+    when_null(name, exit);
+
+    lp->id = dm_get_object_id(lp->path);
+    when_false(lp->id < obj_id_nbr, exit);
+
+    const bool is_template = (dm_get_object_info(lp->id)->prpl_key_name != NULL);
+    if(instance) {
+        /* A template object itself has no params */
+        when_false(!is_template || ends_with_index, exit);
+        lp->index = ends_with_index ? index : 0;
+    } else {
+        when_false(is_template && !ends_with_index, exit);
+        lp->n_instances = get_nr_of_instances(name, name_len);
+    }
+
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Return the state of xpon_onu.<onu_index>, or NULL if it does not exist.
+ *
+ * The function allocates the state of all xpon_onu instances the first time.
+ */
+static loopback_onu_t* get_onu(uint32_t onu_index) {
+
+    uint32_t i;
+
+    if(NULL == s_loopback.onus) {
+        s_loopback.onus = (loopback_onu_t*) calloc(s_loopback.n_onus, sizeof(loopback_onu_t));
+        when_null_trace(s_loopback.onus, exit_error, ERROR, "Failed to allocate mem");
+        for(i = 0; i < s_loopback.n_onus; ++i) {
+            s_loopback.onus[i].enabled = true;
+            s_loopback.onus[i].ani_enabled = true;
+        }
+    }
+    if((0 == onu_index) || (onu_index > s_loopback.n_onus)) {
+        goto exit_error;
+    }
+    return &s_loopback.onus[onu_index - 1];
+
+exit_error:
+    return NULL;
+}
+
+/**
+ * Add the key of the instance @a lp refers to to @a table.
+ *
+ * The 'name' of an instance is the name of its template object followed by
+ * its index, e.g., "ethernet_uni_2".
+ */
+static void add_key_value(const object_info_t* const info,
+                          const loopback_path_t* const lp,
+                          amxc_var_t* const table) {
+
+    char value[LOOPBACK_MAX_VALUE_LEN];
+
+    if(strcmp(info->prpl_key_name, "name") == 0) {
+        const char* const dot = strrchr(info->prpl_path, '.');
+        snprintf(value, sizeof(value), "%s_%u", dot ? (dot + 1) : info->prpl_path, lp->index);
+        amxc_var_add_key(cstring_t, table, info->prpl_key_name, value);
+    } else if(obj_id_gem_port == lp->id) {
+        amxc_var_add_key(uint32_t, table, info->prpl_key_name,
+                         LOOPBACK_FIRST_GEM_PORT_ID + lp->index - 1);
+    } else {
+        /* The IDs of software images and transceivers start at 0 */
+        amxc_var_add_key(uint32_t, table, info->prpl_key_name, lp->index - 1);
+    }
+}
+
+/**
+ * Add the value of @a param to @a table.
+ *
+ * @param[in] seed  value the generated value is derived from
+ *
+ * The 'enable' param of an ONU or an ANI reflects the last call of enable()
+ * or disable(). String params which are an enumeration get a fixed valid
+ * value. The other values are derived from @a seed.
+ */
+static void add_param_value(const loopback_path_t* const lp,
+                            const param_info_t* const param,
+                            uint32_t seed,
+                            amxc_var_t* const table) {
+
+    char value[LOOPBACK_MAX_VALUE_LEN];
+    const char* str = NULL;
+    size_t i;
+
+    switch(param->type) {
+    case AMXC_VAR_ID_BOOL: {
+        bool bval = ((seed & 1) != 0);
+        if(strcmp(param->prpl_name, "enable") == 0) {
+            const loopback_onu_t* const onu = get_onu(lp->onu_index);
+            if(onu && (obj_id_onu == lp->id)) {
+                bval = onu->enabled;
+            } else if(onu && (obj_id_ani == lp->id)) {
+                bval = onu->ani_enabled;
+            }
+        }
+        amxc_var_add_key(bool, table, param->prpl_name, bval);
+        break;
+    }
+    case AMXC_VAR_ID_UINT32:
+        amxc_var_add_key(uint32_t, table, param->prpl_name, seed);
+        break;
+    case AMXC_VAR_ID_INT32:
+        amxc_var_add_key(int32_t, table, param->prpl_name, -(int32_t) (seed % 30000));
+        break;
+    case AMXC_VAR_ID_CSTRING:
+    case AMXC_VAR_ID_CSV_STRING:
+        for(i = 0; i < ARRAY_SIZE(ENUM_VALUES); ++i) {
+            if(strcmp(param->prpl_name, ENUM_VALUES[i].prpl_name) == 0) {
+                str = ENUM_VALUES[i].value;
+                break;
+            }
+        }
+        if(NULL == str) {
+            snprintf(value, sizeof(value), "%s_%u", param->prpl_name, seed);
+            str = value;
+        }
+        if(AMXC_VAR_ID_CSV_STRING == param->type) {
+            amxc_var_add_key(csv_string_t, table, param->prpl_name, str);
+        } else {
+            amxc_var_add_key(cstring_t, table, param->prpl_name, str);
+        }
+        break;
+    default:
+        SAH_TRACEZ_ERROR(ME, "%s: unsupported type %u", param->prpl_name, param->type);
+        break;
+    }
+}
+
+/**
+ * Return the index of the param with name @a name in @a info, or
+ * info->n_params if @a info does not have such a param.
+ *
+ * @param[in] name  param name, not 0-terminated
+ * @param[in] len   length of @a name
+ */
+static uint32_t find_param(const object_info_t* const info,
+                           const char* const name, size_t len) {
+
+    uint32_t i;
+
+    for(i = 0; i < info->n_params; ++i) {
+        if(segment_equals(name, len, info->params[i].prpl_name)) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * Fill in the reply of get() or get_params().
+ *
+ * @param[in] lp       object being queried
+ * @param[in] names    comma-separated list of param names for get_params(),
+ *                     NULL for get()
+ * @param[in,out] ret  the function returns the reply via this parameter: a
+ *                     list with one htable, as amxb_call() does. The
+ *                     caller can pass NULL.
+ *
+ * @return 0 on success, else an amxd_status_t value
+ */
+static int fill_reply(const loopback_path_t* const lp,
+                      const char* const names,
+                      amxc_var_t* const ret) {
+
+    int rc = amxd_status_ok;
+    uint32_t i;
+    const object_info_t* const info = dm_get_object_info(lp->id);
+    const uint32_t seed = s_loopback.revision + lp->index;
+
+    when_null(ret, exit);
+
+    amxc_var_set_type(ret, AMXC_VAR_ID_LIST);
+    amxc_var_t* const table = amxc_var_add(amxc_htable_t, ret, NULL);
+
+    if(NULL == names) {
+        if(info->prpl_key_name != NULL) {
+            add_key_value(info, lp, table);
+        }
+        for(i = 0; i < info->n_params; ++i) {
+            add_param_value(lp, &info->params[i], seed + i, table);
+        }
+        goto exit;
+    }
+
+    const char* name = names;
+    while(*name != '\0') {
+        const char* const comma = strchr(name, ',');
+        const size_t len = comma ? (size_t) (comma - name) : strlen(name);
+        i = find_param(info, name, len);
+        if(i == info->n_params) {
+            SAH_TRACEZ_ERROR(ME, "%s: unknown param '%.*s'", lp->path, (int) len, name);
+            amxc_var_clean(ret);
+            rc = amxd_status_parameter_not_found;
+            goto exit;
+        }
+        add_param_value(lp, &info->params[i], seed + i, table);
+        name = comma ? (comma + 1) : (name + len);
+    }
+
+exit:
+    return rc;
+}
+
+static amxb_bus_ctx_t* loopback_who_has(const char* const object) {
+
+    loopback_path_t lp;
+
+    if(resolve_path(object, /*instance=*/ true, &lp) && (obj_id_onu == lp.id) &&
+       (get_onu(lp.onu_index) != NULL)) {
+        return LOOPBACK_BUS_CTX;
+    }
+    return NULL;
+}
+
+static int loopback_call(amxb_bus_ctx_t* const ctx,
+                         const char* const object,
+                         const char* const method,
+                         amxc_var_t* const args,
+                         amxc_var_t* const ret,
+                         UNUSED int timeout_s) {
+    int rc = amxd_status_object_not_found;
+    loopback_path_t lp;
+
+    when_false_trace(LOOPBACK_BUS_CTX == ctx, exit, ERROR, "Unknown bus context");
+    when_null(method, exit);
+    when_false(resolve_path(object, /*instance=*/ true, &lp), exit);
+
+    loopback_onu_t* const onu = get_onu(lp.onu_index);
+    when_null(onu, exit);
+
+    rc = amxd_status_function_not_found;
+    if(strcmp(method, "get") == 0) {
+        rc = fill_reply(&lp, NULL, ret);
+    } else if(strcmp(method, "get_params") == 0) {
+        const char* const names = GET_CHAR(args, "names");
+        rc = names ? fill_reply(&lp, names, ret) : amxd_status_invalid_function_argument;
+    } else if((strcmp(method, "enable") == 0) || (strcmp(method, "disable") == 0)) {
+        const bool enable = (strcmp(method, "enable") == 0);
+        if(obj_id_onu == lp.id) {
+            onu->enabled = enable;
+            rc = amxd_status_ok;
+        } else if(obj_id_ani == lp.id) {
+            onu->ani_enabled = enable;
+            rc = amxd_status_ok;
+        }
+    }
+
+exit:
+    return rc;
+}
+
+static int loopback_subscribe(amxb_bus_ctx_t* const ctx,
+                              const char* const object,
+                              amxp_slot_fn_t fn,
+                              void* const priv) {
+    int rc = -1;
+    loopback_path_t lp;
+
+    when_false_trace(LOOPBACK_BUS_CTX == ctx, exit, ERROR, "Unknown bus context");
+    when_null(fn, exit);
+    when_false(resolve_path(object, /*instance=*/ true, &lp), exit);
+    when_false_trace(obj_id_onu == lp.id, exit, ERROR,
+                     "%s: only xpon_onu instances support subscriptions", lp.path);
+
+    loopback_onu_t* const onu = get_onu(lp.onu_index);
+    when_null(onu, exit);
+    when_false_trace(NULL == onu->fn, exit, ERROR, "%s: already has a subscriber", lp.path);
+
+    onu->fn = fn;
+    onu->priv = priv;
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+static int loopback_unsubscribe(amxb_bus_ctx_t* const ctx,
+                                const char* const object,
+                                amxp_slot_fn_t fn,
+                                void* const priv) {
+    int rc = -1;
+    loopback_path_t lp;
+
+    when_false_trace(LOOPBACK_BUS_CTX == ctx, exit, ERROR, "Unknown bus context");
+    when_false(resolve_path(object, /*instance=*/ true, &lp), exit);
+
+    loopback_onu_t* const onu = get_onu(lp.onu_index);
+    when_null(onu, exit);
+    when_false((onu->fn == fn) && (onu->priv == priv), exit);
+
+    onu->fn = NULL;
+    onu->priv = NULL;
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+static bool loopback_get_indexes(const char* const prpl_path,
+                                 amxc_string_t* const indexes) {
+    bool rv = false;
+    loopback_path_t lp;
+    uint32_t i;
+
+    when_null(indexes, exit);
+    if(!resolve_path(prpl_path, /*instance=*/ false, &lp)) {
+        SAH_TRACEZ_ERROR(ME, "'%s' is not a template object", prpl_path ? prpl_path : "");
+        goto exit;
+    }
+
+    amxc_string_reset(indexes);
+    for(i = 1; i <= lp.n_instances; ++i) {
+        amxc_string_appendf(indexes, (1 == i) ? "%u" : ",%u", i);
+    }
+
+    rv = true;
+
+exit:
+    return rv;
+}
+
+static const sbi_backend_t SBI_LOOPBACK_BACKEND = {
+    .name = SBI_BACKEND_LOOPBACK,
+    .configure = sbi_loopback_configure,
+    .who_has = loopback_who_has,
+    .call = loopback_call,
+    .subscribe = loopback_subscribe,
+    .unsubscribe = loopback_unsubscribe,
+    .get_indexes = loopback_get_indexes,
+    .query = NULL,
+    .forget = NULL
+};
+
+const sbi_backend_t* sbi_loopback_get_backend(void) {
+    return &SBI_LOOPBACK_BACKEND;
+}
+
+/**
+ * Read the setting @a key from @a config into @a value.
+ *
+ * Leave @a value as is if @a config does not have @a key.
+ *
+ * @return true on success, false if the value is not in [@a min, @a max]
+ */
+static bool get_setting(const amxc_var_t* const config, const char* const key,
+                        uint32_t min, uint32_t max, uint32_t* const value) {
+
+    const amxc_var_t* const var = GET_ARG(config, key);
+    if(NULL == var) {
+        return true;
+    }
+    const uint32_t new_value = amxc_var_dyncast(uint32_t, var);
+    if((new_value < min) || (new_value > max)) {
+        SAH_TRACEZ_ERROR(ME, "%s=%u is not in [%u, %u]", key, new_value, min, max);
+        return false;
+    }
+    *value = new_value;
+    return true;
+}
+
+/**
+ * Set the shape of the synthetic DM.
+ *
+ * @param[in] config  NULL for the defaults, or an htable with the optional
+ *                    keys:
+ *                    - 'onus': nr of xpon_onu instances (default 1)
+ *                    - 'ethernet_unis': nr of Ethernet UNIs per ONU
+ *                      (default 4)
+ *                    - 'gem_ports': nr of GEM ports per ONU (default 8)
+ *                    The function ignores other keys.
+ *
+ * The function refuses while the module is subscribed on an xpon_onu
+ * instance of the loopback backend.
+ *
+ * @return true on success, else false
+ */
+bool sbi_loopback_configure(const amxc_var_t* const config) {
+
+    bool rv = false;
+    uint32_t i;
+    loopback_t settings = {
+        .onus = NULL,
+        .n_onus = LOOPBACK_DEFAULT_NR_OF_ONUS,
+        .n_ethernet_unis = LOOPBACK_DEFAULT_NR_OF_ETHERNET_UNIS,
+        .n_gem_ports = LOOPBACK_DEFAULT_NR_OF_GEM_PORTS,
+        .revision = 0
+    };
+
+    if(config != NULL) {
+        when_false_trace(amxc_var_type_of(config) == AMXC_VAR_ID_HTABLE, exit, ERROR,
+                         "config is not an htable");
+        when_false(get_setting(config, "onus", 1, NOTIF_MAX_NR_OF_ONUS_LIMIT,
+                               &settings.n_onus), exit);
+        when_false(get_setting(config, "ethernet_unis", 0, LOOPBACK_MAX_NR_OF_INSTANCES,
+                               &settings.n_ethernet_unis), exit);
+        when_false(get_setting(config, "gem_ports", 0, LOOPBACK_MAX_NR_OF_INSTANCES,
+                               &settings.n_gem_ports), exit);
+    }
+
+    if(s_loopback.onus != NULL) {
+        for(i = 0; i < s_loopback.n_onus; ++i) {
+            when_false_trace(NULL == s_loopback.onus[i].fn, exit, ERROR,
+                             "Still subscribed on xpon_onu.%u", i + 1);
+        }
+    }
+
+    free(s_loopback.onus);
+    s_loopback = settings;
+    SAH_TRACEZ_INFO(ME, "loopback: onus=%u ethernet_unis=%u gem_ports=%u",
+                    s_loopback.n_onus, s_loopback.n_ethernet_unis, s_loopback.n_gem_ports);
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Hand a notification to the subscriber on xpon_onu.<onu_index>.
+ *
+ * @param[in] onu_index  xpon_onu instance index
+ * @param[in] data       the notification as an ONU HAL agent sends it, i.e.,
+ *                       an htable with at least the key 'notification'
+ *
+ * The subscriber is normally the notification handler in notif.c. The
+ * function calls it directly, so the notification is in its queue when the
+ * function returns.
+ *
+ * @return true on success, else false
+ */
+bool sbi_loopback_inject(uint32_t onu_index, const amxc_var_t* const data) {
+
+    bool rv = false;
+    char object[16];
+
+    when_null(data, exit);
+
+    const loopback_onu_t* const onu = (s_loopback.onus != NULL) ? get_onu(onu_index) : NULL;
+    when_false_trace((onu != NULL) && (onu->fn != NULL), exit, ERROR,
+                     "xpon_onu.%u: not subscribed via the loopback backend", onu_index);
+
+    ++s_loopback.revision;
+    snprintf(object, sizeof(object), "xpon_onu.%u.", onu_index);
+    onu->fn(object, data, onu->priv);
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Free the memory of the loopback backend, and restore its defaults.
+ */
+void sbi_loopback_cleanup(void) {
+
+    free(s_loopback.onus);
+    s_loopback.onus = NULL;
+    s_loopback.n_onus = LOOPBACK_DEFAULT_NR_OF_ONUS;
+    s_loopback.n_ethernet_unis = LOOPBACK_DEFAULT_NR_OF_ETHERNET_UNIS;
+    s_loopback.n_gem_ports = LOOPBACK_DEFAULT_NR_OF_GEM_PORTS;
+    s_loopback.revision = 0;
+}
@@ -0,0 +1,653 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "sbi_ubus.h"
+
+#ifdef CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND
+
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strlen(), strncmp(), memcpy(), memset() */
+
+#include <libubus.h>         /* ubus_connect(), ubus_invoke() */
+#include <libubox/blobmsg.h> /* blobmsg_parse() */
+
+#include <amxc/amxc_macros.h> /* when_null(), UNUSED */
+#include <amxc/amxc.h>
+
+#include "dm_info.h" /* dm_get_object_info() */
+#include "mod_xpon_trace.h"
+
+/* Max nr of params of an object, plus 1 for its key */
+#define SBI_UBUS_MAX_POLICY 32
+
+#define SBI_UBUS_MAX_PATH_LEN 128
+
+/* Size of sun_path in struct sockaddr_un */
+#define SBI_UBUS_MAX_SOCKET_LEN 108
+
+/* Event ubusd sends when an object disappears, with its 'id' and 'path' */
+#define SBI_UBUS_OBJECT_REMOVE_EVENT "ubus.object.remove"
+
+/**
+ * blobmsg policy of an object, generated from its param info in dm_info.c.
+ *
+ * Element i of 'policy' is for element i of the 'params' of the object. If
+ * the object is a template object, the last element is for its key.
+ * 'key_index' is the index of that element, or -1.
+ *
+ * The type of each element is BLOBMSG_TYPE_UNSPEC: decode_value() accepts
+ * any integer width for a number, as amxb-ubus does.
+ */
+typedef struct _object_policy {
+    struct blobmsg_policy policy[SBI_UBUS_MAX_POLICY];
+    int n_policy;
+    int key_index;
+} object_policy_t;
+
+static object_policy_t s_policies[obj_id_nbr];
+static bool s_policies_built = false;
+
+static struct ubus_context* s_ubus_ctx = NULL;
+static char s_socket[SBI_UBUS_MAX_SOCKET_LEN]; /* empty: the default ubus socket */
+
+/* Entry of the object ID cache. The key of 'it' is the object path. */
+typedef struct _id_cache_entry {
+    amxc_htable_it_t it;
+    uint32_t id;
+} id_cache_entry_t;
+
+/**
+ * Cache with the ubus object ID per object path.
+ *
+ * Resolving a path costs a round-trip to ubusd. The backend does it once per
+ * object, and invokes by ID afterwards. An entry is removed:
+ * - by sbi_ubus_forget_object(), i.e., when a dm:instance-removed
+ *   notification arrives for the object or one of its ancestors
+ * - when ubusd sends the event SBI_UBUS_OBJECT_REMOVE_EVENT for the object
+ * - when an invoke with the cached ID returns UBUS_STATUS_NOT_FOUND: the ONU
+ *   HAL agent restarted before the backend handled the event. The backend
+ *   then resolves the path again and retries once.
+ * The whole cache is dropped with the ubus connection.
+ */
+typedef struct _id_cache {
+    amxc_htable_t table;
+    bool initialized;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t invalidations;
+} id_cache_t;
+
+static id_cache_t s_id_cache;
+static struct ubus_event_handler s_object_remove_handler;
+
+/**
+ * Context of one ubus_invoke().
+ *
+ * - id, extract_key, ret: see sbi_ubus_query()
+ * - object: path of the object called, for logging
+ * - decoded: set by query_reply_cb()
+ */
+typedef struct _query {
+    object_id_t id;
+    bool extract_key;
+    amxc_var_t* ret;
+    const char* object;
+    bool decoded;
+} query_t;
+
+static bool build_policies(void) {
+
+    bool rv = false;
+    uint32_t id;
+    uint32_t i;
+
+    for(id = 0; id < obj_id_nbr; ++id) {
+        const object_info_t* const info = dm_get_object_info((object_id_t) id);
+        object_policy_t* const op = &s_policies[id];
+
+        when_null(info, exit);
+        when_false_trace(info->n_params < SBI_UBUS_MAX_POLICY, exit, ERROR,
+                         "%s: too many params (%u)", info->prpl_path, info->n_params);
+
+        for(i = 0; i < info->n_params; ++i) {
+            op->policy[i].name = info->params[i].prpl_name;
+            op->policy[i].type = BLOBMSG_TYPE_UNSPEC;
+        }
+        op->n_policy = (int) info->n_params;
+        op->key_index = -1;
+        if(info->prpl_key_name != NULL) {
+            op->key_index = op->n_policy;
+            op->policy[op->n_policy].name = info->prpl_key_name;
+            op->policy[op->n_policy].type = BLOBMSG_TYPE_UNSPEC;
+            ++op->n_policy;
+        }
+    }
+    s_policies_built = true;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Return the value of a blobmsg integer of any width, or of a bool.
+ *
+ * @return true on success, false if @a attr is not a number
+ */
+static bool get_number(struct blob_attr* const attr, uint64_t* const value) {
+
+    switch(blobmsg_type(attr)) {
+    case BLOBMSG_TYPE_INT8:  *value = blobmsg_get_u8(attr); break;
+    case BLOBMSG_TYPE_INT16: *value = blobmsg_get_u16(attr); break;
+    case BLOBMSG_TYPE_INT32: *value = blobmsg_get_u32(attr); break;
+    case BLOBMSG_TYPE_INT64: *value = blobmsg_get_u64(attr); break;
+    default: return false;
+    }
+    return true;
+}
+
+/**
+ * Add the value of @a attr to @a table with key @a key, as type @a type.
+ *
+ * @param[in] type  one of the AMXC_VAR_ID values in param_info_t
+ *
+ * @return true on success, false if @a attr can not be converted to @a type
+ */
+static bool decode_value(amxc_var_t* const table, const char* const key,
+                         uint32_t type, struct blob_attr* const attr) {
+
+    bool rv = false;
+    uint64_t number = 0;
+
+    switch(type) {
+    case AMXC_VAR_ID_BOOL:
+        when_false(get_number(attr, &number), exit);
+        amxc_var_add_key(bool, table, key, (number != 0));
+        break;
+    case AMXC_VAR_ID_UINT32:
+        when_false(get_number(attr, &number), exit);
+        amxc_var_add_key(uint32_t, table, key, (uint32_t) number);
+        break;
+    case AMXC_VAR_ID_INT32:
+        when_false(get_number(attr, &number), exit);
+        amxc_var_add_key(int32_t, table, key, (int32_t) number);
+        break;
+    case AMXC_VAR_ID_CSTRING:
+        when_false(blobmsg_type(attr) == BLOBMSG_TYPE_STRING, exit);
+        amxc_var_add_key(cstring_t, table, key, blobmsg_get_string(attr));
+        break;
+    case AMXC_VAR_ID_CSV_STRING:
+        when_false(blobmsg_type(attr) == BLOBMSG_TYPE_STRING, exit);
+        amxc_var_add_key(csv_string_t, table, key, blobmsg_get_string(attr));
+        break;
+    default:
+        SAH_TRACEZ_ERROR(ME, "Variant type %u: not supported", type);
+        goto exit;
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Decode the reply of get() or get_params() into the htable of the query.
+ *
+ * The result is the same as obj_process_object_params() returns for the
+ * reply via amxb: the key 'parameters' with the params the reply has, by BBF
+ * name, and the key 'keys' if the query must extract the key.
+ */
+static void query_reply_cb(struct ubus_request* req, UNUSED int type, struct blob_attr* msg) {
+
+    query_t* const query = (query_t*) req->priv;
+    const object_info_t* const info = dm_get_object_info(query->id);
+    const object_policy_t* const op = &s_policies[query->id];
+    struct blob_attr* tb[SBI_UBUS_MAX_POLICY];
+    uint32_t i;
+
+    when_null_trace(msg, exit, ERROR, "%s: no reply", query->object);
+    when_null(info, exit);
+
+    blobmsg_parse(op->policy, op->n_policy, tb, blob_data(msg), blob_len(msg));
+
+    amxc_var_set_type(query->ret, AMXC_VAR_ID_HTABLE);
+
+    if(query->extract_key) {
+        when_false_trace(op->key_index >= 0, exit, ERROR, "%s: no key", query->object);
+        struct blob_attr* const key = tb[op->key_index];
+        when_null_trace(key, exit, ERROR, "%s: key '%s' does not occur in reply",
+                        query->object, info->prpl_key_name);
+        amxc_var_t* const keys = amxc_var_add_key(amxc_htable_t, query->ret, "keys", NULL);
+        const uint32_t key_type = (blobmsg_type(key) == BLOBMSG_TYPE_STRING) ?
+            AMXC_VAR_ID_CSTRING : AMXC_VAR_ID_UINT32;
+        when_false_trace(decode_value(keys, info->bbf_key_name, key_type, key), exit, ERROR,
+                         "%s: invalid key", query->object);
+    }
+
+    amxc_var_t* const params = amxc_var_add_key(amxc_htable_t, query->ret, "parameters", NULL);
+    for(i = 0; i < info->n_params; ++i) {
+        if((tb[i] != NULL) &&
+           !decode_value(params, info->params[i].bbf_name, info->params[i].type, tb[i])) {
+            SAH_TRACEZ_ERROR(ME, "%s: '%s' has unexpected type %d", query->object,
+                             info->params[i].prpl_name, blobmsg_type(tb[i]));
+        }
+    }
+    query->decoded = true;
+
+exit:
+    return;
+}
+
+/**
+ * Add the arguments in @a args to @a b.
+ *
+ * The module only passes strings (e.g. 'names') and uint32 values (e.g.
+ * 'trace_id').
+ *
+ * @return true on success, else false
+ */
+static bool add_args(const amxc_var_t* const args, struct blob_buf* const b) {
+
+    bool rv = false;
+
+    if(NULL == args) {
+        rv = true;
+        goto exit;
+    }
+
+    amxc_var_for_each(arg, args) {
+        const char* const key = amxc_var_key(arg);
+        switch(amxc_var_type_of(arg)) {
+        case AMXC_VAR_ID_CSTRING:
+            blobmsg_add_string(b, key, amxc_var_constcast(cstring_t, arg));
+            break;
+        case AMXC_VAR_ID_UINT32:
+            blobmsg_add_u32(b, key, amxc_var_constcast(uint32_t, arg));
+            break;
+        default:
+            SAH_TRACEZ_ERROR(ME, "Argument '%s': type %u not supported", key,
+                             amxc_var_type_of(arg));
+            goto exit;
+        }
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+static void id_cache_entry_delete(UNUSED const char* key, amxc_htable_it_t* it) {
+    free(amxc_htable_it_get_data(it, id_cache_entry_t, it));
+}
+
+static void id_cache_remove(amxc_htable_it_t* const it) {
+    SAH_TRACEZ_DEBUG(ME, "%s: forget object ID", amxc_htable_it_get_key(it));
+    amxc_htable_it_clean(it, id_cache_entry_delete);
+    ++s_id_cache.invalidations;
+}
+
+static void id_cache_clear(void) {
+    if(s_id_cache.initialized) {
+        amxc_htable_clean(&s_id_cache.table, id_cache_entry_delete);
+        s_id_cache.initialized = false;
+    }
+}
+
+/**
+ * Return the ubus object ID of @a path.
+ *
+ * @param[in] path       object path without trailing dot
+ * @param[in,out] id     the function returns the object ID via this parameter
+ * @param[in,out] cached the function sets it to true if @a id comes from
+ *                       the cache
+ *
+ * @return 0 on success, else a ubus status code
+ */
+static int resolve_object_id(const char* const path, uint32_t* const id, bool* const cached) {
+
+    int rc = UBUS_STATUS_UNKNOWN_ERROR;
+    id_cache_entry_t* entry = NULL;
+
+    *cached = false;
+    if(!s_id_cache.initialized) {
+        when_failed(amxc_htable_init(&s_id_cache.table, 64), exit);
+        s_id_cache.initialized = true;
+    }
+
+    amxc_htable_it_t* const it = amxc_htable_get(&s_id_cache.table, path);
+    if(it != NULL) {
+        *id = amxc_htable_it_get_data(it, id_cache_entry_t, it)->id;
+        *cached = true;
+        ++s_id_cache.hits;
+        rc = 0;
+        goto exit;
+    }
+    ++s_id_cache.misses;
+
+    rc = ubus_lookup_id(s_ubus_ctx, path, id);
+    when_failed_trace(rc, exit, ERROR, "%s: lookup failed: %s", path, ubus_strerror(rc));
+
+    entry = (id_cache_entry_t*) calloc(1, sizeof(id_cache_entry_t));
+    when_null_trace(entry, exit, ERROR, "Failed to allocate mem");
+    entry->id = *id;
+    if(amxc_htable_insert(&s_id_cache.table, path, &entry->it) != 0) {
+        SAH_TRACEZ_ERROR(ME, "%s: failed to cache object ID", path);
+        free(entry);
+    }
+
+exit:
+    return rc;
+}
+
+/**
+ * Return true if @a path is @a prefix or one of its descendants.
+ */
+static bool path_is_under(const char* const path, const char* const prefix, size_t prefix_len) {
+    return (strncmp(path, prefix, prefix_len) == 0) &&
+           ((path[prefix_len] == '\0') || (path[prefix_len] == '.'));
+}
+
+static void object_removed_cb(UNUSED struct ubus_context* ctx,
+                              UNUSED struct ubus_event_handler* ev,
+                              UNUSED const char* type,
+                              struct blob_attr* msg) {
+
+    static const struct blobmsg_policy POLICY[] = {
+        { .name = "path", .type = BLOBMSG_TYPE_STRING }
+    };
+    struct blob_attr* tb[1];
+
+    when_null(msg, exit);
+    when_false(s_id_cache.initialized, exit);
+
+    blobmsg_parse(POLICY, 1, tb, blob_data(msg), blob_len(msg));
+    when_null(tb[0], exit);
+
+    amxc_htable_it_t* const it = amxc_htable_get(&s_id_cache.table, blobmsg_get_string(tb[0]));
+    if(it != NULL) {
+        id_cache_remove(it);
+    }
+
+exit:
+    return;
+}
+
+static bool connect_if_needed(void) {
+
+    if(NULL == s_ubus_ctx) {
+        s_ubus_ctx = ubus_connect((s_socket[0] != '\0') ? s_socket : NULL);
+        when_null_trace(s_ubus_ctx, exit, ERROR, "Failed to connect to ubus (%s)",
+                        (s_socket[0] != '\0') ? s_socket : "default socket");
+
+        memset(&s_object_remove_handler, 0, sizeof(s_object_remove_handler));
+        s_object_remove_handler.cb = object_removed_cb;
+        if(ubus_register_event_handler(s_ubus_ctx, &s_object_remove_handler,
+                                       SBI_UBUS_OBJECT_REMOVE_EVENT) != 0) {
+            /* Not fatal: a stale object ID is also detected at invoke */
+            SAH_TRACEZ_ERROR(ME, "Failed to listen to %s", SBI_UBUS_OBJECT_REMOVE_EVENT);
+        }
+    }
+
+exit:
+    return (s_ubus_ctx != NULL);
+}
+
+/**
+ * Invoke @a method on @a path by object ID.
+ *
+ * The function first handles the events which arrived since the last call,
+ * so the object ID cache is current. That's a non-blocking read on the ubus
+ * socket.
+ *
+ * @return 0 on success, else a ubus status code
+ */
+static int invoke(const char* const path, const char* const method,
+                  struct blob_attr* const msg, query_t* const query, int timeout_s) {
+
+    int rc = UBUS_STATUS_UNKNOWN_ERROR;
+    uint32_t object_id = 0;
+    bool cached = false;
+
+    ubus_handle_event(s_ubus_ctx);
+
+    rc = resolve_object_id(path, &object_id, &cached);
+    when_failed(rc, exit);
+
+    rc = ubus_invoke(s_ubus_ctx, object_id, method, msg, query_reply_cb, query, timeout_s * 1000);
+    if((UBUS_STATUS_NOT_FOUND == rc) && cached) {
+        SAH_TRACEZ_INFO(ME, "%s: object ID %u is stale", path, object_id);
+        amxc_htable_it_t* const it = amxc_htable_get(&s_id_cache.table, path);
+        if(it != NULL) {
+            id_cache_remove(it);
+        }
+        rc = resolve_object_id(path, &object_id, &cached);
+        when_failed(rc, exit);
+        rc = ubus_invoke(s_ubus_ctx, object_id, method, msg, query_reply_cb, query,
+                         timeout_s * 1000);
+    }
+
+exit:
+    return rc;
+}
+
+/**
+ * Call get() or get_params() on an object with libubus.
+ *
+ * See the 'query' function of sbi_backend_t for the parameters. The function
+ * ignores @a ctx: it has its own ubus connection.
+ *
+ * @return 0 on success, else a ubus status code
+ */
+int sbi_ubus_query(UNUSED amxb_bus_ctx_t* const ctx,
+                   object_id_t id,
+                   const char* const object,
+                   const char* const method,
+                   amxc_var_t* const args,
+                   bool extract_key,
+                   amxc_var_t* const ret,
+                   int timeout_s) {
+
+    int rc = UBUS_STATUS_INVALID_ARGUMENT;
+    char path[SBI_UBUS_MAX_PATH_LEN];
+    struct blob_buf b;
+    query_t query = {
+        .id = id,
+        .extract_key = extract_key,
+        .ret = ret,
+        .object = object,
+        .decoded = false
+    };
+
+    memset(&b, 0, sizeof(b));
+
+    when_null(object, exit);
+    when_null(method, exit);
+    when_null(ret, exit);
+    when_false_trace(id < obj_id_nbr, exit, ERROR, "%s: unknown object", object);
+
+    /* ubus object names do not end with a dot */
+    size_t len = strlen(object);
+    if((len > 0) && (object[len - 1] == '.')) {
+        --len;
+    }
+    when_false_trace(len < sizeof(path), exit, ERROR, "Path too long: '%s'", object);
+    memcpy(path, object, len);
+    path[len] = '\0';
+
+    rc = UBUS_STATUS_CONNECTION_FAILED;
+    if(!s_policies_built && !build_policies()) {
+        rc = UBUS_STATUS_UNKNOWN_ERROR;
+        goto exit;
+    }
+    when_false(connect_if_needed(), exit);
+
+    blob_buf_init(&b, 0);
+    if(!add_args(args, &b)) {
+        rc = UBUS_STATUS_INVALID_ARGUMENT;
+        goto exit;
+    }
+
+    rc = invoke(path, method, b.head, &query, timeout_s);
+    when_failed(rc, exit);
+    if(!query.decoded) {
+        amxc_var_clean(ret);
+        rc = UBUS_STATUS_NO_DATA;
+    }
+
+exit:
+    if(UBUS_STATUS_CONNECTION_FAILED == rc) {
+        /* Reconnect at the next call */
+        sbi_ubus_cleanup();
+    }
+    blob_buf_free(&b);
+    return rc;
+}
+
+/**
+ * Apply the settings of the ubus backend.
+ *
+ * @param[in] config  NULL for the defaults, or an htable with the optional key
+ *                    'socket': path of the ubus socket. The function ignores
+ *                    other keys.
+ *
+ * The backend connects to ubus at the first query.
+ *
+ * @return true on success, else false
+ */
+bool sbi_ubus_configure(const amxc_var_t* const config) {
+
+    bool rv = false;
+    const char* const socket = config ? GET_CHAR(config, "socket") : NULL;
+
+    when_false_trace((NULL == socket) || (strlen(socket) < sizeof(s_socket)), exit, ERROR,
+                     "Socket path too long: '%s'", socket);
+
+    sbi_ubus_cleanup();
+    snprintf(s_socket, sizeof(s_socket), "%s", socket ? socket : "");
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Forget the object ID of @a prpl_path and of all its descendants.
+ *
+ * @param[in] prpl_path  path of an object which no longer exists, e.g.,
+ *                       "xpon_onu.1.ani.1.tc.gem.port.3", without trailing dot
+ */
+void sbi_ubus_forget_object(const char* const prpl_path) {
+
+    when_null(prpl_path, exit);
+    when_false(s_id_cache.initialized, exit);
+
+    const size_t len = strlen(prpl_path);
+    amxc_htable_for_each(it, &s_id_cache.table) {
+        if(path_is_under(amxc_htable_it_get_key(it), prpl_path, len)) {
+            id_cache_remove(it);
+        }
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Add an 'id_cache' section with the statistics of the object ID cache to
+ * @a section: 'size', 'hits', 'misses' and 'invalidations'.
+ */
+void sbi_ubus_get_stats(amxc_var_t* const section) {
+
+    amxc_var_t* const var = amxc_var_add_key(amxc_htable_t, section, "id_cache", NULL);
+    when_null(var, exit);
+
+    amxc_var_add_key(uint32_t, var, "size", s_id_cache.initialized ?
+                     (uint32_t) amxc_htable_size(&s_id_cache.table) : 0);
+    amxc_var_add_key(uint64_t, var, "hits", s_id_cache.hits);
+    amxc_var_add_key(uint64_t, var, "misses", s_id_cache.misses);
+    amxc_var_add_key(uint64_t, var, "invalidations", s_id_cache.invalidations);
+
+exit:
+    return;
+}
+
+void sbi_ubus_reset_stats(void) {
+    s_id_cache.hits = 0;
+    s_id_cache.misses = 0;
+    s_id_cache.invalidations = 0;
+}
+
+/**
+ * Close the ubus connection of the ubus backend, and drop the object ID
+ * cache.
+ */
+void sbi_ubus_cleanup(void) {
+    if(s_ubus_ctx != NULL) {
+        ubus_unregister_event_handler(s_ubus_ctx, &s_object_remove_handler);
+        ubus_free(s_ubus_ctx);
+        s_ubus_ctx = NULL;
+    }
+    id_cache_clear();
+}
+
+#endif /* CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND */
@@ -0,0 +1,985 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "shadow_mirror.h"
+
+#include <stdio.h>  /* snprintf() */
+#include <stdlib.h> /* calloc(), realloc(), free(), strtoul() */
+#include <string.h> /* strlen(), strncmp(), strchr(), memcpy(), memset() */
+
+#include <amxc/amxc_macros.h> /* when_null(), when_true() */
+#include <amxc/amxc.h>
+
+#include "latency_stats.h" /* latency_now_us() */
+#include "mod_xpon_trace.h"
+#include "string_pool.h"   /* string_pool_intern() */
+
+/* Large enough for "xpon_onu." followed by an uint32 */
+#define ONU_PATH_MAX_LEN 24
+
+/* Max nr of params of an object: the size in bits of mirror_entry_t.present */
+#define MIRROR_MAX_PARAMS 32
+
+/**
+ * Value of a param in a record.
+ *
+ * The type of the param in its param table in dm_info.c tells which member
+ * is valid. 'str' is used for AMXC_VAR_ID_CSTRING and AMXC_VAR_ID_CSV_STRING,
+ * and points to a string in the string pool.
+ */
+typedef union _mirror_value {
+    bool b;
+    int32_t i32;
+    uint32_t u32;
+    const char* str;
+} mirror_value_t;
+
+/* Max nr of instance indexes in a path, e.g., 3 in "xpon_onu.1.ani.1.tc.gem.port.3" */
+#define MIRROR_MAX_INDEXES 3
+
+/* Values of a slot in the index of a table, besides record index + 1 */
+#define SLOT_EMPTY 0
+#define SLOT_DELETED UINT32_MAX
+
+/* Min nr of records and slots a table allocates */
+#define TABLE_MIN_SIZE 16
+
+/**
+ * Record with the mirror of one object.
+ *
+ * A record is a header and a value per param in the param table of the
+ * object, in the order of that table. The records of one object type are
+ * stored back to back in the table of that type. The mirror only converts a
+ * record to a variant when it serves a read.
+ *
+ * - indexes: the instance indexes in the prpl path of the object, e.g.,
+ *     {1, 1, 3} for "xpon_onu.1.ani.1.tc.gem.port.3". Unused ones are 0.
+ * - id: object ID
+ * - n_values: nr of elements in 'values'
+ * - present: bit i is set if values[i] holds a value
+ * - key_type: type of 'key', i.e., of the value for the key of the template
+ *     object, or AMXC_VAR_ID_NULL if the record has none. A record filled by a
+ *     dm:object-changed notification of an object not mirrored yet has none.
+ * - refreshed_us: when the volatile params were read from the ONU HAL agent
+ */
+typedef struct _mirror_entry {
+    uint32_t indexes[MIRROR_MAX_INDEXES];
+    object_id_t id;
+    uint32_t n_values;
+    uint32_t present;
+    uint32_t key_type;
+    uint64_t refreshed_us;
+    mirror_value_t key;
+    mirror_value_t values[];
+} mirror_entry_t;
+
+/**
+ * Records of one object type.
+ *
+ * - records: 'n_records' records of 'stride' bytes, back to back. Removing a
+ *     record moves the last record into its place.
+ * - slots: open addressing index on the instance indexes of the records.
+ *     A slot holds the index of a record + 1, SLOT_EMPTY or SLOT_DELETED.
+ *
+ * Per record, the mirror only needs the record itself and a slot: there is
+ * no key string and no hash table node per object. With thousands of GEM
+ * ports per ONU, those would cost more than the values.
+ */
+typedef struct _mirror_table {
+    uint8_t* records;
+    size_t stride;
+    uint32_t n_records;
+    uint32_t capacity;
+    uint32_t* slots;
+    uint32_t n_slots;   /* 0 or a power of 2 */
+    uint32_t n_deleted; /* nr of SLOT_DELETED slots */
+} mirror_table_t;
+
+typedef struct _mirror_config {
+    bool enable;
+    uint32_t volatile_max_age_ms;
+} mirror_config_t;
+
+static mirror_config_t s_config = {
+    .enable = false,
+    .volatile_max_age_ms = SHADOW_MIRROR_DEFAULT_VOLATILE_MAX_AGE_MS
+};
+
+typedef struct _mirror_stats {
+    uint64_t hits;          /* reads served from memory only */
+    uint64_t partial_hits;  /* reads with only the volatile params from the agent */
+    uint64_t misses;        /* reads passed to the southbound interface */
+    uint64_t updates;       /* entries updated by a notification */
+    uint64_t invalidations; /* entries dropped */
+} mirror_stats_t;
+
+static mirror_stats_t s_stats;
+
+/* Table per object type, indexed by object ID */
+static mirror_table_t s_tables[obj_id_nbr];
+
+static bool is_string_type(uint32_t type) {
+    return (AMXC_VAR_ID_CSTRING == type) || (AMXC_VAR_ID_CSV_STRING == type);
+}
+
+/**
+ * Set @a value of type @a type to the value of @a var.
+ *
+ * @return false if the mirror does not support @a type, else true
+ */
+static bool value_set(uint32_t type, mirror_value_t* const value, const amxc_var_t* const var) {
+
+    bool rv = true;
+
+    switch(type) {
+    case AMXC_VAR_ID_BOOL:   value->b = amxc_var_dyncast(bool, var); break;
+    case AMXC_VAR_ID_INT32:  value->i32 = amxc_var_dyncast(int32_t, var); break;
+    case AMXC_VAR_ID_UINT32: value->u32 = amxc_var_dyncast(uint32_t, var); break;
+    case AMXC_VAR_ID_CSTRING:    /* no break */
+    case AMXC_VAR_ID_CSV_STRING:
+        value->str = string_pool_intern(amxc_var_constcast(cstring_t, var));
+        rv = (value->str != NULL);
+        break;
+    default:
+        rv = false;
+        break;
+    }
+    return rv;
+}
+
+/**
+ * Add @a value of type @a type to the htable @a var with key @a name.
+ */
+static void value_to_var(uint32_t type, const mirror_value_t* const value,
+                         amxc_var_t* const var, const char* const name) {
+
+    switch(type) {
+    case AMXC_VAR_ID_BOOL:       amxc_var_add_key(bool, var, name, value->b); break;
+    case AMXC_VAR_ID_INT32:      amxc_var_add_key(int32_t, var, name, value->i32); break;
+    case AMXC_VAR_ID_UINT32:     amxc_var_add_key(uint32_t, var, name, value->u32); break;
+    case AMXC_VAR_ID_CSTRING:    amxc_var_add_key(cstring_t, var, name, value->str); break;
+    case AMXC_VAR_ID_CSV_STRING: amxc_var_add_key(csv_string_t, var, name, value->str); break;
+    default: break;
+    }
+}
+
+/**
+ * Extract the instance indexes from @a path, e.g., {1, 1, 3} from
+ * "xpon_onu.1.ani.1.tc.gem.port.3". A trailing dot is allowed.
+ *
+ * @param[in,out] n  the function returns the nr of indexes found via this
+ *                   parameter
+ *
+ * @return false if @a path has more than MIRROR_MAX_INDEXES indexes, else true
+ */
+static bool parse_indexes(const char* const path, uint32_t indexes[MIRROR_MAX_INDEXES],
+                          uint32_t* const n) {
+
+    const char* segment = path;
+    char* end = NULL;
+
+    memset(indexes, 0, MIRROR_MAX_INDEXES * sizeof(uint32_t));
+    *n = 0;
+    while(*segment != '\0') {
+        if((*segment >= '0') && (*segment <= '9')) {
+            const unsigned long index = strtoul(segment, &end, 10);
+            if((*end == '.') || (*end == '\0')) {
+                if(*n == MIRROR_MAX_INDEXES) {
+                    return false;
+                }
+                indexes[(*n)++] = (uint32_t) index;
+            }
+        }
+        segment = strchr(segment, '.');
+        if(NULL == segment) {
+            break;
+        }
+        ++segment;
+    }
+    return true;
+}
+
+static uint32_t hash_indexes(const uint32_t indexes[MIRROR_MAX_INDEXES]) {
+
+    uint32_t hash = (indexes[0] * 0x9E3779B1U) ^ (indexes[1] * 0x85EBCA77U) ^
+        (indexes[2] * 0xC2B2AE3DU);
+    hash ^= hash >> 15;
+    return hash;
+}
+
+static bool same_indexes(const uint32_t a[MIRROR_MAX_INDEXES],
+                         const uint32_t b[MIRROR_MAX_INDEXES]) {
+    return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]);
+}
+
+static mirror_entry_t* table_record(const mirror_table_t* const table, uint32_t i) {
+    return (mirror_entry_t*) (table->records + (size_t) i * table->stride);
+}
+
+/**
+ * Return the slot of the record with @a indexes, or NULL if the table has
+ * no such record.
+ */
+static uint32_t* table_lookup(const mirror_table_t* const table,
+                              const uint32_t indexes[MIRROR_MAX_INDEXES]) {
+
+    uint32_t i;
+
+    when_true(0 == table->n_slots, exit);
+
+    const uint32_t mask = table->n_slots - 1;
+    const uint32_t hash = hash_indexes(indexes);
+    for(i = 0; i < table->n_slots; ++i) {
+        uint32_t* const slot = &table->slots[(hash + i) & mask];
+        if(SLOT_EMPTY == *slot) {
+            break;
+        }
+        if((*slot != SLOT_DELETED) &&
+           same_indexes(table_record(table, *slot - 1)->indexes, indexes)) {
+            return slot;
+        }
+    }
+
+exit:
+    return NULL;
+}
+
+static void put_slot(uint32_t* const slots, uint32_t n_slots, uint32_t hash, uint32_t value) {
+
+    const uint32_t mask = n_slots - 1;
+    uint32_t i = hash & mask;
+
+    while((slots[i] != SLOT_EMPTY) && (slots[i] != SLOT_DELETED)) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = value;
+}
+
+/**
+ * Rebuild the index of @a table with @a n_slots slots. It also drops the
+ * SLOT_DELETED slots.
+ */
+static bool table_reindex(mirror_table_t* const table, uint32_t n_slots) {
+
+    bool rv = false;
+    uint32_t i;
+
+    uint32_t* const slots = (uint32_t*) calloc(n_slots, sizeof(uint32_t));
+    when_null_trace(slots, exit, ERROR, "Failed to allocate mem");
+    for(i = 0; i < table->n_records; ++i) {
+        put_slot(slots, n_slots, hash_indexes(table_record(table, i)->indexes), i + 1);
+    }
+    free(table->slots);
+    table->slots = slots;
+    table->n_slots = n_slots;
+    table->n_deleted = 0;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+static mirror_entry_t* find_entry(object_id_t id, const char* const path) {
+
+    mirror_entry_t* entry = NULL;
+    uint32_t indexes[MIRROR_MAX_INDEXES];
+    uint32_t n = 0;
+
+    when_false(id < obj_id_nbr, exit);
+    when_false(parse_indexes(path, indexes, &n), exit);
+
+    const uint32_t* const slot = table_lookup(&s_tables[id], indexes);
+    if(slot != NULL) {
+        entry = table_record(&s_tables[id], *slot - 1);
+    }
+
+exit:
+    return entry;
+}
+
+/**
+ * Drop the values of @a entry, and its key if @a with_key is true.
+ */
+static void record_clear(mirror_entry_t* const entry, bool with_key) {
+
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t i;
+
+    if(dm_get_object_param_info(entry->id, &params, &n_params)) {
+        for(i = 0; i < entry->n_values; ++i) {
+            if((entry->present & (1U << i)) && is_string_type(params[i].type)) {
+                string_pool_release(entry->values[i].str);
+            }
+        }
+    }
+    entry->present = 0;
+
+    if(with_key) {
+        if(is_string_type(entry->key_type)) {
+            string_pool_release(entry->key.str);
+        }
+        entry->key_type = AMXC_VAR_ID_NULL;
+    }
+}
+
+/**
+ * Remove the record in @a slot from @a table. The last record of the table
+ * takes its place.
+ */
+static void table_remove(mirror_table_t* const table, uint32_t* const slot) {
+
+    const uint32_t i = *slot - 1;
+    const uint32_t last = table->n_records - 1;
+    mirror_entry_t* const entry = table_record(table, i);
+
+    SAH_TRACEZ_DEBUG(ME, "id=%d indexes=%u.%u.%u: drop from mirror", entry->id,
+                     entry->indexes[0], entry->indexes[1], entry->indexes[2]);
+    record_clear(entry, /*with_key=*/ true);
+    *slot = SLOT_DELETED;
+    ++table->n_deleted;
+
+    if(i != last) {
+        const mirror_entry_t* const moved = table_record(table, last);
+        uint32_t* const moved_slot = table_lookup(table, moved->indexes);
+        memcpy(entry, moved, table->stride);
+        if(moved_slot != NULL) {
+            *moved_slot = i + 1;
+        }
+    }
+    --table->n_records;
+    ++s_stats.invalidations;
+}
+
+static void table_clean(mirror_table_t* const table) {
+
+    uint32_t i;
+
+    for(i = 0; i < table->n_records; ++i) {
+        record_clear(table_record(table, i), /*with_key=*/ true);
+    }
+    free(table->records);
+    free(table->slots);
+    memset(table, 0, sizeof(mirror_table_t));
+}
+
+static void clear_mirror(void) {
+
+    uint32_t id;
+
+    for(id = 0; id < obj_id_nbr; ++id) {
+        table_clean(&s_tables[id]);
+    }
+}
+
+static mirror_entry_t* add_entry(object_id_t id, const char* const path) {
+
+    mirror_entry_t* entry = NULL;
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t indexes[MIRROR_MAX_INDEXES];
+    uint32_t n = 0;
+
+    when_false(id < obj_id_nbr, exit);
+    when_false(dm_get_object_param_info(id, &params, &n_params), exit);
+    when_false_trace(n_params <= MIRROR_MAX_PARAMS, exit, ERROR,
+                     "%s: %u params: too many to mirror", path, n_params);
+    when_false_trace(parse_indexes(path, indexes, &n), exit, ERROR,
+                     "%s: too many instance indexes", path);
+
+    mirror_table_t* const table = &s_tables[id];
+    if(table->n_records == table->capacity) {
+        const uint32_t capacity = table->capacity ? (table->capacity * 2) : TABLE_MIN_SIZE;
+        const size_t stride = sizeof(mirror_entry_t) + n_params * sizeof(mirror_value_t);
+        uint8_t* const records = (uint8_t*) realloc(table->records, capacity * stride);
+        when_null_trace(records, exit, ERROR, "Failed to allocate mem");
+        table->records = records;
+        table->capacity = capacity;
+        table->stride = stride;
+    }
+    /* Keep the slots at most half used, deleted ones included */
+    if((table->n_records + 1 + table->n_deleted) * 2 > table->n_slots) {
+        uint32_t n_slots = TABLE_MIN_SIZE;
+        while((table->n_records + 1) * 2 > n_slots) {
+            n_slots *= 2;
+        }
+        when_false(table_reindex(table, n_slots), exit);
+    }
+
+    entry = table_record(table, table->n_records);
+    memset(entry, 0, table->stride);
+    memcpy(entry->indexes, indexes, sizeof(indexes));
+    entry->id = id;
+    entry->n_values = n_params;
+    entry->key_type = AMXC_VAR_ID_NULL;
+    put_slot(table->slots, table->n_slots, hash_indexes(indexes), table->n_records + 1);
+    ++table->n_records;
+
+exit:
+    return entry;
+}
+
+/**
+ * Store the 'parameters' in @a reply, a reply of sbi_get_object_content() or
+ * sbi_get_param_values(), in @a entry.
+ *
+ * The function keeps the values of the params which are not in @a reply.
+ */
+static void record_set_params(mirror_entry_t* const entry, const amxc_var_t* const reply) {
+
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t i;
+
+    const amxc_var_t* const values = GET_ARG(reply, "parameters");
+    when_null(values, exit);
+    when_false(dm_get_object_param_info(entry->id, &params, &n_params), exit);
+
+    for(i = 0; i < entry->n_values; ++i) {
+        const amxc_var_t* const var = GET_ARG(values, params[i].bbf_name);
+        if(NULL == var) {
+            continue;
+        }
+        mirror_value_t value;
+        if(!value_set(params[i].type, &value, var)) {
+            continue;
+        }
+        if((entry->present & (1U << i)) && is_string_type(params[i].type)) {
+            string_pool_release(entry->values[i].str);
+        }
+        entry->values[i] = value;
+        entry->present |= (1U << i);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Store the value for the key of the template object in @a reply, a reply of
+ * sbi_get_object_content() with 'keys', in @a entry.
+ *
+ * @return true on success, else false
+ */
+static bool record_set_key(mirror_entry_t* const entry, const amxc_var_t* const reply) {
+
+    bool rv = false;
+    const object_info_t* const info = dm_get_object_info(entry->id);
+    when_null(info, exit);
+    when_null(info->bbf_key_name, exit);
+
+    const amxc_var_t* const keys = GET_ARG(reply, "keys");
+    when_null(keys, exit);
+    const amxc_var_t* const var = GET_ARG(keys, info->bbf_key_name);
+    when_null(var, exit);
+
+    mirror_value_t key;
+    const uint32_t type = amxc_var_type_of(var);
+    when_false(value_set(type, &key, var), exit);
+
+    if(is_string_type(entry->key_type)) {
+        string_pool_release(entry->key.str);
+    }
+    entry->key = key;
+    entry->key_type = type;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Store @a reply, a reply of sbi_get_object_content(), in @a entry.
+ *
+ * If @a has_keys is false, the function keeps the key @a entry has: the key
+ * of an instance never changes.
+ */
+static void record_store(mirror_entry_t* const entry, const char* const path,
+                         const amxc_var_t* const reply, bool has_keys) {
+
+    record_clear(entry, /*with_key=*/ false);
+    if(has_keys && !record_set_key(entry, reply)) {
+        SAH_TRACEZ_WARNING(ME, "%s: no key in reply", path);
+    }
+    record_set_params(entry, reply);
+    entry->refreshed_us = latency_now_us();
+}
+
+/**
+ * Convert @a entry to a reply of sbi_get_object_content(): an htable with
+ * 'parameters' and, if @a with_key is true, 'keys'.
+ */
+static void record_to_var(const mirror_entry_t* const entry, bool with_key,
+                          amxc_var_t* const ret) {
+
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t i;
+
+    amxc_var_set_type(ret, AMXC_VAR_ID_HTABLE);
+    when_false(dm_get_object_param_info(entry->id, &params, &n_params), exit);
+
+    if(with_key) {
+        const object_info_t* const info = dm_get_object_info(entry->id);
+        amxc_var_t* const keys = amxc_var_add_key(amxc_htable_t, ret, "keys", NULL);
+        value_to_var(entry->key_type, &entry->key, keys, info->bbf_key_name);
+    }
+
+    amxc_var_t* const values = amxc_var_add_key(amxc_htable_t, ret, "parameters", NULL);
+    for(i = 0; i < entry->n_values; ++i) {
+        if(entry->present & (1U << i)) {
+            value_to_var(params[i].type, &entry->values[i], values, params[i].bbf_name);
+        }
+    }
+
+exit:
+    return;
+}
+
+static bool volatile_is_fresh(const mirror_entry_t* const entry) {
+    return (s_config.volatile_max_age_ms != 0) &&
+           ((latency_now_us() - entry->refreshed_us) < (uint64_t) s_config.volatile_max_age_ms * 1000);
+}
+
+/**
+ * Read the volatile params of @a entry from the ONU HAL agent if the mirror
+ * may not serve them anymore.
+ *
+ * The southbound call may handle other events, which may move or drop
+ * records. Hence the function looks up the record again afterwards.
+ *
+ * @param[in,out] entry      the function returns the record of the object,
+ *                           or NULL if the mirror dropped it meanwhile, via
+ *                           this parameter
+ * @param[in,out] refreshed  the function sets it to true if it read params
+ *                           from the ONU HAL agent
+ *
+ * @return true if the volatile params in @a entry are fresh, else false
+ */
+static bool refresh_volatile_params(amxb_bus_ctx_t* ctx,
+                                    mirror_entry_t** const entry,
+                                    const amxc_string_t* const prpl_path,
+                                    bool* const refreshed) {
+
+    bool rv = true;
+    const object_id_t id = (*entry)->id;
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t i;
+    amxc_string_t names;
+    amxc_var_t reply;
+
+    amxc_string_init(&names, 0);
+    amxc_var_init(&reply);
+
+    when_true(volatile_is_fresh(*entry), exit);
+    when_false(dm_get_object_param_info(id, &params, &n_params), exit);
+
+    for(i = 0; i < n_params; ++i) {
+        if(param_volatility_volatile == params[i].volatility) {
+            amxc_string_appendf(&names, "%s%s",
+                                amxc_string_is_empty(&names) ? "" : ",", params[i].prpl_name);
+        }
+    }
+    when_true(amxc_string_is_empty(&names), exit);
+
+    rv = sbi_get_param_values(ctx, id, prpl_path, amxc_string_get(&names, 0), &reply);
+    *entry = find_entry(id, amxc_string_get(prpl_path, 0));
+    when_false(rv, exit);
+    if(NULL == *entry) {
+        rv = false;
+        goto exit;
+    }
+
+    record_set_params(*entry, &reply);
+    (*entry)->refreshed_us = latency_now_us();
+    *refreshed = true;
+
+exit:
+    amxc_string_clean(&names);
+    amxc_var_clean(&reply);
+    return rv;
+}
+
+/**
+ * Copy the values of the comma-separated prpl param @a names from @a entry
+ * into @a ret, in the format of sbi_get_param_values().
+ *
+ * @return false if the mirror can not serve all of them, else true
+ */
+static bool copy_param_values(const mirror_entry_t* const entry, const char* const names,
+                              amxc_var_t* const ret) {
+
+    bool rv = false;
+    const char* name = names;
+    const param_info_t* params = NULL;
+    uint32_t n_params = 0;
+    uint32_t wanted = 0; /* bit i set: param i is in 'names' */
+    uint32_t i;
+
+    when_false(dm_get_object_param_info(entry->id, &params, &n_params), exit);
+
+    while(*name != '\0') {
+        const char* const comma = strchr(name, ',');
+        const size_t len = comma ? (size_t) (comma - name) : strlen(name);
+
+        const param_info_t* const info = dm_get_param_info_by_prpl_name(entry->id, name, len);
+        when_null(info, exit);
+        if((param_volatility_volatile == info->volatility) && !volatile_is_fresh(entry)) {
+            goto exit;
+        }
+        wanted |= (1U << (uint32_t) (info - params));
+
+        name += len + (comma ? 1 : 0);
+    }
+    when_false((entry->present & wanted) == wanted, exit);
+
+    amxc_var_set_type(ret, AMXC_VAR_ID_HTABLE);
+    amxc_var_t* const values = amxc_var_add_key(amxc_htable_t, ret, "parameters", NULL);
+    for(i = 0; i < entry->n_values; ++i) {
+        if(wanted & (1U << i)) {
+            value_to_var(params[i].type, &entry->values[i], values, params[i].bbf_name);
+        }
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Configure the mirror.
+ *
+ * @param[in] enable               if false, the module drops the mirror, and
+ *                                 passes each read to the ONU HAL agent
+ * @param[in] volatile_max_age_ms  max age of a volatile value served from
+ *                                 the mirror. 0 means never.
+ *
+ * @return true on success, else false
+ */
+bool shadow_mirror_set_config(bool enable, uint32_t volatile_max_age_ms) {
+
+    SAH_TRACEZ_INFO(ME, "enable=%d volatile_max_age_ms=%u", enable, volatile_max_age_ms);
+    s_config.enable = enable;
+    s_config.volatile_max_age_ms = volatile_max_age_ms;
+    if(!enable) {
+        clear_mirror();
+    }
+    return true;
+}
+
+/**
+ * Add the keys 'enable' and 'volatile_max_age_ms' to @a config, an htable.
+ */
+void shadow_mirror_get_config(amxc_var_t* const config) {
+
+    when_null(config, exit);
+
+    amxc_var_add_key(bool, config, "enable", s_config.enable);
+    amxc_var_add_key(uint32_t, config, "volatile_max_age_ms", s_config.volatile_max_age_ms);
+
+exit:
+    return;
+}
+
+/**
+ * Get the parameter values of an object from the mirror or, if needed, from
+ * the ONU HAL agent.
+ *
+ * Same contract as sbi_get_object_content().
+ */
+bool shadow_mirror_get_object_content(amxb_bus_ctx_t* ctx,
+                                      object_id_t id,
+                                      const amxc_string_t* const prpl_path,
+                                      bool extract_key,
+                                      amxc_var_t* const ret) {
+
+    bool rv = false;
+    bool refreshed = false;
+    const char* const path = amxc_string_get(prpl_path, 0);
+
+    when_false(s_config.enable, passthrough);
+
+    mirror_entry_t* entry = find_entry(id, path);
+    if(entry && ((entry->key_type != AMXC_VAR_ID_NULL) || !extract_key) &&
+       refresh_volatile_params(ctx, &entry, prpl_path, &refreshed)) {
+        record_to_var(entry, extract_key, ret);
+        if(refreshed) {
+            ++s_stats.partial_hits;
+        } else {
+            ++s_stats.hits;
+        }
+        rv = true;
+        goto exit;
+    }
+
+    ++s_stats.misses;
+    rv = sbi_get_object_content(ctx, id, prpl_path, extract_key, ret);
+    when_false(rv, exit);
+
+    /* The southbound call may have moved or dropped records */
+    entry = find_entry(id, path);
+    if(NULL == entry) {
+        entry = add_entry(id, path);
+        when_null(entry, exit);
+    }
+    record_store(entry, path, ret, extract_key);
+    goto exit;
+
+passthrough:
+    rv = sbi_get_object_content(ctx, id, prpl_path, extract_key, ret);
+
+exit:
+    return rv;
+}
+
+/**
+ * Get the values of one or more parameters of an object from the mirror or,
+ * if needed, from the ONU HAL agent.
+ *
+ * Same contract as sbi_get_param_values(). The mirror only serves the read if
+ * it can serve all params in @a names.
+ */
+bool shadow_mirror_get_param_values(amxb_bus_ctx_t* ctx,
+                                    object_id_t id,
+                                    const amxc_string_t* const prpl_path,
+                                    const char* const names,
+                                    amxc_var_t* const ret) {
+
+    bool rv = false;
+
+    when_false(s_config.enable, passthrough);
+
+    const mirror_entry_t* const entry = find_entry(id, amxc_string_get(prpl_path, 0));
+    if(entry && copy_param_values(entry, names, ret)) {
+        ++s_stats.hits;
+        rv = true;
+        goto exit;
+    }
+
+    ++s_stats.misses;
+    rv = sbi_get_param_values(ctx, id, prpl_path, names, ret);
+    if(rv) {
+        /* The southbound call may have moved or dropped records */
+        mirror_entry_t* const updated = find_entry(id, amxc_string_get(prpl_path, 0));
+        if(updated) {
+            record_set_params(updated, ret);
+        }
+    }
+    goto exit;
+
+passthrough:
+    rv = sbi_get_param_values(ctx, id, prpl_path, names, ret);
+
+exit:
+    return rv;
+}
+
+/**
+ * Update the mirror with the object the module queried for a notification.
+ *
+ * @param[in] id         object ID
+ * @param[in] prpl_path  path of the object, e.g., "xpon_onu.1.ani.1"
+ * @param[in] content    reply of sbi_get_object_content() for the object
+ * @param[in] has_keys   true if @a content has 'keys'
+ *
+ * If the object is mirrored and @a content has no keys, the function keeps
+ * the key of the mirror.
+ */
+void shadow_mirror_update(object_id_t id,
+                          const char* const prpl_path,
+                          const amxc_var_t* const content,
+                          bool has_keys) {
+
+    when_false(s_config.enable, exit);
+    when_null(prpl_path, exit);
+    when_null(content, exit);
+
+    mirror_entry_t* entry = find_entry(id, prpl_path);
+    if(NULL == entry) {
+        entry = add_entry(id, prpl_path);
+        when_null(entry, exit);
+    }
+
+    record_store(entry, prpl_path, content, has_keys);
+    ++s_stats.updates;
+
+exit:
+    return;
+}
+
+/**
+ * Drop the object @a prpl_path and all its descendants from the mirror.
+ *
+ * @param[in] prpl_path  path of an object, e.g., "xpon_onu.1.ani.1.tc.gem.port.3".
+ *                       A trailing dot is allowed.
+ */
+void shadow_mirror_forget(const char* const prpl_path) {
+
+    amxc_string_t path;
+    uint32_t indexes[MIRROR_MAX_INDEXES];
+    uint32_t n = 0;
+    uint32_t id;
+    uint32_t i;
+
+    amxc_string_init(&path, 0);
+
+    when_null(prpl_path, exit);
+    amxc_string_set(&path, prpl_path);
+    if(amxc_string_text_length(&path) && (prpl_path[amxc_string_text_length(&path) - 1] == '.')) {
+        amxc_string_remove_at(&path, amxc_string_text_length(&path) - 1, 1);
+    }
+
+    const object_id_t forget_id = dm_get_object_id(amxc_string_get(&path, 0));
+    when_false(forget_id < obj_id_nbr, exit);
+    when_false(parse_indexes(amxc_string_get(&path, 0), indexes, &n), exit);
+
+    /* The object type and its descendant types have a generic path that
+     * starts with the generic path of the object type. */
+    const char* const generic = dm_get_object_info(forget_id)->prpl_path;
+    const size_t len = strlen(generic);
+
+    for(id = 0; id < obj_id_nbr; ++id) {
+        const char* const type_path = dm_get_object_info((object_id_t) id)->prpl_path;
+        mirror_table_t* const table = &s_tables[id];
+
+        if((strncmp(type_path, generic, len) != 0) ||
+           ((type_path[len] != '\0') && (type_path[len] != '.'))) {
+            continue;
+        }
+        i = 0;
+        while(i < table->n_records) {
+            const mirror_entry_t* const entry = table_record(table, i);
+            if(memcmp(entry->indexes, indexes, n * sizeof(uint32_t)) == 0) {
+                /* The last record takes the place of record i */
+                table_remove(table, table_lookup(table, entry->indexes));
+            } else {
+                ++i;
+            }
+        }
+    }
+
+exit:
+    amxc_string_clean(&path);
+}
+
+/**
+ * Drop all objects of the ONU with xpon_onu instance index @a onu_index from
+ * the mirror.
+ */
+void shadow_mirror_forget_onu(uint32_t onu_index) {
+
+    char path[ONU_PATH_MAX_LEN];
+
+    snprintf(path, ONU_PATH_MAX_LEN, "xpon_onu.%u", onu_index);
+    shadow_mirror_forget(path);
+}
+
+/**
+ * Add a 'shadow_mirror' section with the config and counters to @a stats.
+ *
+ * @param[in,out] stats  htable
+ */
+void shadow_mirror_get_stats(amxc_var_t* const stats) {
+
+    when_null(stats, exit);
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "shadow_mirror", NULL);
+    when_null(section, exit);
+
+    amxc_var_t* const config = amxc_var_add_key(amxc_htable_t, section, "config", NULL);
+    shadow_mirror_get_config(config);
+
+    uint32_t n_records = 0;
+    uint64_t n_bytes = 0;
+    uint32_t id;
+    for(id = 0; id < obj_id_nbr; ++id) {
+        n_records += s_tables[id].n_records;
+        n_bytes += (uint64_t) s_tables[id].capacity * s_tables[id].stride +
+            (uint64_t) s_tables[id].n_slots * sizeof(uint32_t);
+    }
+    amxc_var_add_key(uint32_t, section, "entries", n_records);
+    amxc_var_add_key(uint64_t, section, "bytes", n_bytes);
+    amxc_var_add_key(uint64_t, section, "hits", s_stats.hits);
+    amxc_var_add_key(uint64_t, section, "partial_hits", s_stats.partial_hits);
+    amxc_var_add_key(uint64_t, section, "misses", s_stats.misses);
+    amxc_var_add_key(uint64_t, section, "updates", s_stats.updates);
+    amxc_var_add_key(uint64_t, section, "invalidations", s_stats.invalidations);
+
+exit:
+    return;
+}
+
+void shadow_mirror_reset_stats(void) {
+    s_stats = (mirror_stats_t) { 0 };
+}
+
+/**
+ * Drop the mirror, and disable it.
+ *
+ * The module must call this function once when stopping.
+ */
+void shadow_mirror_cleanup(void) {
+    clear_mirror();
+    s_config.enable = false;
+    s_config.volatile_max_age_ms = SHADOW_MIRROR_DEFAULT_VOLATILE_MAX_AGE_MS;
+}
@@ -62,7 +62,8 @@
 
 #include "southbound_if.h"
 
-#include <string.h> /* strlen() */
+#include <stdlib.h> /* strtoul() */
+#include <string.h> /* strlen(), memset(), strncmp(), strcmp() */
 
 #ifdef _DEBUG_
 #include <stdio.h>  /* printf() */
@@ -71,10 +72,127 @@
 
 #include <amxc/amxc_macros.h> /* when_false() */
 
+#include "flight_recorder.h"
+#include "latency_stats.h"
+#include "mod_xpon_macros.h"  /* ARRAY_SIZE() */
 #include "mod_xpon_trace.h"
+#include "object_utils.h"     /* obj_process_object_params() */
+#include "sbi_loopback.h"     /* sbi_loopback_get_backend() */
+#include "sbi_ubus.h"         /* sbi_ubus_query() */
+#include "stall_detector.h"
+#include "trace_id.h"
+#include "traffic_recorder.h"
+#include "ubus_prpl.h"        /* ubus_prpl_get_indexes() */
 
 static const int AMXB_CALL_TIMEOUT_S = 3; /* seconds */
 
+/* Methods the module calls on the southbound interface */
+typedef enum _sbi_method {
+    sbi_method_enable = 0,
+    sbi_method_disable,
+    sbi_method_get,
+    sbi_method_get_params,
+    sbi_method_nr
+} sbi_method_t;
+
+static const char* const SBI_METHOD_NAMES[sbi_method_nr] = {
+    "enable",
+    "disable",
+    "get",
+    "get_params"
+};
+
+/**
+ * Format of the reply call_function_common() returns.
+ *
+ * - sbi_reply_prpl: as the ONU HAL agent sent it, via the 'call' function of
+ *   the backend
+ * - sbi_reply_bbf, sbi_reply_bbf_with_key: converted for tr181-xpon, via the
+ *   'query' function of the backend. See obj_process_object_params().
+ */
+typedef enum _sbi_reply_format {
+    sbi_reply_prpl = 0,
+    sbi_reply_bbf,
+    sbi_reply_bbf_with_key
+} sbi_reply_format_t;
+
+static const fr_op_t SBI_METHOD_FR_OPS[sbi_method_nr] = {
+    fr_op_sbi_enable,
+    fr_op_sbi_disable,
+    fr_op_sbi_get,
+    fr_op_sbi_get_params
+};
+
+#define XPON_ONU_PREFIX "xpon_onu."
+#define XPON_ONU_PREFIX_LEN 9
+
+/**
+ * Statistics of the calls on the southbound interface.
+ *
+ * The module keeps them per method and per object, so one can find out
+ * which objects of the ONU HAL agents dominate the XPON DM read latency. The
+ * last element of 'per_object' is for calls on an unknown object.
+ */
+typedef struct _sbi_stats {
+    latency_stats_t per_method[sbi_method_nr];
+    latency_stats_t per_object[obj_id_nbr + 1];
+} sbi_stats_t;
+
+static sbi_stats_t s_stats;
+
+static int amxb_backend_call(amxb_bus_ctx_t* const ctx,
+                             const char* const object,
+                             const char* const method,
+                             amxc_var_t* const args,
+                             amxc_var_t* const ret,
+                             int timeout_s) {
+    return amxb_call(ctx, object, method, args, ret, timeout_s);
+}
+
+static int amxb_backend_subscribe(amxb_bus_ctx_t* const ctx,
+                                  const char* const object,
+                                  amxp_slot_fn_t fn,
+                                  void* const priv) {
+    return amxb_subscribe(ctx, object, NULL, fn, priv);
+}
+
+static int amxb_backend_unsubscribe(amxb_bus_ctx_t* const ctx,
+                                    const char* const object,
+                                    amxp_slot_fn_t fn,
+                                    void* const priv) {
+    return amxb_unsubscribe(ctx, object, fn, priv);
+}
+
+/* Default backend: talk to the ONU HAL agents over the bus */
+static const sbi_backend_t SBI_AMXB_BACKEND = {
+    .name = SBI_BACKEND_AMXB,
+    .configure = NULL,
+    .who_has = amxb_be_who_has,
+    .call = amxb_backend_call,
+    .subscribe = amxb_backend_subscribe,
+    .unsubscribe = amxb_backend_unsubscribe,
+    .get_indexes = ubus_prpl_get_indexes,
+    .query = NULL,
+    .forget = NULL
+};
+
+#ifdef CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND
+/* As the amxb backend, but get() and get_params() go via libubus directly */
+static const sbi_backend_t SBI_UBUS_BACKEND = {
+    .name = SBI_BACKEND_UBUS,
+    .configure = sbi_ubus_configure,
+    .who_has = amxb_be_who_has,
+    .call = amxb_backend_call,
+    .subscribe = amxb_backend_subscribe,
+    .unsubscribe = amxb_backend_unsubscribe,
+    .get_indexes = ubus_prpl_get_indexes,
+    .query = sbi_ubus_query,
+    .forget = sbi_ubus_forget_object
+};
+#endif
+
+static const sbi_backend_t* s_backend = &SBI_AMXB_BACKEND;
+
 /**
  * Construct string with dot appended.
  *
@@ -100,54 +218,226 @@ exit:
 }
 
 /**
- * Wrapper around amxb_call().
+ * Return the xpon_onu instance index in a prpl path, e.g. 1 for
+ * "xpon_onu.1.ani.1", or 0 if the path does not start with "xpon_onu.".
+ */
+static uint32_t get_onu_index(const char* const path) {
+
+    if((NULL == path) || (strncmp(path, XPON_ONU_PREFIX, XPON_ONU_PREFIX_LEN) != 0)) {
+        return 0;
+    }
+    return (uint32_t) strtoul(path + XPON_ONU_PREFIX_LEN, NULL, 10);
+}
+
+/**
+ * Wrapper around the 'call' function of the backend, normally amxb_call().
  *
  * @param[in] ctx        bus context
+ * @param[in] id         ID of the object @a path refers to. Only used for the
+ *                       statistics.
  * @param[in] path       object in prpl xpon_onu DM
- * @param[in] method     name of the function being called
+ * @param[in] method     function being called
  * @param[in] args       the function arguments in a amxc variant htable type.
  *                       The caller can pass NULL if @a method does not have any
  *                       arguments.
+ * @param[in] format     format of the reply. The caller must only ask for
+ *                       another format than sbi_reply_prpl if the backend has
+ *                       a 'query' function.
  * @param[in,out] ret    will contain the return value(s). The caller can pass
  *                       NULL if he does not expect any return value(s).
  *
+ * If enabled, the function adds the current trace ID as argument 'trace_id'.
+ * If the traffic recorder is active, the function records the call.
+ *
  * @return true on success, else false
  */
 static bool call_function_common(amxb_bus_ctx_t* ctx,
+                                 object_id_t id,
                                  const amxc_string_t* const path,
-                                 const char* const method,
+                                 sbi_method_t method,
                                  amxc_var_t* args,
+                                 sbi_reply_format_t format,
                                  amxc_var_t* ret) {
     bool rv = false;
+    int rc = -1;
+    const uint64_t start_us = latency_now_us();
+    const char* const method_name = SBI_METHOD_NAMES[method];
+    const char* const path_cstr = amxc_string_get(path, 0);
 
     amxc_string_t path_dot;/* path with dot appended */
+    amxc_var_t trace_args; /* args if caller passes none, but trace ID must be passed */
+    amxc_var_t* trace_var = NULL; /* trace ID added to args, removed again at exit */
     amxc_string_init(&path_dot, 0);
+    amxc_var_init(&trace_args);
 
     when_null_trace(ctx, exit, ERROR, "No bus context");
 
-    const char* const path_cstr = amxc_string_get(path, 0);
     string_append_dot(path_cstr, &path_dot);
     const char* const path_dot_cstr = amxc_string_get(&path_dot, 0);
 
-    const int rc =
-        amxb_call(ctx, path_dot_cstr, method, args, ret, AMXB_CALL_TIMEOUT_S);
+    const uint32_t trace_id = trace_id_current();
+    if(trace_id_propagation_enabled() && (trace_id != 0)) {
+        if(NULL == args) {
+            amxc_var_set_type(&trace_args, AMXC_VAR_ID_HTABLE);
+            args = &trace_args;
+        }
+        /* Remove it again afterwards: the caller may reuse its args */
+        trace_var = amxc_var_add_key(uint32_t, args, "trace_id", trace_id);
+    }
+
+    if(sbi_reply_prpl == format) {
+        rc = s_backend->call(ctx, path_dot_cstr, method_name, args, ret, AMXB_CALL_TIMEOUT_S);
+    } else {
+        rc = s_backend->query(ctx, id, path_dot_cstr, method_name, args,
+                              (sbi_reply_bbf_with_key == format), ret, AMXB_CALL_TIMEOUT_S);
+    }
     if(rc) {
-        SAH_TRACEZ_ERROR(ME, "amxb_call %s%s() failed: rc=%d", path_dot_cstr, method, rc);
+        SAH_TRACEZ_ERROR(ME, "%s: call %s%s() failed: rc=%d trace_id=%u",
+                         s_backend->name, path_dot_cstr, method_name, rc, trace_id);
         goto exit;
     }
 
     rv = true;
 exit:
+    {
+        const uint64_t duration_us = latency_now_us() - start_us;
+        latency_stats_add_result(&s_stats.per_method[method], duration_us, rv);
+        latency_stats_add_result(&s_stats.per_object[(id < obj_id_nbr) ? id : obj_id_nbr],
+                                 duration_us, rv);
+        flight_recorder_add(SBI_METHOD_FR_OPS[method], id, get_onu_index(path_cstr),
+                            duration_us, rv ? 0 : ((rc < 0) ? rc : -rc));
+        stall_detector_note_call(path_cstr, method_name, duration_us);
+        if(traffic_recorder_is_active()) {
+            traffic_recorder_add_call(path_cstr, method_name, args, rc, ret, start_us, duration_us);
+        }
+    }
+    amxc_var_delete(&trace_var);
     amxc_string_clean(&path_dot);
+    amxc_var_clean(&trace_args);
     return rv;
 }
 
+/**
+ * Select the backend of the southbound interface.
+ *
+ * @param[in] name    SBI_BACKEND_AMXB, SBI_BACKEND_LOOPBACK or, if the module
+ *                    is built with it, SBI_BACKEND_UBUS
+ * @param[in] config  backend specific settings, or NULL for the defaults.
+ *                    See sbi_loopback_configure() for the loopback backend
+ *                    and sbi_ubus_configure() for the ubus backend.
+ *
+ * The caller must select the backend before the module finds out which
+ * xpon_onu instances exist: the bus contexts and the subscriptions of one
+ * backend mean nothing to another one.
+ *
+ * @return true on success, else false. The current backend stays selected
+ *         on failure.
+ */
+bool sbi_set_backend(const char* const name, const amxc_var_t* const config) {
+
+    bool rv = false;
+    const sbi_backend_t* backend = NULL;
+    const sbi_backend_t* const backends[] = {
+        &SBI_AMXB_BACKEND,
+        sbi_loopback_get_backend(),
+#ifdef CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND
+        &SBI_UBUS_BACKEND,
+#endif
+    };
+    size_t i;
+
+    when_null(name, exit);
+
+    for(i = 0; i < ARRAY_SIZE(backends); ++i) {
+        if(strcmp(name, backends[i]->name) == 0) {
+            backend = backends[i];
+            break;
+        }
+    }
+    when_null_trace(backend, exit, ERROR, "Unknown backend '%s'", name);
+
+    if(backend->configure && !backend->configure(config)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to configure backend '%s'", name);
+        goto exit;
+    }
+
+    SAH_TRACEZ_INFO(ME, "backend: %s -> %s", s_backend->name, backend->name);
+    s_backend = backend;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+const char* sbi_get_backend_name(void) {
+    return s_backend->name;
+}
+
+/**
+ * Return the bus context serving @a object, e.g. "xpon_onu.1", or NULL if
+ * @a object does not exist.
+ */
+amxb_bus_ctx_t* sbi_who_has(const char* const object) {
+    return s_backend->who_has(object);
+}
+
+/**
+ * Subscribe @a fn on the notifications of @a object.
+ *
+ * @param[in] ctx     bus context returned by sbi_who_has()
+ * @param[in] object  object path. It must end with a dot.
+ * @param[in] fn      callback function
+ * @param[in] priv    passed to @a fn
+ *
+ * @return true on success, else false
+ */
+bool sbi_subscribe(amxb_bus_ctx_t* const ctx,
+                   const char* const object,
+                   amxp_slot_fn_t fn,
+                   void* const priv) {
+    return (s_backend->subscribe(ctx, object, fn, priv) == 0);
+}
+
+/**
+ * Undo sbi_subscribe().
+ *
+ * @return true on success, else false
+ */
+bool sbi_unsubscribe(amxb_bus_ctx_t* const ctx,
+                     const char* const object,
+                     amxp_slot_fn_t fn,
+                     void* const priv) {
+    return (s_backend->unsubscribe(ctx, object, fn, priv) == 0);
+}
+
+/**
+ * Return the instance indexes of a template object.
+ *
+ * See ubus_prpl_get_indexes() for the parameters.
+ *
+ * @return true on success, else false
+ */
+bool sbi_get_indexes(const char* const prpl_path, amxc_string_t* const indexes) {
+    return s_backend->get_indexes(prpl_path, indexes);
+}
 
+/**
+ * Inform the backend that the object @a prpl_path was removed.
+ *
+ * @param[in] prpl_path  path of the removed object, e.g.,
+ *                       "xpon_onu.1.ani.1.tc.gem.port.3", without trailing dot
+ */
+void sbi_forget_object(const char* const prpl_path) {
+    if((prpl_path != NULL) && (s_backend->forget != NULL)) {
+        s_backend->forget(prpl_path);
+    }
+}
 
 /**
  * Call enable() or disable() for a prpl xpon_onu object.
  *
  * @param[in] ctx     bus context
+ * @param[in] id      ID of the object @a path refers to
  * @param[in] path    object in prpl xpon_onu DM to call enable() or disable() on
  * @param[in] enable  if true, call enable(), else call disable().
  *
@@ -158,14 +448,15 @@ exit:
  * @return true on success, else false
  */
 bool sbi_enable(amxb_bus_ctx_t* ctx,
+                object_id_t id,
                 const amxc_string_t* const path,
                 bool enable) {
 
-    const char* const method = enable ? "enable" : "disable";
+    const sbi_method_t method = enable ? sbi_method_enable : sbi_method_disable;
 
     SAH_TRACEZ_DEBUG(ME, "path='%s' enable=%d", amxc_string_get(path, 0), enable);
 
-    return call_function_common(ctx, path, method, /*args=*/ NULL, /*ret=*/ NULL);
+    return call_function_common(ctx, id, path, method, /*args=*/ NULL, sbi_reply_prpl, /*ret=*/ NULL);
 }
 
 #ifdef _DEBUG_
@@ -183,6 +474,7 @@ static void dump_param_values(const char* const func_name,
  * Call get() on a prpl xpon_onu object to get the values of its params.
  *
  * @param[in] ctx               bus context
+ * @param[in] id                ID of the object @a path refers to
  * @param[in] path              object in prpl xpon_onu DM to call get() on
  * @param[in,out] param_values  function returns param values via this parameter
  *
@@ -200,10 +492,12 @@ static void dump_param_values(const char* const func_name,
  * @return true on success, else false
  */
 bool sbi_query_object(amxb_bus_ctx_t* ctx,
+                      object_id_t id,
                       const amxc_string_t* const path,
                       amxc_var_t* const param_values) {
 
-    const bool rv = call_function_common(ctx, path, "get", /*args=*/ NULL, param_values);
+    const bool rv = call_function_common(ctx, id, path, sbi_method_get, /*args=*/ NULL,
+                                         sbi_reply_prpl, param_values);
 
 #ifdef _DEBUG_
     if(rv) {
@@ -217,6 +511,7 @@ bool sbi_query_object(amxb_bus_ctx_t* ctx,
  * Call get_params() on a prpl xpon_onu object to get certain param values.
  *
  * @param[in] ctx               bus context
+ * @param[in] id                ID of the object @a path refers to
  * @param[in] path              object in prpl xpon_onu DM to call get_params() on
  * @param[in] names             list of param names to be queried, formatted as
  *                              a comma-separated list.
@@ -233,6 +528,7 @@ bool sbi_query_object(amxb_bus_ctx_t* ctx,
  * @return true on success, else false
  */
 bool sbi_query_params(amxb_bus_ctx_t* ctx,
+                      object_id_t id,
                       const amxc_string_t* const path,
                       const char* const names,
                       amxc_var_t* const param_values) {
@@ -242,7 +538,8 @@ bool sbi_query_params(amxb_bus_ctx_t* ctx,
     amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
     amxc_var_add_key(cstring_t, &args, "names", names);
 
-    const bool rv = call_function_common(ctx, path, "get_params", &args, param_values);
+    const bool rv = call_function_common(ctx, id, path, sbi_method_get_params, &args,
+                                         sbi_reply_prpl, param_values);
 
 #ifdef _DEBUG_
     if(rv) {
@@ -254,3 +551,180 @@ bool sbi_query_params(amxb_bus_ctx_t* ctx,
     return rv;
 }
 
+/**
+ * Return true if the backend converts the replies for tr181-xpon itself.
+ *
+ * Not while the traffic recorder is active: its trace must have the replies
+ * as the ONU HAL agent sent them.
+ */
+static bool backend_converts_replies(void) {
+    return (s_backend->query != NULL) && !traffic_recorder_is_active();
+}
+
+/**
+ * Convert a reply of get() or get_params() for tr181-xpon.
+ *
+ * Wrapper around obj_process_object_params() which adds a conversion span to
+ * the flight recorder.
+ */
+static bool convert_reply(object_id_t id,
+                          const amxc_string_t* const path,
+                          const amxc_var_t* const param_values,
+                          bool extract_key,
+                          amxc_var_t* const ret) {
+
+    const uint64_t start_us = latency_now_us();
+    const char* const path_cstr = amxc_string_get(path, 0);
+    const bool converted = obj_process_object_params(id, param_values, extract_key, ret, path_cstr);
+    flight_recorder_add(fr_op_span_conversion, id, get_onu_index(path_cstr),
+                        latency_now_us() - start_us, converted ? 0 : -1);
+    return converted;
+}
+
+/**
+ * Call get() on a prpl xpon_onu object, and convert the reply for
+ * tr181-xpon.
+ *
+ * @param[in] ctx          bus context
+ * @param[in] id           ID of the object @a path refers to
+ * @param[in] path         object in prpl xpon_onu DM to call get() on
+ * @param[in] extract_key  true if @a path refers to an instance of a template
+ *                         object: then @a ret also gets the key
+ * @param[in,out] ret      the function returns the result via this
+ *                         parameter. See obj_process_object_params().
+ *
+ * If the backend has a 'query' function, it decodes the reply straight into
+ * @a ret. Else the function calls sbi_query_object() and converts its result
+ * with obj_process_object_params().
+ *
+ * @return true on success, else false
+ */
+bool sbi_get_object_content(amxb_bus_ctx_t* ctx,
+                            object_id_t id,
+                            const amxc_string_t* const path,
+                            bool extract_key,
+                            amxc_var_t* const ret) {
+    if(backend_converts_replies()) {
+        return call_function_common(ctx, id, path, sbi_method_get, /*args=*/ NULL,
+                                    extract_key ? sbi_reply_bbf_with_key : sbi_reply_bbf, ret);
+    }
+
+    amxc_var_t param_values;
+    amxc_var_init(&param_values);
+
+    const bool rv = sbi_query_object(ctx, id, path, &param_values) &&
+        convert_reply(id, path, &param_values, extract_key, ret);
+
+    amxc_var_clean(&param_values);
+    return rv;
+}
+
+/**
+ * Call get_params() on a prpl xpon_onu object, and convert the reply for
+ * tr181-xpon.
+ *
+ * @param[in] ctx       bus context
+ * @param[in] id        ID of the object @a path refers to
+ * @param[in] path      object in prpl xpon_onu DM to call get_params() on
+ * @param[in] names     prpl param names, formatted as a comma-separated list
+ * @param[in,out] ret   the function returns the result via this parameter.
+ *                      See obj_process_object_params().
+ *
+ * See sbi_get_object_content() for how the function converts the reply.
+ *
+ * @return true on success, else false
+ */
+bool sbi_get_param_values(amxb_bus_ctx_t* ctx,
+                          object_id_t id,
+                          const amxc_string_t* const path,
+                          const char* const names,
+                          amxc_var_t* const ret) {
+    bool rv = false;
+
+    if(backend_converts_replies()) {
+        amxc_var_t args;
+        amxc_var_init(&args);
+        amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(cstring_t, &args, "names", names);
+        rv = call_function_common(ctx, id, path, sbi_method_get_params, &args, sbi_reply_bbf, ret);
+        amxc_var_clean(&args);
+    } else {
+        amxc_var_t param_values;
+        amxc_var_init(&param_values);
+        rv = sbi_query_params(ctx, id, path, names, &param_values) &&
+            convert_reply(id, path, &param_values, /*extract_key=*/ false, ret);
+        amxc_var_clean(&param_values);
+    }
+
+    return rv;
+}
+
+/**
+ * Add a 'southbound' section with the call statistics to @a stats.
+ *
+ * @param[in,out] stats  htable
+ *
+ * The section has the keys 'methods' (statistics per method) and 'objects'
+ * (statistics per object, by generic BBF path). Objects which were never
+ * called are left out. A build with the ubus backend adds the section
+ * 'id_cache'.
+ */
+void sbi_get_stats(amxc_var_t* const stats) {
+
+    uint32_t i;
+
+    when_null(stats, exit);
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "southbound", NULL);
+    when_null(section, exit);
+
+    amxc_var_t* const methods = amxc_var_add_key(amxc_htable_t, section, "methods", NULL);
+    for(i = 0; i < sbi_method_nr; ++i) {
+        amxc_var_t* const var = amxc_var_add_key(amxc_htable_t, methods, SBI_METHOD_NAMES[i], NULL);
+        latency_stats_to_var(&s_stats.per_method[i], var);
+    }
+
+    amxc_var_t* const objects = amxc_var_add_key(amxc_htable_t, section, "objects", NULL);
+    for(i = 0; i <= obj_id_nbr; ++i) {
+        if(0 == s_stats.per_object[i].count) {
+            continue;
+        }
+        /* dm_get_object_info() logs an error for obj_id_unknown */
+        const object_info_t* const info = (i < obj_id_nbr) ?
+            dm_get_object_info((object_id_t) i) : NULL;
+        const char* const name = info ? info->bbf_path : "unknown";
+        amxc_var_t* const var = amxc_var_add_key(amxc_htable_t, objects, name, NULL);
+        latency_stats_to_var(&s_stats.per_object[i], var);
+    }
+
+#ifdef CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND
+    sbi_ubus_get_stats(section);
+#endif
+
+exit:
+    return;
+}
+
+void sbi_reset_stats(void) {
+    memset(&s_stats, 0, sizeof(s_stats));
+#ifdef CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND
+    sbi_ubus_reset_stats();
+#endif
+}
+
+/**
+ * Clean up the southbound interface.
+ *
+ * Select the default backend again, and free the resources of the other
+ * backends.
+ *
+ * The module must call this function once when stopping, after
+ * notif_cleanup().
+ */
+void sbi_cleanup(void) {
+    s_backend = &SBI_AMXB_BACKEND;
+    sbi_loopback_cleanup();
+#ifdef CONFIG_SAH_MOD_XPON_PRPL_UBUS_BACKEND
+    sbi_ubus_cleanup();
+#endif
+}
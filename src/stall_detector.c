@@ -0,0 +1,341 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "stall_detector.h"
+
+#include <stdio.h>  /* snprintf() */
+#include <string.h> /* memset(), memmove() */
+
+#include <amxc/amxc_macros.h> /* when_null() */
+
+#include "latency_stats.h"
+#include "mod_xpon_trace.h"
+
+#define STALL_PATH_LEN 64
+#define STALL_METHOD_LEN 32
+
+static const char* const STALL_ENTRY_NAMES[stall_entry_nr] = {
+    "pon_ctrl",
+    "notif_handler",
+    "notif_drain",
+    "pon_stat_flush",
+    "constructor"
+};
+
+/* A blocking call made by the module, e.g. an amxb_call() */
+typedef struct _stall_call {
+    uint64_t duration_us;
+    char path[STALL_PATH_LEN];
+    char method[STALL_METHOD_LEN];
+} stall_call_t;
+
+/* A stall: an invocation of an entry point taking longer than 'warn_us' */
+typedef struct _stall_record {
+    uint64_t ts_us;
+    uint64_t duration_us;
+    stall_entry_t entry;
+    char path[STALL_PATH_LEN];
+    char method[STALL_METHOD_LEN];
+    stall_call_t slowest_call; /* slowest blocking call during the stall */
+} stall_record_t;
+
+typedef struct _entry_stats {
+    latency_stats_t duration;
+    uint64_t n_stalls;
+    uint64_t n_severe_stalls;
+} entry_stats_t;
+
+static uint64_t s_warn_us = STALL_DEFAULT_WARN_MS * 1000;
+static uint64_t s_severe_us = STALL_DEFAULT_SEVERE_MS * 1000;
+
+static entry_stats_t s_entry_stats[stall_entry_nr];
+
+/* Worst stalls, the longest one first */
+static stall_record_t s_worst[STALL_N_WORST];
+static uint32_t s_n_worst = 0;
+
+/* Entry points can nest, e.g. a notification arriving while the module waits
+ * for the reply of an ONU HAL agent. Only the outermost one is measured. */
+static uint32_t s_depth = 0;
+static stall_call_t s_slowest_call;
+
+static void copy_str(char* const dest, size_t size, const char* const src) {
+    snprintf(dest, size, "%s", src ? src : "");
+}
+
+/**
+ * Start measuring an invocation of an entry point.
+ *
+ * @return the start time to pass to stall_detector_end()
+ */
+uint64_t stall_detector_begin(void) {
+
+    if(0 == s_depth) {
+        s_slowest_call.duration_us = 0;
+        s_slowest_call.path[0] = '\0';
+        s_slowest_call.method[0] = '\0';
+    }
+    ++s_depth;
+    return latency_now_us();
+}
+
+static void add_worst(const stall_record_t* const record) {
+
+    uint32_t pos;
+
+    for(pos = 0; pos < s_n_worst; ++pos) {
+        if(record->duration_us > s_worst[pos].duration_us) {
+            break;
+        }
+    }
+    if(pos >= STALL_N_WORST) {
+        return;
+    }
+    const uint32_t n_move = ((s_n_worst < STALL_N_WORST) ? s_n_worst : (STALL_N_WORST - 1)) - pos;
+    memmove(&s_worst[pos + 1], &s_worst[pos], n_move * sizeof(stall_record_t));
+    s_worst[pos] = *record;
+    if(s_n_worst < STALL_N_WORST) {
+        ++s_n_worst;
+    }
+}
+
+/**
+ * Stop measuring an invocation of an entry point.
+ *
+ * @param[in] entry     entry point
+ * @param[in] start_us  return value of stall_detector_begin()
+ * @param[in] method    e.g., the name of the pon_ctrl function. If NULL, the
+ *                      function takes the value for the key 'notification' in
+ *                      @a args, if any.
+ * @param[in] args      arguments of the invocation, or NULL. If it's an
+ *                      htable, the function takes the path the invocation was
+ *                      about from its key 'path'. If it's a string, the string
+ *                      is the path.
+ *
+ * The function only looks at @a args if the invocation was a stall.
+ */
+void stall_detector_end(stall_entry_t entry, uint64_t start_us,
+                        const char* const method, const amxc_var_t* const args) {
+
+    when_false(s_depth > 0, exit);
+    --s_depth;
+    when_false(0 == s_depth, exit);
+    when_false(entry < stall_entry_nr, exit);
+
+    const uint64_t duration_us = latency_now_us() - start_us;
+    entry_stats_t* const stats = &s_entry_stats[entry];
+
+    latency_stats_add(&stats->duration, duration_us);
+    when_false(duration_us > s_warn_us, exit);
+
+    ++stats->n_stalls;
+    if(duration_us > s_severe_us) {
+        ++stats->n_severe_stalls;
+        SAH_TRACEZ_WARNING(ME, "%s %s blocked the event loop for %llu ms",
+                           STALL_ENTRY_NAMES[entry], method ? method : "",
+                           (unsigned long long) (duration_us / 1000));
+    }
+
+    if((s_n_worst == STALL_N_WORST) &&
+       (duration_us <= s_worst[STALL_N_WORST - 1].duration_us)) {
+        goto exit;
+    }
+
+    const char* path = NULL;
+    const char* name = method;
+    if(args && (amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE)) {
+        path = GET_CHAR(args, "path");
+        if(NULL == name) {
+            name = GET_CHAR(args, "notification");
+        }
+    } else if(args && (amxc_var_type_of(args) == AMXC_VAR_ID_CSTRING)) {
+        path = amxc_var_constcast(cstring_t, args);
+    }
+
+    stall_record_t record;
+    record.ts_us = latency_now_us();
+    record.duration_us = duration_us;
+    record.entry = entry;
+    copy_str(record.path, sizeof(record.path), path);
+    copy_str(record.method, sizeof(record.method), name);
+    record.slowest_call = s_slowest_call;
+    add_worst(&record);
+
+exit:
+    return;
+}
+
+/**
+ * Report a blocking call made by the module.
+ *
+ * @param[in] path         e.g., the prpl path the call was made on
+ * @param[in] method       e.g., "get"
+ * @param[in] duration_us  how long the call took
+ *
+ * The function only keeps the slowest call made during the current
+ * invocation of an entry point.
+ */
+void stall_detector_note_call(const char* const path, const char* const method,
+                              uint64_t duration_us) {
+
+    if((0 == s_depth) || (duration_us <= s_slowest_call.duration_us)) {
+        return;
+    }
+    s_slowest_call.duration_us = duration_us;
+    copy_str(s_slowest_call.path, sizeof(s_slowest_call.path), path);
+    copy_str(s_slowest_call.method, sizeof(s_slowest_call.method), method);
+}
+
+/**
+ * Set the thresholds for a stall and a severe stall.
+ *
+ * @param[in] warn_ms    an invocation taking longer is a stall. Must not be 0.
+ * @param[in] severe_ms  an invocation taking longer is a severe stall. Must not
+ *                       be smaller than @a warn_ms.
+ *
+ * @return true on success, else false
+ */
+bool stall_detector_set_thresholds(uint32_t warn_ms, uint32_t severe_ms) {
+
+    bool rv = false;
+
+    when_false_trace(warn_ms != 0, exit, ERROR, "warn_ms is 0");
+    when_false_trace(severe_ms >= warn_ms, exit, ERROR,
+                     "severe_ms=%u < warn_ms=%u", severe_ms, warn_ms);
+
+    SAH_TRACEZ_INFO(ME, "warn_ms=%u severe_ms=%u", warn_ms, severe_ms);
+    s_warn_us = (uint64_t) warn_ms * 1000;
+    s_severe_us = (uint64_t) severe_ms * 1000;
+    rv = true;
+
+exit:
+    return rv;
+}
+
+void stall_detector_get_thresholds(amxc_var_t* const thresholds) {
+
+    when_null(thresholds, exit);
+
+    amxc_var_add_key(uint32_t, thresholds, "warn_ms", (uint32_t) (s_warn_us / 1000));
+    amxc_var_add_key(uint32_t, thresholds, "severe_ms", (uint32_t) (s_severe_us / 1000));
+
+exit:
+    return;
+}
+
+/**
+ * Add a 'stalls' section to @a stats.
+ *
+ * @param[in,out] stats  htable
+ *
+ * The section has following keys:
+ * - 'thresholds': see stall_detector_get_thresholds()
+ * - 'entries': per entry point the duration statistics and the nr of (severe)
+ *   stalls
+ * - 'worst': list with the worst stalls, the longest one first
+ */
+void stall_detector_get_stats(amxc_var_t* const stats) {
+
+    uint32_t i;
+
+    when_null(stats, exit);
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "stalls", NULL);
+    when_null(section, exit);
+
+    amxc_var_t* const thresholds = amxc_var_add_key(amxc_htable_t, section, "thresholds", NULL);
+    stall_detector_get_thresholds(thresholds);
+
+    amxc_var_t* const entries = amxc_var_add_key(amxc_htable_t, section, "entries", NULL);
+    for(i = 0; i < stall_entry_nr; ++i) {
+        amxc_var_t* const entry = amxc_var_add_key(amxc_htable_t, entries, STALL_ENTRY_NAMES[i], NULL);
+        latency_stats_to_var(&s_entry_stats[i].duration, entry);
+        amxc_var_add_key(uint64_t, entry, "stalls", s_entry_stats[i].n_stalls);
+        amxc_var_add_key(uint64_t, entry, "severe_stalls", s_entry_stats[i].n_severe_stalls);
+    }
+
+    amxc_var_t* const worst = amxc_var_add_key(amxc_llist_t, section, "worst", NULL);
+    for(i = 0; i < s_n_worst; ++i) {
+        const stall_record_t* const record = &s_worst[i];
+        amxc_var_t* const var = amxc_var_add(amxc_htable_t, worst, NULL);
+        amxc_var_add_key(uint64_t, var, "ts_us", record->ts_us);
+        amxc_var_add_key(uint64_t, var, "duration_us", record->duration_us);
+        amxc_var_add_key(cstring_t, var, "entry", STALL_ENTRY_NAMES[record->entry]);
+        amxc_var_add_key(cstring_t, var, "path", record->path);
+        amxc_var_add_key(cstring_t, var, "method", record->method);
+        if(record->slowest_call.duration_us != 0) {
+            amxc_var_t* const call = amxc_var_add_key(amxc_htable_t, var, "slowest_call", NULL);
+            amxc_var_add_key(cstring_t, call, "path", record->slowest_call.path);
+            amxc_var_add_key(cstring_t, call, "method", record->slowest_call.method);
+            amxc_var_add_key(uint64_t, call, "duration_us", record->slowest_call.duration_us);
+        }
+    }
+
+exit:
+    return;
+}
+
+void stall_detector_reset_stats(void) {
+    memset(s_entry_stats, 0, sizeof(s_entry_stats));
+    memset(s_worst, 0, sizeof(s_worst));
+    s_n_worst = 0;
+}
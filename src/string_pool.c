@@ -0,0 +1,338 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "string_pool.h"
+
+#include <stdint.h>
+#include <stdlib.h> /* calloc(), free() */
+#include <string.h> /* strlen(), strncmp(), memcpy() */
+
+#include <amxc/amxc_macros.h> /* when_null() */
+#include <amxc/amxc.h>
+
+#include "mod_xpon_trace.h"
+
+/* Nr of buckets: a power of 2 */
+#define STRING_POOL_N_BUCKETS 256
+
+/**
+ * String in the pool.
+ *
+ * - next: next string in the same bucket
+ * - next_by_ptr: next string in the same bucket of s_by_ptr
+ * - str: the string. It points to a static string added with
+ *     string_pool_add_static(), or to 'buf'.
+ * - len: strlen(str)
+ * - hash: hash of 'str'
+ * - refs: nr of references to an interned string. 0 for a static string.
+ * - buf: copy of an interned string
+ *
+ * The pool does not use an amxc_htable_t: it copies each key, and the point
+ * of the pool is to not copy the static strings.
+ */
+typedef struct _pool_string {
+    struct _pool_string* next;
+    struct _pool_string* next_by_ptr;
+    const char* str;
+    size_t len;
+    uint32_t hash;
+    uint32_t refs;
+    char buf[];
+} pool_string_t;
+
+/* Strings by hash of their contents */
+static pool_string_t* s_buckets[STRING_POOL_N_BUCKETS];
+/* Strings by address: string_pool_release() finds a string by pointer */
+static pool_string_t* s_by_ptr[STRING_POOL_N_BUCKETS];
+
+typedef struct _pool_stats {
+    uint32_t n_static;   /* static strings */
+    uint32_t n_interned; /* strings copied into the pool */
+    uint64_t bytes;      /* size of the strings copied into the pool */
+    uint64_t hits;       /* string_pool_intern() calls for a string in the pool */
+    uint64_t misses;     /* string_pool_intern() calls which added a string */
+} pool_stats_t;
+
+static pool_stats_t s_stats;
+
+/* FNV-1a */
+static uint32_t hash_string(const char* const str, size_t len) {
+
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    for(i = 0; i < len; ++i) {
+        hash ^= (uint8_t) str[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static pool_string_t* find(const char* const str, size_t len, uint32_t hash) {
+
+    pool_string_t* node = s_buckets[hash & (STRING_POOL_N_BUCKETS - 1)];
+
+    while(node != NULL) {
+        if((node->hash == hash) && (node->len == len) && (strncmp(node->str, str, len) == 0)) {
+            break;
+        }
+        node = node->next;
+    }
+    return node;
+}
+
+static uint32_t ptr_bucket(const char* const str) {
+    /* The low bits of a heap address are mostly the same */
+    return (uint32_t) (((uintptr_t) str) >> 4) & (STRING_POOL_N_BUCKETS - 1);
+}
+
+static void insert(pool_string_t* const node) {
+
+    pool_string_t** const bucket = &s_buckets[node->hash & (STRING_POOL_N_BUCKETS - 1)];
+    pool_string_t** const by_ptr = &s_by_ptr[ptr_bucket(node->str)];
+
+    node->next = *bucket;
+    *bucket = node;
+    node->next_by_ptr = *by_ptr;
+    *by_ptr = node;
+}
+
+static void unlink_node(pool_string_t* const node) {
+
+    pool_string_t** link = &s_buckets[node->hash & (STRING_POOL_N_BUCKETS - 1)];
+    while(*link != node) {
+        link = &(*link)->next;
+    }
+    *link = node->next;
+
+    link = &s_by_ptr[ptr_bucket(node->str)];
+    while(*link != node) {
+        link = &(*link)->next_by_ptr;
+    }
+    *link = node->next_by_ptr;
+}
+
+/**
+ * Add the static string @a str to the pool without copying it.
+ *
+ * @param[in] str  string which stays valid while the module is loaded, e.g.,
+ *                 a param name in a table in dm_info.c
+ *
+ * If the pool already has the string, the function keeps it.
+ *
+ * @return the pooled string equal to @a str: @a str itself, or the string
+ *         the pool already had. NULL on error.
+ */
+const char* string_pool_add_static(const char* const str) {
+
+    const char* rv = NULL;
+    when_null(str, exit);
+
+    const size_t len = strlen(str);
+    const uint32_t hash = hash_string(str, len);
+    const pool_string_t* const existing = find(str, len, hash);
+    if(existing != NULL) {
+        rv = existing->str;
+        goto exit;
+    }
+
+    pool_string_t* const node = (pool_string_t*) calloc(1, sizeof(pool_string_t));
+    when_null_trace(node, exit, ERROR, "Failed to allocate mem");
+    node->str = str;
+    node->len = len;
+    node->hash = hash;
+    insert(node);
+    ++s_stats.n_static;
+    rv = node->str;
+
+exit:
+    return rv;
+}
+
+/**
+ * Return the pooled copy of @a str, or NULL on error.
+ *
+ * The caller must pass the returned pointer to string_pool_release() when it
+ * no longer needs it.
+ */
+const char* string_pool_intern(const char* const str) {
+
+    const char* rv = NULL;
+    when_null(str, exit);
+
+    const size_t len = strlen(str);
+    const uint32_t hash = hash_string(str, len);
+    pool_string_t* node = find(str, len, hash);
+    if(node != NULL) {
+        if(node->str == node->buf) {
+            ++node->refs;
+        }
+        ++s_stats.hits;
+        rv = node->str;
+        goto exit;
+    }
+
+    node = (pool_string_t*) calloc(1, sizeof(pool_string_t) + len + 1);
+    when_null_trace(node, exit, ERROR, "Failed to allocate mem");
+    memcpy(node->buf, str, len + 1);
+    node->str = node->buf;
+    node->len = len;
+    node->hash = hash;
+    node->refs = 1;
+    insert(node);
+    ++s_stats.n_interned;
+    s_stats.bytes += len + 1;
+    ++s_stats.misses;
+    rv = node->str;
+
+exit:
+    return rv;
+}
+
+/**
+ * Drop a reference to @a str, a string returned by string_pool_intern().
+ *
+ * The function finds the string by its address: it does not look at the
+ * contents.
+ */
+void string_pool_release(const char* const str) {
+
+    when_null(str, exit);
+
+    pool_string_t* node = s_by_ptr[ptr_bucket(str)];
+    while((node != NULL) && (node->str != str)) {
+        node = node->next_by_ptr;
+    }
+    when_null_trace(node, exit, ERROR, "'%s' is not in the pool", str);
+
+    if((node->str == node->buf) && (--node->refs == 0)) {
+        unlink_node(node);
+        --s_stats.n_interned;
+        s_stats.bytes -= node->len + 1;
+        free(node);
+    }
+
+exit:
+    return;
+}
+
+/**
+ * Return the pooled string equal to the first @a len characters of @a str,
+ * or NULL if the pool does not have it.
+ *
+ * The function does not add the string, nor a reference to it. It lets the
+ * caller compare a string with pooled strings by pointer, e.g., with the
+ * param names in dm_info.c.
+ */
+const char* string_pool_lookup(const char* const str, size_t len) {
+
+    const pool_string_t* const node = str ? find(str, len, hash_string(str, len)) : NULL;
+    return node ? node->str : NULL;
+}
+
+/**
+ * Add a 'string_pool' section with the counters of the pool to @a stats.
+ *
+ * @param[in,out] stats  htable
+ */
+void string_pool_get_stats(amxc_var_t* const stats) {
+
+    when_null(stats, exit);
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "string_pool", NULL);
+    when_null(section, exit);
+
+    amxc_var_add_key(uint32_t, section, "static_strings", s_stats.n_static);
+    amxc_var_add_key(uint32_t, section, "interned_strings", s_stats.n_interned);
+    amxc_var_add_key(uint64_t, section, "bytes", s_stats.bytes);
+    amxc_var_add_key(uint64_t, section, "hits", s_stats.hits);
+    amxc_var_add_key(uint64_t, section, "misses", s_stats.misses);
+
+exit:
+    return;
+}
+
+void string_pool_reset_stats(void) {
+    s_stats.hits = 0;
+    s_stats.misses = 0;
+}
+
+/**
+ * Empty the pool.
+ *
+ * The module must call this function once when stopping, after the parts
+ * which intern strings cleaned up.
+ */
+void string_pool_cleanup(void) {
+
+    uint32_t i;
+
+    for(i = 0; i < STRING_POOL_N_BUCKETS; ++i) {
+        while(s_buckets[i] != NULL) {
+            pool_string_t* const node = s_buckets[i];
+            s_buckets[i] = node->next;
+            free(node);
+        }
+        s_by_ptr[i] = NULL;
+    }
+    s_stats = (pool_stats_t) { 0 };
+}
@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "trace_id.h"
+
+#include "mod_xpon_trace.h"
+
+static uint32_t s_last_id = 0;
+static uint32_t s_current_id = 0;
+static bool s_propagate = false;
+
+/**
+ * Return a new trace ID.
+ *
+ * The IDs are unique until the counter wraps, and never 0.
+ */
+uint32_t trace_id_new(void) {
+    ++s_last_id;
+    if(0 == s_last_id) {
+        s_last_id = 1;
+    }
+    return s_last_id;
+}
+
+uint32_t trace_id_current(void) {
+    return s_current_id;
+}
+
+/**
+ * Make @a id the current trace ID.
+ *
+ * @return the previous current trace ID. The caller must restore it with
+ *         trace_id_swap() when done, as requests and notifications can nest.
+ */
+uint32_t trace_id_swap(uint32_t id) {
+    const uint32_t previous = s_current_id;
+    s_current_id = id;
+    return previous;
+}
+
+/**
+ * Enable or disable passing the trace ID to the ONU HAL agents.
+ *
+ * It's disabled by default: an agent might reject the extra argument.
+ */
+void trace_id_set_propagation(bool enable) {
+    if(s_propagate != enable) {
+        SAH_TRACEZ_INFO(ME, "propagate trace ID: %d -> %d", s_propagate, enable);
+        s_propagate = enable;
+    }
+}
+
+bool trace_id_propagation_enabled(void) {
+    return s_propagate;
+}
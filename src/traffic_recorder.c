@@ -0,0 +1,258 @@
+/****************************************************************************
+**
+** SPDX-License-Identifier: BSD-2-Clause-Patent
+**
+** SPDX-FileCopyrightText: Copyright (c) 2022 SoftAtHome
+**
+** Redistribution and use in source and binary forms, with or
+** without modification, are permitted provided that the following
+** conditions are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+** notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above
+** copyright notice, this list of conditions and the following
+** disclaimer in the documentation and/or other materials provided
+** with the distribution.
+**
+** Subject to the terms and conditions of this license, each
+** copyright holder and contributor hereby grants to those receiving
+** rights under this license a perpetual, worldwide, non-exclusive,
+** no-charge, royalty-free, irrevocable (except for failure to
+** satisfy the conditions of this license) patent license to make,
+** have made, use, offer to sell, sell, import, and otherwise
+** transfer this software, where such license applies only to those
+** patent claims, already acquired or hereafter acquired, licensable
+** by such copyright holder or contributor that are necessarily
+** infringed by:
+**
+** (a) their Contribution(s) (the licensed copyrights of copyright
+** holders and non-copyrightable additions of contributors, in
+** source or binary form) alone; or
+**
+** (b) combination of their Contribution(s) with the work of
+** authorship to which such Contribution(s) was added by such
+** copyright holder or contributor, if, at the time the Contribution
+** is added, such addition causes such combination to be necessarily
+** infringed. The patent license shall not apply to any other
+** combinations which include the Contribution.
+**
+** Except as expressly stated above, no rights or licenses from any
+** copyright holder or contributor is granted under this license,
+** whether expressly, by implication, estoppel or otherwise.
+**
+** DISCLAIMER
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+** CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+** INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+** MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+** DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR
+** CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+** USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+** AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+** LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+** ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+** POSSIBILITY OF SUCH DAMAGE.
+**
+****************************************************************************/
+
+#include "traffic_recorder.h"
+
+#include <errno.h>
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>    /* fopen(), fprintf() */
+#include <stdlib.h>   /* free() */
+#include <string.h>   /* strerror() */
+
+#include <amxc/amxc_macros.h> /* when_null() */
+#include <amxc/amxc_string.h>
+
+#include "latency_stats.h" /* latency_now_us() */
+#include "mod_xpon_trace.h"
+
+static FILE* s_file = NULL;
+static uint64_t s_start_us = 0;
+
+/* Buffer to format a record in, reused to avoid an allocation per record */
+static amxc_string_t s_line;
+
+/**
+ * Start recording to @a file. The function truncates the file. If the module
+ * is already recording, it stops that recording first.
+ *
+ * @return true on success, else false
+ */
+bool traffic_recorder_start(const char* const file) {
+    bool rv = false;
+
+    when_null_trace(file, exit, ERROR, "No file");
+    traffic_recorder_stop();
+
+    s_file = fopen(file, "w");
+    when_null_trace(s_file, exit, ERROR, "Failed to open %s: %s", file, strerror(errno));
+
+    amxc_string_init(&s_line, 256);
+    s_start_us = latency_now_us();
+    fprintf(s_file, "# mod-xpon-prpl traffic trace v1\n");
+    SAH_TRACEZ_INFO(ME, "Recording southbound traffic to %s", file);
+
+    rv = true;
+
+exit:
+    return rv;
+}
+
+void traffic_recorder_stop(void) {
+    if(s_file) {
+        fclose(s_file);
+        s_file = NULL;
+        amxc_string_clean(&s_line);
+        SAH_TRACEZ_INFO(ME, "Stopped recording southbound traffic");
+    }
+}
+
+bool traffic_recorder_is_active(void) {
+    return (s_file != NULL);
+}
+
+/* Append @a str to the line, percent-encoding the chars with a meaning in the format */
+static void append_escaped(const char* str) {
+    static const char HEX[] = "0123456789ABCDEF";
+    const char* start = str;
+    const char* p;
+
+    for(p = str; *p; ++p) {
+        const unsigned char c = (unsigned char) *p;
+        if((c > ' ') && (c != '%') && (c != ',') && (c != ':') && (c != 0x7f)) {
+            continue;
+        }
+        amxc_string_append(&s_line, start, (size_t) (p - start));
+        const char escaped[3] = { '%', HEX[c >> 4], HEX[c & 0xf] };
+        amxc_string_append(&s_line, escaped, sizeof(escaped));
+        start = p + 1;
+    }
+    amxc_string_append(&s_line, start, (size_t) (p - start));
+}
+
+/* Append a field separator, followed by @a table in the format of the trace */
+static void append_table(const amxc_var_t* table, const char* const skip_key) {
+    bool empty = true;
+
+    amxc_string_append(&s_line, "\t", 1);
+
+    /* A reply is a list with the table as only element */
+    if(table && (amxc_var_type_of(table) == AMXC_VAR_ID_LIST)) {
+        const amxc_llist_it_t* const first = amxc_llist_get_first(amxc_var_constcast(amxc_llist_t, table));
+        table = first ? amxc_var_from_llist_it(first) : NULL;
+    }
+    when_null(table, exit);
+    when_false(amxc_var_type_of(table) == AMXC_VAR_ID_HTABLE, exit);
+
+    amxc_var_for_each(var, table) {
+        const char* const key = amxc_var_key(var);
+        if((NULL == key) || (skip_key && (strcmp(key, skip_key) == 0))) {
+            continue;
+        }
+        if(!empty) {
+            amxc_string_append(&s_line, ",", 1);
+        }
+        empty = false;
+        append_escaped(key);
+
+        switch(amxc_var_type_of(var)) {
+        case AMXC_VAR_ID_BOOL:
+            amxc_string_appendf(&s_line, ":b:%d", amxc_var_constcast(bool, var) ? 1 : 0);
+            break;
+        case AMXC_VAR_ID_INT8:
+        case AMXC_VAR_ID_INT16:
+        case AMXC_VAR_ID_INT32:
+        case AMXC_VAR_ID_INT64:
+            amxc_string_appendf(&s_line, ":i:%" PRId64, amxc_var_dyncast(int64_t, var));
+            break;
+        case AMXC_VAR_ID_UINT8:
+        case AMXC_VAR_ID_UINT16:
+        case AMXC_VAR_ID_UINT32:
+        case AMXC_VAR_ID_UINT64:
+            amxc_string_appendf(&s_line, ":u:%" PRIu64, amxc_var_dyncast(uint64_t, var));
+            break;
+        default:
+        {
+            char* const value = amxc_var_dyncast(cstring_t, var);
+            amxc_string_append(&s_line, ":s:", 3);
+            append_escaped(value ? value : "");
+            free(value);
+            break;
+        }
+        }
+    }
+
+exit:
+    if(empty) {
+        amxc_string_append(&s_line, "-", 1);
+    }
+}
+
+static void write_line(void) {
+    amxc_string_append(&s_line, "\n", 1);
+    if(fputs(amxc_string_get(&s_line, 0), s_file) == EOF) {
+        SAH_TRACEZ_ERROR(ME, "Failed to write record: %s", strerror(errno));
+        traffic_recorder_stop();
+    }
+}
+
+/**
+ * Record a southbound call.
+ *
+ * @param[in] path         object the module called the method on
+ * @param[in] method       method, e.g., "get"
+ * @param[in] args         arguments, or NULL
+ * @param[in] rc           return code of amxb_call()
+ * @param[in] reply        return value of amxb_call(), or NULL
+ * @param[in] start_us     latency_now_us() at the start of the call
+ * @param[in] duration_us  duration of the call
+ */
+void traffic_recorder_add_call(const char* const path, const char* const method,
+                               const amxc_var_t* const args, int rc,
+                               const amxc_var_t* const reply,
+                               uint64_t start_us, uint64_t duration_us) {
+    when_null(s_file, exit);
+
+    const size_t len = strlen(path);
+    amxc_string_reset(&s_line);
+    amxc_string_appendf(&s_line, "C\t%" PRIu64 "\t%" PRIu64 "\t%d\t", start_us - s_start_us,
+                        duration_us, rc);
+    /* Without trailing dot: as the HAL agent names the object */
+    amxc_string_append(&s_line, path, ((len > 0) && (path[len - 1] == '.')) ? len - 1 : len);
+    amxc_string_appendf(&s_line, "\t%s", method);
+    append_table(args, "trace_id");
+    append_table((rc == 0) ? reply : NULL, NULL);
+    write_line();
+
+exit:
+    return;
+}
+
+/**
+ * Record a notification the module received.
+ *
+ * @param[in] onu_index     xpon_onu instance index which sent the notification
+ * @param[in] notification  notification name, e.g., "dm:object-changed"
+ * @param[in] data          notification data
+ */
+void traffic_recorder_add_notif(uint32_t onu_index, const char* const notification,
+                                const amxc_var_t* const data) {
+    when_null(s_file, exit);
+
+    amxc_string_reset(&s_line);
+    amxc_string_appendf(&s_line, "N\t%" PRIu64 "\t%u\t%s", latency_now_us() - s_start_us,
+                        onu_index, notification);
+    append_table(data, "notification");
+    write_line();
+
+exit:
+    return;
+}
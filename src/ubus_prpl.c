@@ -69,9 +69,11 @@
 
 #include <amxc/amxc_macros.h> /* UNUSED */
 
+#include "latency_stats.h"    /* latency_now_us() */
 #include "mod_xpon_macros.h"  /* ARRAY_SIZE() */
 #include "mod_xpon_trace.h"
 #include "set_of_indexes.h"
+#include "stall_detector.h"   /* stall_detector_note_call() */
 
 #ifndef LINE_MAX
 #define LINE_MAX 256
@@ -134,7 +136,11 @@ static bool ubus_list_objects(const char* const prpl_path) {
     unlink(UBUS_LIST_OUTPUT_FILE);
     SAH_TRACEZ_DEBUG(ME, "%s", cmd);
 
-    if(system(cmd) != 0) {
+    const uint64_t start_us = latency_now_us();
+    const int status = system(cmd);
+    stall_detector_note_call(prpl_path, "ubus list", latency_now_us() - start_us);
+
+    if(status != 0) {
         SAH_TRACEZ_ERROR(ME, "Failed to run 'ubus list' command");
         goto exit;
     }
@@ -148,11 +154,26 @@ exit:
     return rv;
 }
 
-static bool extract_indexes(const char* const prpl_path,
-                            amxc_string_t* const indexes) {
+/**
+ * Parse the output of the 'ubus list' command.
+ *
+ * @param[in] file         output of the command 'ubus list <prpl_path>*'
+ * @param[in] prpl_path    path to template object in the prpl xpon_onu DM,
+ *                         e.g., "xpon_onu.1.software_image"
+ * @param[in,out] indexes  function returns the instance indexes found in
+ *                         @a file via this parameter, formatted as
+ *                         comma-separated integers.
+ *
+ * The function only looks at the lines with the path of an instance of
+ * @a prpl_path, e.g., "xpon_onu.1.software_image.2".
+ *
+ * @return true on success, else false
+ */
+bool ubus_prpl_parse_indexes(FILE* const file,
+                             const char* const prpl_path,
+                             amxc_string_t* const indexes) {
 
     bool rv = false;
-    FILE* file = NULL;
     char prpl_path_with_dot[256];
 
     set_of_indexes_t set;
@@ -161,10 +182,9 @@ static bool extract_indexes(const char* const prpl_path,
     amxc_string_t line_with_prpl_path;
     amxc_string_init(&line_with_prpl_path, 0);
 
-    SAH_TRACEZ_DEBUG(ME, "prpl_path='%s'", prpl_path);
-
-    file = fopen(UBUS_LIST_OUTPUT_FILE, "r");
-    when_null_trace(file, exit, ERROR, "Failed to open %s", UBUS_LIST_OUTPUT_FILE);
+    when_null(file, exit);
+    when_null(prpl_path, exit);
+    when_null(indexes, exit);
 
     char buf[LINE_MAX];
     snprintf(prpl_path_with_dot, 256, "%s.", prpl_path);
@@ -186,8 +206,6 @@ static bool extract_indexes(const char* const prpl_path,
             amxc_string_clean(&line_with_prpl_path);
         }
     }
-    fclose(file);
-    unlink(UBUS_LIST_OUTPUT_FILE);
 
     if(!set_of_indexes_get_indexes_as_string(&set, indexes)) {
         SAH_TRACEZ_ERROR(ME, "Failed to convert set of indexes to string");
@@ -203,6 +221,26 @@ exit:
     return rv;
 }
 
+static bool extract_indexes(const char* const prpl_path,
+                            amxc_string_t* const indexes) {
+
+    bool rv = false;
+    FILE* file = NULL;
+
+    SAH_TRACEZ_DEBUG(ME, "prpl_path='%s'", prpl_path);
+
+    file = fopen(UBUS_LIST_OUTPUT_FILE, "r");
+    when_null_trace(file, exit, ERROR, "Failed to open %s", UBUS_LIST_OUTPUT_FILE);
+
+    rv = ubus_prpl_parse_indexes(file, prpl_path, indexes);
+
+    fclose(file);
+    unlink(UBUS_LIST_OUTPUT_FILE);
+
+exit:
+    return rv;
+}
+
 
 /**
  * Get the instances of a template object in the prpl xpon_onu DM.
@@ -62,19 +62,78 @@
 
 #include "xpon_mgr_pon_stat.h"
 
-#include <amxm/amxm.h> /* amxm_execute_function() */
+#include <amxc/amxc_macros.h> /* when_null() */
+#include <amxm/amxm.h>        /* amxm_execute_function() */
+#include <amxp/amxp_timer.h>
 
 #include "mod_xpon_trace.h"
+#include "stall_detector.h"
 
 #define MOD_PON_STAT "pon_stat"
 
 /**
- * Call a function in the 'pon_stat' namespace of the tr181-xpon plugin.
+ * Function in the 'pon_stat' namespace accepting a batch of calls.
  *
- * @param[in] func_name   name of function to be called, e.g., "dm_instance_added"
- * @param[in] args        call the function with these arguments
+ * The module calls it with a list. Each element is an htable with the keys
+ * 'function' (e.g. "dm_instance_added") and 'args' (the args for that
+ * function). The tr181-xpon plugin must handle the elements in order.
  */
-void xpon_mngr_call_pon_stat_function(const char* const func_name, amxc_var_t* args) {
+#define PON_STAT_BATCH_FUNC "dm_batch"
+
+typedef struct _batch_config {
+    bool enable;
+    uint32_t max_batch_size;
+    uint32_t window_ms;
+} batch_config_t;
+
+static batch_config_t s_config = {
+    .enable = false,
+    .max_batch_size = PON_STAT_BATCH_DEFAULT_MAX_SIZE,
+    .window_ms = PON_STAT_BATCH_DEFAULT_WINDOW_MS
+};
+
+/* Calls waiting to be delivered to the tr181-xpon plugin */
+static amxc_var_t s_batch;
+static uint32_t s_batch_size = 0;
+static amxp_timer_t* s_flush_timer = NULL;
+static bool s_flush_scheduled = false;
+
+typedef struct _batch_stats {
+    uint64_t n_calls;        /* calls passed to xpon_mngr_call_pon_stat_function() */
+    uint64_t n_batches;      /* calls of PON_STAT_BATCH_FUNC */
+    uint64_t n_batched;      /* calls delivered via PON_STAT_BATCH_FUNC */
+    uint64_t n_unbatched;    /* calls delivered one by one */
+    uint64_t n_failed;       /* calls the plugin did not handle successfully */
+    uint64_t n_dropped;      /* pending calls dropped when the module stopped */
+    uint32_t max_batch_size; /* largest batch delivered */
+} batch_stats_t;
+
+static batch_stats_t s_stats;
+
+/**
+ * Return true if the 'pon_stat' namespace has PON_STAT_BATCH_FUNC.
+ *
+ * The module looks it up at each flush, not per call. It does not keep the
+ * handle of the namespace: the tr181-xpon plugin may deregister and register
+ * it again at any time, and amxm does not tell the module.
+ */
+static bool is_batch_supported(void) {
+
+    bool rv = false;
+
+    amxm_shared_object_t* const so = amxm_get_so("self");
+    when_null_trace(so, exit, ERROR, "Failed to get shared object 'self'");
+
+    amxm_module_t* const mod = amxm_so_get_module(so, MOD_PON_STAT);
+    when_null_trace(mod, exit, ERROR, "Failed to get namespace %s", MOD_PON_STAT);
+
+    rv = amxm_module_has_function(mod, PON_STAT_BATCH_FUNC);
+
+exit:
+    return rv;
+}
+
+static bool call_pon_stat_function(const char* const func_name, amxc_var_t* args) {
 
     amxc_var_t ret;
     amxc_var_init(&ret);
@@ -87,5 +146,254 @@ void xpon_mngr_call_pon_stat_function(const char* const func_name, amxc_var_t* a
     }
 
     amxc_var_clean(&ret);
+    return (rc == 0);
+}
+
+static void deliver_one_by_one(amxc_var_t* const batch) {
+
+    amxc_var_for_each(call, batch) {
+        const char* const func_name = GET_CHAR(call, "function");
+        amxc_var_t* const args = GET_ARG(call, "args");
+        if((NULL == func_name) || !call_pon_stat_function(func_name, args)) {
+            s_stats.n_failed++;
+        }
+        s_stats.n_unbatched++;
+    }
+}
+
+/**
+ * Deliver the calls in s_batch to the tr181-xpon plugin.
+ *
+ * Use PON_STAT_BATCH_FUNC if the plugin supports it, else call the functions
+ * one by one. If the batch call fails, the function drops the batch. The
+ * function counts the calls which fail in the stats: the caller of
+ * xpon_mngr_call_pon_stat_function() does not get to know about them.
+ */
+static void flush_batch(void) {
+
+    amxc_var_t batch;
+
+    if(0 == s_batch_size) {
+        return;
+    }
+
+    /* Take over the pending calls: the plugin may cause new ones while
+     * handling the batch. */
+    amxc_var_init(&batch);
+    amxc_var_move(&batch, &s_batch);
+    amxc_var_set_type(&s_batch, AMXC_VAR_ID_LIST);
+    const uint32_t size = s_batch_size;
+    s_batch_size = 0;
+
+    SAH_TRACEZ_DEBUG(ME, "Flush %u call(s)", size);
+
+    if(!is_batch_supported()) {
+        deliver_one_by_one(&batch);
+    } else if(call_pon_stat_function(PON_STAT_BATCH_FUNC, &batch)) {
+        s_stats.n_batches++;
+        s_stats.n_batched += size;
+        if(size > s_stats.max_batch_size) {
+            s_stats.max_batch_size = size;
+        }
+    } else {
+        /* The plugin may have applied part of the batch: passing the calls
+         * again one by one could apply some of them twice. */
+        SAH_TRACEZ_ERROR(ME, "%s() failed: drop %u call(s)", PON_STAT_BATCH_FUNC, size);
+        s_stats.n_failed += size;
+    }
+
+    amxc_var_clean(&batch);
+}
+
+static void flush_cb(UNUSED amxp_timer_t* timer, UNUSED void* priv) {
+    const uint64_t start_us = stall_detector_begin();
+    s_flush_scheduled = false;
+    flush_batch();
+    stall_detector_end(stall_entry_pon_stat_flush, start_us, "flush", NULL);
+}
+
+static void schedule_flush(void) {
+
+    if(s_flush_scheduled) {
+        return;
+    }
+    if((NULL == s_flush_timer) &&
+       (amxp_timer_new(&s_flush_timer, flush_cb, NULL) != 0)) {
+        SAH_TRACEZ_ERROR(ME, "Failed to create flush timer");
+        flush_batch();
+        return;
+    }
+    if(amxp_timer_start(s_flush_timer, s_config.window_ms) != 0) {
+        SAH_TRACEZ_ERROR(ME, "Failed to start flush timer");
+        flush_batch();
+        return;
+    }
+    s_flush_scheduled = true;
 }
 
+/**
+ * Initialize the 'xpon_mgr_pon_stat' part.
+ *
+ * The module must call this function once at startup.
+ */
+void xpon_mgr_pon_stat_init(void) {
+    amxc_var_init(&s_batch);
+    amxc_var_set_type(&s_batch, AMXC_VAR_ID_LIST);
+    s_batch_size = 0;
+}
+
+/**
+ * Clean up the 'xpon_mgr_pon_stat' part.
+ *
+ * Drop the calls which are still pending: the 'pon_stat' namespace may
+ * already be gone when the module stops. The module must call this function
+ * once when stopping.
+ */
+void xpon_mgr_pon_stat_cleanup(void) {
+    if(s_batch_size > 0) {
+        SAH_TRACEZ_WARNING(ME, "Drop %u pending call(s)", s_batch_size);
+        s_stats.n_dropped += s_batch_size;
+        s_batch_size = 0;
+    }
+    amxp_timer_delete(&s_flush_timer);
+    s_flush_scheduled = false;
+    amxc_var_clean(&s_batch);
+}
+
+/**
+ * Call a function in the 'pon_stat' namespace of the tr181-xpon plugin.
+ *
+ * @param[in] func_name   name of function to be called, e.g., "dm_instance_added"
+ * @param[in,out] args    call the function with these arguments
+ *
+ * If batching is enabled, the function moves @a args into the current batch
+ * without copying them, and returns. @a args is then empty. The module delivers the batch when it reaches the max batch
+ * size, or when the batch window expires. A window of 0 ms means: at the
+ * next iteration of the event loop. The calls keep their order.
+ *
+ * @return true if the function was called successfully or if the call was
+ *         added to the batch, else false. For a call added to the batch, the
+ *         caller does not get to know whether the plugin handled it
+ *         successfully: the stats count such a failure as 'failed_calls'.
+ */
+bool xpon_mngr_call_pon_stat_function(const char* const func_name, amxc_var_t* args) {
+
+    bool rv = false;
+
+    when_null(func_name, exit);
+    s_stats.n_calls++;
+
+    if(!s_config.enable) {
+        rv = call_pon_stat_function(func_name, args);
+        s_stats.n_unbatched++;
+        if(!rv) {
+            s_stats.n_failed++;
+        }
+        goto exit;
+    }
+
+    amxc_var_t* const call = amxc_var_add(amxc_htable_t, &s_batch, NULL);
+    when_null_trace(call, exit, ERROR, "Failed to add call to batch");
+    amxc_var_add_key(cstring_t, call, "function", func_name);
+    amxc_var_t* const call_args = amxc_var_add_new_key(call, "args");
+    if(args && call_args) {
+        /* Move: the args hold the forwarded param values, often strings */
+        amxc_var_move(call_args, args);
+    }
+    s_batch_size++;
+    rv = true;
+
+    if(s_batch_size >= s_config.max_batch_size) {
+        flush_batch();
+    } else {
+        schedule_flush();
+    }
+
+exit:
+    return rv;
+}
+
+/**
+ * Configure batched delivery of the calls to the 'pon_stat' namespace.
+ *
+ * @param[in] enable          enable or disable batching. Disabling it delivers
+ *                            the pending calls immediately.
+ * @param[in] max_batch_size  max nr of calls in one batch. Must be in
+ *                            [1, PON_STAT_BATCH_MAX_SIZE].
+ * @param[in] window_ms       max time a call waits in a batch
+ *
+ * @return true on success, else false
+ */
+bool xpon_mgr_pon_stat_set_batch_config(bool enable, uint32_t max_batch_size,
+                                        uint32_t window_ms) {
+    bool rv = false;
+
+    if((0 == max_batch_size) || (max_batch_size > PON_STAT_BATCH_MAX_SIZE)) {
+        SAH_TRACEZ_ERROR(ME, "max_batch_size=%u is not in [1, %d]",
+                         max_batch_size, PON_STAT_BATCH_MAX_SIZE);
+        goto exit;
+    }
+
+    SAH_TRACEZ_INFO(ME, "enable=%d max_batch_size=%u window_ms=%u",
+                    enable, max_batch_size, window_ms);
+    s_config.enable = enable;
+    s_config.max_batch_size = max_batch_size;
+    s_config.window_ms = window_ms;
+
+    if(!enable || (s_batch_size >= max_batch_size)) {
+        flush_batch();
+    }
+    rv = true;
+
+exit:
+    return rv;
+}
+
+/**
+ * Add the batching config to @a config.
+ *
+ * @param[in,out] config  htable
+ */
+void xpon_mgr_pon_stat_get_batch_config(amxc_var_t* const config) {
+
+    when_null(config, exit);
+
+    amxc_var_add_key(bool, config, "enable", s_config.enable);
+    amxc_var_add_key(uint32_t, config, "max_batch_size", s_config.max_batch_size);
+    amxc_var_add_key(uint32_t, config, "window_ms", s_config.window_ms);
+
+exit:
+    return;
+}
+
+/**
+ * Add a 'pon_stat' section with the config and counters to @a stats.
+ *
+ * @param[in,out] stats  htable
+ */
+void xpon_mgr_pon_stat_get_stats(amxc_var_t* const stats) {
+
+    when_null(stats, exit);
+
+    amxc_var_t* const section = amxc_var_add_key(amxc_htable_t, stats, "pon_stat", NULL);
+    when_null(section, exit);
+
+    amxc_var_t* const config = amxc_var_add_key(amxc_htable_t, section, "batch_config", NULL);
+    xpon_mgr_pon_stat_get_batch_config(config);
+
+    amxc_var_add_key(uint64_t, section, "calls", s_stats.n_calls);
+    amxc_var_add_key(uint64_t, section, "batches", s_stats.n_batches);
+    amxc_var_add_key(uint64_t, section, "batched_calls", s_stats.n_batched);
+    amxc_var_add_key(uint64_t, section, "unbatched_calls", s_stats.n_unbatched);
+    amxc_var_add_key(uint32_t, section, "max_batch_size", s_stats.max_batch_size);
+    amxc_var_add_key(uint64_t, section, "failed_calls", s_stats.n_failed);
+    amxc_var_add_key(uint64_t, section, "dropped_calls", s_stats.n_dropped);
+    amxc_var_add_key(uint32_t, section, "pending", s_batch_size);
+
+exit:
+    return;
+}
+
+void xpon_mgr_pon_stat_reset_stats(void) {
+    s_stats = (batch_stats_t) { 0 };
+}
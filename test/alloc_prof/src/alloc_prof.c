@@ -0,0 +1,386 @@
+/**
+ * Allocation profiler for mod-xpon-prpl.
+ *
+ * Preload this library in a process which loads the module, e.g., the
+ * end-to-end harness. It interposes malloc(), calloc(), realloc() and free(),
+ * and it counts the allocations and the allocated bytes:
+ * - per scope: a scope is an invocation of an entry point of the module, e.g.,
+ *   a pon_ctrl function or the handling of a notification. The profiler
+ *   interposes stall_detector_begin() and stall_detector_end() to find out
+ *   where an invocation starts and ends: the module already calls them at
+ *   each entry point.
+ * - per call site within a scope: the function which called malloc() & co.
+ *   Allocations outside any scope go to the scope 'outside'.
+ *
+ * At exit the profiler writes one JSON object per line to the file
+ * ALLOC_PROF_OUTPUT, or to stderr if that env var is not set. ALLOC_PROF_TOP
+ * sets the max nr of call sites reported per scope (default: 20).
+ *
+ * The profiler resolves a call site with dladdr(). A static function does not
+ * occur in the dynamic symbol table: its allocations show up under the
+ * nearest preceding exported symbol. The 'offset' field allows to find the
+ * exact location with addr2line.
+ */
+
+#define _GNU_SOURCE /* RTLD_NEXT, dladdr() */
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <amxc/amxc_variant.h>
+
+#include "stall_detector.h" /* stall_entry_t */
+
+#define MOD_SONAME "mod-xpon-prpl.so"
+
+#define MAX_SCOPES 128      /* distinct scope names */
+#define MAX_DEPTH 16        /* nesting of scopes */
+#define MAX_FRAME_SITES 128 /* distinct call sites per scope invocation */
+#define SITE_TABLE_SIZE 8192 /* power of 2 */
+#define NAME_SIZE 64
+
+/* glibc exports its allocator under these names as well */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+typedef struct _counters {
+    uint64_t allocs;
+    uint64_t bytes;
+    uint64_t frees;
+} counters_t;
+
+typedef struct _scope {
+    char name[NAME_SIZE];
+    uint64_t calls;
+    counters_t counters;
+} scope_t;
+
+typedef struct _frame_site {
+    const void* addr;
+    uint64_t allocs;
+    uint64_t bytes;
+} frame_site_t;
+
+/* An active invocation of an entry point */
+typedef struct _frame {
+    counters_t start;
+    uint32_t n_sites;
+    frame_site_t sites[MAX_FRAME_SITES];
+    frame_site_t other; /* sites which did not fit in 'sites' */
+} frame_t;
+
+typedef struct _site {
+    bool used;
+    uint32_t scope;
+    const void* addr;
+    uint64_t allocs;
+    uint64_t bytes;
+    char symbol[NAME_SIZE];
+    char object[NAME_SIZE];
+    uintptr_t offset;
+} site_t;
+
+typedef uint64_t (* begin_fn_t)(void);
+typedef void (* end_fn_t)(stall_entry_t entry, uint64_t start_us,
+                          const char* const method, const amxc_var_t* const args);
+
+static const char* const ENTRY_NAMES[stall_entry_nr] = {
+    "pon_ctrl", "notif_handler", "notif_drain", "pon_stat_flush", "constructor"
+};
+
+static counters_t s_total;
+static scope_t s_scopes[MAX_SCOPES] = { { .name = "outside" } };
+static uint32_t s_n_scopes = 1;
+static frame_t s_frames[MAX_DEPTH];
+static uint32_t s_depth = 0;
+static uint32_t s_overflow = 0; /* nr of nested frames beyond MAX_DEPTH */
+static site_t s_sites[SITE_TABLE_SIZE];
+static bool s_in_hook = false;
+
+static begin_fn_t s_real_begin = NULL;
+static end_fn_t s_real_end = NULL;
+
+static void frame_add_site(frame_t* const frame, const void* addr,
+                           uint64_t allocs, uint64_t bytes) {
+    uint32_t i;
+    for(i = 0; i < frame->n_sites; ++i) {
+        if(frame->sites[i].addr == addr) {
+            frame->sites[i].allocs += allocs;
+            frame->sites[i].bytes += bytes;
+            return;
+        }
+    }
+    if(frame->n_sites < MAX_FRAME_SITES) {
+        frame->sites[frame->n_sites].addr = addr;
+        frame->sites[frame->n_sites].allocs = allocs;
+        frame->sites[frame->n_sites].bytes = bytes;
+        frame->n_sites++;
+    } else {
+        frame->other.allocs += allocs;
+        frame->other.bytes += bytes;
+    }
+}
+
+static void resolve_site(site_t* const site) {
+    Dl_info info;
+    if(site->addr && dladdr(site->addr, &info)) {
+        const char* const slash = info.dli_fname ? strrchr(info.dli_fname, '/') : NULL;
+        snprintf(site->symbol, NAME_SIZE, "%s", info.dli_sname ? info.dli_sname : "?");
+        snprintf(site->object, NAME_SIZE, "%s",
+                 slash ? slash + 1 : (info.dli_fname ? info.dli_fname : "?"));
+        site->offset = (uintptr_t) site->addr - (uintptr_t) info.dli_fbase;
+    } else {
+        snprintf(site->symbol, NAME_SIZE, "%s", site->addr ? "?" : "(other)");
+        snprintf(site->object, NAME_SIZE, "?");
+    }
+}
+
+/**
+ * Add allocations of call site @a addr in scope @a scope to the site table.
+ *
+ * The function resolves the site when adding it: the object it belongs to
+ * may be unloaded by the time the profiler reports.
+ */
+static void add_site(uint32_t scope, const void* addr, uint64_t allocs, uint64_t bytes) {
+    uint32_t h = (uint32_t) ((((uintptr_t) addr) >> 2) * 2654435761u) ^ (scope * 40503u);
+    uint32_t n;
+    for(n = 0; n < SITE_TABLE_SIZE; ++n) {
+        site_t* const site = &s_sites[(h + n) & (SITE_TABLE_SIZE - 1)];
+        if(!site->used) {
+            site->used = true;
+            site->scope = scope;
+            site->addr = addr;
+            resolve_site(site);
+        }
+        if((site->scope == scope) && (site->addr == addr)) {
+            site->allocs += allocs;
+            site->bytes += bytes;
+            return;
+        }
+    }
+}
+
+static void record_alloc(const void* caller, size_t size) {
+    s_total.allocs++;
+    s_total.bytes += size;
+    if(s_in_hook) {
+        return;
+    }
+    s_in_hook = true;
+    if((s_depth > 0) && (s_overflow == 0)) {
+        frame_add_site(&s_frames[s_depth - 1], caller, 1, size);
+    } else if(s_depth == 0) {
+        s_scopes[0].counters.allocs++;
+        s_scopes[0].counters.bytes += size;
+        add_site(0, caller, 1, size);
+    }
+    s_in_hook = false;
+}
+
+void* malloc(size_t size) {
+    record_alloc(__builtin_return_address(0), size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+    record_alloc(__builtin_return_address(0), nmemb * size);
+    return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    record_alloc(__builtin_return_address(0), size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    if(ptr) {
+        s_total.frees++;
+        if(s_depth == 0) {
+            s_scopes[0].counters.frees++;
+        }
+    }
+    __libc_free(ptr);
+}
+
+/**
+ * Look up a function of the module.
+ *
+ * The tr181-xpon plugin, like the harness, loads the module with
+ * RTLD_LOCAL: RTLD_NEXT does not find its symbols.
+ */
+static void* find_module_symbol(const char* const name) {
+    void* handle = dlopen(MOD_SONAME, RTLD_LAZY | RTLD_NOLOAD);
+    void* sym = handle ? dlsym(handle, name) : NULL;
+    if(handle) {
+        dlclose(handle);
+    }
+    if(NULL == sym) {
+        sym = dlsym(RTLD_NEXT, name);
+    }
+    return sym;
+}
+
+uint64_t stall_detector_begin(void) {
+    if(NULL == s_real_begin) {
+        s_in_hook = true;
+        *(void**) (&s_real_begin) = find_module_symbol("stall_detector_begin");
+        s_in_hook = false;
+    }
+    if(s_depth < MAX_DEPTH) {
+        frame_t* const frame = &s_frames[s_depth++];
+        frame->start = s_total;
+        frame->n_sites = 0;
+        frame->other.addr = NULL;
+        frame->other.allocs = 0;
+        frame->other.bytes = 0;
+    } else {
+        s_overflow++;
+    }
+    return s_real_begin ? s_real_begin() : 0;
+}
+
+static uint32_t find_scope(stall_entry_t entry, const char* method,
+                           const amxc_var_t* const args) {
+    char name[NAME_SIZE];
+    uint32_t i;
+
+    if((NULL == method) && args && (amxc_var_type_of(args) == AMXC_VAR_ID_HTABLE)) {
+        method = amxc_var_constcast(cstring_t,
+                                    amxc_var_get_key(args, "notification", AMXC_VAR_FLAG_DEFAULT));
+    }
+    snprintf(name, NAME_SIZE, "%s:%s",
+             ((uint32_t) entry < stall_entry_nr) ? ENTRY_NAMES[entry] : "?",
+             method ? method : "?");
+
+    for(i = 1; i < s_n_scopes; ++i) {
+        if(strcmp(s_scopes[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if(s_n_scopes == MAX_SCOPES) {
+        return 0;
+    }
+    snprintf(s_scopes[s_n_scopes].name, NAME_SIZE, "%s", name);
+    return s_n_scopes++;
+}
+
+void stall_detector_end(stall_entry_t entry, uint64_t start_us,
+                        const char* const method, const amxc_var_t* const args) {
+    uint32_t i;
+
+    if(s_real_end == NULL) {
+        s_in_hook = true;
+        *(void**) (&s_real_end) = find_module_symbol("stall_detector_end");
+        s_in_hook = false;
+    }
+    if(s_real_end) {
+        s_real_end(entry, start_us, method, args);
+    }
+
+    if(s_overflow > 0) {
+        s_overflow--;
+        return;
+    }
+    if(s_depth == 0) {
+        return;
+    }
+
+    s_in_hook = true;
+    frame_t* const frame = &s_frames[--s_depth];
+    const uint32_t scope_id = find_scope(entry, method, args);
+    scope_t* const scope = &s_scopes[scope_id];
+    scope->calls++;
+    scope->counters.allocs += s_total.allocs - frame->start.allocs;
+    scope->counters.bytes += s_total.bytes - frame->start.bytes;
+    scope->counters.frees += s_total.frees - frame->start.frees;
+
+    /* Scopes are inclusive: the parent also gets the sites of the child */
+    frame_t* const parent = (s_depth > 0) ? &s_frames[s_depth - 1] : NULL;
+    for(i = 0; i < frame->n_sites; ++i) {
+        add_site(scope_id, frame->sites[i].addr, frame->sites[i].allocs, frame->sites[i].bytes);
+        if(parent) {
+            frame_add_site(parent, frame->sites[i].addr,
+                           frame->sites[i].allocs, frame->sites[i].bytes);
+        }
+    }
+    if(frame->other.allocs) {
+        add_site(scope_id, NULL, frame->other.allocs, frame->other.bytes);
+        if(parent) {
+            frame_add_site(parent, NULL, frame->other.allocs, frame->other.bytes);
+        }
+    }
+    s_in_hook = false;
+}
+
+static int compare_sites(const void* a, const void* b) {
+    const site_t* const x = *(const site_t* const*) a;
+    const site_t* const y = *(const site_t* const*) b;
+    return (x->allocs < y->allocs) - (x->allocs > y->allocs);
+}
+
+static double per_call(uint64_t value, uint64_t calls) {
+    return calls ? (double) value / (double) calls : (double) value;
+}
+
+static void report_scope(FILE* const out, uint32_t scope_id, uint32_t top) {
+    static const site_t* sorted[SITE_TABLE_SIZE];
+    const scope_t* const scope = &s_scopes[scope_id];
+    uint32_t n = 0;
+    uint32_t i;
+
+    fprintf(out, "{\"scope\":\"%s\",\"calls\":%llu,\"allocs\":%llu,\"bytes\":%llu,"
+            "\"frees\":%llu,\"allocs_per_call\":%.2f,\"bytes_per_call\":%.1f}\n",
+            scope->name, (unsigned long long) scope->calls,
+            (unsigned long long) scope->counters.allocs,
+            (unsigned long long) scope->counters.bytes,
+            (unsigned long long) scope->counters.frees,
+            per_call(scope->counters.allocs, scope->calls),
+            per_call(scope->counters.bytes, scope->calls));
+
+    for(i = 0; i < SITE_TABLE_SIZE; ++i) {
+        if(s_sites[i].used && (s_sites[i].scope == scope_id)) {
+            sorted[n++] = &s_sites[i];
+        }
+    }
+    qsort(sorted, n, sizeof(sorted[0]), compare_sites);
+    for(i = 0; (i < n) && (i < top); ++i) {
+        fprintf(out, "{\"scope\":\"%s\",\"site\":\"%s\",\"object\":\"%s\","
+                "\"offset\":\"0x%lx\",\"allocs\":%llu,\"bytes\":%llu,"
+                "\"allocs_per_call\":%.2f}\n",
+                scope->name, sorted[i]->symbol, sorted[i]->object,
+                (unsigned long) sorted[i]->offset,
+                (unsigned long long) sorted[i]->allocs,
+                (unsigned long long) sorted[i]->bytes,
+                per_call(sorted[i]->allocs, scope->calls));
+    }
+}
+
+static void __attribute__((destructor)) alloc_prof_report(void) {
+    const char* const path = getenv("ALLOC_PROF_OUTPUT");
+    const char* const top_str = getenv("ALLOC_PROF_TOP");
+    const uint32_t top = top_str ? (uint32_t) strtoul(top_str, NULL, 0) : 20;
+    FILE* out = stderr;
+    uint32_t i;
+
+    s_in_hook = true;
+    if(path && (NULL == (out = fopen(path, "w")))) {
+        out = stderr;
+    }
+
+    fprintf(out, "{\"scope\":\"total\",\"allocs\":%llu,\"bytes\":%llu,\"frees\":%llu}\n",
+            (unsigned long long) s_total.allocs, (unsigned long long) s_total.bytes,
+            (unsigned long long) s_total.frees);
+    for(i = 0; i < s_n_scopes; ++i) {
+        report_scope(out, i, top);
+    }
+
+    if(out != stderr) {
+        fclose(out);
+    }
+}
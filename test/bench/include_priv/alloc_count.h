@@ -0,0 +1,19 @@
+#ifndef __alloc_count_h__
+#define __alloc_count_h__
+
+/**
+ * @file alloc_count.h
+ *
+ * Count the heap allocations of the process.
+ *
+ * alloc_count.c defines malloc(), calloc(), realloc() and free(). They
+ * forward to the glibc implementation and count the calls. As the
+ * benchmark executable defines them, they also replace the ones used by the
+ * shared libraries, e.g., libamxc.
+ */
+
+#include <stdint.h>
+
+uint64_t alloc_count_get(void);
+
+#endif
@@ -0,0 +1,42 @@
+#include "alloc_count.h"
+
+#include <stddef.h> /* size_t */
+
+/* glibc exports its allocator under these names as well */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size);
+void* calloc(size_t nmemb, size_t size);
+void* realloc(void* ptr, size_t size);
+void free(void* ptr);
+
+static uint64_t s_n_allocs = 0;
+
+void* malloc(size_t size) {
+    ++s_n_allocs;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+    ++s_n_allocs;
+    return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    ++s_n_allocs;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+/**
+ * Return the nr of calls of malloc(), calloc() and realloc() so far.
+ */
+uint64_t alloc_count_get(void) {
+    return s_n_allocs;
+}
@@ -0,0 +1,378 @@
+/**
+ * Microbenchmarks for the hot helpers of mod-xpon-prpl.
+ *
+ * The benchmark links the translation units of the module directly. It does
+ * not need a bus, nor the tr181-xpon plugin, nor an ONU HAL agent.
+ *
+ * Each benchmark prints one JSON object per line on stdout:
+ *
+ *   {"bench":"<name>","param":"<param>","iterations":<n>,
+ *    "ns_per_op":<float>,"allocs_per_op":<float>}
+ *
+ * 'allocs_per_op' counts the calls of malloc(), calloc() and realloc(), also
+ * those done by libamxc.
+ *
+ * Usage: bench [filter]
+ * If 'filter' is given, the program only runs the benchmarks whose name
+ * contains 'filter'.
+ *
+ * The program exits with 1 if a benchmark with a time limit per op exceeds
+ * it.
+ */
+
+#define _GNU_SOURCE /* fmemopen() */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <amxc/amxc_string.h>
+#include <amxc/amxc_variant.h>
+
+#include "alloc_count.h"
+#include "dm_info.h"
+#include "object_utils.h"
+#include "set_of_indexes.h"
+#include "ubus_prpl.h"
+
+/* Run a benchmark at least this long to get a stable result */
+#define MIN_DURATION_NS 200000000ULL
+
+#define MAX_ITERATIONS (1ULL << 30)
+
+typedef void (* bench_fn_t)(void* ctx);
+
+static const char* s_filter = NULL;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Run @a fn repeatedly and print the result.
+ *
+ * The function doubles the nr of iterations until one round takes at least
+ * MIN_DURATION_NS. It reports the figures of the last round.
+ *
+ * @return the time per op in ns, or 0 if the filter skipped the benchmark
+ */
+static double run(const char* const name, const char* const param,
+                  bench_fn_t fn, void* ctx) {
+
+    if(s_filter && (strstr(name, s_filter) == NULL)) {
+        return 0;
+    }
+
+    fn(ctx); /* warm up */
+
+    uint64_t n = 1;
+    uint64_t elapsed_ns = 0;
+    uint64_t allocs = 0;
+    while(true) {
+        const uint64_t allocs_start = alloc_count_get();
+        const uint64_t start = now_ns();
+        uint64_t i;
+        for(i = 0; i < n; ++i) {
+            fn(ctx);
+        }
+        elapsed_ns = now_ns() - start;
+        allocs = alloc_count_get() - allocs_start;
+        if((elapsed_ns >= MIN_DURATION_NS) || (n >= MAX_ITERATIONS)) {
+            break;
+        }
+        n *= 2;
+    }
+
+    printf("{\"bench\":\"%s\",\"param\":\"%s\",\"iterations\":%llu,"
+           "\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f}\n",
+           name, param, (unsigned long long) n,
+           (double) elapsed_ns / (double) n, (double) allocs / (double) n);
+    fflush(stdout);
+    return (double) elapsed_ns / (double) n;
+}
+
+/* dm_get_object_id() */
+
+static void bench_get_object_id(void* ctx) {
+    const char* const path = (const char*) ctx;
+    if(dm_get_object_id(path) == obj_id_unknown) {
+        fprintf(stderr, "dm_get_object_id(%s) failed\n", path);
+        exit(1);
+    }
+}
+
+/* dm_convert_bbf_path_to_prpl_path() and dm_convert_prpl_path_to_bbf_path() */
+
+static void bench_bbf_to_prpl(void* ctx) {
+    amxc_string_t out;
+    amxc_string_init(&out, 0);
+    if(!dm_convert_bbf_path_to_prpl_path((const char*) ctx, &out)) {
+        fprintf(stderr, "bbf to prpl conversion of '%s' failed\n", (const char*) ctx);
+        exit(1);
+    }
+    amxc_string_clean(&out);
+}
+
+static void bench_prpl_to_bbf(void* ctx) {
+    amxc_string_t out;
+    amxc_string_init(&out, 0);
+    if(!dm_convert_prpl_path_to_bbf_path((const char*) ctx, &out)) {
+        fprintf(stderr, "prpl to bbf conversion of '%s' failed\n", (const char*) ctx);
+        exit(1);
+    }
+    amxc_string_clean(&out);
+}
+
+/* dm_convert_param_names() */
+
+static void bench_convert_param_names(void* ctx) {
+    amxc_string_t out;
+    amxc_string_init(&out, 0);
+    if(!dm_convert_param_names(obj_id_transceiver, (const char*) ctx, &out)) {
+        fprintf(stderr, "dm_convert_param_names(%s) failed\n", (const char*) ctx);
+        exit(1);
+    }
+    amxc_string_clean(&out);
+}
+
+/* obj_process_object_params() */
+
+typedef struct _process_params_ctx {
+    object_id_t id;
+    const char* path;
+    amxc_var_t params; /* list with one htable, as returned by the ONU HAL agent */
+} process_params_ctx_t;
+
+/**
+ * Fill @a ctx with a value for each param of the object @a id, and with a
+ * value for its key.
+ */
+static void process_params_ctx_init(process_params_ctx_t* const ctx,
+                                    object_id_t id, const char* const path) {
+    const object_info_t* const info = dm_get_object_info(id);
+    const param_info_t* param_info = NULL;
+    uint32_t n_params = 0;
+    uint32_t i;
+
+    ctx->id = id;
+    ctx->path = path;
+    amxc_var_init(&ctx->params);
+    amxc_var_set_type(&ctx->params, AMXC_VAR_ID_LIST);
+    amxc_var_t* const table = amxc_var_add(amxc_htable_t, &ctx->params, NULL);
+
+    if((NULL == info) || !dm_get_object_param_info(id, &param_info, &n_params)) {
+        fprintf(stderr, "No info about object with ID=%d\n", id);
+        exit(1);
+    }
+    if(info->prpl_key_name) {
+        amxc_var_add_key(uint32_t, table, info->prpl_key_name, 1);
+    }
+    for(i = 0; i < n_params; ++i) {
+        switch(param_info[i].type) {
+        case AMXC_VAR_ID_BOOL:
+            amxc_var_add_key(bool, table, param_info[i].prpl_name, true);
+            break;
+        case AMXC_VAR_ID_UINT32:
+            amxc_var_add_key(uint32_t, table, param_info[i].prpl_name, 42);
+            break;
+        case AMXC_VAR_ID_INT32:
+            amxc_var_add_key(int32_t, table, param_info[i].prpl_name, -42);
+            break;
+        default:
+            amxc_var_add_key(cstring_t, table, param_info[i].prpl_name, "value");
+            break;
+        }
+    }
+}
+
+static void bench_process_object_params(void* ctx) {
+    process_params_ctx_t* const pctx = (process_params_ctx_t*) ctx;
+    amxc_var_t ret;
+    amxc_var_init(&ret);
+    if(!obj_process_object_params(pctx->id, &pctx->params, /*extract_key=*/ true,
+                                  &ret, pctx->path)) {
+        fprintf(stderr, "obj_process_object_params(%s) failed\n", pctx->path);
+        exit(1);
+    }
+    amxc_var_clean(&ret);
+}
+
+/* set_of_indexes */
+
+/*
+ * The set is a list: a lookup scans it. Fail if a lookup takes longer than
+ * this per index in the set, i.e., if it got worse than linear.
+ */
+#define SET_LOOKUP_MAX_NS_PER_INDEX 20.0
+
+typedef struct _set_ctx {
+    set_of_indexes_t set;
+    uint32_t size;
+    uint32_t next;
+} set_ctx_t;
+
+/**
+ * Fill the set with @a size unique indexes in descending order, as
+ * ubus_prpl_parse_indexes() does. The benchmark does not time this.
+ */
+static void set_ctx_init(set_ctx_t* const ctx, uint32_t size) {
+    uint32_t i;
+
+    set_of_indexes_init(&ctx->set);
+    for(i = size; i > 0; --i) {
+        set_of_indexes_add_index(&ctx->set, i);
+    }
+    ctx->size = size;
+    ctx->next = 0;
+}
+
+/**
+ * Add an index which is in the set already: one lookup. The indexes cycle
+ * through the set, so the average lookup scans half of it.
+ */
+static void bench_set_of_indexes(void* ctx) {
+    set_ctx_t* const sctx = (set_ctx_t*) ctx;
+
+    set_of_indexes_add_index(&sctx->set, sctx->next + 1);
+    sctx->next = (sctx->next + 1) % sctx->size;
+}
+
+/* ubus_prpl_parse_indexes() */
+
+typedef struct _parse_ctx {
+    FILE* file;
+    char* buf;
+} parse_ctx_t;
+
+/**
+ * Generate synthetic output of 'ubus list xpon_onu.1.software_image*'.
+ *
+ * Per instance the output has the line of the instance itself and lines of
+ * some subobjects. The parser must skip the latter.
+ */
+static void parse_ctx_init(parse_ctx_t* const ctx, uint32_t n_lines) {
+    static const char* const subobjects[] = { "", ".foo", ".bar", ".foo.1" };
+    const uint32_t n_subobjects = sizeof(subobjects) / sizeof(subobjects[0]);
+    amxc_string_t out;
+    uint32_t i;
+
+    amxc_string_init(&out, 0);
+    amxc_string_appendf(&out, "xpon_onu.1.software_image\n");
+    for(i = 1; i < n_lines; ++i) {
+        const uint32_t index = (i - 1) / n_subobjects + 1;
+        amxc_string_appendf(&out, "xpon_onu.1.software_image.%u%s\n", index,
+                            subobjects[(i - 1) % n_subobjects]);
+    }
+    ctx->buf = amxc_string_take_buffer(&out);
+    ctx->file = fmemopen(ctx->buf, strlen(ctx->buf), "r");
+    if(NULL == ctx->file) {
+        fprintf(stderr, "fmemopen() failed\n");
+        exit(1);
+    }
+    amxc_string_clean(&out);
+}
+
+static void parse_ctx_clean(parse_ctx_t* const ctx) {
+    fclose(ctx->file);
+    free(ctx->buf);
+}
+
+static void bench_parse_indexes(void* ctx) {
+    parse_ctx_t* const pctx = (parse_ctx_t*) ctx;
+    amxc_string_t indexes;
+    amxc_string_init(&indexes, 0);
+    rewind(pctx->file);
+    if(!ubus_prpl_parse_indexes(pctx->file, "xpon_onu.1.software_image", &indexes)) {
+        fprintf(stderr, "ubus_prpl_parse_indexes() failed\n");
+        exit(1);
+    }
+    amxc_string_clean(&indexes);
+}
+
+int main(int argc, char* argv[]) {
+    static const char* const object_paths[] = {
+        "XPON.ONU.1",
+        "XPON.ONU.1.ANI.1.TC.GEM.Port.3",
+        "xpon_onu.1.ani.1.tc.alarms",
+    };
+    static const char* const bbf_paths[] = {
+        "XPON.ONU.1.SoftwareImage.2",
+        "XPON.ONU.1.ANI.1.TC.GEM.Port.3",
+    };
+    static const char* const prpl_paths[] = {
+        "xpon_onu.1.software_image.2",
+        "xpon_onu.1.ani.1.tc.gem.port.3",
+    };
+    static const uint32_t set_sizes[] = { 10, 100, 1000, 10000 };
+    static const uint32_t n_lines[] = { 100, 1000, 10000, 100000 };
+    char param[32];
+    size_t i;
+    int rc = 0;
+
+    if(argc > 1) {
+        s_filter = argv[1];
+    }
+
+    if(!dm_info_init()) {
+        fprintf(stderr, "dm_info_init() failed\n");
+        return 1;
+    }
+
+    for(i = 0; i < sizeof(object_paths) / sizeof(object_paths[0]); ++i) {
+        run("dm_get_object_id", object_paths[i], bench_get_object_id,
+            (void*) object_paths[i]);
+    }
+    for(i = 0; i < sizeof(bbf_paths) / sizeof(bbf_paths[0]); ++i) {
+        run("dm_convert_bbf_path_to_prpl_path", bbf_paths[i], bench_bbf_to_prpl,
+            (void*) bbf_paths[i]);
+    }
+    for(i = 0; i < sizeof(prpl_paths) / sizeof(prpl_paths[0]); ++i) {
+        run("dm_convert_prpl_path_to_bbf_path", prpl_paths[i], bench_prpl_to_bbf,
+            (void*) prpl_paths[i]);
+    }
+    run("dm_convert_param_names", "RxPower", bench_convert_param_names,
+        (void*) "RxPower");
+
+    process_params_ctx_t transceiver;
+    process_params_ctx_init(&transceiver, obj_id_transceiver,
+                            "xpon_onu.1.ani.1.transceiver.1");
+    run("obj_process_object_params", "transceiver", bench_process_object_params,
+        &transceiver);
+    amxc_var_clean(&transceiver.params);
+
+    process_params_ctx_t gem_port;
+    process_params_ctx_init(&gem_port, obj_id_gem_port,
+                            "xpon_onu.1.ani.1.tc.gem.port.1");
+    run("obj_process_object_params", "gem_port", bench_process_object_params,
+        &gem_port);
+    amxc_var_clean(&gem_port.params);
+
+    for(i = 0; i < sizeof(set_sizes) / sizeof(set_sizes[0]); ++i) {
+        set_ctx_t ctx;
+        set_ctx_init(&ctx, set_sizes[i]);
+        snprintf(param, sizeof(param), "%u", set_sizes[i]);
+        const double ns_per_op = run("set_of_indexes", param, bench_set_of_indexes, &ctx);
+        if(ns_per_op > SET_LOOKUP_MAX_NS_PER_INDEX * set_sizes[i]) {
+            fprintf(stderr, "set_of_indexes: %.1f ns per lookup in a set of %u: "
+                    "more than %.1f ns per index\n", ns_per_op, set_sizes[i],
+                    SET_LOOKUP_MAX_NS_PER_INDEX);
+            rc = 1;
+        }
+        set_of_indexes_clean(&ctx.set);
+    }
+
+    for(i = 0; i < sizeof(n_lines) / sizeof(n_lines[0]); ++i) {
+        parse_ctx_t ctx;
+        parse_ctx_init(&ctx, n_lines[i]);
+        snprintf(param, sizeof(param), "%u", n_lines[i]);
+        run("ubus_prpl_parse_indexes", param, bench_parse_indexes, &ctx);
+        parse_ctx_clean(&ctx);
+    }
+
+    return rc;
+}
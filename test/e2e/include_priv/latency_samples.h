@@ -0,0 +1,34 @@
+#ifndef __latency_samples_h__
+#define __latency_samples_h__
+
+/**
+ * @file latency_samples.h
+ *
+ * Store latency samples to report the throughput and the percentiles of a
+ * series of operations.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct _latency_samples {
+    uint64_t* values_us;
+    uint32_t n;
+    uint32_t capacity;
+    uint32_t errors;
+} latency_samples_t;
+
+bool latency_samples_init(latency_samples_t* const samples, uint32_t capacity);
+void latency_samples_clean(latency_samples_t* const samples);
+
+void latency_samples_add(latency_samples_t* const samples, uint64_t value_us);
+void latency_samples_add_error(latency_samples_t* const samples);
+
+void latency_samples_print(latency_samples_t* const samples,
+                           const char* const kind,
+                           const char* const name,
+                           uint64_t elapsed_us);
+
+uint64_t now_us(void);
+
+#endif
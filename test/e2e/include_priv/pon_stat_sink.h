@@ -0,0 +1,24 @@
+#ifndef __pon_stat_sink_h__
+#define __pon_stat_sink_h__
+
+/**
+ * @file pon_stat_sink.h
+ *
+ * Recording replacement for the 'pon_stat' namespace of the tr181-xpon plugin.
+ *
+ * mod-xpon-prpl forwards the notifications of an ONU HAL agent by calling
+ * functions of the 'pon_stat' namespace in the shared object 'self', i.e., in
+ * the process which loaded the module. The sink registers that namespace. It
+ * timestamps every call and otherwise ignores its arguments.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool pon_stat_sink_init(bool with_batch);
+void pon_stat_sink_cleanup(void);
+
+uint64_t pon_stat_sink_get_n_calls(void);
+uint64_t pon_stat_sink_get_last_call_us(void);
+
+#endif
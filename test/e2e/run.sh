@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Run the end-to-end performance harness.
+#
+# Start a ubusd (if none is running) and an onu_hal_mock, run e2e_harness
+# against them, and stop what this script started. Extra arguments are passed
+# to e2e_harness, e.g., './run.sh -n 5000 -N 500'.
+#
+# Build the module and the mock first, e.g., with 'make' from the top-level
+# directory. The script does not need PON hardware.
+#
+# MOCK_ARGS are passed to onu_hal_mock, e.g., MOCK_ARGS="-l immediate" to
+# measure the module without the default 100 ms response latency of the mock.
+#
+# If ALLOC_PROF_LIB is set, the script preloads that library in the harness
+# only, e.g., the allocation profiler in ../alloc_prof.
+#
+# After the run, the script prints the total of the HAL calls the mock counted
+# (see 'dbgtool stats'). If CALL_BUDGET is set, the script fails if the module
+# made more HAL calls than that.
+
+set -u
+
+TOP=$(cd "$(dirname "$0")/../.." && pwd)
+MACHINE=${MACHINE:-$(${CC:-cc} -dumpmachine)}
+
+MOD_SO=${MOD_SO:-$TOP/output/$MACHINE/mod-xpon-prpl/mod-xpon-prpl.so}
+MOCK=${MOCK:-$TOP/test/onu_hal_mock/onu_hal_mock/src/onu_hal_mock}
+HARNESS=${HARNESS:-$TOP/test/e2e/src/e2e_harness}
+DBGTOOL=${DBGTOOL:-$TOP/test/onu_hal_mock/dbgtool/src/dbgtool}
+UBUS_SOCK=${UBUS_SOCK:-/var/run/ubus.sock}
+
+UBUSD_PID=""
+MOCK_PID=""
+
+cleanup() {
+    [ -n "$MOCK_PID" ] && kill "$MOCK_PID" 2>/dev/null
+    [ -n "$UBUSD_PID" ] && kill "$UBUSD_PID" 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+for f in "$MOD_SO" "$MOCK" "$HARNESS"; do
+    if [ ! -e "$f" ]; then
+        echo "Error: $f not found" >&2
+        exit 1
+    fi
+done
+
+if [ ! -S "$UBUS_SOCK" ] && [ ! -S /var/run/ubus/ubus.sock ]; then
+    ubusd -s "$UBUS_SOCK" &
+    UBUSD_PID=$!
+    sleep 0.2
+fi
+
+# shellcheck disable=SC2086
+"$MOCK" ${MOCK_ARGS:-} 1 &
+MOCK_PID=$!
+
+# Wait until the mock published xpon_onu.1
+i=0
+until ubus -s "$UBUS_SOCK" list xpon_onu.1 >/dev/null 2>&1; do
+    i=$((i + 1))
+    if [ "$i" -gt 50 ]; then
+        echo "Error: onu_hal_mock did not publish xpon_onu.1" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+if [ -n "${ALLOC_PROF_LIB:-}" ]; then
+    LD_PRELOAD="$ALLOC_PROF_LIB" "$HARNESS" -u "ubus:$UBUS_SOCK" -m "$MOD_SO" "$@"
+else
+    "$HARNESS" -u "ubus:$UBUS_SOCK" -m "$MOD_SO" "$@"
+fi
+RC=$?
+
+if [ -x "$DBGTOOL" ]; then
+    TOTAL=$("$DBGTOOL" stats | tail -n 1)
+    echo "$TOTAL"
+    if [ -n "${CALL_BUDGET:-}" ]; then
+        CALLS=$(echo "$TOTAL" | sed -n 's/.*"calls":\([0-9]*\).*/\1/p')
+        if [ -z "$CALLS" ] || [ "$CALLS" -gt "$CALL_BUDGET" ]; then
+            echo "Error: ${CALLS:-?} HAL calls, budget is $CALL_BUDGET" >&2
+            RC=1
+        fi
+    fi
+fi
+
+exit $RC
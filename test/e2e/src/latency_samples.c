@@ -0,0 +1,87 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L /* clock_gettime() */
+#endif
+
+#include "latency_samples.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+bool latency_samples_init(latency_samples_t* const samples, uint32_t capacity) {
+    samples->values_us = (uint64_t*) calloc(capacity, sizeof(uint64_t));
+    samples->n = 0;
+    samples->capacity = samples->values_us ? capacity : 0;
+    samples->errors = 0;
+    return (samples->values_us != NULL);
+}
+
+void latency_samples_clean(latency_samples_t* const samples) {
+    free(samples->values_us);
+    samples->values_us = NULL;
+    samples->n = 0;
+    samples->capacity = 0;
+}
+
+void latency_samples_add(latency_samples_t* const samples, uint64_t value_us) {
+    if(samples->n < samples->capacity) {
+        samples->values_us[samples->n++] = value_us;
+    }
+}
+
+void latency_samples_add_error(latency_samples_t* const samples) {
+    samples->errors++;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    const uint64_t x = *(const uint64_t*) a;
+    const uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile. Sort the samples before calling this function. */
+static uint64_t percentile(const latency_samples_t* const samples, uint32_t p) {
+    if(samples->n == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t) (((uint64_t) p * samples->n + 99) / 100);
+    if(rank == 0) {
+        rank = 1;
+    }
+    return samples->values_us[rank - 1];
+}
+
+/**
+ * Print the result as one JSON object on stdout.
+ *
+ * @param[in] samples     samples to report. The function sorts them.
+ * @param[in] kind        "pon_ctrl" or "notification"
+ * @param[in] name        name of the pon_ctrl function or notification
+ * @param[in] elapsed_us  wall-clock duration of the series of operations. The
+ *                        function uses it to calculate the throughput.
+ */
+void latency_samples_print(latency_samples_t* const samples,
+                           const char* const kind,
+                           const char* const name,
+                           uint64_t elapsed_us) {
+
+    qsort(samples->values_us, samples->n, sizeof(uint64_t), compare_u64);
+
+    const double throughput = elapsed_us ?
+        (double) samples->n * 1000000.0 / (double) elapsed_us : 0.0;
+
+    printf("{\"kind\":\"%s\",\"name\":\"%s\",\"n\":%u,\"errors\":%u,"
+           "\"throughput_per_s\":%.1f,\"p50_us\":%llu,\"p99_us\":%llu,"
+           "\"max_us\":%llu}\n",
+           kind, name, samples->n, samples->errors, throughput,
+           (unsigned long long) percentile(samples, 50),
+           (unsigned long long) percentile(samples, 99),
+           (unsigned long long) (samples->n ? samples->values_us[samples->n - 1] : 0));
+    fflush(stdout);
+}
+
+uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000ULL + (uint64_t) ts.tv_nsec / 1000ULL;
+}
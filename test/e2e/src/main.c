@@ -0,0 +1,420 @@
+/**
+ * End-to-end performance harness for mod-xpon-prpl.
+ *
+ * The harness does what the tr181-xpon plugin does: it connects to ubus,
+ * registers a 'pon_stat' namespace and loads mod-xpon-prpl.so through amxm.
+ * Then it drives the 'pon_ctrl' functions of the module against an
+ * onu_hal_mock, and it triggers notifications in the mock via its debug
+ * socket.
+ *
+ * With '-L', the harness selects the loopback backend of the module instead:
+ * the module serves a synthetic xpon_onu DM from memory, and the harness
+ * injects the notifications via the pon_ctrl function inject_notification().
+ * There is no bus and no mock, so the numbers show the CPU cost of the module
+ * itself.
+ *
+ * It prints one JSON object per line on stdout:
+ * - per pon_ctrl function: the throughput, and the p50 and p99 of the latency
+ *   of a call
+ * - per notification: the throughput, and the p50 and p99 of the time between
+ *   sending the debug command to the mock (or injecting the notification) and
+ *   the call of the pon_stat function
+ *
+ * See run.sh to start ubusd and onu_hal_mock, and then this program.
+ */
+
+#define _DEFAULT_SOURCE /* getopt(), struct sockaddr_un */
+
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <amxc/amxc.h>
+#include <amxp/amxp.h>
+#include <amxm/amxm.h>
+#include <amxb/amxb.h>
+
+#include "dbg_commands.h"    /* CHANGE_TRANSCEIVER */
+#include "latency_samples.h"
+#include "pon_stat_sink.h"
+
+#define MOD_NAME "mod-xpon-prpl"
+#define MOD_PON_CTRL "pon_ctrl"
+
+#define DEFAULT_BACKEND "/usr/bin/mods/amxb/mod-amxb-ubus.so"
+#define DEFAULT_URI "ubus:/var/run/ubus.sock"
+#define DEFAULT_MOD_PATH "/usr/lib/amx/tr181-xpon/modules/mod-xpon-prpl.so"
+#define DEBUG_SERVER "/var/run/onu_hal_dbg.sock"
+
+/* Give up on a notification if pon_stat is not called within this time */
+#define DELIVERY_TIMEOUT_US 2000000ULL
+
+typedef struct _options {
+    const char* backend;
+    const char* uri;
+    const char* mod_path;
+    uint32_t n_calls;
+    uint32_t n_notifs;
+    bool batch;
+    bool loopback;
+    bool mirror;
+} options_t;
+
+/**
+ * How to let a notification happen.
+ *
+ * - command: debug command of the mock. Also the label in the output.
+ * - path: prpl path of the object changed, for the loopback backend
+ * - fd, servaddr: debug socket of the mock. 'fd' is -1 for the loopback
+ *   backend.
+ */
+typedef struct _notif_trigger {
+    const char* command;
+    const char* path;
+    int fd;
+    const struct sockaddr_un* servaddr;
+} notif_trigger_t;
+
+static amxb_bus_ctx_t* s_bus_ctx = NULL;
+
+/* amxp timers arm an interval timer: SIGALRM must only interrupt poll() */
+static void sigalrm_handler(int sig) {
+    (void) sig;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [options]\n", prog);
+    printf("  -b <path>  amxb backend (default: %s)\n", DEFAULT_BACKEND);
+    printf("  -u <uri>   bus URI (default: %s)\n", DEFAULT_URI);
+    printf("  -m <path>  path to %s.so (default: %s)\n", MOD_NAME, DEFAULT_MOD_PATH);
+    printf("  -n <nr>    nr of calls per pon_ctrl function (default: 1000)\n");
+    printf("  -N <nr>    nr of notifications per type (default: 200)\n");
+    printf("  -B         let the module deliver notifications in batches\n");
+    printf("  -L         use the loopback backend of the module: no bus, no mock\n");
+    printf("  -S         let the module serve reads from its shadow mirror\n");
+    printf("  -h         show this help and exit\n");
+}
+
+/**
+ * Run the event loop until pon_stat got called more than @a n_calls times, or
+ * until @a deadline_us.
+ *
+ * @return true if pon_stat got called in time
+ */
+static bool wait_for_pon_stat(uint64_t n_calls, uint64_t deadline_us) {
+
+    struct pollfd fds[2];
+    fds[0].fd = s_bus_ctx ? amxb_get_fd(s_bus_ctx) : -1;
+    fds[0].events = POLLIN;
+    fds[1].fd = amxp_signal_fd();
+    fds[1].events = POLLIN;
+
+    while(pon_stat_sink_get_n_calls() <= n_calls) {
+        const uint64_t now = now_us();
+        if(now >= deadline_us) {
+            return false;
+        }
+        int timeout_ms = (int) ((deadline_us - now) / 1000) + 1;
+        const int timer_ms = amxp_timers_next_event_timeout();
+        if((timer_ms >= 0) && (timer_ms < timeout_ms)) {
+            timeout_ms = timer_ms;
+        }
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if(poll(fds, 2, timeout_ms) < 0) {
+            if(errno != EINTR) {
+                fprintf(stderr, "poll() failed: %s\n", strerror(errno));
+                return false;
+            }
+        }
+        if(fds[0].revents & POLLIN) {
+            amxb_read(s_bus_ctx);
+        }
+        if(fds[1].revents & POLLIN) {
+            amxp_signal_read();
+        }
+        amxp_timers_calculate();
+        amxp_timers_check();
+    }
+    return true;
+}
+
+static int call_pon_ctrl(const char* const func_name, amxc_var_t* args) {
+    amxc_var_t ret;
+    amxc_var_init(&ret);
+    const int rc = amxm_execute_function(MOD_NAME, MOD_PON_CTRL, func_name, args, &ret);
+    amxc_var_clean(&ret);
+    return rc;
+}
+
+/**
+ * Call the pon_ctrl function @a func_name @a n times with @a args.
+ */
+static void run_pon_ctrl(const char* const label, const char* const func_name,
+                         amxc_var_t* args, uint32_t n) {
+    latency_samples_t samples;
+    uint32_t i;
+
+    if(!latency_samples_init(&samples, n)) {
+        return;
+    }
+
+    call_pon_ctrl(func_name, args); /* warm up */
+
+    const uint64_t start_us = now_us();
+    for(i = 0; i < n; ++i) {
+        const uint64_t t0 = now_us();
+        if(call_pon_ctrl(func_name, args) == 0) {
+            latency_samples_add(&samples, now_us() - t0);
+        } else {
+            latency_samples_add_error(&samples);
+        }
+    }
+    latency_samples_print(&samples, "pon_ctrl", label, now_us() - start_us);
+    latency_samples_clean(&samples);
+}
+
+static void run_pon_ctrl_workload(uint32_t n) {
+    amxc_var_t args;
+    amxc_var_init(&args);
+
+    amxc_var_set(cstring_t, &args, "XPON.ONU");
+    run_pon_ctrl("get_list_of_instances(XPON.ONU)", "get_list_of_instances", &args, n);
+
+    amxc_var_set(cstring_t, &args, "XPON.ONU.1.SoftwareImage");
+    run_pon_ctrl("get_list_of_instances(SoftwareImage)", "get_list_of_instances",
+                 &args, n);
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", "XPON.ONU.1.ANI.1.Transceiver");
+    amxc_var_add_key(uint32_t, &args, "index", 1);
+    run_pon_ctrl("get_object_content(Transceiver)", "get_object_content", &args, n);
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", "XPON.ONU.1.ANI.1.TC.ONUActivation");
+    run_pon_ctrl("get_object_content(ONUActivation)", "get_object_content", &args, n);
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", "XPON.ONU.1.ANI.1.Transceiver.1");
+    amxc_var_add_key(cstring_t, &args, "names", "RxPower");
+    run_pon_ctrl("get_param_values(RxPower)", "get_param_values", &args, n);
+
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(cstring_t, &args, "path", "XPON.ONU.1");
+    amxc_var_add_key(bool, &args, "enable", true);
+    run_pon_ctrl("set_enable(XPON.ONU.1)", "set_enable", &args, n);
+
+    amxc_var_clean(&args);
+}
+
+static int open_dbg_socket(struct sockaddr_un* const servaddr) {
+    const int fd = socket(AF_LOCAL, SOCK_DGRAM, 0);
+    if(fd == -1) {
+        fprintf(stderr, "Failed to create socket: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(servaddr, 0, sizeof(*servaddr));
+    servaddr->sun_family = AF_LOCAL;
+    strncpy(servaddr->sun_path, DEBUG_SERVER, sizeof(servaddr->sun_path) - 1);
+    return fd;
+}
+
+static bool send_trigger(const notif_trigger_t* const trigger) {
+
+    if(trigger->fd != -1) {
+        if(sendto(trigger->fd, trigger->command, strlen(trigger->command), 0,
+                  (const struct sockaddr*) trigger->servaddr, sizeof(*trigger->servaddr)) == -1) {
+            fprintf(stderr, "sendto() failed: %s\n", strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    amxc_var_t args;
+    amxc_var_init(&args);
+    amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+    amxc_var_add_key(uint32_t, &args, "onu_index", 1);
+    amxc_var_add_key(cstring_t, &args, "notification", "dm:object-changed");
+    amxc_var_add_key(cstring_t, &args, "path", trigger->path);
+    const bool rv = (call_pon_ctrl("inject_notification", &args) == 0);
+    amxc_var_clean(&args);
+    return rv;
+}
+
+/**
+ * Let the notification of @a trigger happen @a n times, and measure how long
+ * it takes until the module calls pon_stat.
+ */
+static void run_notification(const notif_trigger_t* const trigger, uint32_t n) {
+    latency_samples_t samples;
+    uint32_t i;
+
+    if(!latency_samples_init(&samples, n)) {
+        return;
+    }
+
+    const uint64_t start_us = now_us();
+    for(i = 0; i < n; ++i) {
+        const uint64_t n_calls = pon_stat_sink_get_n_calls();
+        const uint64_t t0 = now_us();
+        if(!send_trigger(trigger)) {
+            latency_samples_add_error(&samples);
+            continue;
+        }
+        if(wait_for_pon_stat(n_calls, t0 + DELIVERY_TIMEOUT_US)) {
+            latency_samples_add(&samples, pon_stat_sink_get_last_call_us() - t0);
+        } else {
+            latency_samples_add_error(&samples);
+        }
+    }
+    latency_samples_print(&samples, "notification", trigger->command, now_us() - start_us);
+    latency_samples_clean(&samples);
+}
+
+static void run_notification_workload(uint32_t n, bool loopback) {
+    struct sockaddr_un servaddr;
+    int fd = -1;
+    notif_trigger_t transceiver = {
+        .command = CHANGE_TRANSCEIVER,
+        .path = "xpon_onu.1.ani.1.transceiver.1",
+        .fd = -1,
+        .servaddr = &servaddr
+    };
+    notif_trigger_t onu_activation = {
+        .command = CHANGE_ONU_ACTIVATION,
+        .path = "xpon_onu.1.ani.1.tc.onu_activation",
+        .fd = -1,
+        .servaddr = &servaddr
+    };
+
+    if(!loopback) {
+        fd = open_dbg_socket(&servaddr);
+        if(fd == -1) {
+            return;
+        }
+        transceiver.fd = fd;
+        onu_activation.fd = fd;
+    }
+    run_notification(&transceiver, n);
+    run_notification(&onu_activation, n);
+    if(fd != -1) {
+        close(fd);
+    }
+}
+
+static bool parse_options(int argc, char* argv[], options_t* const options) {
+    int c;
+
+    options->backend = DEFAULT_BACKEND;
+    options->uri = DEFAULT_URI;
+    options->mod_path = DEFAULT_MOD_PATH;
+    options->n_calls = 1000;
+    options->n_notifs = 200;
+    options->batch = false;
+    options->loopback = false;
+    options->mirror = false;
+
+    while((c = getopt(argc, argv, "b:u:m:n:N:BLSh")) != -1) {
+        switch(c) {
+        case 'b': options->backend = optarg; break;
+        case 'u': options->uri = optarg; break;
+        case 'm': options->mod_path = optarg; break;
+        case 'n': options->n_calls = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'N': options->n_notifs = (uint32_t) strtoul(optarg, NULL, 0); break;
+        case 'B': options->batch = true; break;
+        case 'L': options->loopback = true; break;
+        case 'S': options->mirror = true; break;
+        default:
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    int rc = 1;
+    options_t options;
+    amxm_shared_object_t* so = NULL;
+    amxc_var_t args;
+
+    amxc_var_init(&args);
+
+    if(!parse_options(argc, argv, &options)) {
+        return 1;
+    }
+    signal(SIGALRM, sigalrm_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    if(!options.loopback) {
+        if(amxb_be_load(options.backend) != 0) {
+            fprintf(stderr, "Failed to load backend %s\n", options.backend);
+            goto exit;
+        }
+        if(amxb_connect(&s_bus_ctx, options.uri) != 0) {
+            fprintf(stderr, "Failed to connect to %s\n", options.uri);
+            goto exit;
+        }
+    }
+    if(!pon_stat_sink_init(options.batch)) {
+        goto exit;
+    }
+    if(amxm_so_open(&so, MOD_NAME, options.mod_path) != 0) {
+        fprintf(stderr, "Failed to load %s\n", options.mod_path);
+        goto exit;
+    }
+
+    if(options.loopback) {
+        amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(cstring_t, &args, "name", "loopback");
+        if(call_pon_ctrl("set_southbound_backend", &args) != 0) {
+            fprintf(stderr, "Failed to select the loopback backend\n");
+            goto exit;
+        }
+    }
+
+    if(options.batch) {
+        amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(bool, &args, "enable", true);
+        call_pon_ctrl("set_pon_stat_batch_config", &args);
+    }
+
+    if(options.mirror) {
+        amxc_var_set_type(&args, AMXC_VAR_ID_HTABLE);
+        amxc_var_add_key(bool, &args, "enable", true);
+        call_pon_ctrl("set_shadow_mirror_config", &args);
+    }
+
+    /* Let the module find and subscribe to xpon_onu.1 */
+    amxc_var_set(cstring_t, &args, "XPON.ONU");
+    if(call_pon_ctrl("get_list_of_instances", &args) != 0) {
+        fprintf(stderr, "Module does not find any ONU: is onu_hal_mock running?\n");
+        goto exit;
+    }
+
+    run_pon_ctrl_workload(options.n_calls);
+    run_notification_workload(options.n_notifs, options.loopback);
+
+    rc = 0;
+
+exit:
+    amxc_var_clean(&args);
+    if(so) {
+        amxm_so_close(&so);
+    }
+    pon_stat_sink_cleanup();
+    if(s_bus_ctx) {
+        amxb_free(&s_bus_ctx);
+    }
+    amxb_be_remove_all();
+    return rc;
+}
@@ -0,0 +1,75 @@
+#include "pon_stat_sink.h"
+
+#include <stdio.h>
+
+#include <amxc/amxc.h>
+#include <amxm/amxm.h>
+
+#include "latency_samples.h" /* now_us() */
+
+#define MOD_PON_STAT "pon_stat"
+
+static amxm_module_t* s_module = NULL;
+static uint64_t s_n_calls = 0;
+static uint64_t s_last_call_us = 0;
+
+static int record_call(const char* function_name,
+                       amxc_var_t* args,
+                       amxc_var_t* ret) {
+    (void) function_name;
+    (void) args;
+    (void) ret;
+    s_last_call_us = now_us();
+    s_n_calls++;
+    return 0;
+}
+
+/* A batch counts as one call per entry: each entry is a delivery. */
+static int record_batch(const char* function_name,
+                        amxc_var_t* args,
+                        amxc_var_t* ret) {
+    (void) function_name;
+    (void) ret;
+    s_last_call_us = now_us();
+    const amxc_llist_t* const list = amxc_var_constcast(amxc_llist_t, args);
+    s_n_calls += list ? amxc_llist_size(list) : 0;
+    return 0;
+}
+
+/**
+ * Register the 'pon_stat' namespace.
+ *
+ * @param[in] with_batch  if true, also register 'dm_batch' so the module can
+ *                        deliver batched notifications
+ */
+bool pon_stat_sink_init(bool with_batch) {
+    static const char* const FUNCTIONS[] = {
+        "dm_instance_added", "dm_instance_removed", "dm_object_changed",
+        "omci_reset_mib"
+    };
+    size_t i;
+
+    if(amxm_module_register(&s_module, NULL, MOD_PON_STAT)) {
+        fprintf(stderr, "Failed to register %s\n", MOD_PON_STAT);
+        return false;
+    }
+    for(i = 0; i < sizeof(FUNCTIONS) / sizeof(FUNCTIONS[0]); ++i) {
+        amxm_module_add_function(s_module, FUNCTIONS[i], record_call);
+    }
+    if(with_batch) {
+        amxm_module_add_function(s_module, "dm_batch", record_batch);
+    }
+    return true;
+}
+
+void pon_stat_sink_cleanup(void) {
+    amxm_module_deregister(&s_module);
+}
+
+uint64_t pon_stat_sink_get_n_calls(void) {
+    return s_n_calls;
+}
+
+uint64_t pon_stat_sink_get_last_call_us(void) {
+    return s_last_call_us;
+}
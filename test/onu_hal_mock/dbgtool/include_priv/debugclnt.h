@@ -5,5 +5,6 @@
 #include <stdbool.h>
 
 bool dbg_handle_command(const char* server_path, const void* msg, size_t len);
+bool dbg_handle_query(const char* server_path, const void* msg, size_t len);
 
 #endif
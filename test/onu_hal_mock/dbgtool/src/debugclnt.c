@@ -12,15 +12,47 @@
 #include <stdio.h>  // snprintf(..)
 #include <stdlib.h> // mkstemp(..)
 #include <string.h> // strlen(..)
+#include <sys/time.h> // struct timeval
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h> // struct sockaddr_un
 #include <unistd.h> // unlink(..)
 
+#include "dbg_commands.h" // DBG_REPLY_END
 #include "onu_hal_trace.h"
 
+// Max time to wait for the next message of the reply to a query
+#define REPLY_TIMEOUT_S 5
+#define MAX_REPLY_SIZE 1024
 
-bool dbg_handle_command(const char* server_path, const void* msg, size_t len) {
+/**
+ * Print the messages the server sends to @a sockfd, one per line, until the
+ * message DBG_REPLY_END.
+ */
+static bool receive_reply(int sockfd) {
+    struct timeval tv = { .tv_sec = REPLY_TIMEOUT_S, .tv_usec = 0 };
+    char buf[MAX_REPLY_SIZE + 1];
+
+    if(setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) == -1) {
+        SAH_TRACE_ERROR("failed to set receive timeout: %s", strerror(errno));
+        return false;
+    }
+    for(;;) {
+        const ssize_t n = recv(sockfd, buf, MAX_REPLY_SIZE, 0);
+        if(n == -1) {
+            SAH_TRACE_ERROR("failed to receive reply: %s", strerror(errno));
+            return false;
+        }
+        buf[n] = '\0';
+        if(strcmp(buf, DBG_REPLY_END) == 0) {
+            break;
+        }
+        printf("%s\n", buf);
+    }
+    return true;
+}
+
+static bool send_command(const char* server_path, const void* msg, size_t len, bool query) {
     bool rv = false;
     int sockfd = 0;
     char client_name[128];
@@ -69,7 +101,7 @@ bool dbg_handle_command(const char* server_path, const void* msg, size_t len) {
         goto exit;
     }
 
-    rv = true;
+    rv = query ? receive_reply(sockfd) : true;
 
 exit:
     if(strlen(client_name)) {
@@ -81,3 +113,15 @@ exit:
 
     return rv;
 }
+
+bool dbg_handle_command(const char* server_path, const void* msg, size_t len) {
+    return send_command(server_path, msg, len, false);
+}
+
+/**
+ * Send a query to the server and print its reply on stdout, one message per
+ * line.
+ */
+bool dbg_handle_query(const char* server_path, const void* msg, size_t len) {
+    return send_command(server_path, msg, len, true);
+}
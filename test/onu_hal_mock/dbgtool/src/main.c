@@ -12,23 +12,79 @@ static const char* const SERVER = "/var/run/onu_hal_dbg.sock";
 static void usage(const char* name) {
     printf("Usage:\n");
     printf("%s -h\n", name);
-    printf("%s <command>\n", name);
+    printf("%s <command> [args]\n", name);
     printf("\n");
     printf("Options:\n");
     printf("  %-22s : show this help and exit\n", "-h");
     printf("\n");
     printf("Commands:\n");
-    printf("  %-22s : add transceiver.2 and send dm:instance-added notification\n", ADD_INSTANCE);
-    printf("  %-22s : remove transceiver.2 and send dm:instance-removed notification\n", REMOVE_INSTANCE);
+    printf("  %-22s : add extra transceiver and send dm:instance-added notification\n", ADD_INSTANCE);
+    printf("  %-22s : remove extra transceiver and send dm:instance-removed notification\n", REMOVE_INSTANCE);
     printf("  %-22s : change transceiver.1 and send dm:object-changed notification\n", CHANGE_TRANSCEIVER);
     printf("  %-22s : change onu_activation and send dm:object-changed notification\n", CHANGE_ONU_ACTIVATION);
     printf("  %-22s : send omci:reset_mib notification\n", OMCI_RESET_MIB);
+    printf("  %-22s : set the response latency for an object (subtree) and/or a\n", SET_LATENCY);
+    printf("  %-22s   method. Args: <object|all> <method|all> <distribution>\n", "");
+    printf("  %-22s   with <distribution> one of: immediate, fixed <ms>,\n", "");
+    printf("  %-22s   uniform <min_ms> <max_ms>, longtail <median_ms> <p99_ms>\n", "");
+    printf("  %-22s : remove all latency rules, back to 'fixed 100'\n", CLEAR_LATENCY);
+    printf("  %-22s : let the mock print the latency rules\n", SHOW_LATENCY);
+    printf("  %-22s : start a notification storm. Args: <kind> <rate> <count> [onus]\n", STORM);
+    printf("  %-22s   with <kind> one of: object_changed, instance_churn,\n", "");
+    printf("  %-22s   alarm_toggle, mixed. <rate> in events/s, 0 for a burst.\n", "");
+    printf("  %-22s   <count> 0 runs until %s. [onus]: nr of ONUs, default all\n", "", STOP_STORM);
+    printf("  %-22s : stop the running notification storm\n", STOP_STORM);
+    printf("  %-22s : inject a fault for an object (subtree) and/or a method.\n", SET_FAULT);
+    printf("  %-22s   Args: <object|all> <method|all> <fault> [arg] [percent]\n", "");
+    printf("  %-22s   with <fault> one of: no_reply, error <status>, late <ms>,\n", "");
+    printf("  %-22s   drop_notif (method: notification name), none (remove)\n", "");
+    printf("  %-22s : remove all fault rules\n", CLEAR_FAULT);
+    printf("  %-22s : let the mock print the fault rules\n", SHOW_FAULT);
+    printf("  %-22s : remove an object (subtree) from ubus. Args: <object|all>\n", DISAPPEAR);
+    printf("  %-22s : advertise an object (subtree) again. Args: <object|all>\n", REAPPEAR);
+    printf("  %-22s : simulate a HAL restart: remove all objects and drop\n", RESTART);
+    printf("  %-22s   pending replies, re-register after [down_ms] (2000)\n", "");
+    printf("  %-22s : print the nr of calls, errors, dropped replies, reply bytes\n", STATS);
+    printf("  %-22s   and handler time per object and method, one JSON object\n", "");
+    printf("  %-22s   per line, then the total. Args: [object|all] [method|all]\n", "");
+    printf("  %-22s : reset the call counters\n", RESET_STATS);
+    printf("  %-22s : replay a trace mod-xpon-prpl recorded: serve the recorded\n", REPLAY);
+    printf("  %-22s   replies and re-emit the notifications. Args: <file> [scale]\n", "");
+    printf("  %-22s   with [scale] the factor for the recorded times (default: 1,\n", "");
+    printf("  %-22s   0: as fast as possible)\n", "");
+    printf("  %-22s : stop the replay\n", STOP_REPLAY);
+    printf("\n");
+    printf("Examples:\n");
+    printf("  %s %s all all immediate\n", name, SET_LATENCY);
+    printf("  %s %s xpon_onu.1.ani.1 get longtail 5 200\n", name, SET_LATENCY);
+    printf("  %s %s instance_churn 1000 50000 4\n", name, STORM);
+    printf("  %s %s mixed 0 10000\n", name, STORM);
+    printf("  %s %s xpon_onu.1.ani.1 get error 9 10\n", name, SET_FAULT);
+    printf("  %s %s all dm:object-changed drop_notif 50\n", name, SET_FAULT);
+    printf("  %s %s 5000\n", name, RESTART);
+    printf("  %s %s xpon_onu.1 get_params\n", name, STATS);
+    printf("  %s %s /tmp/onu.trace 0.5\n", name, REPLAY);
 }
 
-static void handle_command(const char* cmd) {
-    char buf[32];
-    snprintf(buf, 32, "%s", cmd);
-    dbg_handle_command(SERVER, buf, strlen(buf));
+/*
+ * Send the command with its args, separated by spaces. For a query, print the
+ * reply.
+ */
+static bool handle_command(int argc, char* argv[], bool query) {
+    char buf[128];
+    size_t len = 0;
+    int i;
+
+    buf[0] = '\0';
+    for(i = 0; i < argc; ++i) {
+        const int n = snprintf(buf + len, sizeof(buf) - len, "%s%s", i ? " " : "", argv[i]);
+        if((n < 0) || ((size_t) n >= sizeof(buf) - len)) {
+            printf("Command too long\n");
+            return false;
+        }
+        len += (size_t) n;
+    }
+    return query ? dbg_handle_query(SERVER, buf, len) : dbg_handle_command(SERVER, buf, len);
 }
 
 int main(int argc, char* argv[]) {
@@ -48,8 +104,28 @@ int main(int argc, char* argv[]) {
        (strcmp(command, REMOVE_INSTANCE) == 0) ||
        (strcmp(command, CHANGE_TRANSCEIVER) == 0) ||
        (strcmp(command, CHANGE_ONU_ACTIVATION) == 0) ||
-       (strcmp(command, OMCI_RESET_MIB) == 0)) {
-        handle_command(command);
+       (strcmp(command, OMCI_RESET_MIB) == 0) ||
+       (strcmp(command, SET_LATENCY) == 0) ||
+       (strcmp(command, CLEAR_LATENCY) == 0) ||
+       (strcmp(command, SHOW_LATENCY) == 0) ||
+       (strcmp(command, STORM) == 0) ||
+       (strcmp(command, STOP_STORM) == 0) ||
+       (strcmp(command, SET_FAULT) == 0) ||
+       (strcmp(command, CLEAR_FAULT) == 0) ||
+       (strcmp(command, SHOW_FAULT) == 0) ||
+       (strcmp(command, DISAPPEAR) == 0) ||
+       (strcmp(command, REAPPEAR) == 0) ||
+       (strcmp(command, RESTART) == 0) ||
+       (strcmp(command, RESET_STATS) == 0) ||
+       (strcmp(command, REPLAY) == 0) ||
+       (strcmp(command, STOP_REPLAY) == 0)) {
+        if(!handle_command(argc - 1, argv + 1, false)) {
+            return -1;
+        }
+    } else if(strcmp(command, STATS) == 0) {
+        if(!handle_command(argc - 1, argv + 1, true)) {
+            return -1;
+        }
     } else {
         printf("%s: unknown command\n", command);
         return -1;
@@ -6,5 +6,23 @@
 #define CHANGE_TRANSCEIVER    "change_transceiver"
 #define CHANGE_ONU_ACTIVATION "change_onu_activation"
 #define OMCI_RESET_MIB        "omci_reset_mib"
+#define SET_LATENCY           "set_latency"
+#define CLEAR_LATENCY         "clear_latency"
+#define SHOW_LATENCY          "show_latency"
+#define STORM                 "storm"
+#define STOP_STORM            "stop_storm"
+#define SET_FAULT             "set_fault"
+#define CLEAR_FAULT           "clear_fault"
+#define SHOW_FAULT            "show_fault"
+#define DISAPPEAR             "disappear"
+#define REAPPEAR              "reappear"
+#define RESTART               "restart"
+#define STATS                 "stats"
+#define RESET_STATS           "reset_stats"
+#define REPLAY                "replay"
+#define STOP_REPLAY           "stop_replay"
+
+/* Last message of the reply to a query, e.g., STATS */
+#define DBG_REPLY_END         "END"
 
 #endif
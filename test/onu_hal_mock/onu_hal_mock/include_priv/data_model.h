@@ -1,18 +1,73 @@
 #ifndef __data_model_h__
 #define __data_model_h__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "libubus.h"
 
+#include "topology.h"
+
+typedef enum _obj_type {
+    type_xpon_onu = 0,
+    type_sw_img,
+    type_eth_uni,
+    type_ani,
+    type_onu_activation,
+    type_perf_thresholds,
+    type_alarms,
+    type_gem_port,
+    type_transceiver,
+    n_obj_types
+} obj_type_t;
+
+/**
+ * An object the mock advertises on ubus.
+ *
+ * - onu_nr: nr of the ONU the object belongs to
+ * - ani: index of the ANI the object belongs to, or 0
+ * - index: instance index of the object, or 0 for a singleton
+ * - enabled: value of the 'enable' param of an ONU or an ANI
+ * - revision: bumped by the debug commands to change a param value of the
+ *   object, e.g., the vendor revision of a transceiver
+ * - refs: nr of deferred requests for the object. The mock only frees a
+ *   removed object when it has no pending requests anymore.
+ * - hidden: the object is not on ubus because of an injected fault
+ *   (dm_set_hidden(), dm_restart())
+ */
 typedef struct _object_wrapper {
     struct ubus_object ubus_obj;
     char* name;
+    obj_type_t type;
+    uint32_t onu_nr;
+    uint32_t ani;
+    uint32_t index;
+    bool enabled;
+    uint32_t revision;
+    uint32_t refs;
+    bool removed;
+    bool hidden;
 } object_wrapper_t;
 
 
-int dm_init(struct ubus_context* ctx, int onu_nr);
+/* Nr of GEM ports per ONU the instance churn of a storm cycles over */
+#define DM_N_CHURN_GEM_PORTS 256
+
+int dm_init(struct ubus_context* ctx, const topology_t* const topology);
 object_wrapper_t* dm_get_xpon_onu_object(void);
-int dm_register_transceiver_two(void);
-void dm_unregister_transceiver_two(void);
+uint32_t dm_get_n_onus(void);
+object_wrapper_t* dm_get_onu_object(uint32_t i);
+object_wrapper_t* dm_get_ani_one_object(uint32_t i, obj_type_t type);
+void dm_change_object(object_wrapper_t* const obj);
+int dm_churn_gem_port(uint32_t i, bool* const added, uint32_t* const index);
+object_wrapper_t* dm_find_object(const char* const path);
+object_wrapper_t* dm_register_instance(const char* const path);
+void dm_unregister_instance(const char* const path);
+uint32_t dm_set_hidden(const char* const prefix, bool hidden);
+void dm_restart(uint32_t down_ms);
+uint32_t dm_get_extra_transceiver_index(void);
+int dm_register_extra_transceiver(void);
+void dm_unregister_extra_transceiver(void);
 void dm_change_transceiver_one_vendor_rev(void);
 void dm_change_onu_activation_onu_state(void);
 void dm_cleanup(void);
@@ -0,0 +1,50 @@
+#ifndef __fault_h__
+#define __fault_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Fault injection for requests and notifications.
+ *
+ * A rule assigns a fault to the requests for an object (or a subtree), for a
+ * method, or for both, in the same way as a latency rule (see latency.h). For
+ * fault_drop_notif, the method is the name of a notification, e.g.,
+ * "dm:object-changed". A rule applies to a request or notification with a
+ * probability of 'percent' %.
+ *
+ * Faults:
+ * - no_reply: never reply; the caller times out
+ * - error <status>: reply with ubus status <status> after the usual latency
+ * - late <ms>: reply after <ms> instead of the usual latency, e.g., after the
+ *   timeout of the caller
+ * - drop_notif: do not send the notification
+ *
+ * Faults which affect the lifecycle of objects ('disappear', 'reappear' and
+ * 'restart') are in data_model.h.
+ */
+
+typedef enum _fault_type {
+    fault_none = 0,
+    fault_no_reply,
+    fault_error,
+    fault_late,
+    fault_drop_notif
+} fault_type_t;
+
+typedef struct _fault {
+    fault_type_t type;
+    uint32_t arg;     /* error: ubus status, late: delay in ms */
+    uint32_t percent; /* probability the fault applies, 1 to 100 */
+} fault_t;
+
+bool fault_set_rule(const char* const object, const char* const method,
+                    const fault_t* const fault);
+bool fault_set_rule_from_string(const char* const args);
+void fault_clear_rules(void);
+void fault_print_rules(void);
+
+fault_t fault_get_for_request(const char* const object, const char* const method);
+bool fault_drop_notification(const char* const object, const char* const notification);
+
+#endif
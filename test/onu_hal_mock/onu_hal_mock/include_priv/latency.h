@@ -0,0 +1,45 @@
+#ifndef __latency_h__
+#define __latency_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Response latency of the mock.
+ *
+ * A rule assigns a latency distribution to the requests for an object (or a
+ * subtree), for a method, or for both. For a request, the most specific
+ * matching rule applies: object and method > object > method > default.
+ *
+ * Distributions (all values in ms):
+ * - immediate: reply from the method handler itself, without deferring
+ * - fixed <ms>
+ * - uniform <min_ms> <max_ms>
+ * - longtail <median_ms> <p99_ms>: lognormal distribution
+ *
+ * The default is 'fixed 100', the latency the mock always had.
+ */
+
+typedef enum _latency_type {
+    latency_immediate = 0,
+    latency_fixed,
+    latency_uniform,
+    latency_longtail
+} latency_type_t;
+
+typedef struct _latency_dist {
+    latency_type_t type;
+    double a; /* fixed: delay, uniform: min, longtail: median */
+    double b; /* uniform: max, longtail: p99 */
+} latency_dist_t;
+
+bool latency_parse_dist(const char* const spec, latency_dist_t* const dist);
+bool latency_set_rule(const char* const object, const char* const method,
+                      const latency_dist_t* const dist);
+bool latency_set_rule_from_string(const char* const args);
+void latency_clear_rules(void);
+void latency_print_rules(void);
+
+int latency_get_delay_ms(const char* const object, const char* const method);
+
+#endif
@@ -1,13 +1,24 @@
 #ifndef __notif_h__
 #define __notif_h__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "libubus.h"
 
+#include "data_model.h" /* object_wrapper_t */
+
 void notif_init(struct ubus_context* ctx);
-void notif_send_dm_instance_added_for_transceiver_two(void);
-void notif_send_dm_instance_removed_for_transceiver_two(void);
+void notif_send_dm_instance_added_for_extra_transceiver(void);
+void notif_send_dm_instance_removed_for_extra_transceiver(void);
 void notif_send_dm_object_changed_for_transceiver_one(void);
 void notif_send_dm_object_changed_for_onu_activation(void);
 void notif_send_omci_reset_mib(void);
+void notif_send_dm_object_changed(object_wrapper_t* const onu,
+                                  const object_wrapper_t* const obj);
+void notif_send_dm_instance(object_wrapper_t* const onu, bool added,
+                            const char* template_path, uint32_t index);
+void notif_send_msg(object_wrapper_t* const onu, const char* notification,
+                    const char* path, struct blob_attr* msg);
 
 #endif
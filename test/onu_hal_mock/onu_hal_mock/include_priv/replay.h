@@ -0,0 +1,42 @@
+#ifndef __replay_h__
+#define __replay_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "libubus.h"
+
+/**
+ * Replay of a trace file mod-xpon-prpl recorded (see traffic_recorder.h in
+ * mod-xpon-prpl).
+ *
+ * While replaying, the mock serves the recorded replies: for a request, it
+ * looks up the calls recorded for the same object, method and param names,
+ * and serves their replies in the recorded order, repeating the last one. It
+ * replies after the recorded duration of the call, times the scale. A
+ * request without recorded call gets the usual generated reply.
+ *
+ * The mock re-emits the recorded notifications at their recorded time since
+ * the start of the recording, times the scale. For dm:instance-added and
+ * dm:instance-removed, it adds or removes the instance first.
+ *
+ * A scale of 0 means: reply immediately and emit all notifications at once.
+ */
+
+typedef struct _replay_call replay_call_t;
+
+bool replay_start(const char* const file, double scale);
+bool replay_start_from_string(const char* const args);
+void replay_stop(void);
+bool replay_is_active(void);
+uint32_t replay_generation(void);
+
+const replay_call_t* replay_find_call(const char* const object, const char* const method,
+                                      const char* const names);
+int replay_call_status(const replay_call_t* const call);
+int replay_call_delay_ms(const replay_call_t* const call);
+void replay_fill_reply(const replay_call_t* const call, struct blob_buf* const buf);
+
+void replay_cleanup(void);
+
+#endif
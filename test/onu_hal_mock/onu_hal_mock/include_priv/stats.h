@@ -0,0 +1,39 @@
+#ifndef __stats_h__
+#define __stats_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Call accounting: the mock counts the requests per object and method.
+ *
+ * - calls: nr of requests
+ * - errors: nr of replies with an error status
+ * - dropped: nr of requests the mock never replied to (fault no_reply, a
+ *   restart, or a hidden object)
+ * - bytes: size of the replies, in bytes
+ * - handler_ns: time the mock spent in the method handler and building the
+ *   replies, in ns. It excludes the latency the mock adds on purpose.
+ *
+ * The counters are independent of the lifecycle of the objects: they survive
+ * the removal of an object.
+ */
+
+typedef struct _call_stats {
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t dropped;
+    uint64_t bytes;
+    uint64_t handler_ns;
+} call_stats_t;
+
+typedef void (* stats_emit_fn_t) (const char* line, void* priv);
+
+uint64_t stats_now_ns(void);
+call_stats_t* stats_get(const char* const object, const char* const method);
+void stats_reset(void);
+void stats_dump(const char* const object, const char* const method,
+                stats_emit_fn_t emit, void* priv);
+void stats_cleanup(void);
+
+#endif
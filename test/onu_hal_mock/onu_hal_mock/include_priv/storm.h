@@ -0,0 +1,36 @@
+#ifndef __storm_h__
+#define __storm_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Notification storms: streams of dm:object-changed, dm:instance-added and
+ * dm:instance-removed notifications at a given rate to stress the event path
+ * of the module.
+ *
+ * Kinds:
+ * - object_changed: alternately change transceiver 1 and onu_activation
+ * - instance_churn: add and remove GEM ports, cycling over
+ *   DM_N_CHURN_GEM_PORTS ports per ONU
+ * - alarm_toggle: toggle the los alarm
+ * - mixed: interleave the three kinds above
+ *
+ * The events go round-robin over the first 'n_onus' ONUs. A rate of 0 sends
+ * all 'count' events at once (burst). A count of 0 keeps the storm going
+ * until storm_stop().
+ */
+
+typedef enum _storm_kind {
+    storm_object_changed = 0,
+    storm_instance_churn,
+    storm_alarm_toggle,
+    storm_mixed
+} storm_kind_t;
+
+bool storm_start(storm_kind_t kind, uint32_t rate_per_s, uint32_t count,
+                 uint32_t n_onus);
+bool storm_start_from_string(const char* const args);
+void storm_stop(void);
+
+#endif
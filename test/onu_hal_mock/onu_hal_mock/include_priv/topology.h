@@ -0,0 +1,35 @@
+#ifndef __topology_h__
+#define __topology_h__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Shape of the object tree the mock advertises.
+ *
+ * The mock serves 'n_onus' ONUs, with consecutive ONU nrs starting at
+ * 'first_onu'. Each ONU has 'n_anis' ANIs, 'n_ethernet_unis' Ethernet UNIs and
+ * 'n_software_images' software images. Each ANI has 'n_gem_ports' GEM ports
+ * and 'n_transceivers' transceivers.
+ *
+ * The default topology is one ONU with the objects the mock always served:
+ * one ANI, one GEM port, one UNI, two software images and one transceiver.
+ */
+typedef struct _topology {
+    uint32_t first_onu;
+    uint32_t n_onus;
+    uint32_t n_anis;
+    uint32_t n_gem_ports;
+    uint32_t n_ethernet_unis;
+    uint32_t n_software_images;
+    uint32_t n_transceivers;
+} topology_t;
+
+void topology_init(topology_t* const topology);
+bool topology_load_file(topology_t* const topology, const char* const path);
+bool topology_set(topology_t* const topology, const char* const key, const char* const value);
+bool topology_is_valid(const topology_t* const topology);
+uint32_t topology_get_n_objects(const topology_t* const topology);
+void topology_print(const topology_t* const topology);
+
+#endif
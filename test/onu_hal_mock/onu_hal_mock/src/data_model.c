@@ -11,56 +11,18 @@
 #include <stdlib.h> /* calloc() */
 #include <string.h> /* strdup() */
 
+#include "fault.h"
+#include "latency.h"
 #include "onu_hal_macros.h"
 #include "onu_hal_trace.h"
-
-static const char XPON_ONU[] = "xpon_onu.x";
-static const char SW_IMG_1[] = "xpon_onu.x.software_image.1";
-static const char SW_IMG_2[] = "xpon_onu.x.software_image.2";
-static const char ETH_UNI_1[] = "xpon_onu.x.ethernet_uni.1";
-static const char ANI_1[] = "xpon_onu.x.ani.1";
-static const char ONU_ACTIVATION[] = "xpon_onu.x.ani.1.tc.onu_activation";
-static const char PERF_THRESHOLDS[] = "xpon_onu.x.ani.1.tc.performance_thresholds";
-static const char ALARMS[] = "xpon_onu.x.ani.1.tc.alarms";
-static const char GEM_PORT_1[] = "xpon_onu.x.ani.1.tc.gem.port.1";
-static const char TRANSCEIVER_1[] = "xpon_onu.x.ani.1.transceiver.1";
-static const char TRANSCEIVER_2[] = "xpon_onu.x.ani.1.transceiver.2";
-
-static const char XPON_ONU_ONE[] = "xpon_onu.1";
-static const char XPON_ONU_TWO[] = "xpon_onu.2";
+#include "replay.h"
+#include "stats.h"
 
 static const char METHOD_GET[] = "get";
 static const char METHOD_ENABLE[] = "enable";
 static const char METHOD_DISABLE[] = "disable";
 static const char METHOD_GET_PARAMS[] = "get_params";
 
-/* To test dm:object-changed notification */
-static uint32_t s_transceiver_1_vendor_rev = 1;
-static uint32_t s_onu_state = 2;
-
-
-typedef enum _obj_id {
-    id_xpon_onu       = 0,
-    id_sw_img_1,
-    id_sw_img_2,
-    id_eth_uni_1,
-    id_ani_1,
-    id_onu_activation,
-    id_perf_thresholds,
-    id_alarms,
-    id_gem_port_1,
-    id_transceiver_1,
-    id_transceiver_2,
-    n_objects
-} obj_id_t;
-
-typedef struct _object_info {
-    obj_id_t id;
-    const char* name;
-    const struct ubus_method* methods;
-    uint32_t n_methods;
-} object_info_t;
-
 enum {
     PARAM_NAME,
     MAX_PARAMS
@@ -74,7 +36,7 @@ static int32_t s_temperature = -274;
 
 static int common_method_handler(struct ubus_context* ctx, struct ubus_object* obj,
                                  struct ubus_request_data* req, const char* method,
-                                 UNUSED struct blob_attr* msg);
+                                 struct blob_attr* msg);
 
 static const struct ubus_method METHODS_GET_ONLY[] = {
     { .name = METHOD_GET, .handler = common_method_handler, .policy = NULL, .n_policy = 0 }
@@ -90,105 +52,108 @@ static const struct blobmsg_policy GET_PARAMS_POLICY[] = {
     { .name = "names", .type = BLOBMSG_TYPE_STRING }
 };
 
-static struct ubus_method METHODS_TRANSCEIVER[] = {
+/**
+ * Optional argument of each method: the trace ID of the request in
+ * mod-xpon-prpl. The mock logs it and echoes it in the reply.
+ */
+static const struct blobmsg_policy TRACE_ID_POLICY[] = {
+    { .name = "trace_id", .type = BLOBMSG_TYPE_INT32 }
+};
+
+static const struct ubus_method METHODS_TRANSCEIVER[] = {
     { .name = METHOD_GET, .handler = common_method_handler, .policy = NULL, .n_policy = 0 },
     { .name = METHOD_GET_PARAMS, .handler = common_method_handler, .policy = GET_PARAMS_POLICY, .n_policy = 1 }
 };
 
-static const object_info_t OBJECT_INFO[n_objects] = {
-    {
-        .id = id_xpon_onu,
-        .name = XPON_ONU,
-        .methods = METHODS_GET_ENABLE_AND_DISABLE,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ENABLE_AND_DISABLE)
-    },
-    {
-        .id = id_sw_img_1,
-        .name = SW_IMG_1,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_sw_img_2,
-        .name = SW_IMG_2,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_eth_uni_1,
-        .name = ETH_UNI_1,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_ani_1,
-        .name = ANI_1,
-        .methods = METHODS_GET_ENABLE_AND_DISABLE,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ENABLE_AND_DISABLE)
-    },
-    {
-        .id = id_onu_activation,
-        .name = ONU_ACTIVATION,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_perf_thresholds,
-        .name = PERF_THRESHOLDS,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_alarms,
-        .name = ALARMS,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_gem_port_1,
-        .name = GEM_PORT_1,
-        .methods = METHODS_GET_ONLY,
-        .n_methods = ARRAY_SIZE(METHODS_GET_ONLY)
-    },
-    {
-        .id = id_transceiver_1,
-        .name = TRANSCEIVER_1,
-        .methods = METHODS_TRANSCEIVER,
-        .n_methods = ARRAY_SIZE(METHODS_TRANSCEIVER)
-    },
-    {
-        .id = id_transceiver_2,
-        .name = TRANSCEIVER_2,
-        .methods = METHODS_TRANSCEIVER,
-        .n_methods = ARRAY_SIZE(METHODS_TRANSCEIVER)
-    }
+typedef struct _type_info {
+    const char* name;
+    const struct ubus_method* methods;
+    uint32_t n_methods;
+} type_info_t;
+
+static const type_info_t TYPE_INFO[n_obj_types] = {
+    [type_xpon_onu] = { "xpon_onu", METHODS_GET_ENABLE_AND_DISABLE, ARRAY_SIZE(METHODS_GET_ENABLE_AND_DISABLE) },
+    [type_sw_img] = { "xpon_onu.software_image", METHODS_GET_ONLY, ARRAY_SIZE(METHODS_GET_ONLY) },
+    [type_eth_uni] = { "xpon_onu.ethernet_uni", METHODS_GET_ONLY, ARRAY_SIZE(METHODS_GET_ONLY) },
+    [type_ani] = { "xpon_onu.ani", METHODS_GET_ENABLE_AND_DISABLE, ARRAY_SIZE(METHODS_GET_ENABLE_AND_DISABLE) },
+    [type_onu_activation] = { "xpon_onu.ani.tc.onu_activation", METHODS_GET_ONLY, ARRAY_SIZE(METHODS_GET_ONLY) },
+    [type_perf_thresholds] = { "xpon_onu.ani.tc.performance_thresholds", METHODS_GET_ONLY, ARRAY_SIZE(METHODS_GET_ONLY) },
+    [type_alarms] = { "xpon_onu.ani.tc.alarms", METHODS_GET_ONLY, ARRAY_SIZE(METHODS_GET_ONLY) },
+    [type_gem_port] = { "xpon_onu.ani.tc.gem.port", METHODS_GET_ONLY, ARRAY_SIZE(METHODS_GET_ONLY) },
+    [type_transceiver] = { "xpon_onu.ani.transceiver", METHODS_TRANSCEIVER, ARRAY_SIZE(METHODS_TRANSCEIVER) }
 };
 
-static const char DIGITS[] = { '0', '1', '2' };
+/* All objects of a type share one ubus object type */
+static struct ubus_object_type s_types[n_obj_types];
+
+static const char* const GEM_PORT_DIRECTIONS[] = { "ANI-to-UNI", "UNI-to-ANI", "bidirectional" };
+static const char* const GEM_PORT_TYPES[] = { "multicast", "unicast", "broadcast" };
 
 static struct blob_buf b;
 
 static struct ubus_context* s_ctx = NULL;
-static int s_onu_nr = 1;
+static topology_t s_topology;
+
+/* All registered objects, in order of registration */
+static object_wrapper_t** s_objects = NULL;
+static uint32_t s_n_objects = 0;
+static uint32_t s_capacity = 0;
 
-static bool s_onu_enabled = false;
-static bool s_ani_one_enabled = false;
+/**
+ * Per ONU: the objects the debug commands act on, all of ANI 1, and the GEM
+ * ports the instance churn of a storm adds and removes.
+ */
+typedef struct _onu_info {
+    object_wrapper_t* onu;
+    object_wrapper_t* transceiver_one;
+    object_wrapper_t* onu_activation;
+    object_wrapper_t* alarms;
+    object_wrapper_t* churn_gem_ports[DM_N_CHURN_GEM_PORTS];
+    uint32_t churn_next;
+} onu_info_t;
+
+static onu_info_t* s_onus = NULL;
+static uint32_t s_n_onus = 0;
+
+/* Transceiver which add_instance adds to ANI 1 of the first ONU */
+static object_wrapper_t* s_extra_transceiver = NULL;
+
+/* Bumped by a restart: the mock drops the replies to requests of an older epoch */
+static uint32_t s_epoch = 0;
+static struct uloop_timeout s_restart_timer;
 
 
 typedef struct _request {
     struct ubus_request_data req;
     struct uloop_timeout timeout;
-    char* obj_name;
+    object_wrapper_t* obj;
     char* method_name;
     char* param_name;
+    uint32_t trace_id; /* 0 if the caller did not pass a trace ID */
+    int status;        /* ubus status to reply with: non-zero for an injected error */
+    uint32_t epoch;
+    const replay_call_t* replay; /* recorded call to serve, or NULL */
+    uint32_t replay_generation;
 } request_t;
 
-static object_wrapper_t* s_objects[n_objects];
 
+static void delete_object_wrapper(object_wrapper_t* obj) {
+    free(obj->name);
+    free(obj);
+}
+
+static void object_unref(object_wrapper_t* obj) {
+    --obj->refs;
+    if((0 == obj->refs) && obj->removed) {
+        delete_object_wrapper(obj);
+    }
+}
 
 static void request_delete(request_t* req) {
     when_null(req, exit);
-    free(req->obj_name);
+    if(req->obj) {
+        object_unref(req->obj);
+    }
     free(req->method_name);
     free(req->param_name);
     free(req);
@@ -201,136 +166,125 @@ static bool str_equal(const char* const str1, const char* const str2, size_t str
             (strncmp(str1, str2, str1_len) == 0)) ? true : false;
 }
 
-static void test_fill_blob_for_get_method(const char* name) {
-    const size_t name_len = strlen(name);
-    char path[128];
-    snprintf(path, 128, "%s", name);
-    const int index_of_onu_nr = strlen("xpon_onu.");
-    path[index_of_onu_nr] = 'x';
-    /**
-     * 'path' has same length as 'name'. So code below can use 'name_len'
-     * for both.
-     */
-
-    if(str_equal(path, XPON_ONU, name_len)) {
-        SAH_TRACE_INFO("path='%s' => XPON_ONU", path);
-        blobmsg_add_u8(&b, "enable", s_onu_enabled ? 1 : 0);
+/**
+ * Add generated param values for @a obj to the blob buffer.
+ *
+ * The values depend on the ONU nr, the ANI and the index of the object. With
+ * the default topology they are the values the mock always returned.
+ */
+static void test_fill_blob_for_get_method(const object_wrapper_t* const obj) {
+    char buf[64];
+    const uint32_t i = obj->index;
+
+    SAH_TRACE_DEBUG("name='%s' type=%s", obj->name, TYPE_INFO[obj->type].name);
+
+    switch(obj->type) {
+    case type_xpon_onu:
+        blobmsg_add_u8(&b, "enable", obj->enabled ? 1 : 0);
         blobmsg_add_string(&b, "version", "v1.2.3");
         blobmsg_add_string(&b, "equipment_id", "MyEquipment");
-
-        if(str_equal(name, XPON_ONU_ONE, name_len)) {
-            SAH_TRACE_INFO("name='%s' => XPON_ONU_ONE", name);
+        if(obj->onu_nr == 1) {
             blobmsg_add_string(&b, "name", "ONU_ONE");
-        } else if(str_equal(name, XPON_ONU_TWO, name_len)) {
-            SAH_TRACE_INFO("name='%s' => XPON_ONU_TWO", name);
+        } else if(obj->onu_nr == 2) {
             blobmsg_add_string(&b, "name", "ONU_TWO");
+        } else {
+            snprintf(buf, sizeof(buf), "ONU_%u", obj->onu_nr);
+            blobmsg_add_string(&b, "name", buf);
         }
-    } else if(str_equal(path, SW_IMG_1, name_len)) {
-        SAH_TRACE_INFO("path='%s' => SW_IMG_1", path);
-        blobmsg_add_u32(&b, "id", 0);
-        blobmsg_add_u8(&b, "is_committed", 1);
-        blobmsg_add_u8(&b, "is_active", 1);
+        break;
+    case type_sw_img:
+        blobmsg_add_u32(&b, "id", i - 1);
+        blobmsg_add_u8(&b, "is_committed", (i == 1) ? 1 : 0);
+        blobmsg_add_u8(&b, "is_active", (i == 1) ? 1 : 0);
         blobmsg_add_u8(&b, "is_valid", 1);
-        blobmsg_add_string(&b, "version", "SAHE01020304");
-    } else if(str_equal(path, SW_IMG_2, name_len)) {
-        SAH_TRACE_INFO("path='%s' => SW_IMG_2", path);
-        blobmsg_add_u32(&b, "id", 1);
-        blobmsg_add_u8(&b, "is_committed", 0);
-        blobmsg_add_u8(&b, "is_active", 0);
-        blobmsg_add_u8(&b, "is_valid", 1);
-        blobmsg_add_string(&b, "version", "SAHE01020303");
-    } else if(str_equal(path, ETH_UNI_1, name_len)) {
-        SAH_TRACE_INFO("path='%s' => ETH_UNI_1", path);
+        snprintf(buf, sizeof(buf), "SAHE%08u", 1020305 - i);
+        blobmsg_add_string(&b, "version", buf);
+        break;
+    case type_eth_uni:
         blobmsg_add_u8(&b, "enable", 1);
-        blobmsg_add_string(&b, "name", "MyEthernetUNI");
+        if(i == 1) {
+            blobmsg_add_string(&b, "name", "MyEthernetUNI");
+        } else {
+            snprintf(buf, sizeof(buf), "MyEthernetUNI_%u", i);
+            blobmsg_add_string(&b, "name", buf);
+        }
         blobmsg_add_string(&b, "status", "Up");
         blobmsg_add_string(&b, "ani_list", "MyAni");
-        blobmsg_add_string(&b, "interdomain_id", "(VEIP,1025)");
+        snprintf(buf, sizeof(buf), "(VEIP,%u)", 1024 + i);
+        blobmsg_add_string(&b, "interdomain_id", buf);
         blobmsg_add_string(&b, "interdomain_name", "MyDomain");
-    } else if(str_equal(path, ANI_1, name_len)) {
-        SAH_TRACE_INFO("path='%s' => ANI_1", path);
-        blobmsg_add_u8(&b, "enable", s_ani_one_enabled ? 1 : 0);
-        blobmsg_add_string(&b, "name", "MyANI");
+        break;
+    case type_ani:
+        blobmsg_add_u8(&b, "enable", obj->enabled ? 1 : 0);
+        if(i == 1) {
+            blobmsg_add_string(&b, "name", "MyANI");
+        } else {
+            snprintf(buf, sizeof(buf), "MyANI_%u", i);
+            blobmsg_add_string(&b, "name", buf);
+        }
         blobmsg_add_string(&b, "status", "Dormant");
         blobmsg_add_string(&b, "pon_mode", "XGS-PON");
-    } else if(str_equal(path, ONU_ACTIVATION, name_len)) {
-        SAH_TRACE_INFO("path='%s' => ONU_ACTIVATION", path);
-        char onu_state[3];
-        snprintf(onu_state, 3, "O%u", s_onu_state);
-        blobmsg_add_string(&b, "onu_state", onu_state);
+        break;
+    case type_onu_activation:
+        snprintf(buf, sizeof(buf), "O%u", obj->revision);
+        blobmsg_add_string(&b, "onu_state", buf);
         blobmsg_add_string(&b, "vendor_id", "XYZ1");
-        blobmsg_add_string(&b, "serial_number", "ABCD12345678");
-        blobmsg_add_u32(&b, "onu_id", 1);
-    } else if(str_equal(path, PERF_THRESHOLDS, name_len)) {
-        SAH_TRACE_INFO("path='%s' => PERF_THRESHOLDS", path);
+        snprintf(buf, sizeof(buf), "ABCD%08u",
+                 12345678 + (obj->onu_nr - 1) * 100 + (obj->ani - 1));
+        blobmsg_add_string(&b, "serial_number", buf);
+        blobmsg_add_u32(&b, "onu_id", obj->onu_nr);
+        break;
+    case type_perf_thresholds:
         blobmsg_add_u32(&b, "signal_fail", 8);
         blobmsg_add_u32(&b, "signal_degrade", 10);
-    } else if(str_equal(path, ALARMS, name_len)) {
-        SAH_TRACE_INFO("path='%s' => ALARMS", path);
-        blobmsg_add_u8(&b, "los", 1);
+        break;
+    case type_alarms:
+        blobmsg_add_u8(&b, "los", obj->revision % 2);
         blobmsg_add_u8(&b, "rogue", 1);
-    } else if(str_equal(path, GEM_PORT_1, name_len)) {
-        SAH_TRACE_INFO("path='%s' => GEM_PORT_1", path);
-        blobmsg_add_u32(&b, "port_id", 1);
-        blobmsg_add_string(&b, "direction", "ANI-to-UNI");
-        blobmsg_add_string(&b, "port_type", "multicast");
-    } else if(str_equal(path, TRANSCEIVER_1, name_len)) {
-        SAH_TRACE_INFO("path='%s' => TRANSCEIVER_1", path);
-
-        char vendor_rev[64];
-        snprintf(vendor_rev, 64, "Version_%d", s_transceiver_1_vendor_rev);
-
-        blobmsg_add_u32(&b, "id", 0);
-        blobmsg_add_u32(&b, "identifier", 2);
-        blobmsg_add_string(&b, "vendor_name", "MyVendorName");
-        blobmsg_add_string(&b, "vendor_part_number", "MyVendorPN");
-        blobmsg_add_string(&b, "vendor_revision", vendor_rev);
-        blobmsg_add_string(&b, "pon_mode", "XGS-PON");
-    } else if(str_equal(path, TRANSCEIVER_2, name_len)) {
-        SAH_TRACE_INFO("path='%s' => TRANSCEIVER_2", path);
-        blobmsg_add_u32(&b, "id", 1);
-        blobmsg_add_u32(&b, "identifier", 25);
-        blobmsg_add_string(&b, "vendor_name", "SomeOtherVendor");
-        blobmsg_add_string(&b, "pon_mode", "NG-PON2");
-    } else {
-        SAH_TRACE_ERROR("Unknown object: %s", name);
+        break;
+    case type_gem_port:
+        blobmsg_add_u32(&b, "port_id", i);
+        blobmsg_add_string(&b, "direction",
+                           GEM_PORT_DIRECTIONS[(i - 1) % ARRAY_SIZE(GEM_PORT_DIRECTIONS)]);
+        blobmsg_add_string(&b, "port_type",
+                           GEM_PORT_TYPES[(i - 1) % ARRAY_SIZE(GEM_PORT_TYPES)]);
+        break;
+    case type_transceiver:
+        blobmsg_add_u32(&b, "id", i - 1);
+        if(i % 2) {
+            blobmsg_add_u32(&b, "identifier", 2);
+            blobmsg_add_string(&b, "vendor_name", "MyVendorName");
+            blobmsg_add_string(&b, "vendor_part_number", "MyVendorPN");
+            snprintf(buf, sizeof(buf), "Version_%u", obj->revision);
+            blobmsg_add_string(&b, "vendor_revision", buf);
+            blobmsg_add_string(&b, "pon_mode", "XGS-PON");
+        } else {
+            blobmsg_add_u32(&b, "identifier", 25);
+            blobmsg_add_string(&b, "vendor_name", "SomeOtherVendor");
+            blobmsg_add_string(&b, "pon_mode", "NG-PON2");
+        }
+        break;
+    default:
+        SAH_TRACE_ERROR("Unknown object: %s", obj->name);
+        break;
     }
 }
 
-static void set_enable(const char* const obj_name, bool enable) {
-    char path[128];
-    snprintf(path, 128, "%s", obj_name);
-    const int index_of_onu_nr = strlen("xpon_onu.");
-    path[index_of_onu_nr] = 'x';
-    const size_t path_len = strlen(obj_name);
-
-    if(str_equal(path, XPON_ONU, path_len)) {
-        if(s_onu_enabled != enable) {
-            SAH_TRACE_INFO("s_onu_enabled: %d -> %d", s_onu_enabled, enable);
-            s_onu_enabled = enable;
-        }
-        blobmsg_add_u8(&b, "enable", s_onu_enabled);
-    } else if(str_equal(path, ANI_1, path_len)) {
-        if(s_ani_one_enabled != enable) {
-            SAH_TRACE_INFO("s_ani_one_enabled: %d -> %d", s_ani_one_enabled, enable);
-            s_ani_one_enabled = enable;
-        }
-        blobmsg_add_u8(&b, "enable", s_ani_one_enabled);
-    } else {
-        SAH_TRACE_ERROR("Unknown object: '%s'", path);
+static void set_enable(object_wrapper_t* const obj, bool enable) {
+    if((obj->type != type_xpon_onu) && (obj->type != type_ani)) {
+        SAH_TRACE_ERROR("Unknown object: '%s'", obj->name);
+        return;
     }
+    if(obj->enabled != enable) {
+        SAH_TRACE_INFO("%s: enabled: %d -> %d", obj->name, obj->enabled, enable);
+        obj->enabled = enable;
+    }
+    blobmsg_add_u8(&b, "enable", obj->enabled);
 }
 
-static void test_fill_blob_for_get_params_method(const char* const obj_name,
+static void test_fill_blob_for_get_params_method(const object_wrapper_t* const obj,
                                                  const char* const param_name) {
-    char path[128];
-    snprintf(path, 128, "%s", obj_name);
-    const int index_of_onu_nr = strlen("xpon_onu.");
-    path[index_of_onu_nr] = 'x';
-    const size_t path_len = strlen(path);
-
-    if(str_equal(path, TRANSCEIVER_1, path_len) ||
-       str_equal(path, TRANSCEIVER_2, path_len)) {
+    if(obj->type == type_transceiver) {
 
         const size_t len = strlen(param_name);
 
@@ -350,61 +304,143 @@ static void test_fill_blob_for_get_params_method(const char* const obj_name,
             blobmsg_add_u32(&b, "temperature", s_temperature);
             ++s_temperature;
         } else {
-            SAH_TRACE_ERROR("object: %s: unknown param_name: %s", obj_name, param_name);
+            SAH_TRACE_ERROR("object: %s: unknown param_name: %s", obj->name, param_name);
         }
     } else {
-        SAH_TRACE_ERROR("Unknown object: %s", obj_name);
+        SAH_TRACE_ERROR("Unknown object: %s", obj->name);
     }
 }
 
 
-static void method_cb(struct uloop_timeout* t) {
-    request_t* req = container_of(t, request_t, timeout);
-    when_null(req, exit);
-    when_null_trace(req->method_name, exit, ERROR, "method_name is NULL");
+/**
+ * Fill the reply to @a req and send it.
+ *
+ * @param[in] req       the request
+ * @param[in] ubus_req  the ubus request to reply to: the deferred request, or
+ *                      the original one when replying immediately
+ *
+ * @return the size of the reply in bytes
+ */
+static uint32_t send_reply(request_t* const req, struct ubus_request_data* const ubus_req) {
     const char* const method = req->method_name; /* alias */
     const size_t method_len = strlen(method);
 
+    SAH_TRACE_DEBUG("%s.%s(): reply trace_id=%u", req->obj->name, method, req->trace_id);
+
     blob_buf_init(&b, 0);
-    if(str_equal(method, METHOD_GET, method_len)) {
-        test_fill_blob_for_get_method(req->obj_name);
+    if(req->trace_id != 0) {
+        blobmsg_add_u32(&b, "trace_id", req->trace_id);
+    }
+    if(req->obj->removed) {
+        SAH_TRACE_ERROR("%s.%s(): object was removed", req->obj->name, method);
+    } else if(req->replay && (req->replay_generation == replay_generation())) {
+        replay_fill_reply(req->replay, &b);
+    } else if(str_equal(method, METHOD_GET, method_len)) {
+        test_fill_blob_for_get_method(req->obj);
     } else if(str_equal(method, METHOD_ENABLE, method_len)) {
-        set_enable(req->obj_name, true);
+        set_enable(req->obj, true);
     } else if(str_equal(method, METHOD_DISABLE, method_len)) {
-        set_enable(req->obj_name, false);
+        set_enable(req->obj, false);
     } else if(str_equal(method, METHOD_GET_PARAMS, method_len)) {
-        test_fill_blob_for_get_params_method(req->obj_name, req->param_name);
+        test_fill_blob_for_get_params_method(req->obj, req->param_name);
     } else {
         SAH_TRACE_ERROR("Unknown method: '%s'", method);
     }
 
-    if(ubus_send_reply(s_ctx, &req->req, b.head)) {
+    if(ubus_send_reply(s_ctx, ubus_req, b.head)) {
         SAH_TRACE_ERROR("Failed to send msg");
     }
+    return blob_raw_len(b.head);
+}
+
+/**
+ * Update the counters of @a method of @a object.
+ *
+ * @param[in] object   path of the object
+ * @param[in] method   name of the method
+ * @param[in] call     true if called from the method handler, i.e., for a new
+ *                     request
+ * @param[in] status   ubus status of the reply
+ * @param[in] dropped  true if the mock will not reply
+ * @param[in] bytes    size of the reply, or 0 if the mock did not reply yet
+ * @param[in] start    stats_now_ns() at the start of the handling
+ */
+static void account(const char* const object, const char* const method, bool call,
+                    int status, bool dropped, uint32_t bytes, uint64_t start) {
+    call_stats_t* const stats = stats_get(object, method);
+    if(!stats) {
+        return;
+    }
+    if(call) {
+        ++stats->calls;
+    }
+    if(status != 0) {
+        ++stats->errors;
+    }
+    if(dropped) {
+        ++stats->dropped;
+    }
+    stats->bytes += bytes;
+    stats->handler_ns += stats_now_ns() - start;
+}
 
-    ubus_complete_deferred_request(s_ctx, &req->req, 0);
+static void method_cb(struct uloop_timeout* t) {
+    const uint64_t start = stats_now_ns();
+    uint32_t bytes = 0;
+    request_t* req = container_of(t, request_t, timeout);
+    when_null(req, exit);
+    when_null_trace(req->method_name, exit, ERROR, "method_name is NULL");
+
+    /* The HAL restarted or the object disappeared: the reply is lost */
+    if((req->epoch != s_epoch) || req->obj->hidden) {
+        SAH_TRACE_INFO("%s.%s(): drop reply", req->obj->name, req->method_name);
+        account(req->obj->name, req->method_name, false, 0, true, 0, start);
+        goto exit;
+    }
+    if(req->status == 0) {
+        bytes = send_reply(req, &req->req);
+    }
+    ubus_complete_deferred_request(s_ctx, &req->req, req->status);
+    account(req->obj->name, req->method_name, false, req->status, false, bytes, start);
 
 exit:
     request_delete(req);
     return;
 }
 
+/**
+ * Handle a call of any method of any object.
+ *
+ * The handler replies after the delay latency_get_delay_ms() returns for the
+ * object and the method, or from the handler itself if the latency is
+ * 'immediate'. While replaying a trace, a recorded call overrides the reply
+ * and the delay. A fault from fault_get_for_request() overrides both.
+ */
 static int common_method_handler(struct ubus_context* ctx, struct ubus_object* obj,
                                  struct ubus_request_data* req, const char* method,
                                  struct blob_attr* msg) {
+    const uint64_t start = stats_now_ns();
     int rc = UBUS_STATUS_UNKNOWN_ERROR;
+    bool dropped = false;
+    uint32_t bytes = 0;
 
     when_null_trace(obj, exit, ERROR, "obj is NULL");
     when_null_trace(obj->name, exit, ERROR, "obj->name is NULL");
 
-    SAH_TRACE_INFO("%s.%s()", obj->name, method);
+    struct blob_attr* trace_tb[ARRAY_SIZE(TRACE_ID_POLICY)];
+    blobmsg_parse(TRACE_ID_POLICY, ARRAY_SIZE(TRACE_ID_POLICY), trace_tb, blob_data(msg), blob_len(msg));
+    const uint32_t trace_id = trace_tb[0] ? blobmsg_get_u32(trace_tb[0]) : 0;
+
+    SAH_TRACE_INFO("%s.%s() trace_id=%u", obj->name, method, trace_id);
 
     request_t* mreq = (request_t*) calloc(1, sizeof(request_t));
     when_null_trace(mreq, exit, ERROR, "Failed to allocate mem for request_t");
+    mreq->trace_id = trace_id;
+    mreq->epoch = s_epoch;
 
-    ubus_defer_request(ctx, req, &mreq->req);
-
-    mreq->obj_name = strdup(obj->name);
+    /* ubus_obj is the first member of object_wrapper_t */
+    mreq->obj = container_of(obj, object_wrapper_t, ubus_obj);
+    mreq->obj->refs++;
     mreq->method_name = strdup(method);
     mreq->timeout.cb = method_cb;
 
@@ -428,113 +464,244 @@ static int common_method_handler(struct ubus_context* ctx, struct ubus_object* o
         }
     }
 
-    uloop_timeout_set(&mreq->timeout, 100);
+    int delay_ms = latency_get_delay_ms(obj->name, method);
+    mreq->replay = replay_find_call(obj->name, method, mreq->param_name);
+    if(mreq->replay) {
+        mreq->replay_generation = replay_generation();
+        mreq->status = replay_call_status(mreq->replay);
+        delay_ms = replay_call_delay_ms(mreq->replay);
+    }
+    const fault_t fault = fault_get_for_request(obj->name, method);
+    switch(fault.type) {
+    case fault_no_reply:
+        /* Defer the request without ever completing it: the caller times out */
+        ubus_defer_request(ctx, req, &mreq->req);
+        request_delete(mreq);
+        dropped = true;
+        rc = 0;
+        goto exit;
+    case fault_error:
+        mreq->status = (int) fault.arg;
+        break;
+    case fault_late:
+        delay_ms = (int) fault.arg;
+        break;
+    default:
+        break;
+    }
+
+    if((delay_ms < 0) && (mreq->status != 0)) {
+        rc = mreq->status;
+        request_delete(mreq);
+        goto exit;
+    } else if(delay_ms < 0) {
+        bytes = send_reply(mreq, req);
+        request_delete(mreq);
+    } else {
+        ubus_defer_request(ctx, req, &mreq->req);
+        uloop_timeout_set(&mreq->timeout, delay_ms);
+    }
 
     rc = 0;
 
 exit:
-    return rc;
-}
-
-static void delete_object_wrapper(object_wrapper_t* obj) {
-    if(obj->ubus_obj.type) {
-        free(obj->ubus_obj.type);
-    }
-    if(obj->name) {
-        free(obj->name);
+    if(obj && obj->name) {
+        account(obj->name, method, true, rc, dropped, bytes, start);
     }
-    free(obj);
+    return rc;
 }
 
-
-static object_wrapper_t* create_object_wrapper(obj_id_t id, const char* path) {
+static object_wrapper_t* create_object_wrapper(obj_type_t type, const char* path) {
     object_wrapper_t* obj = (object_wrapper_t*) calloc(1, sizeof(object_wrapper_t));
     when_null_trace(obj, exit, ERROR, "Failed to allocate mem");
 
-    obj->ubus_obj.type = (struct ubus_object_type*) calloc(1, sizeof(struct ubus_object_type));
-    if(NULL == obj->ubus_obj.type) {
-        SAH_TRACE_ERROR("Failed to allocate mem for ubus_object_type");
+    obj->name = strdup(path);
+    if(NULL == obj->name) {
+        SAH_TRACE_ERROR("Failed to allocate mem for name");
         free(obj);
         return NULL;
     }
-
-    obj->name = strdup(path);
+    obj->type = type;
 
     obj->ubus_obj.name = obj->name;
-    obj->ubus_obj.methods = OBJECT_INFO[id].methods;
-    obj->ubus_obj.n_methods = OBJECT_INFO[id].n_methods;
-
-    obj->ubus_obj.type->name = obj->name;
-    obj->ubus_obj.type->methods = OBJECT_INFO[id].methods;
-    obj->ubus_obj.type->n_methods = OBJECT_INFO[id].n_methods;
+    obj->ubus_obj.type = &s_types[type];
+    obj->ubus_obj.methods = TYPE_INFO[type].methods;
+    obj->ubus_obj.n_methods = TYPE_INFO[type].n_methods;
 
 exit:
     return obj;
 }
 
-static int register_object(obj_id_t id) {
-    int rc = 1;
-
-    if(id >= n_objects) {
-        SAH_TRACE_ERROR("id=%d >= n_objects=%d", id, n_objects);
-        goto exit;
+static bool add_to_objects(object_wrapper_t* obj) {
+    if(s_n_objects == s_capacity) {
+        const uint32_t capacity = s_capacity ? (2 * s_capacity) : 64;
+        object_wrapper_t** const objects =
+            (object_wrapper_t**) realloc(s_objects, capacity * sizeof(object_wrapper_t*));
+        when_null_trace(objects, error, ERROR, "Failed to allocate mem for %u objects", capacity);
+        s_objects = objects;
+        s_capacity = capacity;
     }
+    s_objects[s_n_objects++] = obj;
+    return true;
 
-    char path[128];
-    const int index = strlen("xpon_onu."); /* index of 'x' char */
+error:
+    return false;
+}
 
-    snprintf(path, 128, "%s", OBJECT_INFO[id].name);
-    /* Replace 'x' char with ONU nr: '1' or '2'. */
-    path[index] = DIGITS[s_onu_nr];
+/**
+ * Create an object and advertise it on ubus.
+ *
+ * @param[in] type    type of the object
+ * @param[in] onu_nr  nr of the ONU the object belongs to
+ * @param[in] ani     index of the ANI the object belongs to, or 0
+ * @param[in] index   instance index of the object, or 0 for a singleton
+ * @param[in] path    path of the object, e.g., "xpon_onu.1.ani.1.transceiver.2"
+ *
+ * @return the object on success, else NULL
+ */
+static object_wrapper_t* register_object(obj_type_t type, uint32_t onu_nr,
+                                         uint32_t ani, uint32_t index,
+                                         const char* const path) {
+    object_wrapper_t* obj = create_object_wrapper(type, path);
+    when_null_trace(obj, exit, ERROR, "Failed to create object for %s", path);
 
-    object_wrapper_t* obj = create_object_wrapper(id, path);
-    when_null_trace(obj, exit, ERROR,
-                    "Failed to create object for %s", path);
+    obj->onu_nr = onu_nr;
+    obj->ani = ani;
+    obj->index = index;
+    obj->revision = (type == type_onu_activation) ? 2 : 1;
 
     if(ubus_add_object(s_ctx, &obj->ubus_obj) != UBUS_STATUS_OK) {
         SAH_TRACE_ERROR("Failed to add '%s' to ubus", path);
         delete_object_wrapper(obj);
+        obj = NULL;
         goto exit;
     }
-    s_objects[id] = obj;
+    if(!add_to_objects(obj)) {
+        ubus_remove_object(s_ctx, &obj->ubus_obj);
+        delete_object_wrapper(obj);
+        obj = NULL;
+    }
 
-    rc = 0;
 exit:
-    return rc;
+    return obj;
 }
 
-static void unregister_object(obj_id_t id) {
-    if(id >= n_objects) {
-        SAH_TRACE_ERROR("id=%d >= n_objects=%d", id, n_objects);
-        return;
+/* Clear the references to @a obj of the debug commands */
+static void forget_object(const object_wrapper_t* const obj) {
+    const uint32_t i = obj->onu_nr - s_topology.first_onu;
+
+    if(obj == s_extra_transceiver) {
+        s_extra_transceiver = NULL;
     }
-    if(s_objects[id] == NULL) {
-        SAH_TRACE_DEBUG("Object with id=%d does not exist", id);
+    if(i >= s_n_onus) {
         return;
     }
+    onu_info_t* const info = &s_onus[i];
+    if(info->onu == obj) {
+        info->onu = NULL;
+    } else if(info->transceiver_one == obj) {
+        info->transceiver_one = NULL;
+    } else if(info->onu_activation == obj) {
+        info->onu_activation = NULL;
+    } else if(info->alarms == obj) {
+        info->alarms = NULL;
+    } else if((obj->type == type_gem_port) && (obj->index > s_topology.n_gem_ports)) {
+        const uint32_t slot = obj->index - s_topology.n_gem_ports - 1;
+        if((slot < DM_N_CHURN_GEM_PORTS) && (info->churn_gem_ports[slot] == obj)) {
+            info->churn_gem_ports[slot] = NULL;
+        }
+    }
+}
 
-    object_wrapper_t* obj = s_objects[id];
+static void unregister_object(object_wrapper_t* obj) {
+    uint32_t i;
 
-    if(ubus_remove_object(s_ctx, &obj->ubus_obj)) {
+    if(s_onus) {
+        forget_object(obj);
+    }
+
+    for(i = 0; i < s_n_objects; ++i) {
+        if(s_objects[i] == obj) {
+            s_objects[i] = s_objects[--s_n_objects];
+            break;
+        }
+    }
+    if(!obj->hidden && ubus_remove_object(s_ctx, &obj->ubus_obj)) {
         SAH_TRACE_ERROR("Failed to remove '%s' from ubus", obj->name);
     }
-    delete_object_wrapper(obj);
-    s_objects[id] = NULL;
+    obj->removed = true;
+    if(0 == obj->refs) {
+        delete_object_wrapper(obj);
+    }
 }
 
-static int dm_advertise_onu(int onu_nr) {
+static int advertise_ani(onu_info_t* const info, uint32_t onu_nr, uint32_t ani) {
     int rc = 1;
+    uint32_t i;
+    char path[128];
+    object_wrapper_t* obj;
 
-    const size_t n_digits = ARRAY_SIZE(DIGITS);
-    if(onu_nr > (int) n_digits) {
-        SAH_TRACE_ERROR("Invalid onu_nr [%d]", onu_nr);
-        goto exit;
+    snprintf(path, sizeof(path), "xpon_onu.%u.ani.%u", onu_nr, ani);
+    when_null(register_object(type_ani, onu_nr, ani, ani, path), exit);
+
+    snprintf(path, sizeof(path), "xpon_onu.%u.ani.%u.tc.onu_activation", onu_nr, ani);
+    obj = register_object(type_onu_activation, onu_nr, ani, 0, path);
+    when_null(obj, exit);
+    if(ani == 1) {
+        info->onu_activation = obj;
     }
 
-    size_t i;
+    snprintf(path, sizeof(path), "xpon_onu.%u.ani.%u.tc.performance_thresholds", onu_nr, ani);
+    when_null(register_object(type_perf_thresholds, onu_nr, ani, 0, path), exit);
+
+    snprintf(path, sizeof(path), "xpon_onu.%u.ani.%u.tc.alarms", onu_nr, ani);
+    obj = register_object(type_alarms, onu_nr, ani, 0, path);
+    when_null(obj, exit);
+    if(ani == 1) {
+        info->alarms = obj;
+    }
 
-    for(i = 0; i < id_transceiver_2; ++i) {
-        if(register_object(i) != 0) {
+    for(i = 1; i <= s_topology.n_gem_ports; ++i) {
+        snprintf(path, sizeof(path), "xpon_onu.%u.ani.%u.tc.gem.port.%u", onu_nr, ani, i);
+        when_null(register_object(type_gem_port, onu_nr, ani, i, path), exit);
+    }
+
+    for(i = 1; i <= s_topology.n_transceivers; ++i) {
+        snprintf(path, sizeof(path), "xpon_onu.%u.ani.%u.transceiver.%u", onu_nr, ani, i);
+        obj = register_object(type_transceiver, onu_nr, ani, i, path);
+        when_null(obj, exit);
+        if((ani == 1) && (i == 1)) {
+            info->transceiver_one = obj;
+        }
+    }
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+static int dm_advertise_onu(onu_info_t* const info, uint32_t onu_nr) {
+    int rc = 1;
+    uint32_t i;
+    char path[128];
+
+    snprintf(path, sizeof(path), "xpon_onu.%u", onu_nr);
+    info->onu = register_object(type_xpon_onu, onu_nr, 0, 0, path);
+    when_null(info->onu, exit);
+
+    for(i = 1; i <= s_topology.n_software_images; ++i) {
+        snprintf(path, sizeof(path), "xpon_onu.%u.software_image.%u", onu_nr, i);
+        when_null(register_object(type_sw_img, onu_nr, 0, i, path), exit);
+    }
+
+    for(i = 1; i <= s_topology.n_ethernet_unis; ++i) {
+        snprintf(path, sizeof(path), "xpon_onu.%u.ethernet_uni.%u", onu_nr, i);
+        when_null(register_object(type_eth_uni, onu_nr, 0, i, path), exit);
+    }
+
+    for(i = 1; i <= s_topology.n_anis; ++i) {
+        if(advertise_ani(info, onu_nr, i) != 0) {
             goto exit;
         }
     }
@@ -545,47 +712,351 @@ exit:
     return rc;
 }
 
-int dm_init(struct ubus_context* ctx, int onu_nr) {
+/**
+ * Advertise the objects of @a topology on ubus.
+ *
+ * @return 0 on success, else 1
+ */
+int dm_init(struct ubus_context* ctx, const topology_t* const topology) {
+    int rc = 1;
+    uint32_t i;
+
     s_ctx = ctx;
-    s_onu_nr = onu_nr;
+    s_topology = *topology;
+
+    for(i = 0; i < n_obj_types; ++i) {
+        s_types[i].name = TYPE_INFO[i].name;
+        s_types[i].methods = TYPE_INFO[i].methods;
+        s_types[i].n_methods = TYPE_INFO[i].n_methods;
+    }
+
+    s_onus = (onu_info_t*) calloc(topology->n_onus, sizeof(onu_info_t));
+    when_null_trace(s_onus, exit, ERROR, "Failed to allocate mem for %u ONUs", topology->n_onus);
+    s_n_onus = topology->n_onus;
 
-    return dm_advertise_onu(onu_nr);
+    for(i = 0; i < topology->n_onus; ++i) {
+        if(dm_advertise_onu(&s_onus[i], topology->first_onu + i) != 0) {
+            goto exit;
+        }
+    }
+    SAH_TRACE_INFO("Advertised %u objects", s_n_objects);
+
+    rc = 0;
+
+exit:
+    return rc;
 }
 
 object_wrapper_t* dm_get_xpon_onu_object(void) {
-    return s_objects[id_xpon_onu];
+    return dm_get_onu_object(0);
 }
 
-int dm_register_transceiver_two(void) {
-    if(s_objects[id_transceiver_2] != NULL) {
-        SAH_TRACE_ERROR("transceiver.2 already exists");
+uint32_t dm_get_n_onus(void) {
+    return s_n_onus;
+}
+
+/**
+ * Return the xpon_onu object of the ONU with position @a i, i.e., of ONU nr
+ * first_onu + i.
+ */
+object_wrapper_t* dm_get_onu_object(uint32_t i) {
+    return (i < s_n_onus) ? s_onus[i].onu : NULL;
+}
+
+/**
+ * Return an object of ANI 1 of the ONU with position @a i.
+ *
+ * @param[in] i     position of the ONU
+ * @param[in] type  type_transceiver (for transceiver 1), type_onu_activation
+ *                  or type_alarms
+ *
+ * @return the object, or NULL if it does not exist
+ */
+object_wrapper_t* dm_get_ani_one_object(uint32_t i, obj_type_t type) {
+    if(i >= s_n_onus) {
+        return NULL;
+    }
+    switch(type) {
+    case type_transceiver:    return s_onus[i].transceiver_one;
+    case type_onu_activation: return s_onus[i].onu_activation;
+    case type_alarms:         return s_onus[i].alarms;
+    default: break;
+    }
+    return NULL;
+}
+
+/**
+ * Change a param value of @a obj, e.g., the vendor revision of a transceiver
+ * or the los alarm.
+ */
+void dm_change_object(object_wrapper_t* const obj) {
+    when_null(obj, exit);
+    ++obj->revision;
+    if((obj->type == type_onu_activation) && (obj->revision > 9)) {
+        obj->revision = 1;
+    }
+exit:
+    return;
+}
+
+/**
+ * Add or remove the next GEM port of the instance churn of ONU @a i.
+ *
+ * The churn cycles over DM_N_CHURN_GEM_PORTS GEM ports of ANI 1 after the
+ * GEM ports of the topology. It adds a port if it does not exist, else it
+ * removes it.
+ *
+ * @param[in] i        position of the ONU
+ * @param[out] added   true if the function added the port
+ * @param[out] index   index of the port
+ *
+ * @return 0 on success, else 1
+ */
+int dm_churn_gem_port(uint32_t i, bool* const added, uint32_t* const index) {
+    int rc = 1;
+    char path[128];
+
+    if(i >= s_n_onus) {
+        goto exit;
+    }
+    onu_info_t* const info = &s_onus[i];
+    if(!info->onu) {
+        goto exit;
+    }
+    const uint32_t slot = info->churn_next;
+    info->churn_next = (slot + 1) % DM_N_CHURN_GEM_PORTS;
+    *index = s_topology.n_gem_ports + 1 + slot;
+
+    if(info->churn_gem_ports[slot]) {
+        unregister_object(info->churn_gem_ports[slot]);
+        info->churn_gem_ports[slot] = NULL;
+        *added = false;
+    } else {
+        const uint32_t onu_nr = info->onu->onu_nr;
+        snprintf(path, sizeof(path), "xpon_onu.%u.ani.1.tc.gem.port.%u", onu_nr, *index);
+        info->churn_gem_ports[slot] = register_object(type_gem_port, onu_nr, 1, *index, path);
+        when_null(info->churn_gem_ports[slot], exit);
+        *added = true;
+    }
+
+    rc = 0;
+
+exit:
+    return rc;
+}
+
+/**
+ * Return the index of the transceiver which the debug commands add and
+ * remove: the first index after the transceivers of the topology.
+ */
+uint32_t dm_get_extra_transceiver_index(void) {
+    return s_topology.n_transceivers + 1;
+}
+
+/**
+ * Add a transceiver to ANI 1 of the first ONU.
+ *
+ * @return 0 on success, else 1
+ */
+int dm_register_extra_transceiver(void) {
+    char path[128];
+
+    if(s_extra_transceiver != NULL) {
+        SAH_TRACE_ERROR("%s already exists", s_extra_transceiver->name);
         return 1;
     }
 
-    return register_object(id_transceiver_2);
+    const uint32_t index = dm_get_extra_transceiver_index();
+    snprintf(path, sizeof(path), "xpon_onu.%u.ani.1.transceiver.%u",
+             s_topology.first_onu, index);
+    s_extra_transceiver = register_object(type_transceiver, s_topology.first_onu,
+                                          1, index, path);
+    return s_extra_transceiver ? 0 : 1;
 }
 
-void dm_unregister_transceiver_two(void) {
-    unregister_object(id_transceiver_2);
+void dm_unregister_extra_transceiver(void) {
+    if(s_extra_transceiver == NULL) {
+        SAH_TRACE_DEBUG("Extra transceiver does not exist");
+        return;
+    }
+    unregister_object(s_extra_transceiver);
+    s_extra_transceiver = NULL;
 }
 
 void dm_change_transceiver_one_vendor_rev(void) {
-    ++s_transceiver_1_vendor_rev;
+    dm_change_object(dm_get_ani_one_object(0, type_transceiver));
 }
 
 void dm_change_onu_activation_onu_state(void) {
-    ++s_onu_state;
-    if(s_onu_state > 9) {
-        s_onu_state = 1;
+    dm_change_object(dm_get_ani_one_object(0, type_onu_activation));
+}
+
+/**
+ * Return the object with path @a path, or NULL if it does not exist.
+ */
+object_wrapper_t* dm_find_object(const char* const path) {
+    uint32_t i;
+    for(i = 0; i < s_n_objects; ++i) {
+        if(strcmp(s_objects[i]->name, path) == 0) {
+            return s_objects[i];
+        }
     }
+    return NULL;
 }
 
-void dm_cleanup(void) {
-    int i;
+/**
+ * Add the instance with path @a path, e.g., "xpon_onu.1.ani.1.transceiver.3".
+ *
+ * The function derives the type of the object from the path, e.g.,
+ * "xpon_onu.ani.transceiver", and the ONU nr, the ANI and the index from the
+ * numbers in the path.
+ *
+ * @return the object on success or if it already exists, else NULL
+ */
+object_wrapper_t* dm_register_instance(const char* const path) {
+    char generic[128];
+    uint32_t numbers[4];
+    uint32_t n_numbers = 0;
+    size_t len = 0;
+    bool last_is_number = false;
+    const char* p = path;
+    uint32_t type;
+
+    object_wrapper_t* obj = dm_find_object(path);
+    if(obj) {
+        return obj;
+    }
+
+    /* Split the path in the generic path and the numbers */
+    while(*p) {
+        const size_t seg_len = strcspn(p, ".");
+        if((seg_len > 0) && (strspn(p, "0123456789") == seg_len)) {
+            if(n_numbers < ARRAY_SIZE(numbers)) {
+                numbers[n_numbers++] = (uint32_t) strtoul(p, NULL, 10);
+            }
+            last_is_number = true;
+        } else {
+            if((len + seg_len + 2) > sizeof(generic)) {
+                goto error;
+            }
+            if(len > 0) {
+                generic[len++] = '.';
+            }
+            memcpy(generic + len, p, seg_len);
+            len += seg_len;
+            last_is_number = false;
+        }
+        p += seg_len;
+        if(*p == '.') {
+            ++p;
+        }
+    }
+    generic[len] = '\0';
+
+    for(type = 0; type < n_obj_types; ++type) {
+        if(strcmp(TYPE_INFO[type].name, generic) == 0) {
+            break;
+        }
+    }
+    if((type == n_obj_types) || (n_numbers == 0)) {
+        goto error;
+    }
+
+    const bool in_ani = (strncmp(generic, "xpon_onu.ani", 12) == 0) && (n_numbers > 1);
+    return register_object((obj_type_t) type, numbers[0], in_ani ? numbers[1] : 0,
+                           last_is_number ? numbers[n_numbers - 1] : 0, path);
+
+error:
+    SAH_TRACE_ERROR("Unknown object type for '%s'", path);
+    return NULL;
+}
+
+/**
+ * Remove the instance with path @a path, if it exists.
+ */
+void dm_unregister_instance(const char* const path) {
+    object_wrapper_t* const obj = dm_find_object(path);
+    if(obj) {
+        unregister_object(obj);
+    }
+}
+
+static void set_hidden(object_wrapper_t* const obj, bool hidden) {
+    if(obj->hidden == hidden) {
+        return;
+    }
+    if(hidden) {
+        if(ubus_remove_object(s_ctx, &obj->ubus_obj)) {
+            SAH_TRACE_ERROR("Failed to remove '%s' from ubus", obj->name);
+            return;
+        }
+    } else if(ubus_add_object(s_ctx, &obj->ubus_obj) != UBUS_STATUS_OK) {
+        SAH_TRACE_ERROR("Failed to add '%s' to ubus", obj->name);
+        return;
+    }
+    obj->hidden = hidden;
+}
 
-    for(i = 0; i < n_objects; ++i) {
-        if(s_objects[i]) {
-            unregister_object(i);
+/**
+ * Remove the objects of a subtree from ubus, or advertise them again.
+ *
+ * The mock keeps the state of a hidden object. It drops the replies to
+ * pending requests for the object, and it does not send notifications for it.
+ * An object which reappears gets a new ubus ID.
+ *
+ * @param[in] prefix  path of the root of the subtree, e.g., "xpon_onu.1.ani.1".
+ *                    "all" or NULL means all objects.
+ * @param[in] hidden  true to remove the objects from ubus, false to advertise
+ *                    them again
+ *
+ * @return the nr of objects in the subtree
+ */
+uint32_t dm_set_hidden(const char* const prefix, bool hidden) {
+    const bool all = (NULL == prefix) || (strcmp(prefix, "all") == 0);
+    const size_t len = all ? 0 : strlen(prefix);
+    uint32_t n = 0;
+    uint32_t i;
+
+    for(i = 0; i < s_n_objects; ++i) {
+        object_wrapper_t* const obj = s_objects[i];
+        if(!all && ((strncmp(obj->name, prefix, len) != 0) ||
+                    ((obj->name[len] != '\0') && (obj->name[len] != '.')))) {
+            continue;
         }
+        set_hidden(obj, hidden);
+        ++n;
+    }
+    return n;
+}
+
+static void restart_done(UNUSED struct uloop_timeout* t) {
+    const uint32_t n = dm_set_hidden(NULL, false);
+    SAH_TRACE_INFO("restart: re-registered %u objects", n);
+}
+
+/**
+ * Simulate a restart of the HAL: remove all objects from ubus, drop the
+ * replies to all pending requests, and re-register the objects after
+ * @a down_ms.
+ */
+void dm_restart(uint32_t down_ms) {
+    ++s_epoch;
+    const uint32_t n = dm_set_hidden(NULL, true);
+    SAH_TRACE_INFO("restart: removed %u objects, down for %u ms", n, down_ms);
+    s_restart_timer.cb = restart_done;
+    uloop_timeout_set(&s_restart_timer, (int) down_ms);
+}
+
+void dm_cleanup(void) {
+    uloop_timeout_cancel(&s_restart_timer);
+    while(s_n_objects > 0) {
+        unregister_object(s_objects[s_n_objects - 1]);
     }
+    free(s_objects);
+    s_objects = NULL;
+    s_capacity = 0;
+    free(s_onus);
+    s_onus = NULL;
+    s_n_onus = 0;
+    s_extra_transceiver = NULL;
 }
@@ -2,6 +2,7 @@
 
 // System headers
 #include <errno.h>
+#include <stdio.h>  /* sscanf() */
 #include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -10,49 +11,156 @@
 
 #include "libubus.h"
 
-#include "data_model.h"   /* dm_register_transceiver_two() */
+#include "data_model.h"   /* dm_register_extra_transceiver() */
 #include "dbg_commands.h" /* ADD_INSTANCE */
-#include "notif.h"        /* notif_send_dm_instance_added_for_transceiver_two() */
+#include "fault.h"        /* fault_set_rule_from_string() */
+#include "latency.h"      /* latency_set_rule_from_string() */
+#include "notif.h"        /* notif_send_dm_instance_added_for_extra_transceiver() */
 #include "onu_hal_macros.h"
 #include "onu_hal_trace.h"
+#include "replay.h"       /* replay_start_from_string() */
+#include "stats.h"        /* stats_dump() */
+#include "storm.h"        /* storm_start_from_string() */
 
 #define DEBUG_SERVER "/var/run/onu_hal_dbg.sock"
 #define MAX_MSG_SIZE 128
 
+/* Default time the HAL is down during a simulated restart */
+#define DEFAULT_RESTART_MS 2000
+
 static struct uloop_fd s_uloop_fd;
 
-typedef void (* handle_dbg_command_fn_t) (void);
+/* Client which sent the command being handled, to send the reply of a query to */
+static struct sockaddr_un s_client;
+static socklen_t s_client_len = 0;
+
+/* 'args': the rest of the message after the command name, without leading spaces */
+typedef void (* handle_dbg_command_fn_t) (const char* args);
 
-static void handle_add_instance(void) {
-    if(dm_register_transceiver_two()) {
+static void handle_add_instance(UNUSED const char* args) {
+    if(dm_register_extra_transceiver()) {
         return;
     }
 
-    notif_send_dm_instance_added_for_transceiver_two();
+    notif_send_dm_instance_added_for_extra_transceiver();
 }
 
-static void handle_remove_instance(void) {
-    dm_unregister_transceiver_two();
-    notif_send_dm_instance_removed_for_transceiver_two();
+static void handle_remove_instance(UNUSED const char* args) {
+    dm_unregister_extra_transceiver();
+    notif_send_dm_instance_removed_for_extra_transceiver();
 }
 
-static void handle_change_transceiver(void) {
+static void handle_change_transceiver(UNUSED const char* args) {
     dm_change_transceiver_one_vendor_rev();
     notif_send_dm_object_changed_for_transceiver_one();
 }
 
-static void handle_change_onu_activation(void) {
+static void handle_change_onu_activation(UNUSED const char* args) {
     dm_change_onu_activation_onu_state();
     notif_send_dm_object_changed_for_onu_activation();
 }
 
-static void handle_omci_mib_reset(void) {
+static void handle_omci_mib_reset(UNUSED const char* args) {
     notif_send_omci_reset_mib();
 }
 
+/* Args: <object|all> <method|all> <distribution>, e.g., "all get uniform 5 50" */
+static void handle_set_latency(const char* args) {
+    if(latency_set_rule_from_string(args)) {
+        latency_print_rules();
+    }
+}
+
+static void handle_clear_latency(UNUSED const char* args) {
+    latency_clear_rules();
+    latency_print_rules();
+}
+
+static void handle_show_latency(UNUSED const char* args) {
+    latency_print_rules();
+}
+
+/* Args: <kind> <rate> <count> [onus], e.g., "instance_churn 1000 50000 4" */
+static void handle_storm(const char* args) {
+    storm_start_from_string(args);
+}
+
+static void handle_stop_storm(UNUSED const char* args) {
+    storm_stop();
+}
+
+/* Args: <object|all> <method|all> <fault> [arg] [percent], e.g., "all get no_reply 10" */
+static void handle_set_fault(const char* args) {
+    if(fault_set_rule_from_string(args)) {
+        fault_print_rules();
+    }
+}
+
+static void handle_clear_fault(UNUSED const char* args) {
+    fault_clear_rules();
+    fault_print_rules();
+}
+
+static void handle_show_fault(UNUSED const char* args) {
+    fault_print_rules();
+}
+
+/* Args: <object|all> */
+static void handle_disappear(const char* args) {
+    SAH_TRACE_INFO("disappear: %u objects", dm_set_hidden(*args ? args : NULL, true));
+}
+
+/* Args: <object|all> */
+static void handle_reappear(const char* args) {
+    SAH_TRACE_INFO("reappear: %u objects", dm_set_hidden(*args ? args : NULL, false));
+}
+
+/* Args: [down_ms] */
+static void handle_restart(const char* args) {
+    unsigned int down_ms = DEFAULT_RESTART_MS;
+    if(*args && (sscanf(args, "%u", &down_ms) != 1)) {
+        SAH_TRACE_ERROR("Invalid restart args '%s': expected [down_ms]", args);
+        return;
+    }
+    dm_restart(down_ms);
+}
+
+/* Send one line of the reply of a query to the client */
+static void reply_line(const char* line, UNUSED void* priv) {
+    if(s_client_len <= sizeof(sa_family_t)) {
+        return; /* unnamed client: no way to reply */
+    }
+    if(sendto(s_uloop_fd.fd, line, strlen(line), 0,
+              (const struct sockaddr*) &s_client, s_client_len) == -1) {
+        SAH_TRACE_ERROR("Failed to send reply: %s", strerror(errno));
+    }
+}
+
+/* Args: [object|all] [method|all] */
+static void handle_stats(const char* args) {
+    char object[128] = "all";
+    char method[64] = "all";
+    sscanf(args, "%127s %63s", object, method);
+    stats_dump(object, method, reply_line, NULL);
+}
+
+static void handle_reset_stats(UNUSED const char* args) {
+    stats_reset();
+}
+
+/* Args: <file> [scale], e.g., "/tmp/onu.trace 0.5" */
+static void handle_replay(const char* args) {
+    replay_start_from_string(args);
+}
+
+static void handle_stop_replay(UNUSED const char* args) {
+    replay_stop();
+}
+
 typedef struct _dbg_function {
     const char* name;
     handle_dbg_command_fn_t handler;
+    bool query; /* the client waits for a reply, ending with DBG_REPLY_END */
 } dbg_function_t;
 
 static const dbg_function_t DBG_FUNCTIONS[] = {
@@ -60,28 +168,54 @@ static const dbg_function_t DBG_FUNCTIONS[] = {
     { .name = REMOVE_INSTANCE, .handler = handle_remove_instance },
     { .name = CHANGE_TRANSCEIVER, .handler = handle_change_transceiver },
     { .name = CHANGE_ONU_ACTIVATION, .handler = handle_change_onu_activation },
-    { .name = OMCI_RESET_MIB, .handler = handle_omci_mib_reset  }
+    { .name = OMCI_RESET_MIB, .handler = handle_omci_mib_reset  },
+    { .name = SET_LATENCY, .handler = handle_set_latency },
+    { .name = CLEAR_LATENCY, .handler = handle_clear_latency },
+    { .name = SHOW_LATENCY, .handler = handle_show_latency },
+    { .name = STORM, .handler = handle_storm },
+    { .name = STOP_STORM, .handler = handle_stop_storm },
+    { .name = SET_FAULT, .handler = handle_set_fault },
+    { .name = CLEAR_FAULT, .handler = handle_clear_fault },
+    { .name = SHOW_FAULT, .handler = handle_show_fault },
+    { .name = DISAPPEAR, .handler = handle_disappear },
+    { .name = REAPPEAR, .handler = handle_reappear },
+    { .name = RESTART, .handler = handle_restart },
+    { .name = STATS, .handler = handle_stats, .query = true },
+    { .name = RESET_STATS, .handler = handle_reset_stats },
+    { .name = REPLAY, .handler = handle_replay },
+    { .name = STOP_REPLAY, .handler = handle_stop_replay }
 };
 
 static void dbg_if_handler(struct uloop_fd* u, UNUSED unsigned int events) {
     when_null_trace(u, exit, ERROR, "struct uloop_fd* param is NULL");
 
-    struct sockaddr_un cliaddr;
-    socklen_t len = sizeof(cliaddr);
-    char msg[MAX_MSG_SIZE];
-    memset(msg, 0, MAX_MSG_SIZE);
+    char msg[MAX_MSG_SIZE + 1];
+    memset(msg, 0, MAX_MSG_SIZE + 1);
 
-    if(recvfrom(u->fd, msg, MAX_MSG_SIZE, 0, (struct sockaddr*) &cliaddr, &len) == -1) {
+    s_client_len = sizeof(s_client);
+    if(recvfrom(u->fd, msg, MAX_MSG_SIZE, 0, (struct sockaddr*) &s_client, &s_client_len) == -1) {
         SAH_TRACE_ERROR("Failed to read data: %s", strerror(errno));
+        s_client_len = 0;
     } else {
         SAH_TRACE_INFO("msg='%s'", msg);
     }
+    msg[strcspn(msg, "\r\n")] = '\0';
+
     const size_t n_dbg_functions = ARRAY_SIZE(DBG_FUNCTIONS);
     size_t i;
     bool found = false;
     for(i = 0; i < n_dbg_functions; ++i) {
-        if(strncmp(msg, DBG_FUNCTIONS[i].name, strlen(DBG_FUNCTIONS[i].name)) == 0) {
-            DBG_FUNCTIONS[i].handler();
+        const size_t name_len = strlen(DBG_FUNCTIONS[i].name);
+        if((strncmp(msg, DBG_FUNCTIONS[i].name, name_len) == 0) &&
+           ((msg[name_len] == '\0') || (msg[name_len] == ' '))) {
+            const char* args = msg + name_len;
+            while(*args == ' ') {
+                ++args;
+            }
+            DBG_FUNCTIONS[i].handler(args);
+            if(DBG_FUNCTIONS[i].query) {
+                reply_line(DBG_REPLY_END, NULL);
+            }
             found = true;
             break;
         }
@@ -0,0 +1,231 @@
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * implicit declaration of function ‘random’
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "fault.h"
+
+#include <stdio.h>
+#include <stdlib.h> /* random() */
+#include <string.h>
+
+#include "onu_hal_macros.h"
+#include "onu_hal_trace.h"
+
+#define MAX_RULES 32
+#define MAX_NAME 128
+
+/* "all" as object or method matches any object or method */
+static const char ALL[] = "all";
+
+typedef struct _rule {
+    char object[MAX_NAME]; /* empty: any object */
+    char method[MAX_NAME]; /* empty: any method or notification */
+    fault_t fault;
+} rule_t;
+
+static rule_t s_rules[MAX_RULES];
+static uint32_t s_n_rules = 0;
+
+static const char* const TYPE_NAMES[] = { "none", "no_reply", "error", "late", "drop_notif" };
+
+/* Copy @a name to @a dest, or an empty string if @a name means 'any' */
+static void set_name(char* const dest, const char* const name) {
+    snprintf(dest, MAX_NAME, "%s", (name && strcmp(name, ALL)) ? name : "");
+}
+
+/**
+ * Set the fault for the requests for @a object and @a method, or for the
+ * notifications named @a method of @a object if the fault is drop_notif.
+ *
+ * @param[in] object  path of an object, or of the root of a subtree, e.g.,
+ *                    "xpon_onu.1.ani.1". "all" or NULL matches any object.
+ * @param[in] method  name of a method or a notification. "all" or NULL
+ *                    matches any method or notification.
+ * @param[in] fault   fault. fault_none removes the rule.
+ *
+ * @return true on success, false if there is no room for more rules
+ */
+bool fault_set_rule(const char* const object, const char* const method,
+                    const fault_t* const fault) {
+    char obj[MAX_NAME];
+    char meth[MAX_NAME];
+    const bool notif = (fault->type == fault_drop_notif);
+    uint32_t i;
+
+    set_name(obj, object);
+    set_name(meth, method);
+
+    /* Rules for requests and rules for notifications do not replace each other */
+    for(i = 0; i < s_n_rules; ++i) {
+        if((strcmp(s_rules[i].object, obj) == 0) && (strcmp(s_rules[i].method, meth) == 0) &&
+           ((s_rules[i].fault.type == fault_drop_notif) == notif)) {
+            break;
+        }
+    }
+    if(fault->type == fault_none) {
+        if(i < s_n_rules) {
+            s_rules[i] = s_rules[--s_n_rules];
+        }
+        return true;
+    }
+    if(i == s_n_rules) {
+        if(s_n_rules == MAX_RULES) {
+            SAH_TRACE_ERROR("Max nr of fault rules (%d) reached", MAX_RULES);
+            return false;
+        }
+        snprintf(s_rules[i].object, MAX_NAME, "%s", obj);
+        snprintf(s_rules[i].method, MAX_NAME, "%s", meth);
+        ++s_n_rules;
+    }
+    s_rules[i].fault = *fault;
+    return true;
+}
+
+/**
+ * Set a rule from a string '<object|all> <method|all> <fault> [arg] [percent]',
+ * e.g., "xpon_onu.1.ani.1 get error 9 10" or "all dm:object-changed
+ * drop_notif 50". The fault 'none' removes the rule.
+ *
+ * @return true on success
+ */
+bool fault_set_rule_from_string(const char* const args) {
+    char object[MAX_NAME];
+    char method[MAX_NAME];
+    char type[16];
+    int offset = 0;
+    unsigned int a = 0;
+    unsigned int b = 0;
+    fault_t fault = { .type = fault_none, .arg = 0, .percent = 100 };
+    uint32_t i;
+
+    if(sscanf(args, "%127s %127s %15s %n", object, method, type, &offset) < 3) {
+        goto error;
+    }
+    for(i = 0; i < ARRAY_SIZE(TYPE_NAMES); ++i) {
+        if(strcmp(type, TYPE_NAMES[i]) == 0) {
+            break;
+        }
+    }
+    if(i == ARRAY_SIZE(TYPE_NAMES)) {
+        goto error;
+    }
+    fault.type = (fault_type_t) i;
+
+    const int n = sscanf(args + offset, "%u %u", &a, &b);
+    if((fault.type == fault_error) || (fault.type == fault_late)) {
+        if(n < 1) {
+            goto error;
+        }
+        fault.arg = a;
+        if(n == 2) {
+            fault.percent = b;
+        }
+    } else if(n >= 1) {
+        fault.percent = a;
+    }
+    if((fault.percent == 0) || (fault.percent > 100)) {
+        goto error;
+    }
+    return fault_set_rule(object, method, &fault);
+
+error:
+    SAH_TRACE_ERROR("Invalid args '%s': expected <object> <method> <fault> [arg] [percent]", args);
+    return false;
+}
+
+void fault_clear_rules(void) {
+    s_n_rules = 0;
+}
+
+void fault_print_rules(void) {
+    uint32_t i;
+    if(s_n_rules == 0) {
+        SAH_TRACE_INFO("fault: none");
+    }
+    for(i = 0; i < s_n_rules; ++i) {
+        SAH_TRACE_INFO("fault: object=%s method=%s: %s %u (%u%%)",
+                       s_rules[i].object[0] ? s_rules[i].object : ALL,
+                       s_rules[i].method[0] ? s_rules[i].method : ALL,
+                       TYPE_NAMES[s_rules[i].fault.type], s_rules[i].fault.arg,
+                       s_rules[i].fault.percent);
+    }
+}
+
+/* True if @a object is @a prefix, or is in the subtree of @a prefix */
+static bool object_matches(const char* const object, const char* const prefix) {
+    const size_t len = strlen(prefix);
+    return (strncmp(object, prefix, len) == 0) &&
+           ((object[len] == '\0') || (object[len] == '.'));
+}
+
+/**
+ * Return the most specific rule for @a object and @a method, considering the
+ * rules for notifications if @a notif is true, else the rules for requests.
+ */
+static const rule_t* find_rule(const char* const object, const char* const method, bool notif) {
+    const rule_t* found = NULL;
+    int best = -1;
+    uint32_t i;
+
+    for(i = 0; i < s_n_rules; ++i) {
+        const rule_t* const rule = &s_rules[i];
+        int score = 0;
+        if((rule->fault.type == fault_drop_notif) != notif) {
+            continue;
+        }
+        if(rule->object[0]) {
+            if(!object_matches(object, rule->object)) {
+                continue;
+            }
+            /* A longer path is more specific */
+            score += 2 * MAX_NAME + (int) strlen(rule->object);
+        }
+        if(rule->method[0]) {
+            if(strcmp(method, rule->method) != 0) {
+                continue;
+            }
+            score += 1;
+        }
+        if(score > best) {
+            best = score;
+            found = rule;
+        }
+    }
+    return found;
+}
+
+static bool applies(const fault_t* const fault) {
+    return (fault->percent >= 100) || ((uint32_t) (random() % 100) < fault->percent);
+}
+
+/**
+ * Return the fault to inject for a call of @a method on @a object, or a fault
+ * of type fault_none.
+ */
+fault_t fault_get_for_request(const char* const object, const char* const method) {
+    const fault_t none = { .type = fault_none, .arg = 0, .percent = 100 };
+    const rule_t* const rule = find_rule(object, method, false);
+
+    if(rule && applies(&rule->fault)) {
+        SAH_TRACE_INFO("%s.%s(): inject fault %s", object, method, TYPE_NAMES[rule->fault.type]);
+        return rule->fault;
+    }
+    return none;
+}
+
+/**
+ * Return true if the mock must not send @a notification for @a object.
+ */
+bool fault_drop_notification(const char* const object, const char* const notification) {
+    const rule_t* const rule = find_rule(object, notification, true);
+
+    if(rule && applies(&rule->fault)) {
+        SAH_TRACE_INFO("%s: drop %s", object, notification);
+        return true;
+    }
+    return false;
+}
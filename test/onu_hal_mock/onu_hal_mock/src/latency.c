@@ -0,0 +1,243 @@
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * implicit declaration of function ‘random’
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "latency.h"
+
+#include <math.h>   /* exp(), log(), sqrt() */
+#include <stdio.h>
+#include <stdlib.h> /* random() */
+#include <string.h>
+
+#include "onu_hal_macros.h"
+#include "onu_hal_trace.h"
+
+#define MAX_RULES 32
+#define MAX_NAME 128
+
+/* z-score of the 99th percentile of the standard normal distribution */
+#define Z_99 2.326
+
+/* Upper bound of a delay: longer delays only make sense as a fault */
+#define MAX_DELAY_MS 600000.0
+
+/* "all" as object or method matches any object or method */
+static const char ALL[] = "all";
+
+typedef struct _rule {
+    char object[MAX_NAME]; /* empty: any object */
+    char method[MAX_NAME]; /* empty: any method */
+    latency_dist_t dist;
+} rule_t;
+
+static rule_t s_rules[MAX_RULES];
+static uint32_t s_n_rules = 0;
+static latency_dist_t s_default = { .type = latency_fixed, .a = 100.0, .b = 0.0 };
+
+static const char* const TYPE_NAMES[] = { "immediate", "fixed", "uniform", "longtail" };
+
+/**
+ * Parse a distribution, e.g., "uniform 5 50".
+ *
+ * @return true on success
+ */
+bool latency_parse_dist(const char* const spec, latency_dist_t* const dist) {
+    char type[16];
+    double a = 0.0;
+    double b = 0.0;
+    const int n = sscanf(spec, "%15s %lf %lf", type, &a, &b);
+
+    if(n < 1) {
+        goto error;
+    }
+    if((strcmp(type, "immediate") == 0) && (n == 1)) {
+        dist->type = latency_immediate;
+    } else if((strcmp(type, "fixed") == 0) && (n == 2) && (a >= 0.0)) {
+        dist->type = latency_fixed;
+    } else if((strcmp(type, "uniform") == 0) && (n == 3) && (a >= 0.0) && (b >= a)) {
+        dist->type = latency_uniform;
+    } else if((strcmp(type, "longtail") == 0) && (n == 3) && (a > 0.0) && (b >= a)) {
+        dist->type = latency_longtail;
+    } else {
+        goto error;
+    }
+    dist->a = a;
+    dist->b = b;
+    return true;
+
+error:
+    SAH_TRACE_ERROR("Invalid latency distribution '%s'", spec);
+    return false;
+}
+
+/* Copy @a name to @a dest, or an empty string if @a name means 'any' */
+static void set_name(char* const dest, const char* const name) {
+    snprintf(dest, MAX_NAME, "%s", (name && strcmp(name, ALL)) ? name : "");
+}
+
+/**
+ * Set the distribution for the requests for @a object and @a method.
+ *
+ * @param[in] object  path of an object, or of the root of a subtree, e.g.,
+ *                    "xpon_onu.1.ani.1". "all" or NULL matches any object.
+ * @param[in] method  name of a method, e.g., "get". "all" or NULL matches any
+ *                    method.
+ * @param[in] dist    distribution
+ *
+ * If object and method are both "all", the function sets the default.
+ *
+ * @return true on success, false if there is no room for more rules
+ */
+bool latency_set_rule(const char* const object, const char* const method,
+                      const latency_dist_t* const dist) {
+    char obj[MAX_NAME];
+    char meth[MAX_NAME];
+    uint32_t i;
+
+    set_name(obj, object);
+    set_name(meth, method);
+
+    if((obj[0] == '\0') && (meth[0] == '\0')) {
+        s_default = *dist;
+        return true;
+    }
+    for(i = 0; i < s_n_rules; ++i) {
+        if((strcmp(s_rules[i].object, obj) == 0) && (strcmp(s_rules[i].method, meth) == 0)) {
+            s_rules[i].dist = *dist;
+            return true;
+        }
+    }
+    if(s_n_rules == MAX_RULES) {
+        SAH_TRACE_ERROR("Max nr of latency rules (%d) reached", MAX_RULES);
+        return false;
+    }
+    snprintf(s_rules[s_n_rules].object, MAX_NAME, "%s", obj);
+    snprintf(s_rules[s_n_rules].method, MAX_NAME, "%s", meth);
+    s_rules[s_n_rules].dist = *dist;
+    ++s_n_rules;
+    return true;
+}
+
+/**
+ * Set a rule from a string '<object|all> <method|all> <distribution>', e.g.,
+ * "xpon_onu.1.ani.1 get uniform 5 50".
+ *
+ * @return true on success
+ */
+bool latency_set_rule_from_string(const char* const args) {
+    char object[MAX_NAME];
+    char method[MAX_NAME];
+    int offset = 0;
+    latency_dist_t dist;
+
+    if(sscanf(args, "%127s %127s %n", object, method, &offset) < 2) {
+        SAH_TRACE_ERROR("Invalid args '%s': expected <object> <method> <distribution>", args);
+        return false;
+    }
+    if(!latency_parse_dist(args + offset, &dist)) {
+        return false;
+    }
+    return latency_set_rule(object, method, &dist);
+}
+
+void latency_clear_rules(void) {
+    s_n_rules = 0;
+    s_default.type = latency_fixed;
+    s_default.a = 100.0;
+    s_default.b = 0.0;
+}
+
+static void print_dist(const char* const object, const char* const method,
+                       const latency_dist_t* const dist) {
+    SAH_TRACE_INFO("latency: object=%s method=%s: %s %.1f %.1f", object, method,
+                   TYPE_NAMES[dist->type], dist->a, dist->b);
+}
+
+void latency_print_rules(void) {
+    uint32_t i;
+    print_dist(ALL, ALL, &s_default);
+    for(i = 0; i < s_n_rules; ++i) {
+        print_dist(s_rules[i].object[0] ? s_rules[i].object : ALL,
+                   s_rules[i].method[0] ? s_rules[i].method : ALL, &s_rules[i].dist);
+    }
+}
+
+/* True if @a object is @a prefix, or is in the subtree of @a prefix */
+static bool object_matches(const char* const object, const char* const prefix) {
+    const size_t len = strlen(prefix);
+    return (strncmp(object, prefix, len) == 0) &&
+           ((object[len] == '\0') || (object[len] == '.'));
+}
+
+static const latency_dist_t* find_dist(const char* const object, const char* const method) {
+    const latency_dist_t* dist = &s_default;
+    int best = 0;
+    uint32_t i;
+
+    for(i = 0; i < s_n_rules; ++i) {
+        const rule_t* const rule = &s_rules[i];
+        int score = 0;
+        if(rule->object[0]) {
+            if(!object_matches(object, rule->object)) {
+                continue;
+            }
+            /* A longer path is more specific */
+            score += 2 * MAX_NAME + (int) strlen(rule->object);
+        }
+        if(rule->method[0]) {
+            if(strcmp(method, rule->method) != 0) {
+                continue;
+            }
+            score += 1;
+        }
+        if(score >= best) {
+            best = score;
+            dist = &rule->dist;
+        }
+    }
+    return dist;
+}
+
+/* Uniform random value in (0, 1) */
+static double random_unit(void) {
+    return ((double) random() + 1.0) / ((double) RAND_MAX + 2.0);
+}
+
+/**
+ * Return the delay to reply to a call of @a method on @a object.
+ *
+ * @return delay in ms, or -1 to reply immediately from the method handler
+ */
+int latency_get_delay_ms(const char* const object, const char* const method) {
+    const latency_dist_t* const dist = find_dist(object, method);
+    double delay = 0.0;
+
+    switch(dist->type) {
+    case latency_immediate:
+        return -1;
+    case latency_fixed:
+        delay = dist->a;
+        break;
+    case latency_uniform:
+        delay = dist->a + (dist->b - dist->a) * random_unit();
+        break;
+    case latency_longtail:
+    {
+        /* Box-Muller: standard normal sample */
+        const double z = sqrt(-2.0 * log(random_unit())) * cos(2.0 * M_PI * random_unit());
+        const double sigma = log(dist->b / dist->a) / Z_99;
+        delay = dist->a * exp(sigma * z);
+        break;
+    }
+    default:
+        break;
+    }
+    if(delay > MAX_DELAY_MS) {
+        delay = MAX_DELAY_MS;
+    }
+    return (int) (delay + 0.5);
+}
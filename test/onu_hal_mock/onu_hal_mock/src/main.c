@@ -1,26 +1,115 @@
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * implicit declaration of function ‘getopt’
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <signal.h>
 #include <stdio.h>
-#include <stdlib.h>  /* atoi() */
+#include <stdlib.h>
 #include <libubus.h> /* ubus_connect() */
-#include <unistd.h>  /* access() */
+#include <unistd.h>  /* access(), getopt() */
 
 #include "dbg_if.h"
 #include "data_model.h"
+#include "latency.h"
 #include "notif.h"
 #include "onu_hal_macros.h"
 #include "onu_hal_trace.h"
+#include "replay.h"
+#include "stats.h"
+#include "storm.h"
+#include "topology.h"
 
 static const char* s_ubus_socket_path = "/var/run/ubus/ubus.sock";
 
 static struct ubus_context* s_ctx = NULL;
 
 static void usage(const char* prog) {
-    printf("%s -h      : show this help and exit\n", prog);
-    printf("%s         : start process with ONU nr = 1\n", prog);
-    printf("%s onu_nr  : start process with ONU nr = onu_nr (must be 1 or 2)\n", prog);
+    printf("%s -h                  : show this help and exit\n", prog);
+    printf("%s [options]           : start process with ONU nr = 1\n", prog);
+    printf("%s [options] onu_nr    : start process with first ONU nr = onu_nr\n", prog);
+    printf("\n");
+    printf("Options to build the object tree:\n");
+    printf("  -c <file>            : load the topology from <file>, with one\n");
+    printf("                         'key = value' per line. The keys are:\n");
+    printf("                         first_onu, onus, anis, gem_ports,\n");
+    printf("                         ethernet_unis, software_images, transceivers\n");
+    printf("  -n <nr>              : nr of ONUs (default: 1)\n");
+    printf("  -a <nr>              : nr of ANIs per ONU (default: 1)\n");
+    printf("  -g <nr>              : nr of GEM ports per ANI (default: 1)\n");
+    printf("  -u <nr>              : nr of Ethernet UNIs per ONU (default: 1)\n");
+    printf("  -s <nr>              : nr of software images per ONU (default: 2)\n");
+    printf("  -t <nr>              : nr of transceivers per ANI (default: 1)\n");
+    printf("Options on the command line override the values in the file.\n");
+    printf("\n");
+    printf("Other options:\n");
+    printf("  -l <distribution>    : default response latency (default: 'fixed 100').\n");
+    printf("                         One of: 'immediate', 'fixed <ms>',\n");
+    printf("                         'uniform <min_ms> <max_ms>',\n");
+    printf("                         'longtail <median_ms> <p99_ms>'\n");
     printf("\n");
     printf("Examples:\n");
-    printf("%s 2       : advertise xpon_onu.2 on ubus\n", prog);
+    printf("%s 2                   : advertise xpon_onu.2 on ubus\n", prog);
+    printf("%s -n 4 -g 1000        : advertise xpon_onu.1 up to xpon_onu.4, each\n", prog);
+    printf("                         with 1000 GEM ports\n");
+    printf("%s -l immediate        : reply to each request without delay\n", prog);
+}
+
+/**
+ * Build the topology from the command line.
+ *
+ * @return 0 on success, 1 on error, -1 if the process must exit with rc=0
+ */
+static int parse_args(int argc, char* argv[], topology_t* const topology) {
+    static const char* const KEYS[] = {
+        ['n'] = "onus", ['a'] = "anis", ['g'] = "gem_ports",
+        ['u'] = "ethernet_unis", ['s'] = "software_images", ['t'] = "transceivers"
+    };
+    const char* config_file = NULL;
+    int c;
+
+    topology_init(topology);
+
+    /* First pass: load the file, so that the other options override it */
+    while((c = getopt(argc, argv, "hc:l:n:a:g:u:s:t:")) != -1) {
+        if(c == 'h') {
+            usage(argv[0]);
+            return -1;
+        } else if(c == 'c') {
+            config_file = optarg;
+        } else if(c == 'l') {
+            latency_dist_t dist;
+            if(!latency_parse_dist(optarg, &dist) ||
+               !latency_set_rule(NULL, NULL, &dist)) {
+                return 1;
+            }
+        } else if(c == '?') {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(config_file && !topology_load_file(topology, config_file)) {
+        return 1;
+    }
+
+    optind = 1;
+    while((c = getopt(argc, argv, "hc:l:n:a:g:u:s:t:")) != -1) {
+        if((c >= 0) && (c < (int) ARRAY_SIZE(KEYS)) && KEYS[c]) {
+            if(!topology_set(topology, KEYS[c], optarg)) {
+                return 1;
+            }
+        }
+    }
+    if(optind < argc) {
+        if(!topology_set(topology, "first_onu", argv[optind])) {
+            return 1;
+        }
+    }
+
+    return topology_is_valid(topology) ? 0 : 1;
 }
 
 static struct ubus_context* connect_to_ubus(void) {
@@ -43,22 +132,14 @@ static struct ubus_context* connect_to_ubus(void) {
 
 int main(int argc, char* argv[]) {
 
-    int onu_nr = 1;
-    if(argc == 2) {
-        const char* option_one = argv[1];
-        if(strncmp(option_one, "-h", 2) == 0) {
-            usage(argv[0]);
-            return 0;
-        } else {
-            onu_nr = atoi(option_one);
-            if((onu_nr < 1) || (onu_nr > 2)) {
-                printf("Error: invalid ONU nr: %d is not in [1, 2]\n", onu_nr);
-                return 1;
-            }
-        }
+    topology_t topology;
+    const int rc = parse_args(argc, argv, &topology);
+    if(rc != 0) {
+        return (rc < 0) ? 0 : 1;
     }
 
-    SAH_TRACE_INFO("Starting %s with onu_nr=%d", argv[0], onu_nr);
+    SAH_TRACE_INFO("Starting %s with first onu_nr=%u", argv[0], topology.first_onu);
+    topology_print(&topology);
 
     s_ctx = connect_to_ubus();
     if(!s_ctx) {
@@ -68,7 +149,7 @@ int main(int argc, char* argv[]) {
 
     dbg_if_init();
 
-    if(dm_init(s_ctx, onu_nr)) {
+    if(dm_init(s_ctx, &topology)) {
         return 1;
     }
 
@@ -82,8 +163,11 @@ int main(int argc, char* argv[]) {
     uloop_run();
 
     SAH_TRACE_INFO("Stopping");
+    storm_stop();
+    replay_cleanup();
     dbg_if_cleanup();
     dm_cleanup();
+    stats_cleanup();
 
     ubus_free(s_ctx);
     uloop_done();
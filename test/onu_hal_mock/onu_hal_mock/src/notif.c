@@ -3,6 +3,7 @@
 #include <stdio.h>
 
 #include "data_model.h" /* dm_get_xpon_onu_object() */
+#include "fault.h"      /* fault_drop_notification() */
 #include "onu_hal_trace.h"
 
 struct ubus_context* s_ctx = NULL;
@@ -53,7 +54,7 @@ static void send_notif_common(notif_test_case_t notif) {
     case notif_test_dm_instance_removed:
         snprintf(path, 128, "%s.ani.1.transceiver", obj->name);
         blobmsg_add_string(&b, "path", path);
-        blobmsg_add_u32(&b, "index", 2);
+        blobmsg_add_u32(&b, "index", dm_get_extra_transceiver_index());
         msg = b.head;
         break;
 
@@ -70,13 +71,16 @@ static void send_notif_common(notif_test_case_t notif) {
         break;
 
     case notif_test_omci_reset_mib:
-        /* Nothing to do */
+        snprintf(path, 128, "%s", obj->name);
         break;
 
     default:
         break;
     }
 
+    if(obj->hidden || fault_drop_notification(path, notification)) {
+        goto exit;
+    }
     const int rc = ubus_notify(s_ctx, &obj->ubus_obj, notification, msg, -1);
     if(rc) {
         SAH_TRACE_ERROR("ubus_notify() failed: rc=%d", rc);
@@ -86,11 +90,61 @@ exit:
     return;
 }
 
-void notif_send_dm_instance_added_for_transceiver_two(void) {
+/**
+ * Send @a notification about @a path from @a onu, unless the ONU is hidden or
+ * a fault rule drops the notification.
+ */
+static void send_notif(object_wrapper_t* const onu, const char* notification,
+                       const char* path, struct blob_attr* msg) {
+    if(onu->hidden || fault_drop_notification(path, notification)) {
+        return;
+    }
+    const int rc = ubus_notify(s_ctx, &onu->ubus_obj, notification, msg, -1);
+    if(rc) {
+        SAH_TRACE_ERROR("ubus_notify() failed: rc=%d", rc);
+    }
+}
+
+/**
+ * Send dm:object-changed for @a obj from the xpon_onu object @a onu.
+ */
+void notif_send_dm_object_changed(object_wrapper_t* const onu,
+                                  const object_wrapper_t* const obj) {
+    when_null_trace(s_ctx, exit, ERROR, "ctx is NULL");
+    when_null_trace(onu, exit, ERROR, "onu is NULL");
+    when_null_trace(obj, exit, ERROR, "obj is NULL");
+
+    blob_buf_init(&b, 0);
+    blobmsg_add_string(&b, "path", obj->name);
+    send_notif(onu, "dm:object-changed", obj->name, b.head);
+
+exit:
+    return;
+}
+
+/**
+ * Send dm:instance-added or dm:instance-removed from the xpon_onu object
+ * @a onu for instance @a index of the template object @a template_path.
+ */
+void notif_send_dm_instance(object_wrapper_t* const onu, bool added,
+                            const char* template_path, uint32_t index) {
+    when_null_trace(s_ctx, exit, ERROR, "ctx is NULL");
+    when_null_trace(onu, exit, ERROR, "onu is NULL");
+
+    blob_buf_init(&b, 0);
+    blobmsg_add_string(&b, "path", template_path);
+    blobmsg_add_u32(&b, "index", index);
+    send_notif(onu, added ? "dm:instance-added" : "dm:instance-removed", template_path, b.head);
+
+exit:
+    return;
+}
+
+void notif_send_dm_instance_added_for_extra_transceiver(void) {
     send_notif_common(notif_test_dm_instance_added);
 }
 
-void notif_send_dm_instance_removed_for_transceiver_two(void) {
+void notif_send_dm_instance_removed_for_extra_transceiver(void) {
     send_notif_common(notif_test_dm_instance_removed);
 }
 
@@ -106,3 +160,18 @@ void notif_send_omci_reset_mib(void) {
     send_notif_common(notif_test_omci_reset_mib);
 }
 
+
+/**
+ * Send @a notification with the message @a msg from the xpon_onu object
+ * @a onu. @a path is the object the notification is about.
+ */
+void notif_send_msg(object_wrapper_t* const onu, const char* notification,
+                    const char* path, struct blob_attr* msg) {
+    when_null_trace(s_ctx, exit, ERROR, "ctx is NULL");
+    when_null_trace(onu, exit, ERROR, "onu is NULL");
+
+    send_notif(onu, notification, path, msg);
+
+exit:
+    return;
+}
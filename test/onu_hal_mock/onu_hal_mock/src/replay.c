@@ -0,0 +1,586 @@
+/**
+ * Define _GNU_SOURCE to avoid following error:
+ * implicit declaration of function ‘getline’
+ */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "replay.h"
+
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>
+#include <stdlib.h>   /* strtoull(), qsort() */
+#include <string.h>
+#include <time.h>     /* clock_gettime() */
+
+#include "data_model.h" /* dm_find_object() */
+#include "notif.h"      /* notif_send_msg() */
+#include "onu_hal_macros.h"
+#include "onu_hal_trace.h"
+
+#define MAX_TAB_FIELDS 8
+
+/* Upper bound of a delay, as for the latency */
+#define MAX_DELAY_MS 600000.0
+
+static const char DM_INSTANCE_ADDED[] = "dm:instance-added";
+static const char DM_INSTANCE_REMOVED[] = "dm:instance-removed";
+
+/* A call in the trace file */
+struct _replay_call {
+    uint64_t t_us;
+    uint64_t duration_us;
+    int rc;
+    char* object;
+    char* method;
+    char* names;  /* 'names' argument of get_params(), or "" */
+    char* reply;  /* encoded reply */
+};
+
+/* Calls with the same object, method and names: s_sorted[first] up to s_sorted[first + n - 1] */
+typedef struct _replay_key {
+    uint32_t first;
+    uint32_t n;
+    uint32_t cursor; /* next call to serve */
+} replay_key_t;
+
+/* A notification in the trace file */
+typedef struct _replay_notif {
+    uint64_t t_us;
+    uint32_t onu_index;
+    char* name;
+    char* data;  /* encoded data */
+} replay_notif_t;
+
+enum {
+    NOTIF_PATH,
+    NOTIF_INDEX,
+    NOTIF_MAX
+};
+
+static const struct blobmsg_policy NOTIF_POLICY[] = {
+    [NOTIF_PATH] = { .name = "path", .type = BLOBMSG_TYPE_STRING },
+    [NOTIF_INDEX] = { .name = "index", .type = BLOBMSG_TYPE_INT32 }
+};
+
+static replay_call_t* s_calls = NULL;
+static uint32_t s_n_calls = 0;
+static uint32_t s_calls_capacity = 0;
+static replay_call_t** s_sorted = NULL;
+static replay_key_t* s_keys = NULL;
+static uint32_t s_n_keys = 0;
+
+static replay_notif_t* s_notifs = NULL;
+static uint32_t s_n_notifs = 0;
+static uint32_t s_notifs_capacity = 0;
+static uint32_t s_next_notif = 0;
+
+static bool s_active = false;
+static double s_scale = 1.0;
+static uint64_t s_start_us = 0;
+static uint32_t s_generation = 0;
+static uint64_t s_hits = 0;
+static uint64_t s_misses = 0;
+static struct uloop_timeout s_timer;
+static struct blob_buf s_buf;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+/* Make room for one more element in the array @a array */
+static bool grow(void** array, uint32_t n, uint32_t* capacity, size_t elem_size) {
+    if(n < *capacity) {
+        return true;
+    }
+    const uint32_t new_capacity = *capacity ? (2 * *capacity) : 256;
+    void* const new_array = realloc(*array, new_capacity * elem_size);
+    when_null_trace(new_array, error, ERROR, "Failed to allocate mem for %u elements", new_capacity);
+    *array = new_array;
+    *capacity = new_capacity;
+    return true;
+
+error:
+    return false;
+}
+
+static int hex_value(char c) {
+    if((c >= '0') && (c <= '9')) {
+        return c - '0';
+    }
+    if((c >= 'A') && (c <= 'F')) {
+        return c - 'A' + 10;
+    }
+    if((c >= 'a') && (c <= 'f')) {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* Percent-decode @a str in place */
+static void decode(char* str) {
+    char* out = str;
+    for(; *str; ++str) {
+        const int hi = (*str == '%') ? hex_value(str[1]) : -1;
+        const int lo = (hi >= 0) ? hex_value(str[2]) : -1;
+        if(lo >= 0) {
+            *out++ = (char) ((hi << 4) | lo);
+            str += 2;
+        } else {
+            *out++ = *str;
+        }
+    }
+    *out = '\0';
+}
+
+/**
+ * Take the next 'key:type:value' item of an encoded list. The function
+ * modifies the list in place and advances @a list.
+ *
+ * @return true if it found an item
+ */
+static bool next_item(char** list, char** key, char* type, char** value) {
+    char* const item = *list;
+    if((NULL == item) || (*item == '\0') || (strcmp(item, "-") == 0)) {
+        return false;
+    }
+    char* const comma = strchr(item, ',');
+    if(comma) {
+        *comma = '\0';
+    }
+    *list = comma ? comma + 1 : NULL;
+
+    char* const colon = strchr(item, ':');
+    if((NULL == colon) || (colon[1] == '\0') || (colon[2] != ':')) {
+        SAH_TRACE_ERROR("Invalid item '%s'", item);
+        return false;
+    }
+    *colon = '\0';
+    *key = item;
+    *type = colon[1];
+    *value = colon + 3;
+    decode(*key);
+    decode(*value);
+    return true;
+}
+
+/* Add the items of the encoded list @a encoded to @a buf */
+static void add_items(const char* const encoded, struct blob_buf* const buf) {
+    char* const copy = strdup(encoded);
+    char* list = copy;
+    char* key = NULL;
+    char* value = NULL;
+    char type = 0;
+
+    when_null_trace(copy, exit, ERROR, "Failed to allocate mem");
+    while(next_item(&list, &key, &type, &value)) {
+        switch(type) {
+        case 'b':
+            blobmsg_add_u8(buf, key, strtoul(value, NULL, 10) ? 1 : 0);
+            break;
+        case 'i':
+        {
+            const long long n = strtoll(value, NULL, 10);
+            if((n >= INT32_MIN) && (n <= INT32_MAX)) {
+                blobmsg_add_u32(buf, key, (uint32_t) (int32_t) n);
+            } else {
+                blobmsg_add_u64(buf, key, (uint64_t) n);
+            }
+            break;
+        }
+        case 'u':
+        {
+            const unsigned long long n = strtoull(value, NULL, 10);
+            if(n <= UINT32_MAX) {
+                blobmsg_add_u32(buf, key, (uint32_t) n);
+            } else {
+                blobmsg_add_u64(buf, key, (uint64_t) n);
+            }
+            break;
+        }
+        default:
+            blobmsg_add_string(buf, key, value);
+            break;
+        }
+    }
+
+exit:
+    free(copy);
+}
+
+/* Return a copy of the value of @a wanted in the encoded list @a encoded, or "" */
+static char* find_value(const char* const encoded, const char* const wanted) {
+    char* const copy = strdup(encoded);
+    char* list = copy;
+    char* key = NULL;
+    char* value = NULL;
+    char type = 0;
+    char* found = NULL;
+
+    when_null_trace(copy, exit, ERROR, "Failed to allocate mem");
+    while(next_item(&list, &key, &type, &value)) {
+        if(strcmp(key, wanted) == 0) {
+            found = strdup(value);
+            break;
+        }
+    }
+
+exit:
+    free(copy);
+    return found ? found : strdup("");
+}
+
+static bool add_call(char* fields[], uint32_t n_fields) {
+    if((n_fields != 8) || !grow((void**) &s_calls, s_n_calls, &s_calls_capacity, sizeof(replay_call_t))) {
+        return false;
+    }
+    replay_call_t* const call = &s_calls[s_n_calls];
+    call->t_us = strtoull(fields[1], NULL, 10);
+    call->duration_us = strtoull(fields[2], NULL, 10);
+    call->rc = (int) strtol(fields[3], NULL, 10);
+    call->object = strdup(fields[4]);
+    call->method = strdup(fields[5]);
+    call->names = find_value(fields[6], "names");
+    call->reply = strdup(fields[7]);
+    ++s_n_calls;
+    return (call->object && call->method && call->names && call->reply);
+}
+
+static bool add_notif(char* fields[], uint32_t n_fields) {
+    if((n_fields != 5) || !grow((void**) &s_notifs, s_n_notifs, &s_notifs_capacity, sizeof(replay_notif_t))) {
+        return false;
+    }
+    replay_notif_t* const notif = &s_notifs[s_n_notifs];
+    notif->t_us = strtoull(fields[1], NULL, 10);
+    notif->onu_index = (uint32_t) strtoul(fields[2], NULL, 10);
+    notif->name = strdup(fields[3]);
+    notif->data = strdup(fields[4]);
+    ++s_n_notifs;
+    return (notif->name && notif->data);
+}
+
+static int compare_calls(const void* a, const void* b) {
+    const replay_call_t* const call_a = *(const replay_call_t* const*) a;
+    const replay_call_t* const call_b = *(const replay_call_t* const*) b;
+    int rc = strcmp(call_a->object, call_b->object);
+    if(rc == 0) {
+        rc = strcmp(call_a->method, call_b->method);
+    }
+    if(rc == 0) {
+        rc = strcmp(call_a->names, call_b->names);
+    }
+    if(rc == 0) {
+        /* Keep the recorded order */
+        rc = (call_a < call_b) ? -1 : ((call_a > call_b) ? 1 : 0);
+    }
+    return rc;
+}
+
+/* Sort the calls and group them per object, method and names */
+static bool build_keys(void) {
+    uint32_t i;
+
+    if(s_n_calls == 0) {
+        return true;
+    }
+    s_sorted = (replay_call_t**) calloc(s_n_calls, sizeof(replay_call_t*));
+    s_keys = (replay_key_t*) calloc(s_n_calls, sizeof(replay_key_t));
+    when_null_trace(s_sorted, error, ERROR, "Failed to allocate mem");
+    when_null_trace(s_keys, error, ERROR, "Failed to allocate mem");
+
+    for(i = 0; i < s_n_calls; ++i) {
+        s_sorted[i] = &s_calls[i];
+    }
+    qsort(s_sorted, s_n_calls, sizeof(replay_call_t*), compare_calls);
+
+    for(i = 0; i < s_n_calls; ++i) {
+        const replay_call_t* const call = s_sorted[i];
+        const replay_call_t* const prev = (i > 0) ? s_sorted[i - 1] : NULL;
+        if(!prev || strcmp(call->object, prev->object) || strcmp(call->method, prev->method) ||
+           strcmp(call->names, prev->names)) {
+            s_keys[s_n_keys].first = i;
+            ++s_n_keys;
+        }
+        ++s_keys[s_n_keys - 1].n;
+    }
+    return true;
+
+error:
+    return false;
+}
+
+static void free_data(void) {
+    uint32_t i;
+    for(i = 0; i < s_n_calls; ++i) {
+        free(s_calls[i].object);
+        free(s_calls[i].method);
+        free(s_calls[i].names);
+        free(s_calls[i].reply);
+    }
+    for(i = 0; i < s_n_notifs; ++i) {
+        free(s_notifs[i].name);
+        free(s_notifs[i].data);
+    }
+    free(s_calls);
+    free(s_sorted);
+    free(s_keys);
+    free(s_notifs);
+    s_calls = NULL;
+    s_sorted = NULL;
+    s_keys = NULL;
+    s_notifs = NULL;
+    s_n_calls = 0;
+    s_calls_capacity = 0;
+    s_n_keys = 0;
+    s_n_notifs = 0;
+    s_notifs_capacity = 0;
+}
+
+static bool load(const char* const file) {
+    bool rv = false;
+    char* line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    uint32_t line_nr = 0;
+
+    FILE* const fp = fopen(file, "r");
+    when_null_trace(fp, exit, ERROR, "Failed to open %s", file);
+
+    while((len = getline(&line, &size, fp)) != -1) {
+        char* fields[MAX_TAB_FIELDS];
+        uint32_t n_fields = 0;
+        char* saveptr = NULL;
+        char* field;
+
+        ++line_nr;
+        line[strcspn(line, "\r\n")] = '\0';
+        if((line[0] == '#') || (line[0] == '\0')) {
+            continue;
+        }
+        for(field = strtok_r(line, "\t", &saveptr); field && (n_fields < MAX_TAB_FIELDS);
+            field = strtok_r(NULL, "\t", &saveptr)) {
+            fields[n_fields++] = field;
+        }
+        bool ok = false;
+        if((n_fields > 0) && (strcmp(fields[0], "C") == 0)) {
+            ok = add_call(fields, n_fields);
+        } else if((n_fields > 0) && (strcmp(fields[0], "N") == 0)) {
+            ok = add_notif(fields, n_fields);
+        }
+        if(!ok) {
+            SAH_TRACE_ERROR("%s:%u: invalid record", file, line_nr);
+            goto exit;
+        }
+    }
+    rv = build_keys();
+    SAH_TRACE_INFO("replay: loaded %u calls (%u keys) and %u notifications from %s",
+                   s_n_calls, s_n_keys, s_n_notifs, file);
+
+exit:
+    free(line);
+    if(fp) {
+        fclose(fp);
+    }
+    return rv;
+}
+
+/* Emit a recorded notification, adding or removing the instance first */
+static void emit_notif(const replay_notif_t* const notif) {
+    char onu_name[32];
+    char instance[256];
+    struct blob_attr* tb[NOTIF_MAX];
+
+    snprintf(onu_name, sizeof(onu_name), "xpon_onu.%u", notif->onu_index);
+    object_wrapper_t* const onu = dm_find_object(onu_name);
+    if(!onu) {
+        SAH_TRACE_NOTICE("replay: %s does not exist: skip %s", onu_name, notif->name);
+        return;
+    }
+
+    blob_buf_init(&s_buf, 0);
+    add_items(notif->data, &s_buf);
+    blobmsg_parse(NOTIF_POLICY, NOTIF_MAX, tb, blob_data(s_buf.head), blob_len(s_buf.head));
+    const char* const path = tb[NOTIF_PATH] ? blobmsg_get_string(tb[NOTIF_PATH]) : onu_name;
+
+    if(tb[NOTIF_PATH] && tb[NOTIF_INDEX]) {
+        snprintf(instance, sizeof(instance), "%s.%u", path, blobmsg_get_u32(tb[NOTIF_INDEX]));
+        if(strcmp(notif->name, DM_INSTANCE_ADDED) == 0) {
+            dm_register_instance(instance);
+        } else if(strcmp(notif->name, DM_INSTANCE_REMOVED) == 0) {
+            dm_unregister_instance(instance);
+        }
+    }
+    notif_send_msg(onu, notif->name, path, s_buf.head);
+}
+
+static uint64_t scaled_us(uint64_t t_us) {
+    return (uint64_t) ((double) t_us * s_scale);
+}
+
+static void replay_tick(struct uloop_timeout* t) {
+    const uint64_t elapsed_us = now_us() - s_start_us;
+
+    while(s_next_notif < s_n_notifs) {
+        const uint64_t due_us = scaled_us(s_notifs[s_next_notif].t_us);
+        if(due_us > elapsed_us) {
+            uloop_timeout_set(t, (int) ((due_us - elapsed_us + 999) / 1000));
+            return;
+        }
+        emit_notif(&s_notifs[s_next_notif]);
+        ++s_next_notif;
+    }
+    SAH_TRACE_INFO("replay: sent all %u notifications", s_n_notifs);
+}
+
+/**
+ * Start replaying @a file. A running replay stops first.
+ *
+ * @param[in] file   trace file
+ * @param[in] scale  factor for the recorded durations and times, e.g., 0.5
+ *                   to replay twice as fast. 0: as fast as possible.
+ *
+ * @return true on success
+ */
+bool replay_start(const char* const file, double scale) {
+    if(scale < 0.0) {
+        SAH_TRACE_ERROR("Invalid scale %f", scale);
+        return false;
+    }
+    replay_stop();
+    free_data();
+    ++s_generation;
+    if(!load(file)) {
+        free_data();
+        return false;
+    }
+
+    s_active = true;
+    s_scale = scale;
+    s_hits = 0;
+    s_misses = 0;
+    s_next_notif = 0;
+    s_start_us = now_us();
+    s_timer.cb = replay_tick;
+    uloop_timeout_set(&s_timer, 0);
+    return true;
+}
+
+/**
+ * Start replaying from a debug command: "<file> [scale]", e.g.,
+ * "/tmp/onu.trace 0.5".
+ *
+ * @return true on success
+ */
+bool replay_start_from_string(const char* const args) {
+    char file[128];
+    double scale = 1.0;
+
+    if(sscanf(args, "%127s %lf", file, &scale) < 1) {
+        SAH_TRACE_ERROR("Invalid args '%s': expected <file> [scale]", args);
+        return false;
+    }
+    return replay_start(file, scale);
+}
+
+void replay_stop(void) {
+    if(!s_active) {
+        return;
+    }
+    uloop_timeout_cancel(&s_timer);
+    s_active = false;
+    printf("replay: served %" PRIu64 " recorded replies, %" PRIu64 " requests not in the trace, "
+           "sent %u of %u notifications\n", s_hits, s_misses, s_next_notif, s_n_notifs);
+    fflush(stdout);
+}
+
+bool replay_is_active(void) {
+    return s_active;
+}
+
+/**
+ * Return the generation of the replay. It changes when a new replay starts:
+ * a call replay_find_call() returned is only valid in the same generation.
+ */
+uint32_t replay_generation(void) {
+    return s_generation;
+}
+
+static int compare_key(const replay_call_t* const call, const char* const object,
+                       const char* const method, const char* const names) {
+    int rc = strcmp(call->object, object);
+    if(rc == 0) {
+        rc = strcmp(call->method, method);
+    }
+    if(rc == 0) {
+        rc = strcmp(call->names, names);
+    }
+    return rc;
+}
+
+/**
+ * Return the recorded call to serve for a request, or NULL if the trace has
+ * no call for the object, method and names.
+ *
+ * @param[in] object  path of the object
+ * @param[in] method  name of the method
+ * @param[in] names   'names' argument of get_params(), or NULL
+ */
+const replay_call_t* replay_find_call(const char* const object, const char* const method,
+                                      const char* const names) {
+    uint32_t lo = 0;
+    uint32_t hi = s_n_keys;
+
+    if(!s_active) {
+        return NULL;
+    }
+    while(lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        replay_key_t* const key = &s_keys[mid];
+        const int rc = compare_key(s_sorted[key->first], object, method, names ? names : "");
+        if(rc == 0) {
+            const replay_call_t* const call = s_sorted[key->first + key->cursor];
+            if(key->cursor + 1 < key->n) {
+                ++key->cursor;
+            }
+            ++s_hits;
+            return call;
+        } else if(rc < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    ++s_misses;
+    return NULL;
+}
+
+/* Return the ubus status to reply with */
+int replay_call_status(const replay_call_t* const call) {
+    return (call->rc == 0) ? UBUS_STATUS_OK : UBUS_STATUS_UNKNOWN_ERROR;
+}
+
+/* Return the delay to reply after in ms, or -1 to reply immediately */
+int replay_call_delay_ms(const replay_call_t* const call) {
+    if(s_scale == 0.0) {
+        return -1;
+    }
+    double delay = (double) scaled_us(call->duration_us) / 1000.0;
+    if(delay > MAX_DELAY_MS) {
+        delay = MAX_DELAY_MS;
+    }
+    return (int) delay;
+}
+
+/* Add the recorded reply to @a buf */
+void replay_fill_reply(const replay_call_t* const call, struct blob_buf* const buf) {
+    add_items(call->reply, buf);
+}
+
+void replay_cleanup(void) {
+    replay_stop();
+    free_data();
+    blob_buf_free(&s_buf);
+}
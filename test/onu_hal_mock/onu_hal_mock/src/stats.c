@@ -0,0 +1,185 @@
+/**
+ * Define _POSIX_C_SOURCE to avoid following error:
+ * implicit declaration of function ‘clock_gettime’
+ */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "stats.h"
+
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>
+#include <stdlib.h>   /* calloc() */
+#include <string.h>
+#include <time.h>     /* clock_gettime() */
+
+#include "onu_hal_macros.h"
+#include "onu_hal_trace.h"
+
+/* Nr of hash buckets: a power of 2 */
+#define N_BUCKETS 1024
+
+/* "all" as object or method matches any object or method */
+static const char ALL[] = "all";
+
+typedef struct _entry {
+    char* object;
+    char* method;
+    call_stats_t stats;
+    int32_t next; /* index of the next entry in the bucket, or -1 */
+} entry_t;
+
+/* Entries in order of creation, so a dump lists them in the order of the first call */
+static entry_t* s_entries = NULL;
+static uint32_t s_n_entries = 0;
+static uint32_t s_capacity = 0;
+static int32_t s_buckets[N_BUCKETS];
+static bool s_buckets_init = false;
+
+uint64_t stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* FNV-1a hash of object and method */
+static uint32_t hash(const char* const object, const char* const method) {
+    uint32_t h = 2166136261u;
+    const char* p;
+    for(p = object; *p; ++p) {
+        h = (h ^ (uint8_t) *p) * 16777619u;
+    }
+    h = (h ^ (uint8_t) ' ') * 16777619u;
+    for(p = method; *p; ++p) {
+        h = (h ^ (uint8_t) *p) * 16777619u;
+    }
+    return h & (N_BUCKETS - 1);
+}
+
+static void init_buckets(void) {
+    uint32_t i;
+    for(i = 0; i < N_BUCKETS; ++i) {
+        s_buckets[i] = -1;
+    }
+    s_buckets_init = true;
+}
+
+/**
+ * Return the counters for @a method of @a object. The function creates them
+ * at the first call.
+ *
+ * The pointer is only valid until the next call of stats_get() or
+ * stats_reset().
+ *
+ * @return the counters, or NULL if out of memory
+ */
+call_stats_t* stats_get(const char* const object, const char* const method) {
+    call_stats_t* stats = NULL;
+    int32_t i;
+
+    if(!s_buckets_init) {
+        init_buckets();
+    }
+    const uint32_t h = hash(object, method);
+    for(i = s_buckets[h]; i >= 0; i = s_entries[i].next) {
+        if((strcmp(s_entries[i].object, object) == 0) &&
+           (strcmp(s_entries[i].method, method) == 0)) {
+            return &s_entries[i].stats;
+        }
+    }
+
+    if(s_n_entries == s_capacity) {
+        const uint32_t capacity = s_capacity ? (2 * s_capacity) : 256;
+        entry_t* const entries = (entry_t*) realloc(s_entries, capacity * sizeof(entry_t));
+        when_null_trace(entries, exit, ERROR, "Failed to allocate mem for %u entries", capacity);
+        s_entries = entries;
+        s_capacity = capacity;
+    }
+    entry_t* const entry = &s_entries[s_n_entries];
+    memset(entry, 0, sizeof(entry_t));
+    entry->object = strdup(object);
+    entry->method = strdup(method);
+    if(!entry->object || !entry->method) {
+        SAH_TRACE_ERROR("Failed to allocate mem for %s.%s()", object, method);
+        free(entry->object);
+        free(entry->method);
+        goto exit;
+    }
+    entry->next = s_buckets[h];
+    s_buckets[h] = (int32_t) s_n_entries;
+    ++s_n_entries;
+    stats = &entry->stats;
+
+exit:
+    return stats;
+}
+
+void stats_reset(void) {
+    uint32_t i;
+    for(i = 0; i < s_n_entries; ++i) {
+        free(s_entries[i].object);
+        free(s_entries[i].method);
+    }
+    s_n_entries = 0;
+    init_buckets();
+}
+
+/* True if @a object is @a prefix, or is in the subtree of @a prefix */
+static bool object_matches(const char* const object, const char* const prefix) {
+    const size_t len = strlen(prefix);
+    return (strncmp(object, prefix, len) == 0) &&
+           ((object[len] == '\0') || (object[len] == '.'));
+}
+
+static void emit_stats(const char* const object, const char* const method,
+                       const call_stats_t* const stats, stats_emit_fn_t emit, void* priv) {
+    char line[512];
+    snprintf(line, sizeof(line),
+             "{\"object\":\"%s\",\"method\":\"%s\",\"calls\":%" PRIu64 ",\"errors\":%" PRIu64
+             ",\"dropped\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"handler_us\":%" PRIu64 "}",
+             object, method, stats->calls, stats->errors, stats->dropped, stats->bytes,
+             stats->handler_ns / 1000);
+    emit(line, priv);
+}
+
+/**
+ * Pass the counters matching @a object and @a method to @a emit, one JSON
+ * object per line, followed by their sum with object "total".
+ *
+ * @param[in] object  path of an object, or of the root of a subtree. "all" or
+ *                    NULL matches any object.
+ * @param[in] method  name of a method. "all" or NULL matches any method.
+ * @param[in] emit    function to pass each line to
+ * @param[in] priv    passed to @a emit
+ */
+void stats_dump(const char* const object, const char* const method,
+                stats_emit_fn_t emit, void* priv) {
+    const bool any_object = (NULL == object) || (strcmp(object, ALL) == 0);
+    const bool any_method = (NULL == method) || (strcmp(method, ALL) == 0);
+    call_stats_t total;
+    uint32_t i;
+
+    memset(&total, 0, sizeof(total));
+    for(i = 0; i < s_n_entries; ++i) {
+        const entry_t* const entry = &s_entries[i];
+        if((!any_object && !object_matches(entry->object, object)) ||
+           (!any_method && (strcmp(entry->method, method) != 0))) {
+            continue;
+        }
+        emit_stats(entry->object, entry->method, &entry->stats, emit, priv);
+        total.calls += entry->stats.calls;
+        total.errors += entry->stats.errors;
+        total.dropped += entry->stats.dropped;
+        total.bytes += entry->stats.bytes;
+        total.handler_ns += entry->stats.handler_ns;
+    }
+    emit_stats("total", any_method ? ALL : method, &total, emit, priv);
+}
+
+void stats_cleanup(void) {
+    stats_reset();
+    free(s_entries);
+    s_entries = NULL;
+    s_capacity = 0;
+}
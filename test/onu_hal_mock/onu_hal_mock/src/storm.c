@@ -0,0 +1,237 @@
+/**
+ * Define _POSIX_C_SOURCE to avoid following error:
+ * implicit declaration of function ‘clock_gettime’
+ */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "storm.h"
+
+#include <inttypes.h> /* PRIu64 */
+#include <stdio.h>
+#include <string.h>
+#include <time.h> /* clock_gettime() */
+
+#include "libubus.h"
+
+#include "data_model.h" /* dm_change_object() */
+#include "notif.h"      /* notif_send_dm_object_changed() */
+#include "onu_hal_macros.h"
+#include "onu_hal_trace.h"
+
+/* Period of the timer which sends the events of a storm with a rate */
+#define TICK_MS 10
+
+/* Upper bound of the nr of events per tick, to keep serving uloop */
+#define MAX_EVENTS_PER_TICK 10000
+
+#define N_MIXED_KINDS 3
+
+static const char* const KIND_NAMES[] = {
+    "object_changed", "instance_churn", "alarm_toggle", "mixed"
+};
+
+typedef struct _storm {
+    bool running;
+    storm_kind_t kind;
+    uint32_t rate_per_s;
+    uint32_t count;      /* 0: until storm_stop() */
+    uint32_t n_onus;
+    uint64_t n_sent;
+    uint32_t n_failed;
+    double credit;       /* nr of events due but not sent yet */
+    uint64_t last_ms;
+    uint64_t start_ms;
+    struct uloop_timeout timer;
+} storm_t;
+
+static storm_t s_storm;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+static bool change_object(object_wrapper_t* const onu, object_wrapper_t* const obj) {
+    if(!obj) {
+        return false;
+    }
+    dm_change_object(obj);
+    notif_send_dm_object_changed(onu, obj);
+    return true;
+}
+
+static bool churn_instance(uint32_t onu_idx, object_wrapper_t* const onu) {
+    bool added = false;
+    uint32_t index = 0;
+    char template_path[128];
+
+    if(dm_churn_gem_port(onu_idx, &added, &index)) {
+        return false;
+    }
+    snprintf(template_path, sizeof(template_path), "%s.ani.1.tc.gem.port", onu->name);
+    notif_send_dm_instance(onu, added, template_path, index);
+    return true;
+}
+
+/**
+ * Send event nr @a seq of the storm.
+ *
+ * Event 'seq' goes to ONU 'seq % n_onus'. The round, 'seq / n_onus', selects
+ * the object for object_changed and the kind for mixed, so all ONUs see the
+ * same sequence.
+ */
+static bool send_event(uint64_t seq) {
+    const uint32_t onu_idx = (uint32_t) (seq % s_storm.n_onus);
+    const uint64_t round = seq / s_storm.n_onus;
+    object_wrapper_t* const onu = dm_get_onu_object(onu_idx);
+    storm_kind_t kind = s_storm.kind;
+
+    if(!onu) {
+        return false;
+    }
+    if(kind == storm_mixed) {
+        kind = (storm_kind_t) (round % N_MIXED_KINDS);
+    }
+
+    switch(kind) {
+    case storm_object_changed:
+        return change_object(onu, dm_get_ani_one_object(onu_idx,
+                                                        (round % 2) ? type_onu_activation : type_transceiver));
+    case storm_instance_churn:
+        return churn_instance(onu_idx, onu);
+    case storm_alarm_toggle:
+        return change_object(onu, dm_get_ani_one_object(onu_idx, type_alarms));
+    default:
+        break;
+    }
+    return false;
+}
+
+static bool is_done(void) {
+    return (s_storm.count != 0) && (s_storm.n_sent >= s_storm.count);
+}
+
+static void send_events(uint32_t n) {
+    uint32_t i;
+    for(i = 0; (i < n) && !is_done(); ++i) {
+        if(!send_event(s_storm.n_sent)) {
+            ++s_storm.n_failed;
+        }
+        ++s_storm.n_sent;
+    }
+}
+
+static void print_summary(void) {
+    const uint64_t elapsed_ms = now_ms() - s_storm.start_ms;
+    printf("storm %s: sent=%" PRIu64 " failed=%u elapsed_ms=%" PRIu64 "\n",
+           KIND_NAMES[s_storm.kind], s_storm.n_sent, s_storm.n_failed, elapsed_ms);
+    fflush(stdout);
+}
+
+static void storm_tick(UNUSED struct uloop_timeout* t) {
+    const uint64_t now = now_ms();
+
+    s_storm.credit += (double) s_storm.rate_per_s * (double) (now - s_storm.last_ms) / 1000.0;
+    s_storm.last_ms = now;
+
+    uint32_t n = (s_storm.credit > MAX_EVENTS_PER_TICK) ?
+        MAX_EVENTS_PER_TICK : (uint32_t) s_storm.credit;
+    s_storm.credit -= n;
+    send_events(n);
+
+    if(is_done()) {
+        storm_stop();
+    } else {
+        uloop_timeout_set(&s_storm.timer, TICK_MS);
+    }
+}
+
+/**
+ * Start a storm. A running storm stops first.
+ *
+ * @param[in] kind        kind of events
+ * @param[in] rate_per_s  events per second, 0: send all events at once
+ * @param[in] count       nr of events, 0: until storm_stop()
+ * @param[in] n_onus      nr of ONUs to spread the events over, 0: all
+ *
+ * @return true on success
+ */
+bool storm_start(storm_kind_t kind, uint32_t rate_per_s, uint32_t count,
+                 uint32_t n_onus) {
+    const uint32_t n_onus_dm = dm_get_n_onus();
+
+    if((rate_per_s == 0) && (count == 0)) {
+        SAH_TRACE_ERROR("A burst (rate 0) needs a count");
+        return false;
+    }
+    if((n_onus == 0) || (n_onus > n_onus_dm)) {
+        n_onus = n_onus_dm;
+    }
+    if(n_onus == 0) {
+        SAH_TRACE_ERROR("No ONUs");
+        return false;
+    }
+
+    storm_stop();
+
+    memset(&s_storm, 0, sizeof(s_storm));
+    s_storm.running = true;
+    s_storm.kind = kind;
+    s_storm.rate_per_s = rate_per_s;
+    s_storm.count = count;
+    s_storm.n_onus = n_onus;
+    s_storm.start_ms = now_ms();
+    s_storm.last_ms = s_storm.start_ms;
+    s_storm.timer.cb = storm_tick;
+
+    printf("storm %s: rate=%u/s count=%u onus=%u\n", KIND_NAMES[kind],
+           rate_per_s, count, n_onus);
+    fflush(stdout);
+
+    if(rate_per_s == 0) {
+        send_events(count);
+        storm_stop();
+    } else {
+        uloop_timeout_set(&s_storm.timer, TICK_MS);
+    }
+    return true;
+}
+
+/**
+ * Start a storm from a debug command: "<kind> <rate> <count> [onus]", e.g.,
+ * "instance_churn 1000 50000 4".
+ *
+ * @return true on success
+ */
+bool storm_start_from_string(const char* const args) {
+    char kind_name[32];
+    unsigned int rate = 0;
+    unsigned int count = 0;
+    unsigned int n_onus = 0;
+    size_t i;
+
+    const int n = sscanf(args, "%31s %u %u %u", kind_name, &rate, &count, &n_onus);
+    if(n < 3) {
+        SAH_TRACE_ERROR("Invalid storm: '%s'", args);
+        return false;
+    }
+    for(i = 0; i < ARRAY_SIZE(KIND_NAMES); ++i) {
+        if(strcmp(kind_name, KIND_NAMES[i]) == 0) {
+            return storm_start((storm_kind_t) i, rate, count, n_onus);
+        }
+    }
+    SAH_TRACE_ERROR("Unknown storm kind: '%s'", kind_name);
+    return false;
+}
+
+void storm_stop(void) {
+    if(!s_storm.running) {
+        return;
+    }
+    uloop_timeout_cancel(&s_storm.timer);
+    s_storm.running = false;
+    print_summary();
+}
@@ -0,0 +1,159 @@
+#include "topology.h"
+
+#include <ctype.h>  /* isspace() */
+#include <stddef.h> /* offsetof() */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h> /* strtoul() */
+#include <string.h>
+
+#include "onu_hal_macros.h"
+#include "onu_hal_trace.h"
+
+/* Upper bounds: high enough for worst-case load tests */
+#define MAX_ONUS 128
+#define MAX_PER_ONU 64       /* ANIs, UNIs and software images */
+#define MAX_GEM_PORTS 65535  /* per ANI */
+#define MAX_TRANSCEIVERS 64  /* per ANI */
+
+typedef struct _topology_key {
+    const char* name;
+    size_t offset;
+    uint32_t min;
+    uint32_t max;
+} topology_key_t;
+
+static const topology_key_t KEYS[] = {
+    { "first_onu", offsetof(topology_t, first_onu), 1, 999 },
+    { "onus", offsetof(topology_t, n_onus), 1, MAX_ONUS },
+    { "anis", offsetof(topology_t, n_anis), 1, MAX_PER_ONU },
+    { "gem_ports", offsetof(topology_t, n_gem_ports), 0, MAX_GEM_PORTS },
+    { "ethernet_unis", offsetof(topology_t, n_ethernet_unis), 0, MAX_PER_ONU },
+    { "software_images", offsetof(topology_t, n_software_images), 0, MAX_PER_ONU },
+    { "transceivers", offsetof(topology_t, n_transceivers), 0, MAX_TRANSCEIVERS }
+};
+
+void topology_init(topology_t* const topology) {
+    topology->first_onu = 1;
+    topology->n_onus = 1;
+    topology->n_anis = 1;
+    topology->n_gem_ports = 1;
+    topology->n_ethernet_unis = 1;
+    topology->n_software_images = 2;
+    topology->n_transceivers = 1;
+}
+
+/**
+ * Set the field of @a topology with name @a key, e.g., "gem_ports".
+ *
+ * @return true on success, false if the key is unknown or the value is
+ *         invalid
+ */
+bool topology_set(topology_t* const topology, const char* const key, const char* const value) {
+    size_t i;
+    char* end = NULL;
+
+    for(i = 0; i < ARRAY_SIZE(KEYS); ++i) {
+        if(strcmp(key, KEYS[i].name) != 0) {
+            continue;
+        }
+        errno = 0;
+        const unsigned long v = strtoul(value, &end, 0);
+        if((errno != 0) || (end == value) || (*end != '\0') ||
+           (v < KEYS[i].min) || (v > KEYS[i].max)) {
+            SAH_TRACE_ERROR("%s: invalid value '%s': must be in [%u, %u]",
+                            key, value, KEYS[i].min, KEYS[i].max);
+            return false;
+        }
+        *(uint32_t*) ((char*) topology + KEYS[i].offset) = (uint32_t) v;
+        return true;
+    }
+    SAH_TRACE_ERROR("Unknown topology key '%s'", key);
+    return false;
+}
+
+static char* trim(char* str) {
+    char* end;
+    while(isspace((unsigned char) *str)) {
+        ++str;
+    }
+    end = str + strlen(str);
+    while((end > str) && isspace((unsigned char) end[-1])) {
+        --end;
+    }
+    *end = '\0';
+    return str;
+}
+
+/**
+ * Load a topology from a file with one 'key = value' per line.
+ *
+ * Empty lines and lines starting with '#' are ignored. The keys are the names
+ * in KEYS[], e.g.:
+ *
+ *   # 4 ONUs with 1000 GEM ports each
+ *   onus = 4
+ *   gem_ports = 1000
+ *
+ * Keys which do not occur in the file keep their value.
+ */
+bool topology_load_file(topology_t* const topology, const char* const path) {
+    bool rv = false;
+    char line[256];
+    uint32_t line_nr = 0;
+
+    FILE* const file = fopen(path, "r");
+    when_null_trace(file, exit, ERROR, "Failed to open %s: %s", path, strerror(errno));
+
+    while(fgets(line, sizeof(line), file)) {
+        ++line_nr;
+        char* const content = trim(line);
+        if((*content == '\0') || (*content == '#')) {
+            continue;
+        }
+        char* const sep = strchr(content, '=');
+        if(NULL == sep) {
+            SAH_TRACE_ERROR("%s:%u: expected 'key = value'", path, line_nr);
+            goto exit_close;
+        }
+        *sep = '\0';
+        if(!topology_set(topology, trim(content), trim(sep + 1))) {
+            SAH_TRACE_ERROR("%s:%u: invalid line", path, line_nr);
+            goto exit_close;
+        }
+    }
+    rv = true;
+
+exit_close:
+    fclose(file);
+exit:
+    return rv;
+}
+
+bool topology_is_valid(const topology_t* const topology) {
+    if(topology->first_onu + topology->n_onus - 1 > 999) {
+        SAH_TRACE_ERROR("ONU nrs must not exceed 999");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Return the nr of objects the mock advertises at startup for @a topology.
+ */
+uint32_t topology_get_n_objects(const topology_t* const topology) {
+    /* onu_activation, performance_thresholds and alarms */
+    const uint32_t per_ani = 1 + 3 + topology->n_gem_ports + topology->n_transceivers;
+    const uint32_t per_onu = 1 + topology->n_software_images +
+        topology->n_ethernet_unis + (topology->n_anis * per_ani);
+    return topology->n_onus * per_onu;
+}
+
+void topology_print(const topology_t* const topology) {
+    SAH_TRACE_INFO("topology: onus=%u (first=%u) anis=%u gem_ports=%u "
+                   "ethernet_unis=%u software_images=%u transceivers=%u => %u objects",
+                   topology->n_onus, topology->first_onu, topology->n_anis,
+                   topology->n_gem_ports, topology->n_ethernet_unis,
+                   topology->n_software_images, topology->n_transceivers,
+                   topology_get_n_objects(topology));
+}